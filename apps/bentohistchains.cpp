@@ -30,8 +30,19 @@ namespace
             optBasePath("basepath"), optBasePathDefault("./optdata"),
             optDefaultRiskFreeRate("riskfreerate"), optDefaultRiskFreeRateDefault("0.042"),
             optRatesCsv("yieldcurve"), optRatesCsvDefault("./data/TSY.2025-06-06.csv"),
+            optRatesCache("yieldcurvecache"), optRatesCacheDefault(""),
             bStacked("csvstacked"), bStackedDefault(false),
             bDateDirs("outdatedirs"), bDateDirsDefault(true),
+            bGreeks("greeks"), bGreeksDefault(false),
+            bBinary("binary"), bBinaryDefault(false),
+            bChainStore("chainstore"), bChainStoreDefault(false),
+            bSyncWrites("syncwrites"), bSyncWritesDefault(false),
+            bIoUring("iouring"), bIoUringDefault(false),
+            bConsolidated("consolidated"), bConsolidatedDefault(false),
+            optZstdLevel("zstdlevel"), optZstdLevelDefault("0"),
+            optZstdDict("zstddict"), optZstdDictDefault(""),
+            optDeltaShift("deltashift"), optDeltaShiftDefault("0"),
+            optCbboCapture("cbbocapture"), optCbboCaptureDefault(""),
             optSymbologyThreads("symbologythreads"), optSymbologyThreadsDefault("5"),
             optTimeseriesThreads("timeseriesthreads"), optTimeseriesThreadsDefault("10"),
             optRetries("retries"), optRetriesDefault("3"),
@@ -97,6 +108,12 @@ namespace
             fmt::format("Yield curve CSV treasury.org format, Default: {}", optRatesCsvDefault).c_str()
             )
 
+            (
+            fmt::format("{}", optRatesCache).c_str(),
+            po::value<std::string>()->default_value(optRatesCacheDefault),
+            "Directory caching parsed yield curves in binary format, Default: none (no caching)"
+            )
+
             (
             fmt::format("{},f",bStacked).c_str(),
             po::value<bool>()->default_value(bStackedDefault),
@@ -108,6 +125,66 @@ namespace
             po::value<bool>()->default_value(bDateDirsDefault),
             fmt::format("CSV into date directories below base path, Default: {}", bDateDirsDefault).c_str()
             )
+
+            (
+            fmt::format("{}",bGreeks).c_str(),
+            po::value<bool>()->default_value(bGreeksDefault),
+            fmt::format("CSV with implied volatility and Greeks columns, Default: {}", bGreeksDefault).c_str()
+            )
+
+            (
+            fmt::format("{}",bBinary).c_str(),
+            po::value<bool>()->default_value(bBinaryDefault),
+            fmt::format("Columnar binary chain files instead of CSV, Default: {}", bBinaryDefault).c_str()
+            )
+
+            (
+            fmt::format("{}",bChainStore).c_str(),
+            po::value<bool>()->default_value(bChainStoreDefault),
+            fmt::format("Append chains to a memory-mapped chain store in the base path instead of files, Default: {}", bChainStoreDefault).c_str()
+            )
+
+            (
+            fmt::format("{}",bSyncWrites).c_str(),
+            po::value<bool>()->default_value(bSyncWritesDefault),
+            fmt::format("Sync output to disk after each batch of written files, Default: {}", bSyncWritesDefault).c_str()
+            )
+
+            (
+            fmt::format("{}",bIoUring).c_str(),
+            po::value<bool>()->default_value(bIoUringDefault),
+            fmt::format("Write batches of output files with io_uring if available, Default: {}", bIoUringDefault).c_str()
+            )
+
+            (
+            fmt::format("{}",bConsolidated).c_str(),
+            po::value<bool>()->default_value(bConsolidatedDefault),
+            fmt::format("Append all chains of a symbol and date to one file with an offset index, Default: {}", bConsolidatedDefault).c_str()
+            )
+
+            (
+            fmt::format("{}",optZstdLevel).c_str(),
+            po::value<std::uint16_t>()->default_value(std::stoi(optZstdLevelDefault)),
+            fmt::format("zstd compression level of chain files (1-22), 0 for uncompressed, Default: {}", optZstdLevelDefault).c_str()
+            )
+
+            (
+            fmt::format("{}",optZstdDict).c_str(),
+            po::value<std::string>()->default_value(optZstdDictDefault),
+            "Optional zstd dictionary file for compressing chain files, e.g. trained with zstd --train on sample chains"
+            )
+
+            (
+            fmt::format("{}",optDeltaShift).c_str(),
+            po::value<std::uint16_t>()->default_value(std::stoi(optDeltaShiftDefault)),
+            fmt::format("Seconds after which quotes get shifted to chain time by estimated delta, 0 disables, Default: {}", optDeltaShiftDefault).c_str()
+            )
+
+            (
+            fmt::format("{}",optCbboCapture).c_str(),
+            po::value<std::string>()->default_value(optCbboCaptureDefault),
+            "Optional base path to capture raw CBBO data of each chain for offline reprocessing with bentoreprocess"
+            )
             
             (
             fmt::format("{}", optSymbologyThreads).c_str(),
@@ -207,6 +284,10 @@ namespace
         {
             return vm[optRatesCsv].as<std::string>();
         }
+        std::string getRatesCache() const
+        {
+            return vm[optRatesCache].as<std::string>();
+        }
         std::string getKeyScript() const
         {
             return vm[optKeyScript].as<std::string>();
@@ -219,6 +300,46 @@ namespace
         {
             return vm[bDateDirs].as<bool>();
         }
+        bool getGreeks() const
+        {
+            return vm[bGreeks].as<bool>();
+        }
+        bool getBinary() const
+        {
+            return vm[bBinary].as<bool>();
+        }
+        bool getChainStore() const
+        {
+            return vm[bChainStore].as<bool>();
+        }
+        bool getSyncWrites() const
+        {
+            return vm[bSyncWrites].as<bool>();
+        }
+        bool getIoUring() const
+        {
+            return vm[bIoUring].as<bool>();
+        }
+        bool getConsolidated() const
+        {
+            return vm[bConsolidated].as<bool>();
+        }
+        std::uint16_t getZstdLevel() const
+        {
+            return vm[optZstdLevel].as<std::uint16_t>();
+        }
+        std::string getZstdDict() const
+        {
+            return vm[optZstdDict].as<std::string>();
+        }
+        std::uint16_t getDeltaShift() const
+        {
+            return vm[optDeltaShift].as<std::uint16_t>();
+        }
+        std::string getCbboCapture() const
+        {
+            return vm[optCbboCapture].as<std::string>();
+        }
         std::uint16_t getSymbologyThreads() const
         {
             return vm[optSymbologyThreads].as<std::uint16_t>();
@@ -263,10 +384,28 @@ namespace
         std::string optBasePath, optBasePathDefault;
         std::string optDefaultRiskFreeRate, optDefaultRiskFreeRateDefault;
         std::string optRatesCsv, optRatesCsvDefault;
+        std::string optRatesCache, optRatesCacheDefault;
         std::string bStacked;
         bool bStackedDefault;
         std::string bDateDirs;
         bool bDateDirsDefault;
+        std::string bGreeks;
+        bool bGreeksDefault;
+        std::string bBinary;
+        bool bBinaryDefault;
+        std::string bChainStore;
+        bool bChainStoreDefault;
+        std::string bSyncWrites;
+        bool bSyncWritesDefault;
+        std::string bIoUring;
+        bool bIoUringDefault;
+        std::string bConsolidated;
+        bool bConsolidatedDefault;
+        std::string optZstdLevel, optZstdLevelDefault;
+        std::string optZstdDict, optZstdDictDefault;
+        std::string optDeltaShift;
+        std::string optDeltaShiftDefault;
+        std::string optCbboCapture, optCbboCaptureDefault;
         std::string optSymbologyThreads, optSymbologyThreadsDefault;
         std::string optTimeseriesThreads, optTimeseriesThreadsDefault;
         std::string optRetries, optRetriesDefault;
@@ -294,9 +433,20 @@ int main(int argc, char* argv[]) {
     std::string sBasePath;
     double fDefaultRiskFreeRate(0.0);
     std::string sRatesCsv;
+    std::string sRatesCache;
     std::string sKeyScript;
     bool bStacked = false;
     bool bDateDirs = true;
+    bool bGreeks = false;
+    bool bBinary = false;
+    bool bChainStore = false;
+    bool bSyncWrites = false;
+    bool bIoUring = false;
+    bool bConsolidated = false;
+    std::uint64_t nZstdLevel = 0;
+    std::string sZstdDict;
+    std::uint64_t nDeltaShift = 0;
+    std::string sCbboCapture;
     // the oomp of this app, its number of request threads hammering databento servers
     std::uint64_t nThreadsSymbology = 0;
     std::uint64_t nThreadsTimeseries = 0;
@@ -321,9 +471,20 @@ int main(int argc, char* argv[]) {
         sBasePath = cli.getBasePath();
         fDefaultRiskFreeRate = cli.getDefaultRiskFreeRate();
         sRatesCsv = cli.getRatesCsv();
+        sRatesCache = cli.getRatesCache();
         sKeyScript = cli.getKeyScript();
         bStacked = cli.getStacked();
         bDateDirs = cli.getDateDirs();
+        bGreeks = cli.getGreeks();
+        bBinary = cli.getBinary();
+        bChainStore = cli.getChainStore();
+        bSyncWrites = cli.getSyncWrites();
+        bIoUring = cli.getIoUring();
+        bConsolidated = cli.getConsolidated();
+        nZstdLevel = minMax(cli.getZstdLevel(), 0, 22);
+        sZstdDict = cli.getZstdDict();
+        nDeltaShift = cli.getDeltaShift();
+        sCbboCapture = cli.getCbboCapture();
         nThreadsSymbology = minMax(cli.getSymbologyThreads(), 1, 10);
         nThreadsTimeseries = minMax(cli.getTimeseriesThreads(), 1, 100);
         nRetries = minMax(cli.getRetries(), 0, 5);
@@ -336,6 +497,22 @@ int main(int argc, char* argv[]) {
         fmt::print("Error converting command options: {}", e.what());
         return 1;
     }
+    // reject options the chosen output doesn't support instead of silently ignoring them
+    std::string sConflict;
+    if (bChainStore && (bConsolidated || bBinary || bStacked || bGreeks || bIoUring || nZstdLevel != 0))
+    {
+        sConflict = "chainstore does not combine with consolidated, binary, csvstacked, greeks, iouring or zstdlevel";
+    } else if (bConsolidated && (bIoUring || nZstdLevel != 0)) {
+        sConflict = "consolidated does not combine with iouring or zstdlevel";
+    } else if (!sZstdDict.empty() && nZstdLevel == 0) {
+        sConflict = "zstddict requires a zstdlevel";
+    }
+    if (!sConflict.empty())
+    {
+        fmt::print("Conflicting command options: {}\nRun {} -help for options\n",
+            sConflict, bc::AppUtils::getExecutableName(argv));
+        return 1;
+    }
 
     try {
         bc::logging::init_logging(bLogThreadId, sLogLevel);
@@ -359,8 +536,8 @@ int main(int argc, char* argv[]) {
     // give a start message of what is going to be loaded
     std::cout << "Getting option chains for symbols \"" 
         << symbols << "\"" << std::endl 
-        << "as " << (bStacked? "stacked" : "side by side")
-        << " CSV files for up to " << nDte << " days to expiration" << std::endl
+        << "as " << (bChainStore? "chain store" : bBinary? "binary" : bStacked? "stacked CSV" : "side by side CSV")
+        << (bChainStore? "" : bConsolidated? " files per symbol and date" : " files per chain") << " for up to " << nDte << " days to expiration" << std::endl
         << "from valuation date "
         << sDate << ", time " << sTime << std::endl
         << "to base output path: " << sBasePath << std::endl; 
@@ -386,27 +563,38 @@ int main(int argc, char* argv[]) {
     std::function<bool()> terminateSignal = [](){
         return bc::SignalHandler::getSignal() != 0;
     };
-    // dataset for US option chains
-    std::string sDataset("OPRA.PILLAR");
     // the interface for asynchronous job submission
+    bc::RequesterAsynchronous::Options requesterOptions;
+    requesterOptions.m_sApiKey = apiKey;
+    // dataset for US option chains
+    requesterOptions.m_sDataset = "OPRA.PILLAR";
+    requesterOptions.m_sBasePath = sBasePath;
+    requesterOptions.m_nThreadsRequester = nThreadsRequester;
+    requesterOptions.m_nThreadsSymbology = nThreadsSymbology;
+    requesterOptions.m_nThreadsTimeseries = nThreadsTimeseries;
+    requesterOptions.m_terminateSignal = terminateSignal;
+    requesterOptions.m_nSplitInstrumentIds = nSplitInstrumentIds;
+    requesterOptions.m_nRetries = nRetries;
+    requesterOptions.m_chainLookupTimeRange = chainLookupTimeRange;
+    requesterOptions.m_cbbo1sTimeRange = cbbo1sTimeRange;
+    requesterOptions.m_cbbo1mTimeRange = cbbo1mTimeRange;
+    requesterOptions.m_fDefaultRiskFreeRate = fDefaultRiskFreeRate;
+    requesterOptions.m_sInterestRatesCsv = sRatesCsv;
+    requesterOptions.m_sInterestRatesCache = sRatesCache;
+    requesterOptions.m_bStacked = bStacked;
+    requesterOptions.m_bDateDirs = bDateDirs;
+    requesterOptions.m_bGreeks = bGreeks;
+    requesterOptions.m_deltaShiftStaleAfter = std::chrono::seconds(nDeltaShift);
+    requesterOptions.m_bBinary = bBinary;
+    requesterOptions.m_bChainStore = bChainStore;
+    requesterOptions.m_bSyncWrites = bSyncWrites;
+    requesterOptions.m_bIoUring = bIoUring;
+    requesterOptions.m_nCompressionLevel = static_cast<int>(nZstdLevel);
+    requesterOptions.m_sCompressionDictionary = sZstdDict;
+    requesterOptions.m_bConsolidated = bConsolidated;
+    requesterOptions.m_sCbboCapturePath = sCbboCapture;
     std::unique_ptr<bc::RequesterAsynchronous> requester = 
-        bc::RequesterAsynchronous::makeRequesterCSV(
-        apiKey,
-        sDataset,
-        sBasePath,
-        nThreadsRequester,
-        nThreadsSymbology,
-        nThreadsTimeseries,
-        terminateSignal,
-        nSplitInstrumentIds,
-        nRetries,
-        chainLookupTimeRange,
-        cbbo1sTimeRange,
-        cbbo1mTimeRange,
-        fDefaultRiskFreeRate,
-        sRatesCsv,
-        bStacked,
-        bDateDirs);
+        bc::RequesterAsynchronous::makeRequesterCSV(requesterOptions);
 
     std::map<bc::Requester::JobId, std::string> requestMap;
     for (auto& symbol : symbolList)
@@ -448,5 +636,12 @@ int main(int argc, char* argv[]) {
         // returns empty map if all pending jobs are done. Otherwise blocks until more results are in.
         resultMap = requester->query();
     }
+    std::uint64_t nFailedPersists = requester->finishPersisting();
+    if (nFailedPersists > 0)
+    {
+        std::cerr << nFailedPersists << " chains or files failed to get written, see the error log"
+            << " and missing chain files" << std::endl;
+        return 1;
+    }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,414 @@
+#include "bentoclient/apputils.hpp"
+#include "bentoclient/signalhandler.hpp"
+#include "bentoclient/cbbocapture.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/optionrecordgapfiller.hpp"
+#include "bentoclient/marketenvironmentextended.hpp"
+#include "bentoclient/persistercsv.hpp"
+#include "bentoclient/persisterbinary.hpp"
+#include "bentoclient/persisterconsolidated.hpp"
+#include "bentoclient/variadicthreadpool.hpp"
+#include "bentoclient/dateutils.hpp"
+#include "bentoclient/logging.hpp"
+#include <boost/log/trivial.hpp>
+#include <fmt/format.h>
+#include <iostream>
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace po = boost::program_options;
+namespace bc = bentoclient;
+
+bc::SignalHandler gSignalHandler;
+
+namespace
+{
+    class CommandLine
+    {
+    public:
+        CommandLine(int argc, char* argv[]) :
+            desc(bc::AppUtils::getExecutableName(argv) + " option chain reprocessing command line options"),
+            vm{},
+            optCapturePath("capturepath"),
+            optBasePath("basepath"), optBasePathDefault("./optdata"),
+            optDefaultRiskFreeRate("riskfreerate"), optDefaultRiskFreeRateDefault("0.042"),
+            optRatesCsv("yieldcurve"), optRatesCsvDefault("./data/TSY.2025-06-06.csv"),
+            optRatesCache("yieldcurvecache"), optRatesCacheDefault(""),
+            bStacked("csvstacked"), bStackedDefault(false),
+            bDateDirs("outdatedirs"), bDateDirsDefault(true),
+            bGreeks("greeks"), bGreeksDefault(false),
+            bBinary("binary"), bBinaryDefault(false),
+            bConsolidated("consolidated"), bConsolidatedDefault(false),
+            optDeltaShift("deltashift"), optDeltaShiftDefault("0"),
+            optThreads("threads"), optThreadsDefault("0"),
+            optLogLevel("loglevel"), optLogLevelDefault("error"),
+            bLogThreadId("logthreadid"), bLogThreadIdDefault(false)
+        {
+            addOptions();
+        }
+    private:
+        void addOptions()
+        {
+        /// command line options
+        desc.add_options()
+
+            (
+            fmt::format("{},c", optCapturePath).c_str(),
+            po::value<std::string>(),
+            "Capture file, or directory searched recursively for capture files written with bentohistchains --cbbocapture"
+            )
+
+            (
+            fmt::format("{}", optBasePath).c_str(),
+            po::value<std::string>()->default_value(optBasePathDefault),
+            fmt::format("Base CSV output path, Default: {}", optBasePathDefault).c_str()
+            )
+
+            (
+            fmt::format("{}", optDefaultRiskFreeRate).c_str(),
+            po::value<double>()->default_value(std::stod(optDefaultRiskFreeRateDefault)),
+            fmt::format("Default continuously compounded risk free rate, Default: {}", optDefaultRiskFreeRateDefault).c_str()
+            )
+
+            (
+            fmt::format("{}", optRatesCsv).c_str(),
+            po::value<std::string>()->default_value(optRatesCsvDefault),
+            fmt::format("Yield curve CSV treasury.org format, Default: {}", optRatesCsvDefault).c_str()
+            )
+
+            (
+            fmt::format("{}", optRatesCache).c_str(),
+            po::value<std::string>()->default_value(optRatesCacheDefault),
+            "Directory caching parsed yield curves in binary format, Default: none (no caching)"
+            )
+
+            (
+            fmt::format("{},f",bStacked).c_str(),
+            po::value<bool>()->default_value(bStackedDefault),
+            fmt::format("CSV with put/call stacked, Default: {} (side by side)", bStackedDefault).c_str()
+            )
+
+            (
+            fmt::format("{}",bDateDirs).c_str(),
+            po::value<bool>()->default_value(bDateDirsDefault),
+            fmt::format("CSV into date directories below base path, Default: {}", bDateDirsDefault).c_str()
+            )
+
+            (
+            fmt::format("{}",bGreeks).c_str(),
+            po::value<bool>()->default_value(bGreeksDefault),
+            fmt::format("CSV with implied volatility and Greeks columns, Default: {}", bGreeksDefault).c_str()
+            )
+
+            (
+            fmt::format("{}",bBinary).c_str(),
+            po::value<bool>()->default_value(bBinaryDefault),
+            fmt::format("Columnar binary chain files instead of CSV, Default: {}", bBinaryDefault).c_str()
+            )
+
+            (
+            fmt::format("{}",bConsolidated).c_str(),
+            po::value<bool>()->default_value(bConsolidatedDefault),
+            fmt::format("Append all chains of a symbol and date to one file with an offset index, Default: {}", bConsolidatedDefault).c_str()
+            )
+
+            (
+            fmt::format("{}",optDeltaShift).c_str(),
+            po::value<std::uint16_t>()->default_value(std::stoi(optDeltaShiftDefault)),
+            fmt::format("Seconds after which quotes get shifted to chain time by estimated delta, 0 disables, Default: {}", optDeltaShiftDefault).c_str()
+            )
+
+            (
+            fmt::format("{}", optThreads).c_str(),
+            po::value<std::uint16_t>()->default_value(std::stoi(optThreadsDefault)),
+            fmt::format("Number of reprocessing threads, 0 for the number of CPU cores, Default: {}", optThreadsDefault).c_str()
+            )
+
+            (
+            fmt::format("{},l", optLogLevel).c_str(),
+            po::value<std::string>()->default_value(optLogLevelDefault),
+            fmt::format("LogLevel, Default: {}, options {}", optLogLevelDefault, bc::logging::get_log_levels()).c_str()
+            )
+
+            (
+            fmt::format("{}",bLogThreadId).c_str(),
+            po::value<bool>()->default_value(bLogThreadIdDefault),
+            fmt::format("Output thread ID in logging, Default: {}", bLogThreadIdDefault).c_str()
+            )
+
+            ;
+        }
+    public:
+        std::pair<int, bool> parseCommandLine(int argc, char* argv[])
+        {
+            try {
+                po::store(po::parse_command_line(argc, argv, desc), vm);
+                po::notify(vm);
+                if (vm.count("help")
+                    || vm.count(optCapturePath) == 0) {
+                    std::cout << desc << std::endl;
+                    return {0,true};
+                }
+            } catch (const std::exception& e) {
+                fmt::print("Command line error: {}\n", e.what());
+                std::cout << desc << std::endl;
+                return {1,true};
+            }
+            return {0,false};
+        }
+
+        std::string getCapturePath() const
+        {
+            return vm[optCapturePath].as<std::string>();
+        }
+        std::string getBasePath() const
+        {
+            return vm[optBasePath].as<std::string>();
+        }
+        double getDefaultRiskFreeRate() const
+        {
+            return vm[optDefaultRiskFreeRate].as<double>();
+        }
+        std::string getRatesCsv() const
+        {
+            return vm[optRatesCsv].as<std::string>();
+        }
+        std::string getRatesCache() const
+        {
+            return vm[optRatesCache].as<std::string>();
+        }
+        bool getStacked() const
+        {
+            return vm[bStacked].as<bool>();
+        }
+        bool getDateDirs() const
+        {
+            return vm[bDateDirs].as<bool>();
+        }
+        bool getGreeks() const
+        {
+            return vm[bGreeks].as<bool>();
+        }
+        bool getBinary() const
+        {
+            return vm[bBinary].as<bool>();
+        }
+        bool getConsolidated() const
+        {
+            return vm[bConsolidated].as<bool>();
+        }
+        std::uint16_t getDeltaShift() const
+        {
+            return vm[optDeltaShift].as<std::uint16_t>();
+        }
+        std::uint16_t getThreads() const
+        {
+            return vm[optThreads].as<std::uint16_t>();
+        }
+        std::string getLogLevel() const
+        {
+            return vm[optLogLevel].as<std::string>();
+        }
+        bool getLogThreadId() const
+        {
+            return vm[bLogThreadId].as<bool>();
+        }
+
+    private:
+        po::options_description desc;
+        po::variables_map vm;
+        std::string optCapturePath;
+        std::string optBasePath, optBasePathDefault;
+        std::string optDefaultRiskFreeRate, optDefaultRiskFreeRateDefault;
+        std::string optRatesCsv, optRatesCsvDefault;
+        std::string optRatesCache, optRatesCacheDefault;
+        std::string bStacked;
+        bool bStackedDefault;
+        std::string bDateDirs;
+        bool bDateDirsDefault;
+        std::string bGreeks;
+        bool bGreeksDefault;
+        std::string bBinary;
+        bool bBinaryDefault;
+        std::string bConsolidated;
+        bool bConsolidatedDefault;
+        std::string optDeltaShift;
+        std::string optDeltaShiftDefault;
+        std::string optThreads, optThreadsDefault;
+        std::string optLogLevel, optLogLevelDefault;
+        std::string bLogThreadId;
+        bool bLogThreadIdDefault;
+    };
+
+    /// @brief Capture files of a path, sorted for a reproducible order of output
+    std::vector<std::string> findCaptureFiles(const std::string& capturePath)
+    {
+        std::vector<std::string> captureFiles;
+        if (std::filesystem::is_regular_file(capturePath))
+        {
+            captureFiles.push_back(capturePath);
+            return captureFiles;
+        }
+        for (auto& entry : std::filesystem::recursive_directory_iterator(capturePath))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == bc::CbboCapture::m_fileExtension)
+            {
+                captureFiles.push_back(entry.path().string());
+            }
+        }
+        std::sort(captureFiles.begin(), captureFiles.end());
+        return captureFiles;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    CommandLine cli(argc,argv);
+    auto parseResult = cli.parseCommandLine(argc,argv);
+    if (parseResult.second) {
+        return parseResult.first;
+    }
+
+    // get command line arguments
+    std::string sCapturePath;
+    std::string sBasePath;
+    double fDefaultRiskFreeRate(0.0);
+    std::string sRatesCsv;
+    std::string sRatesCache;
+    bool bStacked = false;
+    bool bDateDirs = true;
+    bool bGreeks = false;
+    bool bBinary = false;
+    bool bConsolidated = false;
+    std::uint64_t nDeltaShift = 0;
+    std::uint64_t nThreads = 0;
+    std::string sLogLevel;
+    bool bLogThreadId = false;
+    try {
+        sCapturePath = cli.getCapturePath();
+        sBasePath = cli.getBasePath();
+        fDefaultRiskFreeRate = cli.getDefaultRiskFreeRate();
+        sRatesCsv = cli.getRatesCsv();
+        sRatesCache = cli.getRatesCache();
+        bStacked = cli.getStacked();
+        bDateDirs = cli.getDateDirs();
+        bGreeks = cli.getGreeks();
+        bBinary = cli.getBinary();
+        bConsolidated = cli.getConsolidated();
+        nDeltaShift = cli.getDeltaShift();
+        nThreads = cli.getThreads();
+        sLogLevel = cli.getLogLevel();
+        bLogThreadId = cli.getLogThreadId();
+    } catch (const std::exception& e) {
+        fmt::print("Error converting command options: {}", e.what());
+        return 1;
+    }
+    if (nThreads == 0)
+    {
+        nThreads = std::max<std::uint64_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    try {
+        bc::logging::init_logging(bLogThreadId, sLogLevel);
+    } catch (const std::exception& e) {
+        std::cout << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> captureFiles;
+    std::shared_ptr<bc::MarketEnvironment> marketEnvironment;
+    try {
+        captureFiles = findCaptureFiles(sCapturePath);
+        marketEnvironment = std::make_shared<bc::MarketEnvironmentExtended>(
+            fDefaultRiskFreeRate,
+            bc::DateUtils::m_nasdaqClose,
+            sRatesCsv,
+            sRatesCache);
+    } catch (const std::exception& e) {
+        std::cout << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Reprocessing " << captureFiles.size() << " captures in " << sCapturePath << std::endl
+        << "as " << (bBinary? "binary" : bStacked? "stacked CSV" : "side by side CSV")
+        << (bConsolidated? " consolidated" : "") << " files with " << nThreads << " threads" << std::endl
+        << "to base output path: " << sBasePath << std::endl;
+
+    std::unique_ptr<bc::Persister> persister;
+    bc::PersisterCSV::CSVFormat csvFormat = bStacked?
+        bc::PersisterCSV::CSVFormat::Stacked : bc::PersisterCSV::CSVFormat::SideBySide;
+    if (bConsolidated)
+    {
+        persister = std::make_unique<bc::PersisterConsolidated>(sBasePath, bDateDirs,
+            bBinary ? bc::ConsolidatedFile::Flavour::Binary : bc::ConsolidatedFile::Flavour::CSV,
+            csvFormat, bGreeks);
+    } else if (bBinary) {
+        persister = std::make_unique<bc::PersisterBinary>(sBasePath, bDateDirs);
+    } else {
+        persister = std::make_unique<bc::PersisterCSV>(sBasePath, bDateDirs, csvFormat, bGreeks);
+    }
+
+    // Each capture is independent CPU work: timeline, chain build, gap filling and formatting
+    bc::TimeRange deltaShiftStaleAfter = std::chrono::seconds(nDeltaShift);
+    std::list<std::future<bool>> results;
+    // missing notices of a symbol and date share a file, so they get persisted after the pool
+    std::map<std::pair<std::string, std::string>, std::list<std::pair<bc::Timestamp, std::string>>> missingChains;
+    std::mutex missingMutex;
+    {
+        bc::VariadicThreadPool pool(nThreads);
+        for (auto& captureFile : captureFiles)
+        {
+            results.push_back(pool.post([&persister, &missingChains, &missingMutex, marketEnvironment, deltaShiftStaleAfter](
+                const std::string& captureFile) -> bool {
+                if (bc::SignalHandler::getSignal() != 0)
+                {
+                    return false;
+                }
+                try {
+                    bc::CbboCapture capture = bc::CbboCapture::load(captureFile);
+                    bc::OptionChain rawChain = capture.buildOptionChain(*marketEnvironment, deltaShiftStaleAfter);
+                    if (!rawChain.isValid())
+                    {
+                        BOOST_LOG_TRIVIAL(warning) << "Missing chain data in capture " << captureFile;
+                        std::lock_guard<std::mutex> lock(missingMutex);
+                        missingChains[{capture.getSymbol(), capture.getValuationDate()}].push_back(
+                            {capture.getRequestTime(), capture.getExpiryDate()});
+                        return false;
+                    }
+                    bc::OptionRecordGapFiller gapFiller(marketEnvironment);
+                    persister->persist(gapFiller.fillGaps(std::move(rawChain)), marketEnvironment);
+                    BOOST_LOG_TRIVIAL(info) << "Reprocessed capture " << captureFile;
+                    return true;
+                } catch (const std::exception& e) {
+                    BOOST_LOG_TRIVIAL(error) << "Failed to reprocess capture " << captureFile << ": " << e.what();
+                }
+                return false;
+            }, captureFile));
+        }
+        pool.join();
+    }
+
+    std::uint64_t nFailed = 0;
+    for (auto& result : results)
+    {
+        nFailed += result.get() ? 0 : 1;
+    }
+    for (auto& missing : missingChains)
+    {
+        try {
+            persister->persistMissing(missing.first.first, missing.first.second, std::move(missing.second));
+        } catch (const std::exception& e) {
+            BOOST_LOG_TRIVIAL(error) << "Failed to persist missing chains of symbol " << missing.first.first
+                << " at " << missing.first.second << ": " << e.what();
+        }
+    }
+    // writes index footers of consolidated files
+    persister.reset();
+    std::cout << "Reprocessed " << captureFiles.size() - nFailed << " of " << captureFiles.size()
+        << " captures" << std::endl;
+    return nFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace bentoclient
+{
+    /// @brief Writes many small files in batches
+    /// @details Streams from the outputter buffer a whole file in memory and hand it over on
+    /// destruction. Pending files get written once a batch is full or on flush: with io_uring,
+    /// all opens of a batch go out in one submission and all writes with linked closes in a
+    /// second one. Without io_uring support in kernel or sandbox, files are written with plain
+    /// open, write and close calls. Parent directories get created once per writer.
+    class BatchFileWriter : public std::enable_shared_from_this<BatchFileWriter>
+    {
+        class Algos;
+        class Ring;
+        class BufferStream;
+    public:
+        /// @brief Same signature as PersisterCSV::Outputter and PersisterBinary::Outputter
+        typedef std::function<std::unique_ptr<std::ostream>(const std::string&)> Outputter;
+        /// @brief A file waiting to be written
+        struct PendingFile
+        {
+            std::string m_path;
+            std::string m_bytes;
+        };
+    public:
+        /// @brief Creates a batch file writer
+        /// @param nBatchFiles Number of pending files triggering a batch write
+        /// @param bIoUring Use io_uring if available, plain file calls otherwise
+        static std::shared_ptr<BatchFileWriter> create(std::size_t nBatchFiles = 64, bool bIoUring = true);
+        BatchFileWriter(const BatchFileWriter&) = delete;
+        BatchFileWriter& operator = (const BatchFileWriter&) = delete;
+        BatchFileWriter(BatchFileWriter&&) = delete;
+        BatchFileWriter& operator = (BatchFileWriter&&) = delete;
+        /// @brief Writes pending files
+        ~BatchFileWriter();
+
+        /// @brief Outputter for persisters, keeping the writer alive
+        Outputter makeOutputter();
+
+        /// @brief Writes all pending files
+        void flush();
+
+        /// @brief True if batches are written with io_uring
+        bool isIoUring() const;
+
+        /// @brief Number of files failing to get written
+        std::uint64_t getFailedCount() const;
+
+    private:
+        BatchFileWriter(std::size_t nBatchFiles, bool bIoUring);
+        /// @brief Takes over a completed file, writing the batch once full
+        void submit(PendingFile&& pendingFile);
+        /// @brief Writes a batch, requires the write lock
+        void write(std::vector<PendingFile>& batch);
+        void createDirectories(const std::vector<PendingFile>& batch);
+    private:
+        const std::size_t m_nBatchFiles;
+        std::unique_ptr<Ring> m_ring;
+        std::vector<PendingFile> m_pending;
+        std::set<std::string> m_knownDirectories;
+        std::uint64_t m_nFailed;
+        mutable std::mutex m_pendingMutex;
+        mutable std::mutex m_writeMutex;
+    };
+}
@@ -0,0 +1,171 @@
+#pragma once
+#include "bentoclient/clienttypes.hpp"
+#include "bentoclient/zstdstream.hpp"
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bentoclient
+{
+    class OptionChain;
+    class MarketEnvironment;
+    /// @brief Compact columnar binary format of option chains
+    /// @details A file holds a fixed size header with chain time, parity rate and
+    /// precision, followed by one typed column per record field over all puts, then all
+    /// calls, each 8 byte aligned, and a table of distinct comments. Files are written
+    /// in native byte order, which the header records.
+    class BinaryChain
+    {
+        class Algos;
+    public:
+        /// @brief Columns in file order
+        enum class Column : std::uint32_t
+        {
+            STRIKE,         // std::uint32_t, strike key digits, i.e. strike in 1/1000
+            BID_PRICE,      // double
+            BID_SIZE,       // std::uint64_t
+            ASK_PRICE,      // double
+            ASK_SIZE,       // std::uint64_t
+            TRADE_PRICE,    // double
+            TRADE_SIZE,     // std::uint64_t
+            TRADE_TIME,     // std::int64_t, ns since epoch
+            RECV_TIME,      // std::int64_t, ns since epoch
+            PROVENANCE,     // std::uint8_t, Provenance flags
+            COMMENT,        // std::uint16_t, index into the comment table
+            COUNT
+        };
+        /// @brief Flags for the gap filling steps that produced a record, taken from its comment
+        enum Provenance : std::uint8_t
+        {
+            PCP_FIT = 1,
+            SPREAD_FIT = 2,
+            LIN_INTERPOL = 4,
+            LOG_EXTRAPOLATE = 8,
+            DELTA_SHIFT = 16,
+            OTHER = 128
+        };
+        /// @brief File header
+        struct Header
+        {
+            char m_magic[4];
+            std::uint32_t m_version;
+            std::uint32_t m_byteOrder;
+            std::uint32_t m_nPuts;
+            std::uint32_t m_nCalls;
+            std::uint32_t m_nComments;
+            std::int64_t m_chainTime;
+            std::int64_t m_expiryTime;
+            double m_parityRate;
+            double m_precision;
+            double m_riskFreeRate;
+            char m_symbol[16];
+            char m_valuationDate[16];
+            char m_expiryDate[16];
+            std::uint64_t m_columnOffsets[static_cast<std::size_t>(Column::COUNT)];
+            std::uint64_t m_commentsOffset;
+            std::uint64_t m_fileSize;
+        };
+        /// @brief Chain level values stored in the header
+        struct Summary
+        {
+            Timestamp m_expiryTime;
+            double m_riskFreeRate;
+            double m_parityRate;
+            double m_precision;
+        };
+        /// @brief Zero-parse reader exposing the columns of a file in memory
+        /// @details Columns are pointers into the file bytes, only the comment table
+        /// gets decoded.
+        class Reader
+        {
+        public:
+            /// @brief Loads a file, decompressing files written through a ZstdStream
+            /// @param path File path
+            /// @param dictionary Dictionary the file was compressed with, if any
+            explicit Reader(const std::string& path, const ZstdStream::Dictionary* dictionary = nullptr);
+            /// @brief Takes over file bytes
+            explicit Reader(std::vector<char>&& bytes);
+            /// @brief Views file bytes owned by the caller, e.g. a memory mapping
+            /// @param data File bytes, 8 byte aligned
+            /// @param size Number of bytes
+            Reader(const char* data, std::size_t size);
+            Reader(const Reader&) = delete;
+            Reader& operator=(const Reader&) = delete;
+            Reader(Reader&&) = default;
+            Reader& operator=(Reader&&) = default;
+            ~Reader() = default;
+
+            const Header& getHeader() const
+            {
+                return *reinterpret_cast<const Header*>(m_data);
+            }
+            /// @brief Number of records, puts first
+            std::size_t getRowCount() const
+            {
+                return getHeader().m_nPuts + getHeader().m_nCalls;
+            }
+            std::string getSymbol() const;
+            std::string getValuationDate() const;
+            std::string getExpiryDate() const;
+            Timestamp getChainTime() const;
+            Timestamp getExpiryTime() const;
+
+            const std::uint32_t* getStrikes() const { return getColumn<std::uint32_t>(Column::STRIKE); }
+            const double* getBidPrices() const { return getColumn<double>(Column::BID_PRICE); }
+            const std::uint64_t* getBidSizes() const { return getColumn<std::uint64_t>(Column::BID_SIZE); }
+            const double* getAskPrices() const { return getColumn<double>(Column::ASK_PRICE); }
+            const std::uint64_t* getAskSizes() const { return getColumn<std::uint64_t>(Column::ASK_SIZE); }
+            const double* getTradePrices() const { return getColumn<double>(Column::TRADE_PRICE); }
+            const std::uint64_t* getTradeSizes() const { return getColumn<std::uint64_t>(Column::TRADE_SIZE); }
+            const std::int64_t* getTradeTimes() const { return getColumn<std::int64_t>(Column::TRADE_TIME); }
+            const std::int64_t* getRecvTimes() const { return getColumn<std::int64_t>(Column::RECV_TIME); }
+            const std::uint8_t* getProvenances() const { return getColumn<std::uint8_t>(Column::PROVENANCE); }
+            /// @brief Comment of a record
+            const std::string& getComment(std::size_t row) const
+            {
+                return m_comments[getColumn<std::uint16_t>(Column::COMMENT)[row]];
+            }
+            /// @brief Strike key of a record
+            std::string getStrikeKey(std::size_t row) const;
+
+            /// @brief Rebuilds the persisted option chain
+            OptionChain toOptionChain() const;
+        private:
+            template <typename T>
+            const T* getColumn(Column column) const
+            {
+                return reinterpret_cast<const T*>(
+                    m_data + getHeader().m_columnOffsets[static_cast<std::size_t>(column)]);
+            }
+            /// @brief Checks header and column bounds, decodes the comment table
+            void validate();
+        private:
+            std::vector<char> m_bytes;
+            const char* m_data;
+            std::size_t m_size;
+            std::vector<std::string> m_comments;
+        };
+    public:
+        /// @brief Derives the summary of a chain, nan for values the chain doesn't allow
+        static Summary makeSummary(const OptionChain& optionChain,
+            const MarketEnvironment& marketEnvironment);
+
+        /// @brief Writes a chain in binary format
+        /// @param ostr Binary output stream
+        /// @param optionChain Chain to write
+        /// @param summary Chain level values for the header
+        static void write(std::ostream& ostr, const OptionChain& optionChain, const Summary& summary);
+
+        /// @brief Provenance flags of a record comment
+        static std::uint8_t getProvenance(const std::string& comment);
+
+    public:
+        static const char m_magic[4];
+        static const std::uint32_t m_version;
+        static const std::uint32_t m_byteOrder;
+        /// @brief File extension of binary chain files
+        static const std::string m_fileExtension;
+    };
+}
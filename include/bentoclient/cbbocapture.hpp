@@ -0,0 +1,114 @@
+#pragma once
+#include "bentoclient/clienttypes.hpp"
+#include "bentoclient/optionchain.hpp"
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+
+namespace bentoclient
+{
+    class MarketEnvironment;
+    /// @brief Raw CBBO data of an option chain request, captured for offline reprocessing
+    /// @details Holds the joined cbbo map of all CBBO schemata a requester fetched for a
+    /// symbol, valuation date and expiry date, along with the instrument ID to OSI ID map
+    /// of the chain. Files hold a fixed size header, then per instrument its IDs and its
+    /// cbbo messages as raw records in native byte order, which the header records.
+    /// Rebuilding chains from captures reruns the CPU part of a request without downloads.
+    class CbboCapture
+    {
+        class Algos;
+    public:
+        /// @brief File header
+        struct Header
+        {
+            char m_magic[4];
+            std::uint32_t m_version;
+            std::uint32_t m_byteOrder;
+            std::uint32_t m_nInstruments;
+            std::int64_t m_requestTime;
+            std::uint64_t m_nCbboMsgs;
+            char m_symbol[16];
+            char m_valuationDate[16];
+            char m_expiryDate[16];
+        };
+    public:
+        /// @brief Captured request data
+        /// @param symbol Underlier symbol
+        /// @param valuationDate yyyy-mm-dd valuation date
+        /// @param expiryDate yyyy-mm-dd expiry date
+        /// @param requestTime Requested chain time
+        /// @param idToOsi Instrument ID to OSI ID map of the chain
+        /// @param cbboMap Joined cbbo messages by instrument ID
+        CbboCapture(const std::string& symbol, const std::string& valuationDate,
+            const std::string& expiryDate, Timestamp requestTime,
+            std::map<std::string, std::string> idToOsi,
+            OptionChain::InstrumentIdToCbboMap cbboMap);
+
+        /// @brief Writes captured request data without copying it
+        static void write(std::ostream& ostr, const std::string& symbol, const std::string& valuationDate,
+            const std::string& expiryDate, Timestamp requestTime,
+            const std::map<std::string, std::string>& idToOsi,
+            const OptionChain::InstrumentIdToCbboMap& cbboMap);
+
+        /// @brief Reads a capture
+        /// @param istr Binary input stream
+        static CbboCapture read(std::istream& istr);
+
+        /// @brief Loads a capture file
+        static CbboCapture load(const std::string& path);
+
+        /// @brief File name of a capture, without directory
+        static std::string makeFileName(const std::string& symbol, const std::string& valuationDate,
+            const std::string& expiryDate, Timestamp requestTime);
+
+        /// @brief Rebuilds the raw option chain like the requester did
+        /// @details Runs buildRecordTimeline, mapLatestBestInTimelineToRecord and OptionChain::build,
+        /// then shifts stale records if enabled. Gap filling is left to OptionRecordGapFiller.
+        /// @param marketEnvironment Market environment for discounting the delta shift path
+        /// @param deltaShiftStaleAfter Delta shift records older than this before chain time, zero disables
+        /// @return The raw chain, check isValid
+        OptionChain buildOptionChain(const MarketEnvironment& marketEnvironment,
+            TimeRange deltaShiftStaleAfter = TimeRange::zero()) const;
+
+        const std::string& getSymbol() const
+        {
+            return m_symbol;
+        }
+        const std::string& getValuationDate() const
+        {
+            return m_valuationDate;
+        }
+        const std::string& getExpiryDate() const
+        {
+            return m_expiryDate;
+        }
+        Timestamp getRequestTime() const
+        {
+            return m_requestTime;
+        }
+        const std::map<std::string, std::string>& getInstrumentIdToOsiMap() const
+        {
+            return m_idToOsi;
+        }
+        const OptionChain::InstrumentIdToCbboMap& getCbboMap() const
+        {
+            return m_cbboMap;
+        }
+
+    public:
+        static const char m_magic[4];
+        static const std::uint32_t m_version;
+        static const std::uint32_t m_byteOrder;
+        /// @brief File extension of capture files
+        static const std::string m_fileExtension;
+    private:
+        std::string m_symbol;
+        std::string m_valuationDate;
+        std::string m_expiryDate;
+        Timestamp m_requestTime;
+        std::map<std::string, std::string> m_idToOsi;
+        OptionChain::InstrumentIdToCbboMap m_cbboMap;
+    };
+}
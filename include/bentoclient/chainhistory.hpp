@@ -0,0 +1,92 @@
+#pragma once
+#include "bentoclient/clienttypes.hpp"
+#include <cstdint>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bentoclient
+{
+    class OptionChain;
+    /// @brief Compact in-memory history of option chains by symbol, expiry and chain time
+    /// @details Holds full days of intraday chains at a fraction of the memory of OptionChain
+    /// record maps. All snapshots of a symbol and expiry share one table of strike keys and
+    /// one of comments. Each snapshot is a separately encoded byte string of its records
+    /// in strike order, puts first: strike table indices, fixed-point prices in ticks of
+    /// the largest power of 10 common to the snapshot, and timestamps relative to chain
+    /// time, all as variable length integers. Snapshots decode to records equal to the
+    /// appended ones, and single snapshots decode without touching others. Missing
+    /// instrument maps of chains are not kept, like with BinaryChain.
+    class ChainHistory
+    {
+        class Algos;
+    public:
+        ChainHistory();
+        ChainHistory(const ChainHistory&) = delete;
+        ChainHistory& operator = (const ChainHistory&) = delete;
+        ~ChainHistory();
+
+        /// @brief Encodes and adds a chain, replacing a chain with the same key
+        /// @param optionChain Chain to add, keyed by underlier, expiry date and chain time
+        void append(const OptionChain& optionChain);
+
+        /// @brief Finds the chain time closest to {dateTime}
+        /// @param symbol Underlier symbol
+        /// @param dateTime Requested chain time
+        /// @param expiryDate Expiry date of the chain
+        /// @param timeRange Maximum distance of chain time from {dateTime}
+        /// @param chainTime Set to the chain time if found
+        /// @return True if a chain is in range
+        bool find(const std::string& symbol, Timestamp dateTime, const std::string& expiryDate,
+            TimeRange timeRange, Timestamp& chainTime) const;
+
+        /// @brief Decodes a single snapshot
+        /// @param symbol Underlier symbol
+        /// @param expiryDate Expiry date of the chain
+        /// @param chainTime Chain time as returned from find or getChainTimes
+        /// @return The chain as appended, or throws std::out_of_range if missing
+        OptionChain get(const std::string& symbol, const std::string& expiryDate,
+            Timestamp chainTime) const;
+
+        /// @brief Chain times of all snapshots of a symbol and expiry date, in order
+        std::vector<Timestamp> getChainTimes(const std::string& symbol,
+            const std::string& expiryDate) const;
+
+        /// @brief Number of snapshots held
+        std::size_t size() const;
+
+        /// @brief Approximate number of bytes held by snapshots and shared tables
+        std::size_t getMemoryUsage() const;
+
+    private:
+        /// @brief An encoded chain
+        struct Snapshot
+        {
+            std::string m_valuationDate;
+            std::uint64_t m_tickUnit;
+            std::uint32_t m_nPuts;
+            std::uint32_t m_nCalls;
+            std::vector<std::uint8_t> m_bytes;
+        };
+        /// @brief Snapshots of a symbol and expiry date with their shared tables
+        struct Series
+        {
+            std::vector<std::string> m_strikeKeys;
+            std::unordered_map<std::string, std::uint32_t> m_strikeIndices;
+            std::vector<std::string> m_comments;
+            std::unordered_map<std::string, std::uint32_t> m_commentIndices;
+            std::map<Timestamp, Snapshot> m_snapshots;
+        };
+        typedef std::map<std::string, Series> ExpiryToSeriesMap;
+        typedef std::map<std::string, ExpiryToSeriesMap> SymbolToExpiryMap;
+    private:
+        /// @brief Series of a symbol and expiry date, or nullptr, requires a lock
+        const Series* findSeries(const std::string& symbol, const std::string& expiryDate) const;
+    private:
+        SymbolToExpiryMap m_series;
+        std::size_t m_nSnapshots;
+        mutable std::shared_mutex m_mutex;
+    };
+}
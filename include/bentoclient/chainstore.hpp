@@ -0,0 +1,116 @@
+#pragma once
+#include "bentoclient/clienttypes.hpp"
+#include "bentoclient/binarychain.hpp"
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+
+namespace bentoclient
+{
+    class OptionChain;
+    /// @brief Persistent store of option chains with random access by symbol, expiry and time
+    /// @details The store is a directory holding an append-only data file of BinaryChain
+    /// records, each 8 byte aligned, and an append-only index of fixed size entries with
+    /// the key and location of every record. Opening a store loads the index into maps keyed
+    /// like the in-memory retriever, symbol to expiry date to chain time, and memory-maps the
+    /// data file, so lookups are O(log n) and chains are read without parsing. Data gets
+    /// written before its index entry, a torn index entry at the end is ignored, and so are
+    /// entries pointing past the end of the data file after a crash. Writers
+    /// of several stores on one directory, also across processes, append in turns under
+    /// an advisory lock on the index file.
+    class ChainStore
+    {
+        class Algos;
+    public:
+        /// @brief Location of a chain in the data file
+        struct Location
+        {
+            std::uint64_t m_offset;
+            std::uint64_t m_size;
+        };
+        typedef std::map<Timestamp, Location> TimeToLocationMap;
+        typedef std::map<std::string, TimeToLocationMap> ExpiryToLocationsMap;
+        typedef std::map<std::string, ExpiryToLocationsMap> SymbolToExpiryMap;
+        /// @brief Index file entry
+        struct IndexEntry
+        {
+            char m_symbol[16];
+            char m_expiryDate[16];
+            std::int64_t m_chainTime;
+            std::uint64_t m_offset;
+            std::uint64_t m_size;
+        };
+    public:
+        /// @brief Opens a store, creating its directory and files if needed
+        /// @param basePath Store directory
+        explicit ChainStore(const std::string& basePath);
+        ChainStore(const ChainStore&) = delete;
+        ChainStore& operator = (const ChainStore&) = delete;
+        ChainStore(ChainStore&&) = delete;
+        ChainStore& operator = (ChainStore&&) = delete;
+        ~ChainStore();
+
+        /// @brief Appends a chain, replacing lookups of a chain with the same key
+        /// @param optionChain Chain to store
+        /// @param summary Chain level values, see BinaryChain::makeSummary
+        void append(const OptionChain& optionChain, const BinaryChain::Summary& summary);
+
+        /// @brief Finds the chain closest to {dateTime}
+        /// @param symbol Underlier symbol
+        /// @param dateTime Requested chain time
+        /// @param expiryDate Expiry date of the chain
+        /// @param timeRange Maximum distance of chain time from {dateTime}
+        /// @param location Set to the chain location if found
+        /// @return True if a chain is in range
+        bool find(const std::string& symbol, Timestamp dateTime, const std::string& expiryDate,
+            TimeRange timeRange, Location& location);
+
+        /// @brief Reads a chain from the mapped data file
+        /// @param location Location as returned from find
+        /// @return The stored option chain
+        OptionChain read(const Location& location);
+
+        /// @brief Loads index entries appended by other writers since the last load
+        void refresh();
+
+        /// @brief Number of chains in the index
+        std::size_t size() const;
+
+        /// @brief Store directory
+        const std::string& getBasePath() const
+        {
+            return m_basePath;
+        }
+
+        /// @brief Data file name within the store directory
+        static const std::string m_dataFileName;
+        /// @brief Index file name within the store directory
+        static const std::string m_indexFileName;
+    private:
+        /// @brief Loads index entries from {m_indexSize} on, requires the exclusive lock
+        void loadIndex();
+        /// @brief Adds or replaces a chain location, requires the exclusive lock
+        void insertLocation(const std::string& symbol, const std::string& expiryDate,
+            Timestamp chainTime, const Location& location);
+        /// @brief Maps at least {size} bytes of the data file, requires the exclusive lock
+        void mapData(std::uint64_t size);
+        void unmapData();
+    private:
+        const std::string m_basePath;
+        const std::string m_dataPath;
+        const std::string m_indexPath;
+        std::ofstream m_dataStream;
+        std::ofstream m_indexStream;
+        std::uint64_t m_dataSize;
+        std::uint64_t m_indexSize;
+        SymbolToExpiryMap m_locations;
+        std::size_t m_nChains;
+        int m_indexLockFd;
+        const char* m_mapping;
+        std::uint64_t m_mappingSize;
+        mutable std::shared_mutex m_mutex;
+    };
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include "bentoclient/clienttypes.hpp"
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace bentoclient
+{
+    /// @brief File of all option chains of a symbol and valuation date with an offset index footer
+    /// @details Chains get appended as sections, CSV text or BinaryChain files, followed
+    /// by a footer listing expiry date, chain time, offset and size of every section, and a
+    /// fixed size trailer locating the footer. Readers load the footer and seek to single
+    /// chains directly. A file missing its footer, e.g. after a crash, gets its index rebuilt
+    /// by scanning the sections: CSV sections are preceded by a marker line
+    /// "#chain,{expiryDate},{chainTime ns},{size}", binary sections are 8 byte aligned
+    /// BinaryChain files, whose headers carry the same keys.
+    class ConsolidatedFile
+    {
+        class Algos;
+    public:
+        enum class Flavour : int
+        {
+            CSV,
+            Binary
+        };
+        /// @brief Location of a section in the file
+        struct Location
+        {
+            std::uint64_t m_offset;
+            std::uint64_t m_size;
+        };
+        /// @brief Index entry of a section
+        struct Entry
+        {
+            std::string m_expiryDate;
+            Timestamp m_chainTime;
+            Location m_location;
+        };
+        typedef std::map<Timestamp, Location> TimeToLocationMap;
+        typedef std::map<std::string, TimeToLocationMap> ExpiryToLocationsMap;
+
+        /// @brief Appends sections to a new or existing file, writing the footer on finish
+        /// @details Reopening a file keeps its sections and appends after them. Only one
+        /// writer may have a file open at a time.
+        class Writer
+        {
+        public:
+            /// @brief Opens or creates {path}, creating its directory if needed
+            /// @param path File path
+            /// @param flavour Section format, must match an existing file
+            Writer(const std::string& path, Flavour flavour);
+            Writer(const Writer&) = delete;
+            Writer& operator = (const Writer&) = delete;
+            /// @brief Finishes the file, errors get logged
+            ~Writer();
+
+            /// @brief Appends a section
+            /// @param expiryDate Expiry date of the chain
+            /// @param chainTime Chain time
+            /// @param section CSV text or BinaryChain file bytes
+            void append(const std::string& expiryDate, Timestamp chainTime, const std::string& section);
+
+            /// @brief Writes the footer and closes the file, further appends reopen it
+            void finish();
+
+            const std::string& getPath() const
+            {
+                return m_path;
+            }
+            /// @brief Number of sections in the file
+            std::size_t size() const
+            {
+                return m_entries.size();
+            }
+        private:
+            void open();
+        private:
+            const std::string m_path;
+            const Flavour m_flavour;
+            std::ofstream m_ostr;
+            std::vector<Entry> m_entries;
+            std::uint64_t m_dataSize;
+        };
+    public:
+        /// @brief Opens a file for reading and loads its index
+        /// @param path File path, the flavour follows from its extension
+        explicit ConsolidatedFile(const std::string& path);
+
+        /// @brief Finds the section of the chain closest to {dateTime}
+        /// @param expiryDate Expiry date of the chain
+        /// @param dateTime Requested chain time
+        /// @param timeRange Maximum distance of chain time from {dateTime}
+        /// @param location Set to the section location if found
+        /// @return True if a chain is in range
+        bool find(const std::string& expiryDate, Timestamp dateTime, TimeRange timeRange,
+            Location& location) const;
+
+        /// @brief Reads a section
+        /// @param location Location as returned from find or getLocations
+        /// @return CSV text or BinaryChain file bytes
+        std::string read(const Location& location);
+
+        /// @brief Section locations by expiry date and chain time
+        const ExpiryToLocationsMap& getLocations() const
+        {
+            return m_locations;
+        }
+        Flavour getFlavour() const
+        {
+            return m_flavour;
+        }
+        /// @brief True if the index was loaded from the footer rather than rebuilt
+        bool hasFooter() const
+        {
+            return m_bFooter;
+        }
+
+        /// @brief Flavour of a file path, Binary for m_binaryFileExtension
+        static Flavour getFlavour(const std::string& path);
+
+        /// @brief File extension of CSV flavour files
+        static const std::string m_csvFileExtension;
+        /// @brief File extension of binary flavour files
+        static const std::string m_binaryFileExtension;
+    private:
+        const std::string m_path;
+        const Flavour m_flavour;
+        std::ifstream m_istr;
+        ExpiryToLocationsMap m_locations;
+        bool m_bFooter;
+    };
+}
@@ -1,7 +1,9 @@
 #pragma once
 #include "bentoclient/marketenvironment.hpp"
+#include "bentoclient/optionanalytics.hpp"
 #include <list>
 #include <memory>
+#include <vector>
 
 
 namespace bentoclient
@@ -9,6 +11,8 @@ namespace bentoclient
     class OptionChain;
     class MarketEnvironment;
     /// @brief Converts an option chain's record data to CSV
+    /// @details Rows are streamed from the chain's record maps through a buffer,
+    /// the column layouts are fixed at compile time.
     class CSVFromOptionChain
     {
         class Algos;
@@ -35,14 +39,21 @@ namespace bentoclient
             static const std::string m_askSize;
             static const std::string m_precision;
             static const std::string m_comment;
+            static const std::string m_impliedVolatility;
+            static const std::string m_delta;
+            static const std::string m_gamma;
+            static const std::string m_vega;
+            static const std::string m_theta;
             // column name prefixes
             static const std::string m_prefix_call_stacked;
             static const std::string m_prefix_put_stacked;
 
             /// @brief derives a list of columns for side by side display of puts and calls
-            static std::list<std::string> getSideBySideCols();
+            static std::list<std::string> getSideBySideCols(bool bGreeks = false);
             /// @brief derives a list of columns for stacked display of puts and calls
-            static std::list<std::string> getStackedCols();
+            static std::list<std::string> getStackedCols(bool bGreeks = false);
+            /// @brief implied volatility and Greeks columns appended with analytics enabled
+            static std::list<std::string> getGreeksCols();
 
             /// @brief capitalizes the first letter of header columns
             static std::list<std::string> capitalizeFirst(const std::list<std::string>& cols);
@@ -62,7 +73,9 @@ namespace bentoclient
         CSVFromOptionChain() = delete;
         /// @brief Constructs CSV converter with put-call-parity computation parameters
         /// @param marketEnvironment The market environment for put-call-parity
-        CSVFromOptionChain(std::shared_ptr<MarketEnvironment> marketEnvironment);
+        /// @param bGreeks Append implied volatility and Greeks columns
+        CSVFromOptionChain(std::shared_ptr<MarketEnvironment> marketEnvironment,
+            bool bGreeks = false);
         ~CSVFromOptionChain() = default;
 
         /// @brief Writes a side by side CSV representation of an option chain to output stream
@@ -78,8 +91,12 @@ namespace bentoclient
         double getPcpRate(const OptionChain& optionChain) const;
         /// @brief computes the precision column estimating the variability in put-call-parity across records
         double computePrecision(const OptionChain& optionChain) const;
+        /// @brief computes implied volatilities and Greeks, empty if the chain doesn't allow it
+        OptionAnalytics::PutCallGreeksMap computeGreeks(const OptionChain& optionChain) const;
     private:
         /// @brief Market environment for put-call-parity
         std::shared_ptr<MarketEnvironment> m_marketEnvironment;
+        /// @brief Append implied volatility and Greeks columns
+        bool m_bGreeks;
     };
 }
\ No newline at end of file
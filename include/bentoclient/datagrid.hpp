@@ -244,18 +244,30 @@ namespace bentoclient
 
         /// @brief TimestampFormatSeconds formats a timestamp in seconds without fractional
         /// seconds. It is used for formatting timestamps and shifts in local timezones.
+        /// @details The default timestamp, date and time formats are written by integer
+        /// conversions, other formats by fmtlib.
         class TimestampFormatSeconds : public TimestampFormat
         {
+            /// @brief Formats with integer conversion
+            enum class CivilFormat : int
+            {
+                NONE,
+                TIMESTAMP,
+                DATE,
+                TIME
+            };
         public:
             TimestampFormatSeconds() :
                 TimestampFormat(),
-                m_timeZone(DateUtils::Timezone::m_UTC)
+                m_timeZone(DateUtils::Timezone::m_UTC),
+                m_civilFormat(getCivilFormat(m_fmt))
             {}
             TimestampFormatSeconds(const std::string& fmt, 
                 const std::string& timeZone = DateUtils::Timezone::m_UTC,
                 const std::string& defaultNull = m_defaultNull) :
                 TimestampFormat(fmt, defaultNull),
-                m_timeZone(timeZone)
+                m_timeZone(timeZone),
+                m_civilFormat(getCivilFormat(m_fmt))
             {}
             TimestampFormatSeconds(const TimestampFormatSeconds&) = delete;
             TimestampFormatSeconds& operator=(const TimestampFormatSeconds&) = delete;
@@ -264,8 +276,11 @@ namespace bentoclient
             ~TimestampFormatSeconds() override = default;
 
             std::string formatCell(const Cell& cell) const override;
+        private:
+            static CivilFormat getCivilFormat(const std::string& fmt);
         private:
             std::string m_timeZone;
+            CivilFormat m_civilFormat;
         };
         /// @brief Header definition with name and data format
         class Header
@@ -48,6 +48,26 @@ namespace bentoclient
             const std::string& tz = Timezone::m_NYC);
         /// @brief output a nanoseconds timestring without fractional seconds
         static std::string timestampToStringIntSeconds(const Timestamp& timestamp);
+        /// @brief Calendar date and time of day of a timestamp, in whole seconds
+        struct CivilTime
+        {
+            int m_year;
+            unsigned m_month;
+            unsigned m_day;
+            unsigned m_hour;
+            unsigned m_minute;
+            unsigned m_second;
+        };
+        /// @brief Integer conversion of a timestamp to calendar date and time of day
+        /// @details No time zone shifts, fractional seconds get truncated
+        static CivilTime toCivilTime(const Timestamp& timestamp);
+        /// @brief Writes a civil time as yyyy-mm-dd, HH:MM:SS, or yyyy-mm-dd HH:MM:SS
+        /// @param buffer Output buffer of at least 19 characters, not null terminated
+        /// @param civilTime Civil time to write
+        /// @param bDate Write the date part
+        /// @param bTime Write the time of day part
+        /// @return Number of characters written, 0 for years out of four digit range
+        static std::size_t writeCivilTime(char* buffer, const CivilTime& civilTime, bool bDate, bool bTime);
         /// @brief Recognized time zones (not even all of the americas)
         struct Timezone
         {
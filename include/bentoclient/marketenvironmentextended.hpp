@@ -1,16 +1,21 @@
 #pragma once
 
 #include "bentoclient/marketenvironment.hpp"
+#include <cstdint>
 #include <map>
 #include <mutex>
+#include <vector>
 
 namespace bentoclient
 {
     /// @brief A market environment reading a yield curve from CSV
     /// @details Extended market environments must remain immutable as 
     /// they are shared across threads without synchronization.
+    /// At load time, each curve date gets a monotone cubic interpolation of continuously
+    /// compounded rates, tabulated over a daily tenor grid, so rate lookups don't search maps.
     class MarketEnvironmentExtended : public MarketEnvironment
     {
+        class Algos;
     public:
         /// @brief Map with yield curve entries as value_type. Though yield curves
         /// are in tenors, the mapped_type has Timestamps of maturity for faster lookup
@@ -23,13 +28,29 @@ namespace bentoclient
         /// @param fDefaultRiskFreeRate The default risk free rate, if yield curve can't be read
         /// @param exchangeClose Information on the exchange for the underlier
         /// @param yieldCurveCsv Pathname for a yield curve CSV file
+        /// @param cacheDirectory Directory for a binary cache of the parsed yield curves, read
+        /// instead of the CSV file if it's not older, else written after parsing. Empty disables caching
         MarketEnvironmentExtended(double fDefaultRiskFreeRate,
             const DateUtils::ExchangeClose& exchangeClose,
-            const std::string& yieldCurveCsv);
+            const std::string& yieldCurveCsv,
+            const std::string& cacheDirectory = std::string());
         ~MarketEnvironmentExtended() override;
 
+        /// @brief Continuously compounded rate interpolated on the yield curve closest to valuation time
         double getRiskFreeRate(Timestamp valuationTime, Timestamp expiryTime) const override;
 
+        /// @brief Path of the binary cache for {yieldCurveCsv} in {cacheDirectory}
+        /// @details The file name has a hash of the absolute CSV path, so same named
+        /// CSV files of different directories don't share a cache
+        static std::string getCachePath(const std::string& yieldCurveCsv,
+            const std::string& cacheDirectory);
+
+        /// @brief The yield curves as read from CSV or cache
+        const YieldCurveMap& getYieldCurveMap() const
+        {
+            return m_yieldCurveMap;
+        }
+
         /// @brief Finds the key for the record next in time to requested time {at}
         /// @tparam T Mapped type
         /// @param at Requested time
@@ -70,8 +91,37 @@ namespace bentoclient
             }
         }
     private:
+        /// @brief Monotone interpolation of a single yield curve, and its tenor grid tables
+        struct InterpolatedCurve
+        {
+            /// @brief Knot tenors in years, ascending
+            std::vector<double> m_tenors;
+            /// @brief Continuously compounded rates at knots
+            std::vector<double> m_rates;
+            /// @brief Hermite slopes at knots, limited to preserve monotonicity
+            std::vector<double> m_slopes;
+            /// @brief Rates by tenor day
+            std::vector<double> m_gridRates;
+        };
         static YieldCurveMap readYieldCurveCsv(const std::string& filename);
+        static YieldCurveMap readYieldCurve(const std::string& filename, const std::string& cacheDirectory);
+        static YieldCurveMap readYieldCurveCache(const std::string& filename);
+        static void writeYieldCurveCache(const std::string& filename, const YieldCurveMap& yieldCurveMap);
+        /// @brief Selects the interpolated curve closest to {valuationTime}
+        const InterpolatedCurve& getCurve(Timestamp valuationTime) const;
+        /// @brief Years from {valuationTime} to {expiryTime}, throws if not positive
+        static double getTenorYears(Timestamp valuationTime, Timestamp expiryTime);
     private:
         const YieldCurveMap m_yieldCurveMap;
+        /// @brief Interpolated curves in curve date order
+        std::vector<InterpolatedCurve> m_curves;
+        /// @brief Index into m_curves for half day slots from the first curve date
+        std::vector<std::uint32_t> m_slotToCurve;
+        Timestamp m_firstCurveTime;
+    public:
+        /// @brief Number of days in tenor grid tables, longer tenors are interpolated on lookup
+        static const std::size_t m_nGridDays;
+        /// @brief Extension appended to the yield curve CSV pathname for the binary cache
+        static const std::string m_cacheExtension;
     };
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+#include "bentoclient/marketenvironment.hpp"
+#include <map>
+#include <memory>
+#include <string>
+
+namespace bentoclient
+{
+    class OptionChain;
+    /// @brief Black-Scholes implied volatilities and Greeks for all strikes of an option chain
+    /// @details Options are valued on the underlier price consistent with put-call-parity
+    /// (OptionChain::getParityRate) and the risk free rate of the market environment.
+    /// The batch kernels work on contiguous arrays: a rational approximation provides initial
+    /// volatilities, followed by a fixed number of Newton steps for all strikes at once.
+    class OptionAnalytics
+    {
+        class Algos;
+    public:
+        /// @brief Implied volatility and Greeks of a single option
+        struct Greeks
+        {
+            Greeks();
+            Greeks(double impliedVolatility, double delta, double gamma, double vega, double theta) :
+            m_impliedVolatility(impliedVolatility),
+            m_delta(delta),
+            m_gamma(gamma),
+            m_vega(vega),
+            m_theta(theta)
+            {}
+            /// @brief Annualized implied volatility
+            double m_impliedVolatility;
+            /// @brief Price change per unit change of underlier
+            double m_delta;
+            /// @brief Delta change per unit change of underlier
+            double m_gamma;
+            /// @brief Price change per volatility percentage point
+            double m_vega;
+            /// @brief Price change per calendar day
+            double m_theta;
+        };
+        /// @brief strike key to Greeks
+        typedef std::map<std::string, Greeks> GreeksMap;
+        /// @brief Put/call combination of Greeks maps
+        typedef std::pair<GreeksMap, GreeksMap> PutCallGreeksMap;
+        /// @brief Valuation parameters shared by all strikes of a chain
+        struct Parameters
+        {
+            /// @brief Underlier price consistent with put-call-parity
+            double m_underlierPrice;
+            /// @brief Continuously compounded risk free rate
+            double m_riskFreeRate;
+            /// @brief Time to expiry in years
+            double m_years;
+        };
+    public:
+        /// @brief Constructs analytics for the risk free rates and exchange of a market environment
+        /// @param marketEnvironment Market environment of the option chains' underlier
+        OptionAnalytics(std::shared_ptr<MarketEnvironment> marketEnvironment);
+        OptionAnalytics() = delete;
+        OptionAnalytics(const OptionAnalytics&) = default;
+        OptionAnalytics& operator = (const OptionAnalytics&) = default;
+        OptionAnalytics(OptionAnalytics&&) = default;
+        OptionAnalytics& operator = (OptionAnalytics&&) = default;
+        ~OptionAnalytics() = default;
+
+        /// @brief Derives valuation parameters for an option chain
+        /// @param optionChain Gap filled option chain
+        /// @return Parameters, or throws if no parity rate is available or the chain expired
+        Parameters getParameters(const OptionChain& optionChain) const;
+
+        /// @brief Computes implied volatility and Greeks for all records with valid bid and ask
+        /// @param optionChain Gap filled option chain
+        /// @return Put and call Greeks by strike key, nan values where no volatility is implied
+        PutCallGreeksMap compute(const OptionChain& optionChain) const;
+
+        /// @brief Batch implied volatility solver
+        /// @param parameters Valuation parameters
+        /// @param strikes Strike prices
+        /// @param prices Option prices
+        /// @param bCall True for calls, false for puts
+        /// @param volatilities Output array for n implied volatilities, nan if prices are out of bounds
+        /// @param n Number of options
+        static void impliedVolatilities(const Parameters& parameters, const double* strikes,
+            const double* prices, bool bCall, double* volatilities, std::size_t n);
+
+        /// @brief Batch Greeks computation
+        /// @param parameters Valuation parameters
+        /// @param strikes Strike prices
+        /// @param volatilities Implied volatilities
+        /// @param bCall True for calls, false for puts
+        /// @param greeks Output array for n Greeks
+        /// @param n Number of options
+        static void computeGreeks(const Parameters& parameters, const double* strikes,
+            const double* volatilities, bool bCall, Greeks* greeks, std::size_t n);
+
+        /// @brief Black-Scholes price of a European option
+        static double price(const Parameters& parameters, double strike, double volatility, bool bCall);
+
+    public:
+        /// @brief Number of Newton steps polishing the rational approximation
+        static const int m_nNewtonSteps;
+    private:
+        std::shared_ptr<MarketEnvironment> m_marketEnvironment;
+    };
+}
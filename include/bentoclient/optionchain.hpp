@@ -1,14 +1,24 @@
 #pragma once
 
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <list>
+#include <vector>
 #include <databento/record.hpp>
 #include <tuple>
+#include <type_traits>
 #include "bentoclient/dateutils.hpp"
 
 namespace bentoclient {
 
+class MarketEnvironment;
 class OptionInstruments;
 class OsiOption;
 class OptionRecordGapFiller;
@@ -22,24 +32,58 @@ class OptionChain {
     friend class OptionRecordGapFiller;
 public:
     typedef std::map<std::string, std::list<databento::CbboMsg>> InstrumentIdToCbboMap;
-    /// @brief PriceWeight behaves like a tuple, but offers an operator ==
-    /// taking into account possible nan or undefined values, which are irrelevant
-    /// due to their weight() == 0.
-    struct PriceWeight : public std::tuple<double, uint64_t> {
-        // avoid redefining constructors
-        using std::tuple<double, uint64_t>::tuple;
+    /// @brief PriceWeight behaves like a tuple of a fixed-point price and its weight
+    /// @details Prices are databento's native int64 in units of 1 / m_priceScaling, so
+    /// records from CBBO messages take them over without conversion and compare exactly.
+    /// price() converts to double for numeric kernels and output, setPrice() and fromPrice()
+    /// round computed prices back to fixed-point. The operator == ignores prices of
+    /// PriceWeights with weight() == 0, which are irrelevant.
+    struct PriceWeight : public std::tuple<std::int64_t, uint64_t> {
+        /// @brief Fixed-point units per price unit, as of databento
+        static constexpr std::uint64_t m_priceScaling = 1000000000;
+        /// @brief Undefined fixed-point price, as databento::kUndefPrice
+        static constexpr std::int64_t m_undefinedPrice = std::numeric_limits<std::int64_t>::max();
+
+        PriceWeight() : std::tuple<std::int64_t, uint64_t>(m_undefinedPrice, 0) {}
+        PriceWeight(std::int64_t fixedPrice, uint64_t weight) :
+            std::tuple<std::int64_t, uint64_t>(fixedPrice, weight) {}
+        /// @brief Floating point prices need to go through fromPrice
+        template <typename T, typename = std::enable_if_t<std::is_floating_point_v<T>>>
+        PriceWeight(T price, uint64_t weight) = delete;
+        /// @brief Rounds {price} to fixed-point, undefined if not representable
+        static PriceWeight fromPrice(double price, uint64_t weight) {
+            return PriceWeight(toFixedPrice(price), weight);
+        }
+        static std::int64_t toFixedPrice(double price) {
+            double scaled = price * m_priceScaling;
+            // also false for nan
+            if (!(std::fabs(scaled) < 9.0e18)) {
+                return m_undefinedPrice;
+            }
+            return std::llround(scaled);
+        }
         // named accessors
-        double& price() { return std::get<0>(*this); }
+        std::int64_t& fixedPrice() { return std::get<0>(*this); }
         uint64_t& weight() { return std::get<1>(*this); }
-        const double& price() const { return std::get<0>(*this); }
+        const std::int64_t& fixedPrice() const { return std::get<0>(*this); }
         const uint64_t& weight() const { return std::get<1>(*this); }
+        /// @brief Price as double, nan if undefined
+        double price() const {
+            if (fixedPrice() == m_undefinedPrice) {
+                return std::nan("0xbad");
+            }
+            return static_cast<double>(fixedPrice()) / m_priceScaling;
+        }
+        void setPrice(double price) {
+            fixedPrice() = toFixedPrice(price);
+        }
         // custom operator not conflicting with other overloads for tuples
         bool operator==(const PriceWeight& other) const {
-            // for empty PriceWeights possibly having nan as a value,
-            // only compare weights
-            return (weight() == 0 && other.weight() == 0)
-                || (weight() == other.weight()
-                    && price() == other.price());
+            return weight() == other.weight()
+                && (weight() == 0 || fixedPrice() == other.fixedPrice());
+        }
+        bool operator!=(const PriceWeight& other) const {
+            return !(*this == other);
         }
     };    
     /// @brief Record is a handy subset of CbboMsg
@@ -63,7 +107,7 @@ public:
             {
                 return std::nan("0xbad");
             }
-            return std::get<0>(m_bidPrice);
+            return m_bidPrice.price();
         }
 
         double getAskPrice() const
@@ -72,7 +116,7 @@ public:
             {
                 return std::nan("0xbad");
             }
-            return std::get<0>(m_askPrice);
+            return m_askPrice.price();
         }
 
         double getMidPrice() const
@@ -98,8 +142,7 @@ public:
 
         double getSpread() const
         {
-            return std::get<0>(m_askPrice) -
-                std::get<0>(m_bidPrice);
+            return m_askPrice.price() - m_bidPrice.price();
         }
 
         double getTradePrice() const
@@ -108,7 +151,7 @@ public:
             {
                 return std::nan("0xbad");
             }
-            return std::get<0>(m_price);
+            return m_price.price();
         }
 
         Timestamp getTradeTime() const
@@ -148,6 +191,64 @@ public:
     typedef std::pair<RecordMap, RecordMap> PutCallRecordMap;
     /// @brief Timeline maps record time slots to pairs of put and call records
     typedef std::map<Timestamp, PutCallRecordMap> RecordTimeline;
+    /// @brief Put-call-parity implied underlier prices by timeline slot
+    typedef std::map<Timestamp, double> UnderlierPath;
+private:
+    /// @brief Record map storage that derived chains share copy-on-write with their source
+    /// @details Copies are deep, keeping OptionChain a value type. Only share() hands out
+    /// storage referencing the same records; mutate() detaches before the first write.
+    class SharedRecordMap {
+    public:
+        SharedRecordMap() = default;
+        SharedRecordMap(RecordMap&& recordMap);
+        SharedRecordMap(const SharedRecordMap& other);
+        SharedRecordMap& operator=(const SharedRecordMap& other);
+        SharedRecordMap(SharedRecordMap&&) = default;
+        SharedRecordMap& operator=(SharedRecordMap&&) = default;
+        ~SharedRecordMap() = default;
+
+        /// @brief Read access to the records, possibly shared with other chains
+        const RecordMap& get() const {
+            return m_recordMap ? *m_recordMap : m_emptyRecordMap;
+        }
+        /// @brief Write access to the records, detaching from any sharing chain first
+        RecordMap& mutate();
+        /// @brief Storage referencing the same records until either side mutates
+        SharedRecordMap share() const;
+        /// @brief Stamp identifying the record contents, renewed on every mutate()
+        std::uint64_t getVersion() const {
+            return m_version;
+        }
+    private:
+        std::shared_ptr<RecordMap> m_recordMap;
+        std::uint64_t m_version{};
+        static const RecordMap m_emptyRecordMap;
+        static std::atomic<std::uint64_t> m_versionCounter;
+    };
+    /// @brief Metrics derived from the records, memoized while the record maps are unchanged
+    /// @details Guarded by a mutex as chains are shared across threads as immutable handles.
+    /// Copies start empty, moves take over the memoized values.
+    class MetricsCache {
+    public:
+        /// @brief Risk free rate and exchange close the parity metrics were computed for
+        typedef std::tuple<double, int, int, std::string> ParityKey;
+        MetricsCache() = default;
+        MetricsCache(const MetricsCache&);
+        MetricsCache& operator=(const MetricsCache&);
+        MetricsCache(MetricsCache&& other);
+        MetricsCache& operator=(MetricsCache&& other);
+        ~MetricsCache() = default;
+
+        /// @brief Drops memoized values computed for other record versions, call with m_mutex held
+        void validate(std::uint64_t putsVersion, std::uint64_t callsVersion);
+
+        std::mutex m_mutex;
+        std::uint64_t m_putsVersion{};
+        std::uint64_t m_callsVersion{};
+        std::optional<Timestamp> m_chainTime;
+        std::map<ParityKey, double> m_parityRates;
+        std::map<ParityKey, double> m_parityRateQualityScores;
+    };
 public:
     OptionChain() = default;
     // Deleted copy constructor and assignment operator
@@ -170,12 +271,20 @@ public:
     /// @brief Record timeline maps time slots to available strike keys with data
     static RecordTimeline buildRecordTimeline(const InstrumentIdToCbboMap& cbboMap,
         const std::map<std::string, std::string>& idToOsi,
-        TimeRange slotWindow);
+        TimeRange slotWindow = m_slotWindow);
 
     /// @brief Revert the timeline back to RecordMaps having just the latest and best data
     static PutCallRecordMap mapLatestBestInTimelineToRecord(
         const RecordTimeline& timeline);
 
+    /// @brief Estimates the underlier price for timeline slots from put-call-parity
+    /// @details Each slot with enough put/call pairs of valid bid and ask at matching strikes
+    /// gets the median of their parity rates. Slots with fewer pairs are left out.
+    /// @param timeline Record timeline
+    /// @param fDiscountFactor Discount factor of strikes, taken constant along the timeline
+    static UnderlierPath estimateUnderlierPath(const RecordTimeline& timeline,
+        double fDiscountFactor);
+
     /// @brief Find instrument IDs without mapped cbbo messages
     /// @details Called for cbbo 1s data to find instruments for a 
     /// secondary cbbo 1m query to reduce data gaps
@@ -187,6 +296,20 @@ public:
     static OptionChain build(PutCallRecordMap&& recordMaps,
         const OptionInstruments& optionInstruments);
 
+    /// @brief Creates a chain from put and call record maps, e.g. of persisted chains
+    /// @param underlier Symbol of the underlier
+    /// @param valuationDate yyyy-mm-dd valuation date
+    /// @param expiryDate yyyy-mm-dd expiry date
+    /// @param recordMaps Put and call records by strike key
+    static OptionChain fromRecords(const std::string& underlier,
+        const std::string& valuationDate, const std::string& expiryDate,
+        PutCallRecordMap&& recordMaps);
+
+    /// @brief Creates a chain sharing the records of {optionChain}
+    /// @details Records are copied only when the gap filler modifies a put or call side,
+    /// so derived chains of long-lived raw chains don't duplicate unchanged records.
+    static OptionChain shareRecords(const OptionChain& optionChain);
+
     // ** Attributes 
 
     /// @brief gets the symbol / underlier of the option
@@ -207,13 +330,13 @@ public:
     /// @brief Gets the put record map
     /// @return Record map
     const RecordMap& getPuts() const {
-        return m_putsStrikeKeyToRecord;
+        return m_putsStrikeKeyToRecord.get();
     }
 
     /// @brief Gets the call record map
     /// @return Record map
     const RecordMap& getCalls() const {
-        return m_callsStrikeKeyToRecord;
+        return m_callsStrikeKeyToRecord.get();
     }
 
     /// @brief Gets missing instruments, if any
@@ -224,10 +347,10 @@ public:
 
     /// @brief Brief check if option data is valid
     bool isValid() const {
-        return m_putsStrikeKeyToRecord.size() > 0
-            && m_callsStrikeKeyToRecord.size() > 0
-            && m_putsStrikeKeyToRecord.size() > m_missingInstrumentIdToOsiMap.size()
-            && m_callsStrikeKeyToRecord.size() > m_missingInstrumentIdToOsiMap.size();
+        return getPuts().size() > 0
+            && getCalls().size() > 0
+            && getPuts().size() > m_missingInstrumentIdToOsiMap.size()
+            && getCalls().size() > m_missingInstrumentIdToOsiMap.size();
     }
     class Util;
     friend class Util;
@@ -242,13 +365,46 @@ public:
     /// @brief Get a parity rate quality score
     double getParityRateQualityScore(double fRiskFreeRate, 
         const DateUtils::ExchangeClose& exchangeClose = DateUtils::m_nasdaqClose) const;
+    /// @brief Shifts stale records to chain time by their delta times the underlier move
+    /// @details Deltas derive from the slope of mid prices along the strike axis, using
+    /// homogeneity of option prices in underlier and strike: delta = (V - K * dV/dK) / S.
+    /// The underlier move is the latest value of {underlierPath} minus its value at the
+    /// record's receive time. Shifted records get chain time as receive time and a comment.
+    /// @param underlierPath Underlier path from estimateUnderlierPath
+    /// @param staleAfter Records received longer than this before chain time get shifted
+    /// @return Number of shifted records
+    std::size_t shiftStaleRecords(const UnderlierPath& underlierPath, TimeRange staleAfter);
+    /// @brief Shifts stale records along the underlier path estimated from {timeline}
+    /// @details Discounts strikes at the risk free rate of {marketEnvironment}. Failures get
+    /// logged and leave the chain unshifted, stale records are better than a lost chain.
+    /// @param timeline Record timeline the chain got built from
+    /// @param marketEnvironment Market environment of the chain's symbol
+    /// @param staleAfter Records received longer than this before chain time get shifted
+    /// @return Number of shifted records
+    std::size_t shiftStaleRecords(const RecordTimeline& timeline,
+        const MarketEnvironment& marketEnvironment, TimeRange staleAfter);
+    /// @brief Comment on records shifted by shiftStaleRecords
+    static const std::string m_deltaShiftComment;
+    /// @brief Time slot width of record timelines built from cbbo data
+    static const TimeRange m_slotWindow;
+private:
+    /// @brief Latest receive time over all records in a single pass
+    Timestamp computeChainTime() const;
+    double computeParityRate(double fRiskFreeRate, 
+        const DateUtils::ExchangeClose& exchangeClose) const;
+    double computeParityRateQualityScore(double fRiskFreeRate, 
+        const DateUtils::ExchangeClose& exchangeClose) const;
+    /// @brief Looks up or computes and memoizes the parity rate or its quality score
+    double getParityMetric(bool bQualityScore, double fRiskFreeRate, 
+        const DateUtils::ExchangeClose& exchangeClose) const;
 private:
     std::string m_underlier;
     std::string m_valuationDate;
     std::string m_expiryDate;
-    RecordMap m_putsStrikeKeyToRecord;
-    RecordMap m_callsStrikeKeyToRecord;
+    SharedRecordMap m_putsStrikeKeyToRecord;
+    SharedRecordMap m_callsStrikeKeyToRecord;
     std::map<std::string, std::string> m_missingInstrumentIdToOsiMap;
+    mutable MetricsCache m_metricsCache;
 };
 
 /// @brief Utilities around computing and filling and option chain
@@ -270,6 +426,13 @@ public:
         double m_discountFactor;  
     };
     
+    /// @brief Computes the time to expiry in years from chain time
+    /// @param optionChain Reference to an option chain
+    /// @param exchangeClose The definition of the exchange for expiry time
+    /// @return Year fraction, or throws if expiry time is before chain time
+    static double getYearFraction(const OptionChain& optionChain,
+        const DateUtils::ExchangeClose& exchangeClose = DateUtils::m_nasdaqClose);
+
     /// @brief Computes discount factor for the discounting of strikes in put-call-parity
     /// @param optionChain Reference to an option chain 
     /// @param fContinuousRate The continuously compounded risk-free rate
@@ -292,8 +455,8 @@ public:
                 records.push_back(callback(it->second));
             }
         };
-        caller(optionChain.m_callsStrikeKeyToRecord);
-        caller(optionChain.m_putsStrikeKeyToRecord);
+        caller(optionChain.getCalls());
+        caller(optionChain.getPuts());
         return records;
     }
     /// @brief Runs a functor on all pairs of matching strike put and call records
@@ -310,10 +473,11 @@ public:
         bool bOnlyValid = true, bool bRelaxedBidAskValid = false)
     {
         std::map<std::string, T> records;
-        for (auto callIt = optionChain.m_callsStrikeKeyToRecord.begin(); 
-                callIt != optionChain.m_callsStrikeKeyToRecord.end(); ++callIt) {
-            auto putIt = optionChain.m_putsStrikeKeyToRecord.find(callIt->first);
-            if (putIt != optionChain.m_putsStrikeKeyToRecord.end()) {
+        const RecordMap& calls = optionChain.getCalls();
+        const RecordMap& puts = optionChain.getPuts();
+        for (auto callIt = calls.begin(); callIt != calls.end(); ++callIt) {
+            auto putIt = puts.find(callIt->first);
+            if (putIt != puts.end()) {
                 if (!bOnlyValid 
                     || (bRelaxedBidAskValid && putIt->second.bidAskValid() && callIt->second.bidAskValid())
                     || (putIt->second.isValid() && callIt->second.isValid())) {
@@ -324,6 +488,50 @@ public:
         }
         return records;
     }
+    /// @brief Strike matched put and call mid prices in strike order as contiguous arrays
+    /// @details Feeds the array kernels below, which compilers can vectorize
+    struct ParitySeries {
+        std::vector<const std::string*> m_strikeKeys;
+        std::vector<double> m_strikes;
+        std::vector<double> m_putPrices;
+        std::vector<double> m_callPrices;
+        std::size_t size() const {
+            return m_strikes.size();
+        }
+    };
+
+    /// @brief Collects put/call pairs valid as in onAllPutCallRecords in a single merge pass
+    /// @param optionChain Option chain instance
+    /// @param bRelaxedBidAskValid Also collect pairs with just valid bid and ask
+    /// @return Series of strike matched pairs
+    static ParitySeries makeParitySeries(const OptionChain& optionChain, bool bRelaxedBidAskValid = false);
+
+    /// @brief Computes put-call-parity rates S = C - P + K * discountFactor
+    /// @param strikes Strikes K
+    /// @param putPrices Put prices P
+    /// @param callPrices Call prices C
+    /// @param discountFactor Discount factor for the strike as a zero coupon bond
+    /// @param parityRates Output array for n parity rates
+    /// @param n Number of elements
+    static void computeParityRates(const double* strikes, const double* putPrices,
+        const double* callPrices, double discountFactor, double* parityRates, std::size_t n);
+
+    /// @brief Esimate slope and intercept of a least squares line in a single pass over arrays
+    /// @param x X values
+    /// @param y Y values
+    /// @param n Number of points
+    /// @return pair of slope and intercept
+    static std::pair<double, double> fitLeastSquaresLine(const double* x, const double* y, std::size_t n);
+
+    /// @brief Returns variance from sum of squared residuals of line fit to arrays
+    /// @param x X values
+    /// @param y Y values
+    /// @param n Number of points
+    /// @param fittedLine Slope and intercept
+    /// @return Variance
+    static double computeVarianceAlongFittedLine(const double* x, const double* y, std::size_t n,
+        const std::pair<double, double>& fittedLine);
+
     /// @brief Esimate slope and intercept of a least squares line fitted to the data series
     /// @param dataSeries (X, Y) pairs of data points
     /// @return pair of slope and intercept
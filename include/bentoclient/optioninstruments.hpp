@@ -3,8 +3,11 @@
 #include <memory>
 #include <list>
 #include <map>
+#include <unordered_map>
+#include <string_view>
 
 namespace bentoclient {
+    class OsiSymbol;
     /// @brief Container of symbology data for an underlier
     class OptionInstruments
     {
@@ -33,9 +36,98 @@ namespace bentoclient {
         typedef std::map<std::string, ExpiryToPutCallMap> ValuationDateToExpiryPutCallMap;
         /// @brief Maps available underliers to known put and call options for value and expiry date.
         typedef std::map<std::string, ValuationDateToExpiryPutCallMap> UnderlierToPutCallMap;
+
+        /// @brief Immutable, hashed index of the instruments of a single option chain
+        /// @details Built once per symbology load for every underlier, valuation date and
+        /// expiry date. Hashed lookups key on views into the shared StrikeKeyPutCallMap,
+        /// which must not change after indexing. OptionInstruments::insert copies a 
+        /// StrikeKeyPutCallMap before it adds to an indexed chain.
+        class ChainIndex
+        {
+        public:
+            /// @brief Location of an instrument within the chain
+            struct Entry {
+                const std::string* m_strikeKey;
+                const OsiToInstrumentId* m_osiToInstrumentId;
+                bool m_put;
+                const std::string& getStrikeKey() const {
+                    return *m_strikeKey;
+                }
+                const std::string& getOsiIdentifier() const {
+                    return m_osiToInstrumentId->first;
+                }
+                const std::string& getInstrumentId() const {
+                    return m_osiToInstrumentId->second;
+                }
+            };
+            typedef std::unordered_map<std::string_view, Entry> EntryMap;
+        public:
+            ChainIndex(const std::string& underlier, const std::string& valuationDate,
+                const std::string& expiryDate, StrikeKeyPutCallMapPtr strikeKeyPutCallMapPtr);
+            ChainIndex(const ChainIndex&) = delete;
+            ChainIndex& operator=(const ChainIndex&) = delete;
+            ChainIndex(ChainIndex&&) = delete;
+            ChainIndex& operator=(ChainIndex&&) = delete;
+            ~ChainIndex() = default;
+
+            const std::string& getUnderlier() const {
+                return m_underlier;
+            }
+            const std::string& getValuationDate() const {
+                return m_valuationDate;
+            }
+            const std::string& getExpiryDate() const {
+                return m_expiryDate;
+            }
+            const StrikeKeyPutCallMapPtr& getStrikeKeyPutCallMap() const {
+                return m_strikeKeyPutCallMapPtr;
+            }
+            /// @brief Ordered instrument ID to OSI ID map, built once
+            const std::map<std::string, std::string>& getInstrumentIdToOsiMap() const {
+                return m_instrumentIdToOsi;
+            }
+            /// @brief Ordered OSI ID to instrument ID map, built once
+            const std::map<std::string, std::string>& getOsiToInstrumentIdMap() const {
+                return m_osiToInstrumentId;
+            }
+            /// @brief O(1) lookup by databento instrument ID, nullptr if unknown
+            const Entry* findInstrumentId(std::string_view instrumentId) const {
+                return find(m_byInstrumentId, instrumentId);
+            }
+            /// @brief O(1) lookup by OSI ID, nullptr if unknown
+            const Entry* findOsiIdentifier(std::string_view osiIdentifier) const {
+                return find(m_byOsiIdentifier, osiIdentifier);
+            }
+            /// @brief O(1) lookup by strike key for puts or calls, nullptr if unknown
+            const Entry* findStrikeKey(std::string_view strikeKey, bool put) const {
+                return find(put ? m_putsByStrikeKey : m_callsByStrikeKey, strikeKey);
+            }
+            /// @brief Number of instruments in the chain
+            std::size_t size() const {
+                return m_byInstrumentId.size();
+            }
+        private:
+            static const Entry* find(const EntryMap& entryMap, std::string_view key) {
+                auto it = entryMap.find(key);
+                return it != entryMap.end() ? &it->second : nullptr;
+            }
+        private:
+            std::string m_underlier;
+            std::string m_valuationDate;
+            std::string m_expiryDate;
+            StrikeKeyPutCallMapPtr m_strikeKeyPutCallMapPtr;
+            std::map<std::string, std::string> m_instrumentIdToOsi;
+            std::map<std::string, std::string> m_osiToInstrumentId;
+            EntryMap m_byInstrumentId;
+            EntryMap m_byOsiIdentifier;
+            EntryMap m_putsByStrikeKey;
+            EntryMap m_callsByStrikeKey;
+        };
+        /// @brief Shared, immutable chain index, also held by single chain instances
+        typedef std::shared_ptr<const ChainIndex> ChainIndexPtr;
     private:
         // Subset constructor
-        OptionInstruments(UnderlierToPutCallMap&& underlierToPutCallMap);
+        OptionInstruments(ChainIndexPtr chainIndexPtr);
     public:
         OptionInstruments();
         // Deleted copy constructor and assignment operator
@@ -58,8 +150,17 @@ namespace bentoclient {
                 return getStrikeKeyPutCallMap(underlier, date, expiryDate) != nullptr;
         }
 
+        /// @brief Returns the hashed index of an option chain
+        /// @return Index or nullptr if the chain does not exist
+        ChainIndexPtr getChainIndex(const std::string& underlier, const std::string& date,
+            const std::string& expiryDate) const;
+
+        /// @brief Returns the hashed index of a single chain instance
+        const ChainIndex& getChainIndex() const;
+
         /// @brief Returns an OptionInstruments object containing a single option chain
-        /// @details Elsewhere referred to as single chain instance
+        /// @details Elsewhere referred to as single chain instance. Shares the chain
+        /// index with this instance and doesn't copy mappings.
         /// @param underlier Stock symbol
         /// @param date Valuation date
         /// @param expiryDate Expiry date
@@ -94,20 +195,20 @@ namespace bentoclient {
         /// @param date Valuation date
         /// @param expiryDate Expiry date
         /// @return Map of OSI to ID
-        std::map<std::string, std::string> getOsiToInstrumentIdMap(const std::string& underlier,
+        const std::map<std::string, std::string>& getOsiToInstrumentIdMap(const std::string& underlier,
             const std::string& date, const std::string& expiryDate) const;
         /// @brief gets a map from OSI IDs to databento instrument IDs for use in single chain instances
-        std::map<std::string, std::string> getOsiToInstrumentIdMap() const;
+        const std::map<std::string, std::string>& getOsiToInstrumentIdMap() const;
 
         /// @brief Gets a map from databento instrument IDs to OSI IDs
         /// @param underlier Stock symbol
         /// @param date Valuation date
         /// @param expiryDate Expiry date
         /// @return Map of ID to OSI
-        std::map<std::string, std::string> getInstrumentIdToOsiMap(const std::string& underlier,
+        const std::map<std::string, std::string>& getInstrumentIdToOsiMap(const std::string& underlier,
             const std::string& date, const std::string& expiryDate) const;
         /// @brief Gets a map from databento instrument IDs to OSI IDs for use in single chain instance
-        std::map<std::string, std::string> getInstrumentIdToOsiMap() const;
+        const std::map<std::string, std::string>& getInstrumentIdToOsiMap() const;
 
         /// @brief Gets the underlier for a single chain instance
         const std::string& getUnderlier() const; 
@@ -119,6 +220,12 @@ namespace bentoclient {
         /// @brief Builds a multiple instancce option chain from a databento symbology resolution
         void insert(const databento::SymbologyResolution& resolution);
 
+        /// @brief Adds OSI ID to instrument ID mappings valid at a valuation date, e.g. of captured chains
+        /// @param valuationDate yyyy-mm-dd valuation date
+        /// @param osiToInstrumentId Map of OSI IDs to databento instrument IDs
+        void insert(const std::string& valuationDate,
+            const std::map<std::string, std::string>& osiToInstrumentId);
+
         /// @brief Get potentially unmapped parts of a resultion
         const Unmapped* getUnmapped() const {
             return m_unmapped.get();
@@ -136,8 +243,31 @@ namespace bentoclient {
             const std::string& valuationDate, const std::string& expiryDate, bool put) const;
         std::list<std::string> getStrikes(const std::string& underlier, 
             const std::string& valuationDate, const std::string& expiryDate, bool put) const;
+    private:
+        /// @brief Chain touched by an insert
+        struct TouchedChain {
+            const std::string* m_underlier;
+            const std::string* m_valuationDate;
+            const std::string* m_expiryDate;
+        };
+        typedef std::unordered_map<StrikeKeyPutCallMapPtr*, TouchedChain> TouchedChainMap;
+        /// @brief Adds a mapping, copying indexed chains on their first write
+        void insertMapping(const OsiSymbol& osiSymbol, const std::string& osiIdentifier,
+            const std::string& valuationDate, const std::string& instrumentId,
+            TouchedChainMap& touchedChains);
+        /// @brief (Re-)indexes the touched chains once all mappings are in
+        void indexChains(const TouchedChainMap& touchedChains);
+        /// @brief Hash key of a chain in the flat chain index
+        static std::string makeChainKey(const std::string& underlier, const std::string& date,
+            const std::string& expiryDate);
     private:
         std::unique_ptr<Unmapped> m_unmapped;
         UnderlierToPutCallMap m_underlierToPutCallMap;
+        /// @brief Flat index of all chains keyed by underlier, valuation and expiry date
+        std::unordered_map<std::string, ChainIndexPtr> m_chainIndex;
+        /// @brief The chain of a single chain instance
+        ChainIndexPtr m_defaultChainIndex;
+        /// @brief Returned for unknown chains
+        static const std::map<std::string, std::string> m_emptyMap;
     };
 }
\ No newline at end of file
@@ -25,8 +25,16 @@ namespace bentoclient
         OptionRecordGapFiller& operator = (OptionRecordGapFiller&&) = default;
 
 
+        /// @brief Fills gaps in a chain derived from {optionChain}, sharing its unchanged records
+        /// @param optionChain Raw option chain, left unmodified
+        /// @return Option chain with filled gaps
         OptionChain fillGaps(const OptionChain& optionChain);
 
+        /// @brief Fills gaps in place, taking ownership of {optionChain}
+        /// @param optionChain Raw option chain to complete
+        /// @return The completed option chain
+        OptionChain fillGaps(OptionChain&& optionChain);
+
         /// @brief Strike keys for any calls that had no matching put
         const std::list<std::string>& getOrphanedCalls() const 
         {
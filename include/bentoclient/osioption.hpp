@@ -1,8 +1,135 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
 #include <iostream>
 namespace bentoclient {
 
+/// @brief Fixed-layout, allocation-free decoding of an OSI identifier
+/// @details Trivially copyable counterpart of OsiOption for the symbology and cbbo
+/// ingestion paths. The OSI format is up to 6 characters root, padded with spaces,
+/// 2 digits year, 2 digits month, 2 digits day, C/P and 8 digits strike in thousandths
+/// of a dollar. The last 8 digits double as the strike key.
+struct OsiSymbol
+{
+    static constexpr std::size_t m_rootCapacity = 6;
+    static constexpr std::size_t m_strikeKeyLength = 8;
+    /// @brief yymmdd, C/P and strike key following the padded root
+    static constexpr std::size_t m_tailLength = 7 + m_strikeKeyLength;
+
+    char m_root[m_rootCapacity] = {};
+    std::uint8_t m_rootLength = 0;
+    std::uint8_t m_year = 0;
+    std::uint8_t m_month = 0;
+    std::uint8_t m_day = 0;
+    char m_type = '\0';
+    char m_strikeKey[m_strikeKeyLength] = {};
+    std::uint32_t m_strikeThousandths = 0;
+
+    /// @brief Decodes an OSI identifier without allocating
+    /// @param sOsiIdentifier OSI identifier, such as "SPY   240610C00123000"
+    /// @param symbol Target of the decoded fields, undefined on failure
+    /// @return False if the identifier does not match the OSI format
+    static constexpr bool parse(std::string_view sOsiIdentifier, OsiSymbol& symbol) noexcept
+    {
+        if (sOsiIdentifier.size() <= m_tailLength) {
+            return false;
+        }
+        const std::size_t nTail = sOsiIdentifier.size() - m_tailLength;
+        std::size_t nRoot = nTail;
+        while (nRoot > 0 && isSpace(sOsiIdentifier[nRoot - 1])) {
+            --nRoot;
+        }
+        if (nRoot == 0 || nRoot > m_rootCapacity) {
+            return false;
+        }
+        for (std::size_t i = 0; i < nRoot; ++i) {
+            if (!isUpper(sOsiIdentifier[i])) {
+                return false;
+            }
+            symbol.m_root[i] = sOsiIdentifier[i];
+        }
+        symbol.m_rootLength = static_cast<std::uint8_t>(nRoot);
+        const char* tail = sOsiIdentifier.data() + nTail;
+        for (std::size_t i = 0; i < 6; ++i) {
+            if (!isDigit(tail[i])) {
+                return false;
+            }
+        }
+        symbol.m_year = static_cast<std::uint8_t>(twoDigits(tail));
+        symbol.m_month = static_cast<std::uint8_t>(twoDigits(tail + 2));
+        symbol.m_day = static_cast<std::uint8_t>(twoDigits(tail + 4));
+        if (tail[6] != 'C' && tail[6] != 'P') {
+            return false;
+        }
+        symbol.m_type = tail[6];
+        std::uint32_t nStrike = 0;
+        for (std::size_t i = 0; i < m_strikeKeyLength; ++i) {
+            char c = tail[7 + i];
+            if (!isDigit(c)) {
+                return false;
+            }
+            symbol.m_strikeKey[i] = c;
+            nStrike = nStrike * 10 + static_cast<std::uint32_t>(c - '0');
+        }
+        symbol.m_strikeThousandths = nStrike;
+        return true;
+    }
+
+    /// @brief Decodes an OSI identifier
+    /// @throws std::invalid_argument with the same message as OsiOption
+    static OsiSymbol fromIdentifier(std::string_view sOsiIdentifier);
+
+    /// @brief Gets the underlier without padding
+    constexpr std::string_view getUnderlier() const {
+        return std::string_view(m_root, m_rootLength);
+    }
+
+    /// @brief Gets the strike key digits
+    constexpr std::string_view getStrikeKeyView() const {
+        return std::string_view(m_strikeKey, m_strikeKeyLength);
+    }
+
+    /// @brief Gets the strike key as used in OptionInstruments and OptionChain maps
+    std::string getStrikeKey() const {
+        return std::string(m_strikeKey, m_strikeKeyLength);
+    }
+
+    /// @brief Gets the yyyy-mm-dd expiry date
+    std::string getExpiryDate() const;
+
+    /// @brief Gets the strike price
+    constexpr double getStrikeValue() const {
+        return static_cast<double>(m_strikeThousandths) / 1000.0;
+    }
+
+    /// @brief Returns true if option is a call
+    constexpr bool isCall() const {
+        return m_type == 'C';
+    }
+
+    /// @brief Returns true if option is a put
+    constexpr bool isPut() const {
+        return m_type == 'P';
+    }
+
+private:
+    static constexpr bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+    static constexpr bool isUpper(char c) {
+        return c >= 'A' && c <= 'Z';
+    }
+    // matches the std::regex \s class
+    static constexpr bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+    }
+    static constexpr unsigned twoDigits(const char* digits) {
+        return static_cast<unsigned>(digits[0] - '0') * 10 + static_cast<unsigned>(digits[1] - '0');
+    }
+};
+
 /// @brief Utility class around an OSI identifier extracting all relevant fields
 class OsiOption
 {
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <list>
 #include <memory>
@@ -27,5 +28,14 @@ namespace bentoclient
         /// @brief Perist missing chain notice
         virtual void persistMissing(const std::string& symbol, const std::string& sDate,
             std::list<std::pair<Timestamp, std::string>>&& missingList) = 0;
+
+        /// @brief Blocks until chains accepted by persist are written, for persisters writing behind
+        virtual void drain() {}
+
+        /// @brief Number of chains accepted by persist but failing to get written afterwards
+        virtual std::uint64_t getFailedCount() const
+        {
+            return 0;
+        }
     };
 }
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+#include "bentoclient/persister.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bentoclient
+{
+    /// @brief Write-behind persister decorator, running another persister on dedicated writer threads
+    /// @details Calls queue up to a bound, then block the caller until writers catch up. Writers take
+    /// batches of queued calls and optionally sync the file system after each batch. Destruction
+    /// drains the queue, also after a terminate signal, so chains fetched before Ctrl-C get written.
+    /// Chains failing to get written are reported like missing chains through persistMissing
+    /// of the decorated persister, after each batch.
+    class PersisterAsynchronous : public Persister
+    {
+    public:
+        /// @brief When written data gets forced to disk
+        enum class Durability : int
+        {
+            NONE,       // left to the operating system
+            SYNC_BATCH  // file system of the sync path synced after each batch
+        };
+        /// @brief Queue and writer settings
+        struct Options
+        {
+            /// @param nMaxQueued Maximum number of queued calls before callers block
+            /// @param nWriters Number of writer threads
+            /// @param nMaxBatch Maximum number of calls a writer takes at once
+            /// @param durability Sync policy
+            /// @param syncPath Path on the file system to sync, typically the base output path
+            Options(std::size_t nMaxQueued = 256,
+                std::size_t nWriters = 2,
+                std::size_t nMaxBatch = 32,
+                Durability durability = Durability::NONE,
+                const std::string& syncPath = "") :
+            m_nMaxQueued(nMaxQueued),
+            m_nWriters(nWriters),
+            m_nMaxBatch(nMaxBatch),
+            m_durability(durability),
+            m_syncPath(syncPath),
+            m_afterBatch(),
+            m_writeFailures()
+            {}
+            std::size_t m_nMaxQueued;
+            std::size_t m_nWriters;
+            std::size_t m_nMaxBatch;
+            Durability m_durability;
+            std::string m_syncPath;
+            /// @brief Optional call after each batch ahead of syncing, e.g. flushing buffered files
+            std::function<void()> m_afterBatch;
+            /// @brief Optional count of files failing after the decorated persister returned,
+            /// e.g. of a BatchFileWriter flushed in m_afterBatch, added to getFailedCount
+            std::function<std::uint64_t()> m_writeFailures;
+        };
+    public:
+        /// @brief Decorates a persister with write-behind queueing
+        /// @param persister Persister doing the writes, called from writer threads only
+        /// @param options Queue and writer settings
+        /// @param terminateSignal Terminate signal, e.g. from SignalHandler, for draining diagnostics
+        PersisterAsynchronous(std::unique_ptr<Persister>&& persister,
+            const Options& options = Options(),
+            std::function<bool()> terminateSignal = [](){ return false; });
+        /// @brief Drains the queue and joins writers
+        ~PersisterAsynchronous() override;
+
+        /// @brief Queues an option chain for persisting
+        /// @param optionChain Chain to persist
+        /// @param marketEnvironment Market enviroment for put-call-parity compatible rte
+        void persist(OptionChain&& optionChain,
+            std::shared_ptr<MarketEnvironment> marketEnvironment) override;
+
+        /// @brief Queues a missing chain notice
+        void persistMissing(const std::string& symbol, const std::string& sDate,
+            std::list<std::pair<Timestamp, std::string>>&& missingList) override;
+
+        /// @brief Blocks until all queued calls are written and synced
+        void drain() override;
+
+        /// @brief Number of queued calls failing in the decorated persister
+        std::uint64_t getFailedCount() const override;
+
+    private:
+        typedef std::function<void()> Job;
+        /// @brief Failed chains by symbol and valuation date, as missing chain lists
+        typedef std::map<std::pair<std::string, std::string>,
+            std::list<std::pair<Timestamp, std::string>>> FailedChainsMap;
+        void push(Job&& job);
+        /// @brief Reports chains failed since the last batch as missing, called from writer threads
+        void persistFailed();
+        void runWriter();
+        void sync() const;
+    private:
+        std::unique_ptr<Persister> m_persister;
+        const Options m_options;
+        std::function<bool()> m_terminateSignal;
+        std::deque<Job> m_queue;
+        std::size_t m_nBusy;
+        std::uint64_t m_nFailed;
+        FailedChainsMap m_failedChains;
+        bool m_bStopping;
+        bool m_bTerminateLogged;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_notEmpty;
+        std::condition_variable m_notFull;
+        std::condition_variable m_idle;
+        std::vector<std::thread> m_writers;
+    };
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "bentoclient/persister.hpp"
+#include <string>
+#include <functional>
+#include <memory>
+
+namespace bentoclient
+{
+    /// @brief Persister to columnar binary chain files, see BinaryChain
+    /// @details Files are named like the CSVs of PersisterCSV with the BinaryChain
+    /// file extension, missing chain notices are the same text files.
+    class PersisterBinary : public Persister
+    {
+    public:
+        typedef std::function<std::unique_ptr<std::ostream>(const std::string&)> Outputter;
+    public:
+        /// @brief Persister to create binary option chain files
+        /// @param basePath Base path to store files in
+        /// @param splitFoldersByDate Add date subdirectories if true
+        PersisterBinary(const std::string& basePath, bool splitFoldersByDate);
+
+        /// @brief Persist an option chain
+        /// @param optionChain Chain to persist
+        /// @param marketEnvironment Market enviroment for put-call-parity compatible rte
+        void persist(OptionChain&& optionChain,
+            std::shared_ptr<MarketEnvironment> marketEnvironment) override;
+
+        /// @brief Perist missing chain notice
+        void persistMissing(const std::string& symbol, const std::string& sDate,
+            std::list<std::pair<Timestamp, std::string>>&& missingList) override;
+
+        /// @brief Optional overwrite of stream outputter (for test cases)
+        /// @param outputter Function to create output streams
+        void setOutputter(Outputter&& outputter);
+
+        /// @brief Optional overwrite of stream outputter for missing chains (for test cases)
+        void setMissingOutputter(Outputter&& outputter);
+
+        /// @brief Default outputter writing files, creating directories as needed
+        /// @details Wrap it with ZstdStream::wrapOutputter for compressed chain files.
+        static Outputter makeFileOutputter(std::ios::openmode mode);
+
+    private:
+        std::string filenamePart(const std::string& sDate, const std::string& symbol) const;
+    private:
+        std::string m_basePath;
+        bool m_splitFoldersByDate;
+        Outputter m_outputter;
+        Outputter m_missingOutputter;
+    };
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "bentoclient/persister.hpp"
+#include <string>
+#include <functional>
+#include <memory>
+
+namespace bentoclient
+{
+    class ChainStore;
+    /// @brief Persister appending chains to a ChainStore
+    /// @details Missing chain notices are text files in the store directory, named like
+    /// the ones of PersisterCSV.
+    class PersisterChainStore : public Persister
+    {
+    public:
+        typedef std::function<std::unique_ptr<std::ostream>(const std::string&)> Outputter;
+    public:
+        /// @brief Persister to a chain store
+        /// @param chainStore Store to append chains to, may be shared with a RetrieverChainStore
+        PersisterChainStore(std::shared_ptr<ChainStore> chainStore);
+
+        /// @brief Persist an option chain
+        /// @param optionChain Chain to persist
+        /// @param marketEnvironment Market enviroment for put-call-parity compatible rte
+        void persist(OptionChain&& optionChain,
+            std::shared_ptr<MarketEnvironment> marketEnvironment) override;
+
+        /// @brief Perist missing chain notice
+        void persistMissing(const std::string& symbol, const std::string& sDate,
+            std::list<std::pair<Timestamp, std::string>>&& missingList) override;
+
+        /// @brief Optional overwrite of stream outputter for missing chains (for test cases)
+        void setMissingOutputter(Outputter&& outputter);
+
+    private:
+        std::shared_ptr<ChainStore> m_chainStore;
+        Outputter m_missingOutputter;
+    };
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "bentoclient/persister.hpp"
+#include "bentoclient/persistercsv.hpp"
+#include "bentoclient/consolidatedfile.hpp"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace bentoclient
+{
+    /// @brief Persister appending all chains of a symbol and valuation date to one ConsolidatedFile
+    /// @details Files are named {symbol}_chains_{date} with the extension of their flavour,
+    /// missing chain notices of a symbol and date get appended to {symbol}_missing_{date}.txt.
+    /// Files stay open for further chains, up to a maximum number of open files, and get
+    /// their index footer written when closed, at latest on destruction.
+    class PersisterConsolidated : public Persister
+    {
+    public:
+        /// @brief Persister to create consolidated chain files
+        /// @param basePath Base path to store files in
+        /// @param splitFoldersByDate Add date subdirectories if true
+        /// @param flavour CSV or binary chain sections
+        /// @param csvFormat Stacked or put/call side by side, for CSV sections
+        /// @param bGreeks Append implied volatility and Greeks columns, for CSV sections
+        /// @param nMaxOpenFiles Number of files kept open, the least recently used one gets closed first
+        PersisterConsolidated(const std::string& basePath, bool splitFoldersByDate,
+            ConsolidatedFile::Flavour flavour,
+            PersisterCSV::CSVFormat csvFormat = PersisterCSV::CSVFormat::Stacked,
+            bool bGreeks = false,
+            std::size_t nMaxOpenFiles = 64);
+        /// @brief Closes all files
+        ~PersisterConsolidated() override;
+
+        /// @brief Persist an option chain
+        /// @param optionChain Chain to persist
+        /// @param marketEnvironment Market enviroment for put-call-parity compatible rte
+        void persist(OptionChain&& optionChain,
+            std::shared_ptr<MarketEnvironment> marketEnvironment) override;
+
+        /// @brief Perist missing chain notice
+        void persistMissing(const std::string& symbol, const std::string& sDate,
+            std::list<std::pair<Timestamp, std::string>>&& missingList) override;
+
+        /// @brief Writes the index footers of all open files and closes them
+        void flush();
+
+        /// @brief Path of the consolidated file of a symbol and valuation date
+        std::string getPath(const std::string& symbol, const std::string& sDate) const;
+
+    private:
+        std::string filenamePart(const std::string& sDate, const std::string& symbol) const;
+        /// @brief Open writer of {path}, requires the lock
+        ConsolidatedFile::Writer& getWriter(const std::string& path);
+    private:
+        struct OpenFile
+        {
+            std::unique_ptr<ConsolidatedFile::Writer> m_writer;
+            std::uint64_t m_lastUse;
+        };
+        std::string m_basePath;
+        bool m_splitFoldersByDate;
+        ConsolidatedFile::Flavour m_flavour;
+        PersisterCSV::CSVFormat m_csvFormat;
+        bool m_bGreeks;
+        std::size_t m_nMaxOpenFiles;
+        std::map<std::string, OpenFile> m_openFiles;
+        std::uint64_t m_nUses;
+        std::mutex m_mutex;
+    };
+}
@@ -21,8 +21,10 @@ namespace bentoclient
         /// @param basePath Base path to store CSVs in
         /// @param splitFoldersByDate Add date subdirectories if true
         /// @param csvFormat Stacked or put/call side by side
+        /// @param bGreeks Append implied volatility and Greeks columns
         PersisterCSV(const std::string& basePath, 
-            bool splitFoldersByDate, CSVFormat csvFormat = CSVFormat::Stacked);
+            bool splitFoldersByDate, CSVFormat csvFormat = CSVFormat::Stacked,
+            bool bGreeks = false);
 
         /// @brief Persist an option chain
         /// @param optionChain Chain to persist
@@ -41,13 +43,18 @@ namespace bentoclient
         /// @brief Optional overwrite of stream outputter for missing chains (for test cases)
         void setMissingOutputter(Outputter&& outputter);
 
+        /// @brief Default outputter writing files, creating directories as needed
+        /// @details Wrap it with ZstdStream::wrapOutputter for compressed chain files.
+        /// @param mode Open mode, missing chain notices get appended to not lose earlier ones
+        static Outputter makeFileOutputter(std::ios::openmode mode = std::ios::out);
+
     private:
         std::string filenamePart(const std::string& sDate, const std::string& symbol) const;
-        static Outputter makeFileOutputter();
     private:
         std::string m_basePath;
         bool m_splitFoldersByDate;
         CSVFormat m_csvFormat;
+        bool m_bGreeks;
         Outputter m_outputter;
         Outputter m_missingOutputter;
     };
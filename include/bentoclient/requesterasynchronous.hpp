@@ -24,6 +24,7 @@ namespace bentoclient
         /// @param terminateSignal A signal handler function for bailout on interrupt
         /// @param fDefaultRiskFreeRate Default for risk free continuous rate, if yield curve missing
         /// @param sInterestRatesCsv Path to a CSV file having a yield curve in TSY par rate format
+        /// @param sInterestRatesCache Directory caching the parsed yield curve, empty disables caching
         RequesterAsynchronous(std::unique_ptr<Getter>&& getter, 
             std::unique_ptr<Retriever>&& retriever,
             std::unique_ptr<Persister>&& persister,
@@ -34,7 +35,8 @@ namespace bentoclient
             std::uint64_t nThreads,
             std::function<bool()> terminateSignal,
             double fDefaultRiskFreeRate,
-            const std::string& sInterestRatesCsv
+            const std::string& sInterestRatesCsv,
+            const std::string& sInterestRatesCache = std::string()
             );
         ~RequesterAsynchronous() override;
 
@@ -49,41 +51,98 @@ namespace bentoclient
         /// @brief Checks the progress of submitted jobs, returns empty map when all done
         ThreadPool::ResultMap query();
 
+        /// @brief Settings of the requester set up by makeRequesterCSV
+        struct Options
+        {
+            Options() :
+            m_sApiKey(),
+            m_sDataset("OPRA.PILLAR"),
+            m_sBasePath("./optdata"),
+            m_nThreadsRequester(20),
+            m_nThreadsSymbology(5),
+            m_nThreadsTimeseries(10),
+            m_terminateSignal([](){ return false; }),
+            m_nSplitInstrumentIds(100),
+            m_nRetries(3),
+            m_chainLookupTimeRange(std::chrono::minutes(10)),
+            m_cbbo1sTimeRange(std::chrono::seconds(10)),
+            m_cbbo1mTimeRange(std::chrono::minutes(120)),
+            m_fDefaultRiskFreeRate(0.042),
+            m_sInterestRatesCsv(),
+            m_sInterestRatesCache(),
+            m_bStacked(false),
+            m_bDateDirs(true),
+            m_bGreeks(false),
+            m_deltaShiftStaleAfter(TimeRange::zero()),
+            m_bBinary(false),
+            m_bChainStore(false),
+            m_bSyncWrites(false),
+            m_bIoUring(false),
+            m_nCompressionLevel(0),
+            m_sCompressionDictionary(),
+            m_bConsolidated(false),
+            m_sCbboCapturePath()
+            {}
+            /// @brief Databento API key
+            std::string m_sApiKey;
+            /// @brief Databento data set, such as OPRA.PILLAR
+            std::string m_sDataset;
+            /// @brief The base storage path for chain persists
+            std::string m_sBasePath;
+            /// @brief Number of threads in underlying pool
+            std::uint64_t m_nThreadsRequester;
+            /// @brief Number of threads for symbology requests to databento
+            std::uint64_t m_nThreadsSymbology;
+            /// @brief Number of threads for time series requests to databento
+            std::uint64_t m_nThreadsTimeseries;
+            /// @brief Signal handler to bail out on interrupt
+            std::function<bool()> m_terminateSignal;
+            /// @brief Max number of instrument IDs in single time series call to databento
+            std::uint64_t m_nSplitInstrumentIds;
+            /// @brief Number of retries on sporadic request failures
+            std::uint64_t m_nRetries;
+            /// @brief Time range for looking up chains from intermediate storage (retriever) interface
+            TimeRange m_chainLookupTimeRange;
+            /// @brief Lookback time range for CBBO 1S
+            TimeRange m_cbbo1sTimeRange;
+            /// @brief Lookback time range for CBBO 1M
+            TimeRange m_cbbo1mTimeRange;
+            /// @brief Default for risk free continuous rate, if yield curve missing
+            double m_fDefaultRiskFreeRate;
+            /// @brief Path to a CSV file having a yield curve in TSY par rate format
+            std::string m_sInterestRatesCsv;
+            /// @brief Directory caching the parsed yield curve, empty disables caching
+            std::string m_sInterestRatesCache;
+            /// @brief Stacked CSV output instead of side by side
+            bool m_bStacked;
+            /// @brief Add valuation date directories to the base output path m_sBasePath
+            bool m_bDateDirs;
+            /// @brief Append implied volatility and Greeks columns to CSV output
+            bool m_bGreeks;
+            /// @brief Delta shift records older than this before chain time, zero disables
+            TimeRange m_deltaShiftStaleAfter;
+            /// @brief Persist columnar binary chain files (BinaryChain) instead of CSV
+            bool m_bBinary;
+            /// @brief Append chains to a ChainStore in m_sBasePath instead of files
+            bool m_bChainStore;
+            /// @brief Sync the file system of m_sBasePath after each batch of writes
+            bool m_bSyncWrites;
+            /// @brief Write batches of output files with io_uring if available
+            bool m_bIoUring;
+            /// @brief zstd compression level of chain files, 0 disables compression
+            int m_nCompressionLevel;
+            /// @brief Optional zstd dictionary file for compressing chain files
+            std::string m_sCompressionDictionary;
+            /// @brief Append all chains of a symbol and date to one indexed file, see ConsolidatedFile
+            bool m_bConsolidated;
+            /// @brief Base path for capturing raw CBBO data of each chain, empty disables
+            std::string m_sCbboCapturePath;
+        };
+
         /// @brief Sets up an asynchronous requester interface
-        /// @param sApiKey Databento API key
-        /// @param sDataset Databento data set, such as OPRA.PILLAR
-        /// @param sBasePath The base storage path for CSV persists
-        /// @param nThreadsRequester Number of threads in underlying pool
-        /// @param nThreadsSymbology Number of threads for symbology requests to databento
-        /// @param nThreadsTimeseries Number of threads for time series requests to databento
-        /// @param terminateSignal Signal handler to bail out on interrupt
-        /// @param nSplitInstrumentIds Max number of instrument IDs in single time series call to databento
-        /// @param nRetries Number of retries on sporadic request failures
-        /// @param chainLookupTimeRange Time range for looking up chains from intermediate storage (retriever) interface
-        /// @param cbbo1sTimeRange Lookback time range for CBBO 1S
-        /// @param cbbo1mTimeRange Lookback time range for CBBO 1M
-        /// @param fDefaultRiskFreeRate Default for risk free continuous rate, if yield curve missing
-        /// @param sInterestRatesCsv Path to a CSV file having a yield curve in TSY par rate format
-        /// @param bStacked Stacked CSV output instead of side by side
-        /// @param bDateDirs Add valuation date directories ot the base CSV output path sBasePath
+        /// @param options Data source, threading and output settings
         /// @return The constructed requester interface
-        static std::unique_ptr<RequesterAsynchronous> makeRequesterCSV(
-            const std::string& sApiKey,
-            const std::string& sDataset,
-            const std::string& sBasePath,
-            std::uint64_t nThreadsRequester,
-            std::uint64_t nThreadsSymbology,
-            std::uint64_t nThreadsTimeseries,
-            std::function<bool()> terminateSignal,
-            std::uint64_t nSplitInstrumentIds,
-            std::uint64_t nRetries,
-            TimeRange chainLookupTimeRange,
-            TimeRange cbbo1sTimeRange,
-            TimeRange cbbo1mTimeRange,
-            double fDefaultRiskFreeRate,
-            const std::string& sInterestRatesCsv,
-            bool bStacked,
-            bool bDateDirs);
+        static std::unique_ptr<RequesterAsynchronous> makeRequesterCSV(const Options& options);
 
     private:
         ThreadPool m_threadPool;
@@ -2,11 +2,15 @@
 #include "bentoclient/requester.hpp"
 #include <memory>
 #include <functional>
+#include <string>
 
 namespace bentoclient
 {
     class MarketEnvironment;
+    class VariadicThreadPool;
     /// @brief A requester that loads option chains in the calling thread
+    /// @details Gap filling and persisting of the chains of all expiry dates fan out to a
+    /// compute pool sized to the number of CPU cores, shared by all requesting threads
     class RequesterSynchronous : public Requester
     {
         class Internal;
@@ -23,6 +27,8 @@ namespace bentoclient
         /// @param nInstrumentsSplit Max number of instruments in databento timeseries requests
         /// @param fDefaultRiskFreeRate Default for risk free continuous rate, if yield curve missing
         /// @param sInterestRatesCsv Path to a CSV file having a yield curve in TSY par rate format
+        /// @param sInterestRatesCache Directory caching the parsed yield curve in binary format
+        /// for faster startup, empty disables caching
         RequesterSynchronous(std::unique_ptr<Getter>&& getter, 
             std::unique_ptr<Retriever>&& retriever,
             std::unique_ptr<Persister>&& persister,
@@ -31,7 +37,8 @@ namespace bentoclient
             TimeRange cbbo1mRange,
             std::uint64_t nInstrumentsSplit,
             double fDefaultRiskFreeRate,
-            const std::string& sInterestRatesCsv
+            const std::string& sInterestRatesCsv,
+            const std::string& sInterestRatesCache = std::string()
             );
         ~RequesterSynchronous() override;
 
@@ -42,11 +49,29 @@ namespace bentoclient
             const bentoclient::Timestamp& dateTime, int nDte);
 
         void setTerminateSignal(std::function<bool()> terminateSignal);
+
+        /// @brief Enables shifting of stale records by estimated delta along the put-call-parity
+        /// underlier path of the CBBO timeline. With shifting, shorter CBBO 1M lookbacks keep
+        /// chain quality, as older quotes get moved to the chain time.
+        /// @param staleAfter Records older than chain time minus staleAfter get shifted, zero disables
+        void setDeltaShift(TimeRange staleAfter);
+
+        /// @brief Enables capturing the joined CBBO data of each chain request as CbboCapture
+        /// files in {capturePath}/{date}/, for rebuilding chains offline with bentoreprocess
+        /// @param capturePath Base path of capture files, empty disables
+        void setCbboCapture(const std::string& capturePath);
+
+        /// @brief Waits for chains handed to a write-behind persister to get written
+        /// @return Number of chains failing to get written after persist returned
+        std::uint64_t finishPersisting();
     private:
         std::unique_ptr<Internal> m_internal;
         std::shared_ptr<MarketEnvironment> m_marketEnvironment;
+        std::unique_ptr<VariadicThreadPool> m_computePool;
     protected:
         std::function<bool()> m_terminateSignal; 
+        TimeRange m_deltaShiftStaleAfter;
+        std::string m_sCbboCapturePath;
         TimeRange m_cbbo1sRange;
         TimeRange m_cbbo1mRange;
         std::string m_sDataset;
@@ -1,6 +1,7 @@
 #pragma once
 #include "bentoclient/clienttypes.hpp"
 #include "bentoclient/dateutils.hpp"
+#include "bentoclient/marketenvironmentextended.hpp"
 #include <chrono>
 #include <map>
 #include <memory>
@@ -13,6 +14,8 @@ namespace bentoclient
     {
     public:
         typedef std::map<Timestamp, OptionChain> TimeToChainMap;
+        /// @brief Refcounted immutable option chain handle, valid independent of storage lifetime
+        typedef std::shared_ptr<const OptionChain> OptionChainPtr;
     public:
         /// @brief Constructs a retriever for a lookup leniency time range
         /// @param timeRange The lookup timerange, within which stored objects match requested datetimes
@@ -60,8 +63,8 @@ namespace bentoclient
         /// @param symbol Symbol for option chain
         /// @param dateTime Requested valuation time and date
         /// @param expiryDate Expiry date for option chain
-        /// @return original OptionChain without enhancements
-        virtual const OptionChain& getRawOptionChain(
+        /// @return Handle to original OptionChain without enhancements
+        virtual OptionChainPtr getRawOptionChain(
             const std::string& symbol,
             Timestamp dateTime,
             const std::string& expiryDate) = 0;
@@ -73,11 +76,16 @@ namespace bentoclient
             const std::string& symbol) const = 0;
 
         /// @brief Find closest key to {at} and verify it's in internal time range
+        /// @tparam T Mapped type, typically an option chain or handle
         /// @param at Time to find closest key for
         /// @param timeToChainMap Map with all chains for expiry date and symbol
         /// @return Timestamp and boolean if Timestamp is in range
+        template <typename T>
         std::pair<Timestamp, bool> getNextInTimeRange(Timestamp at, 
-            const TimeToChainMap& timeToChainMap) const;
+            const std::map<Timestamp, T>& timeToChainMap) const
+        {
+            return MarketEnvironmentExtended::getNextInTimeRange(at, timeToChainMap, m_timeRange);
+        }
     private:
         const TimeRange m_timeRange;
     };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "bentoclient/retriever.hpp"
+#include "bentoclient/chainstore.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+namespace bentoclient
+{
+    /// @brief A retriever looking up chains in a ChainStore on disk
+    /// @details Lookups run against the store's index, chains get read from its memory-mapped
+    /// data file on request. Chains appended by other processes become visible on the next lookup
+    /// missing them.
+    class RetrieverChainStore : public Retriever
+    {
+    public:
+        typedef std::map<std::string, std::shared_ptr<MarketEnvironment>> SymbolToMarketEnvironmentMap;
+    public:
+        /// @brief Constructs a chain store retriever
+        /// @param timeRange The lookup timerange, within which stored objects match requested datetimes
+        /// @param chainStore Store to look up chains in, may be shared with a PersisterChainStore
+        RetrieverChainStore(TimeRange timeRange, std::shared_ptr<ChainStore> chainStore);
+
+        /// @brief Appends a raw option chain to the store
+        /// @details The chain summary gets computed if a market environment for its underlier
+        /// was submitted before
+        void submitOptionChain(OptionChain&& optionChain) override;
+
+        void submitMarketEnvironment(const std::string& symbol,
+            std::shared_ptr<MarketEnvironment> marketEnvironment) override;
+
+        bool hasOptionChain(
+            const std::string& symbol,
+            Timestamp dateTime,
+            const std::string& expiryDate) override;
+
+        OptionChainPtr getRawOptionChain(
+            const std::string& symbol,
+            Timestamp dateTime,
+            const std::string& expiryDate) override;
+
+        std::shared_ptr<MarketEnvironment> getMarketEnvironment(
+            const std::string& symbol) const override;
+
+    private:
+        /// @brief Finds a chain in the store, reloading its index once if missing
+        bool findLocation(const std::string& symbol, Timestamp dateTime,
+            const std::string& expiryDate, ChainStore::Location& location);
+    private:
+        std::shared_ptr<ChainStore> m_chainStore;
+        const TimeRange m_timeRange;
+        SymbolToMarketEnvironmentMap m_marketEnvironmentData;
+        mutable std::mutex m_mutex;
+    };
+}
@@ -1,24 +1,54 @@
 #pragma once
 
 #include "bentoclient/retriever.hpp"
+#include <atomic>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <vector>
 namespace bentoclient
 {
     /// @brief A retriever internal storage using in-memory collections
+    /// @details Chains are held in shards selected by symbol hash, each with its own lock,
+    /// so writers and readers of different symbols don't contend. A retention policy
+    /// bounds the number of chains held across all shards and their age, so a single hot
+    /// symbol can use the whole bound. Exceeding the bound evicts chains not used within
+    /// the latest uses in one pass over the shards, approximating least recently used first.
+    /// Retrieved chains are refcounted handles and stay valid after eviction.
     class RetrieverInMemory : public Retriever
     {
     public:
-        typedef std::map<std::string, TimeToChainMap> ExpiryToChainsMap;
-        typedef std::map<std::string, ExpiryToChainsMap> SymbolToExpiryMap;
         typedef std::map<std::string, std::shared_ptr<MarketEnvironment>> SymbolToMarketEnvironmentMap;
+        /// @brief Bounds for the chains held in memory
+        struct RetentionPolicy
+        {
+            /// @brief Constructs a retention policy
+            /// @param nMaxChains Maximum number of chains held in all shards, 0 for unbounded
+            /// @param retentionWindow Chains older than the latest chain of their shard by more
+            /// than this window get evicted, 0 for unbounded
+            /// @param nShards Number of independently locked shards
+            RetentionPolicy(std::size_t nMaxChains = 0,
+                TimeRange retentionWindow = TimeRange::zero(),
+                std::size_t nShards = 16) :
+            m_nMaxChains(nMaxChains),
+            m_retentionWindow(retentionWindow),
+            m_nShards(nShards)
+            {}
+            std::size_t m_nMaxChains;
+            TimeRange m_retentionWindow;
+            std::size_t m_nShards;
+        };
     public:
-        RetrieverInMemory(TimeRange timeRange);
-        ~RetrieverInMemory() override = default;
+        /// @brief Constructs an in-memory retriever
+        /// @param timeRange The lookup timerange, within which stored objects match requested datetimes
+        /// @param retentionPolicy Bounds for chains held in memory, unbounded by default
+        RetrieverInMemory(TimeRange timeRange,
+            const RetentionPolicy& retentionPolicy = RetentionPolicy());
+        ~RetrieverInMemory() override;
 
         void submitOptionChain(OptionChain&& optionChain) override;
 
-        void submitMarketEnvironment(const std::string& symbol, 
+        void submitMarketEnvironment(const std::string& symbol,
             std::shared_ptr<MarketEnvironment> marketEnvironment) override;
 
         bool hasOptionChain(
@@ -26,17 +56,32 @@ namespace bentoclient
             Timestamp dateTime,
             const std::string& expiryDate) override;
 
-        const OptionChain& getRawOptionChain(
+        OptionChainPtr getRawOptionChain(
             const std::string& symbol,
             Timestamp dateTime,
             const std::string& expiryDate) override;
-        
+
         std::shared_ptr<MarketEnvironment> getMarketEnvironment(
             const std::string& symbol) const override;
 
+        /// @brief Number of chains currently held
+        std::size_t size() const;
+
+    private:
+        class Shard;
+        /// @brief Selects the shard holding chains of {symbol}
+        Shard& getShard(const std::string& symbol) const;
+        /// @brief Evicts chains not used recently from all shards once over the chain bound
+        /// @details Evicts down to 7/8 of the bound, so the following submits don't need a pass
+        void evictLeastRecentlyUsed();
     private:
-        SymbolToExpiryMap m_chainData;
+        const RetentionPolicy m_retentionPolicy;
+        std::vector<std::unique_ptr<Shard>> m_shards;
+        /// @brief Chains held in all shards
+        std::atomic<std::size_t> m_nChains;
+        /// @brief Ticks ordering chain uses across shards
+        std::atomic<std::uint64_t> m_useTick;
         SymbolToMarketEnvironmentMap m_marketEnvironmentData;
         mutable std::mutex m_mutex;
     };
-}
\ No newline at end of file
+}
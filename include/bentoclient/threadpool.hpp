@@ -8,6 +8,8 @@
 namespace bentoclient
 {
     /// @brief Thread pool utility class for simplified task submission and progress checks
+    /// @details Posting and completing jobs does not lock, so many small jobs scale with
+    /// the number of threads. Results are delivered once, by either query.
     class ThreadPool
     {
         class Impl;
@@ -48,6 +50,10 @@ namespace bentoclient
         ResultMap query();
         /// @brief Waits for all internal threads to finish
         void join();
+        /// @brief Number of job IDs whose delivery state is still kept
+        /// @details Stays below 64 plus the spread between the oldest undelivered
+        /// and the newest delivered job, instead of growing with every job posted.
+        std::uint64_t getTrackedIdCount() const;
 
     private:
         std::unique_ptr<Impl> m_impl;
@@ -1,18 +1,36 @@
 #pragma once
+#include "bentoclient/workstealingexecutor.hpp"
 #include <boost/asio/thread_pool.hpp>
 #include <boost/asio/post.hpp>
 #include <future>
 #include <functional>
+#include <memory>
 
 namespace bentoclient
 {
     /// @brief A thread pool for variable number of parametes submission of jobs
     class VariadicThreadPool
     {
+    public:
+        /// @brief How jobs get distributed over the internal threads
+        enum class Scheduling
+        {
+            /// @brief One queue shared by all threads, jobs start in order of submission
+            SharedQueue,
+            /// @brief A deque per thread with stealing, see WorkStealingExecutor
+            WorkStealing
+        };
     public:
         /// @brief Creates a variadic pool
         /// @param nThreads Number of internal threads 
-        VariadicThreadPool(std::uint64_t nThreads) : m_pool(nThreads) {}
+        /// @param scheduling Shared queue for ordered jobs like rate limited requests,
+        /// work stealing for compute jobs posting further jobs to the same pool
+        VariadicThreadPool(std::uint64_t nThreads, Scheduling scheduling = Scheduling::SharedQueue) :
+            m_sharedPool(scheduling == Scheduling::SharedQueue
+                ? std::make_unique<boost::asio::thread_pool>(nThreads) : nullptr),
+            m_stealingPool(scheduling == Scheduling::WorkStealing
+                ? std::make_unique<WorkStealingExecutor>(nThreads) : nullptr)
+        {}
         VariadicThreadPool(const VariadicThreadPool&) = delete;
         VariadicThreadPool& operator = (const VariadicThreadPool&) = delete;
         VariadicThreadPool(VariadicThreadPool&&) = default;
@@ -20,11 +38,16 @@ namespace bentoclient
 
         ~VariadicThreadPool() 
         {
-            m_pool.join();
+            join();
         }
 
         void join() {
-            m_pool.join();
+            if (m_sharedPool) {
+                m_sharedPool->join();
+            }
+            if (m_stealingPool) {
+                m_stealingPool->join();
+            }
         }
 
         /// @brief Variable number of parameters submission of jobs
@@ -43,7 +66,7 @@ namespace bentoclient
 
             std::future<ReturnType> result = task->get_future();
 
-            boost::asio::post(m_pool, [task]() { (*task)(); });
+            dispatch([task]() { (*task)(); });
 
             return result;
         }
@@ -56,10 +79,21 @@ namespace bentoclient
         template <typename Func, typename... Args>
         void postNoFuture(Func&& func, Args&&... args) {
             // Wrap the task with std::bind and post it to the thread pool
-            boost::asio::post(m_pool, std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+            dispatch(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
         }
     
     private:
-        boost::asio::thread_pool m_pool;
+        template <typename Task>
+        void dispatch(Task&& task) {
+            if (m_stealingPool) {
+                m_stealingPool->post(std::forward<Task>(task));
+            } else {
+                boost::asio::post(*m_sharedPool, std::forward<Task>(task));
+            }
+        }
+
+    private:
+        std::unique_ptr<boost::asio::thread_pool> m_sharedPool;
+        std::unique_ptr<WorkStealingExecutor> m_stealingPool;
     };
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bentoclient
+{
+    /// @brief Thread pool with a task deque per worker thread and random stealing
+    /// @details Tasks posted from a worker go to the back of its own deque and get popped
+    /// from there again, last in first out, so nested fan-out keeps running on warm caches.
+    /// Tasks posted from other threads get spread round robin over the workers. Workers
+    /// running dry steal the oldest task of a randomly chosen other worker, and only sleep
+    /// when no task is queued anywhere. Like boost::asio::thread_pool, join waits for all
+    /// tasks including those posted by running tasks.
+    class WorkStealingExecutor
+    {
+        class WorkerQueue;
+    public:
+        typedef std::function<void()> Task;
+    public:
+        /// @brief Starts the worker threads
+        /// @param nThreads Number of worker threads, at least one
+        WorkStealingExecutor(std::uint64_t nThreads);
+        WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+        WorkStealingExecutor& operator = (const WorkStealingExecutor&) = delete;
+        WorkStealingExecutor(WorkStealingExecutor&&) = delete;
+        WorkStealingExecutor& operator = (WorkStealingExecutor&&) = delete;
+        /// @brief Joins the worker threads
+        ~WorkStealingExecutor();
+
+        /// @brief Queues a task, on the deque of the calling worker if posted from one
+        void post(Task task);
+
+        /// @brief Waits for all tasks to finish and stops the worker threads
+        void join();
+
+        /// @brief Number of worker threads
+        std::uint64_t getThreadCount() const;
+
+    private:
+        /// @brief Worker thread loop
+        void run(std::size_t index);
+        /// @brief Pops the newest task of the own deque or steals the oldest of another
+        bool tryAcquire(std::size_t index, Task& task);
+        /// @brief Wakes a sleeping worker after a task got queued
+        void notifyIdle();
+        /// @brief True once joining and no task is queued or running
+        bool isDone() const;
+    private:
+        std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+        std::vector<std::thread> m_threads;
+        std::atomic<std::uint64_t> m_nQueued;
+        std::atomic<std::uint64_t> m_nOutstanding;
+        std::atomic<std::uint64_t> m_nIdle;
+        std::atomic<std::uint64_t> m_nextQueue;
+        std::atomic<bool> m_joining;
+        std::mutex m_idleMutex;
+        std::condition_variable m_idleCondition;
+        std::mutex m_joinMutex;
+    };
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bentoclient
+{
+    /// @brief Output stream compressing into another stream as one zstd frame
+    /// @details The frame gets finished on destruction, like files get completed by
+    /// closing the streams of persister outputters.
+    class ZstdStream : public std::ostream
+    {
+        class Algos;
+        class CompressBuffer;
+    public:
+        typedef std::function<std::unique_ptr<std::ostream>(const std::string&)> Outputter;
+        /// @brief Prepared compression dictionary, shareable among streams and threads
+        class Dictionary
+        {
+        public:
+            /// @brief Prepares a dictionary
+            /// @param bytes Dictionary content, e.g. from trainDictionary or `zstd --train`
+            /// @param level Compression level used with this dictionary
+            Dictionary(const std::string& bytes, int level);
+            Dictionary(const Dictionary&) = delete;
+            Dictionary& operator = (const Dictionary&) = delete;
+            ~Dictionary();
+            /// @brief Loads a dictionary file
+            static std::shared_ptr<const Dictionary> load(const std::string& path, int level);
+            const std::string& getBytes() const
+            {
+                return m_bytes;
+            }
+        private:
+            friend class ZstdStream;
+            std::string m_bytes;
+            void* m_cdict;
+            void* m_ddict;
+        };
+    public:
+        /// @brief Compresses into {sink}
+        /// @param sink Stream receiving the compressed frame
+        /// @param level Compression level, ignored with a dictionary having its own level
+        /// @param dictionary Optional dictionary
+        ZstdStream(std::unique_ptr<std::ostream>&& sink, int level,
+            std::shared_ptr<const Dictionary> dictionary = nullptr);
+        /// @brief Finishes the frame
+        ~ZstdStream() override;
+
+        /// @brief Wraps an outputter to write compressed files with m_fileExtension appended
+        static Outputter wrapOutputter(Outputter outputter, int level,
+            std::shared_ptr<const Dictionary> dictionary = nullptr);
+
+        /// @brief Trains a dictionary on sample files, e.g. chain CSVs
+        /// @param samples Sample file contents
+        /// @param capacity Maximum dictionary size in bytes
+        /// @return Dictionary content
+        static std::string trainDictionary(const std::vector<std::string>& samples,
+            std::size_t capacity = 112640);
+
+        /// @brief Decompresses frames in memory
+        static std::string decompress(const std::string& compressed,
+            const Dictionary* dictionary = nullptr);
+
+        /// @brief True if {bytes} start with a zstd frame
+        static bool isCompressed(const char* bytes, std::size_t size);
+
+        /// @brief File extension appended to compressed files
+        static const std::string m_fileExtension;
+    private:
+        std::unique_ptr<CompressBuffer> m_buffer;
+    };
+}
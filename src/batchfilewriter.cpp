@@ -0,0 +1,478 @@
+#include "bentoclient/batchfilewriter.hpp"
+#include <boost/log/trivial.hpp>
+#include <fmt/core.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define BENTOCLIENT_IO_URING 1
+#endif
+
+using namespace bentoclient;
+
+class BatchFileWriter::Algos
+{
+public:
+    static constexpr int m_openFlags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    static constexpr mode_t m_openMode = 0644;
+    /// @brief Writes {bytes} from {offset} on with blocking calls, false on errors
+    static bool writeAll(int fd, const std::string& bytes, std::size_t offset)
+    {
+        while (offset < bytes.size())
+        {
+            ssize_t nWritten = ::write(fd, bytes.data() + offset, bytes.size() - offset);
+            if (nWritten < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            offset += static_cast<std::size_t>(nWritten);
+        }
+        return true;
+    }
+    /// @brief Writes a file with plain open, write and close calls
+    static bool writeFile(const PendingFile& pendingFile)
+    {
+        int fd = ::open(pendingFile.m_path.c_str(), m_openFlags, m_openMode);
+        if (fd < 0)
+        {
+            logError(pendingFile, errno);
+            return false;
+        }
+        bool bWritten = writeAll(fd, pendingFile.m_bytes, 0);
+        int writeErrno = errno;
+        bool bClosed = ::close(fd) == 0;
+        if (!bWritten || !bClosed)
+        {
+            logError(pendingFile, bWritten ? errno : writeErrno);
+        }
+        return bWritten && bClosed;
+    }
+    static void logError(const PendingFile& pendingFile, int error)
+    {
+        BOOST_LOG_TRIVIAL(error) << "Failed to write " << pendingFile.m_path << ": " << std::strerror(error);
+    }
+};
+
+/// @brief Minimal io_uring submission and completion rings
+class BatchFileWriter::Ring
+{
+public:
+    typedef std::function<void(std::uint64_t, std::int32_t)> CompletionHandler;
+#if BENTOCLIENT_IO_URING
+    /// @brief Sets up a ring, nullptr if io_uring is unavailable
+    static std::unique_ptr<Ring> create(unsigned nEntries)
+    {
+        std::unique_ptr<Ring> ring(new Ring());
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring->m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, nEntries, &params));
+        if (ring->m_fd < 0)
+        {
+            BOOST_LOG_TRIVIAL(info) << "io_uring unavailable, writing files with plain calls: "
+                << std::strerror(errno);
+            return nullptr;
+        }
+        ring->m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring->m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool bSingleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (bSingleMap)
+        {
+            ring->m_sqRingSize = ring->m_cqRingSize = std::max(ring->m_sqRingSize, ring->m_cqRingSize);
+        }
+        ring->m_sqRing = ::mmap(nullptr, ring->m_sqRingSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring->m_fd, IORING_OFF_SQ_RING);
+        if (ring->m_sqRing == MAP_FAILED)
+        {
+            ring->m_sqRing = nullptr;
+            return nullptr;
+        }
+        if (bSingleMap)
+        {
+            ring->m_cqRing = ring->m_sqRing;
+        } else {
+            ring->m_cqRing = ::mmap(nullptr, ring->m_cqRingSize, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring->m_fd, IORING_OFF_CQ_RING);
+            if (ring->m_cqRing == MAP_FAILED)
+            {
+                ring->m_cqRing = nullptr;
+                return nullptr;
+            }
+        }
+        ring->m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = ::mmap(nullptr, ring->m_sqesSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring->m_fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        ring->m_sqes = static_cast<io_uring_sqe*>(sqes);
+        char* sqRing = static_cast<char*>(ring->m_sqRing);
+        char* cqRing = static_cast<char*>(ring->m_cqRing);
+        ring->m_sqTail = reinterpret_cast<unsigned*>(sqRing + params.sq_off.tail);
+        ring->m_sqMask = *reinterpret_cast<unsigned*>(sqRing + params.sq_off.ring_mask);
+        ring->m_sqArray = reinterpret_cast<unsigned*>(sqRing + params.sq_off.array);
+        ring->m_cqHead = reinterpret_cast<unsigned*>(cqRing + params.cq_off.head);
+        ring->m_cqTail = reinterpret_cast<unsigned*>(cqRing + params.cq_off.tail);
+        ring->m_cqMask = *reinterpret_cast<unsigned*>(cqRing + params.cq_off.ring_mask);
+        ring->m_cqes = reinterpret_cast<io_uring_cqe*>(cqRing + params.cq_off.cqes);
+        ring->m_nEntries = params.sq_entries;
+        return ring;
+    }
+    ~Ring()
+    {
+        if (m_sqes != nullptr)
+            ::munmap(m_sqes, m_sqesSize);
+        if (m_cqRing != nullptr && m_cqRing != m_sqRing)
+            ::munmap(m_cqRing, m_cqRingSize);
+        if (m_sqRing != nullptr)
+            ::munmap(m_sqRing, m_sqRingSize);
+        if (m_fd >= 0)
+            ::close(m_fd);
+    }
+    unsigned getEntries() const
+    {
+        return m_nEntries;
+    }
+    /// @brief Queues an open of {path} for writing
+    void queueOpen(const std::string& path, std::uint64_t userData)
+    {
+        io_uring_sqe& sqe = nextSqe();
+        sqe.opcode = IORING_OP_OPENAT;
+        sqe.fd = AT_FDCWD;
+        sqe.addr = reinterpret_cast<std::uint64_t>(path.c_str());
+        sqe.len = Algos::m_openMode;
+        sqe.open_flags = Algos::m_openFlags;
+        sqe.user_data = userData;
+    }
+    /// @brief Queues a write of {bytes} to {fd}, linked to the next queued operation
+    void queueWrite(int fd, const std::string& bytes, std::uint64_t userData)
+    {
+        io_uring_sqe& sqe = nextSqe();
+        sqe.opcode = IORING_OP_WRITE;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(bytes.data());
+        sqe.len = static_cast<std::uint32_t>(bytes.size());
+        sqe.off = 0;
+        sqe.flags = IOSQE_IO_LINK;
+        sqe.user_data = userData;
+    }
+    void queueClose(int fd, std::uint64_t userData)
+    {
+        io_uring_sqe& sqe = nextSqe();
+        sqe.opcode = IORING_OP_CLOSE;
+        sqe.fd = fd;
+        sqe.user_data = userData;
+    }
+    /// @brief Submits queued operations with as few system calls as possible and waits for all completions
+    void submitAndWait(const CompletionHandler& onCompletion)
+    {
+        unsigned nToSubmit = m_nQueued;
+        unsigned nToComplete = m_nQueued;
+        m_nQueued = 0;
+        __atomic_store_n(m_sqTail, m_sqLocalTail, __ATOMIC_RELEASE);
+        while (nToComplete > 0)
+        {
+            int nSubmitted = static_cast<int>(::syscall(__NR_io_uring_enter, m_fd, nToSubmit,
+                nToComplete, IORING_ENTER_GETEVENTS, nullptr, 0));
+            if (nSubmitted < 0)
+            {
+                if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                {
+                    throw std::runtime_error(fmt::format("BatchFileWriter: io_uring_enter failed: {}",
+                        std::strerror(errno)));
+                }
+            } else {
+                nToSubmit -= static_cast<unsigned>(nSubmitted);
+            }
+            nToComplete -= reap(onCompletion);
+        }
+    }
+private:
+    Ring() = default;
+    io_uring_sqe& nextSqe()
+    {
+        unsigned index = m_sqLocalTail & m_sqMask;
+        io_uring_sqe& sqe = m_sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        m_sqArray[index] = index;
+        ++m_sqLocalTail;
+        ++m_nQueued;
+        return sqe;
+    }
+    unsigned reap(const CompletionHandler& onCompletion)
+    {
+        unsigned head = *m_cqHead;
+        unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        unsigned nReaped = 0;
+        for (; head != tail; ++head, ++nReaped)
+        {
+            const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+            onCompletion(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+        return nReaped;
+    }
+private:
+    int m_fd = -1;
+    void* m_sqRing = nullptr;
+    void* m_cqRing = nullptr;
+    std::size_t m_sqRingSize = 0;
+    std::size_t m_cqRingSize = 0;
+    std::size_t m_sqesSize = 0;
+    io_uring_sqe* m_sqes = nullptr;
+    io_uring_cqe* m_cqes = nullptr;
+    unsigned* m_sqTail = nullptr;
+    unsigned* m_sqArray = nullptr;
+    unsigned* m_cqHead = nullptr;
+    unsigned* m_cqTail = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned m_cqMask = 0;
+    unsigned m_sqLocalTail = 0;
+    unsigned m_nQueued = 0;
+    unsigned m_nEntries = 0;
+#else
+    static std::unique_ptr<Ring> create(unsigned)
+    {
+        return nullptr;
+    }
+#endif
+};
+
+/// @brief Output stream collecting a whole file, handed over to the writer on destruction
+class BatchFileWriter::BufferStream : public std::ostream
+{
+    /// @brief Unbuffered stream buffer appending to a string
+    class StringBuffer : public std::streambuf
+    {
+    public:
+        std::string m_bytes;
+    protected:
+        int_type overflow(int_type ch) override
+        {
+            if (!traits_type::eq_int_type(ch, traits_type::eof()))
+            {
+                m_bytes.push_back(traits_type::to_char_type(ch));
+            }
+            return traits_type::not_eof(ch);
+        }
+        std::streamsize xsputn(const char* chars, std::streamsize nChars) override
+        {
+            m_bytes.append(chars, static_cast<std::size_t>(nChars));
+            return nChars;
+        }
+    };
+public:
+    BufferStream(std::shared_ptr<BatchFileWriter> writer, const std::string& path) :
+        std::ostream(nullptr),
+        m_buffer(),
+        m_writer(std::move(writer)),
+        m_path(path)
+    {
+        rdbuf(&m_buffer);
+    }
+    ~BufferStream() override
+    {
+        try {
+            m_writer->submit(PendingFile{std::move(m_path), std::move(m_buffer.m_bytes)});
+        } catch (const std::exception& e) {
+            BOOST_LOG_TRIVIAL(error) << "Failed to write batch of files: " << e.what();
+        }
+    }
+private:
+    StringBuffer m_buffer;
+    std::shared_ptr<BatchFileWriter> m_writer;
+    std::string m_path;
+};
+
+std::shared_ptr<BatchFileWriter> BatchFileWriter::create(std::size_t nBatchFiles, bool bIoUring)
+{
+    return std::shared_ptr<BatchFileWriter>(new BatchFileWriter(nBatchFiles, bIoUring));
+}
+
+BatchFileWriter::BatchFileWriter(std::size_t nBatchFiles, bool bIoUring) :
+    m_nBatchFiles(std::max<std::size_t>(nBatchFiles, 1)),
+    m_ring(bIoUring ? Ring::create(256) : nullptr),
+    m_pending(),
+    m_knownDirectories(),
+    m_nFailed(0),
+    m_pendingMutex(),
+    m_writeMutex()
+{
+}
+
+BatchFileWriter::~BatchFileWriter()
+{
+    try {
+        flush();
+    } catch (const std::exception& e) {
+        BOOST_LOG_TRIVIAL(error) << "Failed to write batch of files: " << e.what();
+    }
+}
+
+BatchFileWriter::Outputter BatchFileWriter::makeOutputter()
+{
+    std::shared_ptr<BatchFileWriter> writer = shared_from_this();
+    return [writer](const std::string& pathname) -> std::unique_ptr<std::ostream>
+    {
+        return std::make_unique<BufferStream>(writer, pathname);
+    };
+}
+
+void BatchFileWriter::flush()
+{
+    std::vector<PendingFile> batch;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        batch.swap(m_pending);
+    }
+    if (!batch.empty())
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        write(batch);
+    }
+}
+
+bool BatchFileWriter::isIoUring() const
+{
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    return m_ring != nullptr;
+}
+
+std::uint64_t BatchFileWriter::getFailedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    return m_nFailed;
+}
+
+void BatchFileWriter::submit(PendingFile&& pendingFile)
+{
+    std::vector<PendingFile> batch;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        m_pending.push_back(std::move(pendingFile));
+        if (m_pending.size() < m_nBatchFiles)
+        {
+            return;
+        }
+        batch.swap(m_pending);
+    }
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    write(batch);
+}
+
+void BatchFileWriter::write(std::vector<PendingFile>& batch)
+{
+    createDirectories(batch);
+    std::size_t nDone = 0;
+#if BENTOCLIENT_IO_URING
+    // two submissions per chunk: opens, then writes each linked to its close
+    std::size_t nChunk = m_ring ? m_ring->getEntries() / 2 : 0;
+    while (m_ring && nDone < batch.size())
+    {
+        std::size_t nFiles = std::min(nChunk, batch.size() - nDone);
+        // close results are zero or negative once completed
+        const std::int32_t notClosed = 1;
+        std::vector<std::int32_t> fds(nFiles, -1), writeResults(nFiles, 0), closeResults(nFiles, notClosed);
+        try {
+            for (std::size_t i = 0; i < nFiles; ++i)
+            {
+                m_ring->queueOpen(batch[nDone + i].m_path, i);
+            }
+            m_ring->submitAndWait([&fds](std::uint64_t userData, std::int32_t result) {
+                fds[userData] = result;
+            });
+            if (std::all_of(fds.begin(), fds.end(), [](std::int32_t fd) { return fd == -EINVAL; }))
+            {
+                // kernels before 5.6 don't know the file opcodes
+                BOOST_LOG_TRIVIAL(info) << "io_uring lacks file operations, writing files with plain calls";
+                m_ring.reset();
+                break;
+            }
+            for (std::size_t i = 0; i < nFiles; ++i)
+            {
+                if (fds[i] >= 0)
+                {
+                    m_ring->queueWrite(fds[i], batch[nDone + i].m_bytes, 2 * i);
+                    m_ring->queueClose(fds[i], 2 * i + 1);
+                }
+            }
+            m_ring->submitAndWait([&writeResults, &closeResults](std::uint64_t userData, std::int32_t result) {
+                (userData % 2 == 0 ? writeResults : closeResults)[userData / 2] = result;
+            });
+        } catch (const std::exception& e) {
+            // the chunk and the rest of the batch get rewritten from scratch with plain calls
+            BOOST_LOG_TRIVIAL(error) << "io_uring failed, writing files with plain calls: " << e.what();
+            m_ring.reset();
+            for (std::size_t i = 0; i < nFiles; ++i)
+            {
+                if (fds[i] >= 0 && closeResults[i] == notClosed)
+                {
+                    ::close(fds[i]);
+                }
+            }
+            break;
+        }
+        for (std::size_t i = 0; i < nFiles; ++i)
+        {
+            const PendingFile& pendingFile = batch[nDone + i];
+            if (fds[i] < 0)
+            {
+                Algos::logError(pendingFile, -fds[i]);
+                ++m_nFailed;
+            } else if (closeResults[i] == -ECANCELED) {
+                // a short or failed write breaks the link, finish with blocking calls
+                bool bWritten = writeResults[i] >= 0 &&
+                    Algos::writeAll(fds[i], pendingFile.m_bytes, static_cast<std::size_t>(writeResults[i]));
+                int error = writeResults[i] < 0 ? -writeResults[i] : errno;
+                if (::close(fds[i]) != 0 || !bWritten)
+                {
+                    Algos::logError(pendingFile, bWritten ? errno : error);
+                    ++m_nFailed;
+                }
+            } else if (closeResults[i] < 0) {
+                Algos::logError(pendingFile, -closeResults[i]);
+                ++m_nFailed;
+            }
+        }
+        nDone += nFiles;
+    }
+#endif
+    for (; nDone < batch.size(); ++nDone)
+    {
+        if (!Algos::writeFile(batch[nDone]))
+        {
+            ++m_nFailed;
+        }
+    }
+}
+
+void BatchFileWriter::createDirectories(const std::vector<PendingFile>& batch)
+{
+    for (const PendingFile& pendingFile : batch)
+    {
+        std::filesystem::path path(pendingFile.m_path);
+        if (path.has_parent_path())
+        {
+            std::string directory = path.parent_path().string();
+            if (m_knownDirectories.count(directory) == 0)
+            {
+                // failures surface when opening the file
+                std::error_code errorCode;
+                std::filesystem::create_directories(directory, errorCode);
+                if (!errorCode)
+                {
+                    m_knownDirectories.insert(directory);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,389 @@
+#include "bentoclient/binarychain.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/optionrecordgapfiller.hpp"
+#include "bentoclient/marketenvironment.hpp"
+#include "bentoclient/apputils.hpp"
+#include "bentoclient/zstdstream.hpp"
+#include <boost/log/trivial.hpp>
+#include <fmt/core.h>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace bentoclient;
+
+const char BinaryChain::m_magic[4] = {'B', 'C', 'C', 'F'};
+const std::uint32_t BinaryChain::m_version = 1;
+const std::uint32_t BinaryChain::m_byteOrder = 0x01020304;
+const std::string BinaryChain::m_fileExtension(".bcc");
+
+class BinaryChain::Algos
+{
+public:
+    static_assert(std::is_trivially_copyable_v<Header>, "BinaryChain::Header must be trivially copyable");
+    static constexpr std::size_t m_alignment = 8;
+    static constexpr std::size_t m_nColumns = static_cast<std::size_t>(Column::COUNT);
+    /// @brief Element sizes of the columns in file order
+    static constexpr std::size_t m_elementSizes[m_nColumns] = {
+        sizeof(std::uint32_t),
+        sizeof(double),
+        sizeof(std::uint64_t),
+        sizeof(double),
+        sizeof(std::uint64_t),
+        sizeof(double),
+        sizeof(std::uint64_t),
+        sizeof(std::int64_t),
+        sizeof(std::int64_t),
+        sizeof(std::uint8_t),
+        sizeof(std::uint16_t)
+    };
+    static std::size_t align(std::size_t offset)
+    {
+        return (offset + m_alignment - 1) / m_alignment * m_alignment;
+    }
+    /// @brief Sets column offsets for {nRows} records, returns the offset past the columns
+    static std::size_t layoutColumns(Header& header, std::size_t nRows)
+    {
+        std::size_t offset = align(sizeof(Header));
+        for (std::size_t col = 0; col < m_nColumns; ++col)
+        {
+            header.m_columnOffsets[col] = offset;
+            offset = align(offset + nRows * m_elementSizes[col]);
+        }
+        return offset;
+    }
+    static void copyString(char (&target)[16], const std::string& source, const char* name)
+    {
+        if (source.size() >= sizeof(target))
+        {
+            throw std::invalid_argument(fmt::format("BinaryChain: {} {} exceeds {} characters",
+                name, source, sizeof(target) - 1));
+        }
+        std::memset(target, 0, sizeof(target));
+        std::memcpy(target, source.data(), source.size());
+    }
+    static std::string readString(const char (&source)[16])
+    {
+        return std::string(source, strnlen(source, sizeof(source)));
+    }
+    static std::int64_t toNanoseconds(const Timestamp& timestamp)
+    {
+        return static_cast<std::int64_t>(timestamp.time_since_epoch().count());
+    }
+    static Timestamp fromNanoseconds(std::int64_t nanoseconds)
+    {
+        return Timestamp(Timestamp::duration(static_cast<Timestamp::duration::rep>(nanoseconds)));
+    }
+    static std::uint32_t parseStrikeKey(const std::string& strikeKey)
+    {
+        std::uint32_t strike = 0;
+        auto result = std::from_chars(strikeKey.data(), strikeKey.data() + strikeKey.size(), strike);
+        if (strikeKey.size() != 8 || result.ec != std::errc{} || result.ptr != strikeKey.data() + strikeKey.size())
+        {
+            throw std::invalid_argument("BinaryChain: invalid strike key " + strikeKey);
+        }
+        return strike;
+    }
+    template <typename T>
+    static T* column(std::vector<char>& bytes, const Header& header, Column col)
+    {
+        return reinterpret_cast<T*>(bytes.data() + header.m_columnOffsets[static_cast<std::size_t>(col)]);
+    }
+};
+
+constexpr std::size_t BinaryChain::Algos::m_elementSizes[];
+
+BinaryChain::Summary BinaryChain::makeSummary(const OptionChain& optionChain,
+    const MarketEnvironment& marketEnvironment)
+{
+    const DateUtils::ExchangeClose& exchangeClose = marketEnvironment.getExchangeClose();
+    Summary summary{optionChain.getExpiryTime(exchangeClose), std::nan("0xbad"),
+        std::nan("0xbad"), std::nan("0xbad")};
+    try {
+        summary.m_riskFreeRate = marketEnvironment.getRiskFreeRate(
+            optionChain.getChainTime(), summary.m_expiryTime);
+        summary.m_parityRate = optionChain.getParityRate(summary.m_riskFreeRate, exchangeClose);
+        summary.m_precision = std::sqrt(optionChain.getParityRateQualityScore(
+            summary.m_riskFreeRate, exchangeClose));
+    } catch (const std::exception& e)
+    {
+        BOOST_LOG_TRIVIAL(warning) << "Incomplete binary chain summary for symbol " << optionChain.getUnderlier()
+            << " at " << optionChain.getValuationDate() << " for expiry " << optionChain.getExpiryDate()
+            << ", due to cause: " << e.what();
+    }
+    return summary;
+}
+
+void BinaryChain::write(std::ostream& ostr, const OptionChain& optionChain, const Summary& summary)
+{
+    const OptionChain::RecordMap& puts = optionChain.getPuts();
+    const OptionChain::RecordMap& calls = optionChain.getCalls();
+    std::size_t nRows = puts.size() + calls.size();
+    Header header{};
+    std::memcpy(header.m_magic, m_magic, sizeof(m_magic));
+    header.m_version = m_version;
+    header.m_byteOrder = m_byteOrder;
+    header.m_nPuts = static_cast<std::uint32_t>(puts.size());
+    header.m_nCalls = static_cast<std::uint32_t>(calls.size());
+    header.m_chainTime = Algos::toNanoseconds(optionChain.getChainTime());
+    header.m_expiryTime = Algos::toNanoseconds(summary.m_expiryTime);
+    header.m_parityRate = summary.m_parityRate;
+    header.m_precision = summary.m_precision;
+    header.m_riskFreeRate = summary.m_riskFreeRate;
+    Algos::copyString(header.m_symbol, optionChain.getUnderlier(), "symbol");
+    Algos::copyString(header.m_valuationDate, optionChain.getValuationDate(), "valuation date");
+    Algos::copyString(header.m_expiryDate, optionChain.getExpiryDate(), "expiry date");
+    std::size_t columnsEnd = Algos::layoutColumns(header, nRows);
+
+    std::vector<char> bytes(columnsEnd);
+    auto strikes = Algos::column<std::uint32_t>(bytes, header, Column::STRIKE);
+    auto bidPrices = Algos::column<double>(bytes, header, Column::BID_PRICE);
+    auto bidSizes = Algos::column<std::uint64_t>(bytes, header, Column::BID_SIZE);
+    auto askPrices = Algos::column<double>(bytes, header, Column::ASK_PRICE);
+    auto askSizes = Algos::column<std::uint64_t>(bytes, header, Column::ASK_SIZE);
+    auto tradePrices = Algos::column<double>(bytes, header, Column::TRADE_PRICE);
+    auto tradeSizes = Algos::column<std::uint64_t>(bytes, header, Column::TRADE_SIZE);
+    auto tradeTimes = Algos::column<std::int64_t>(bytes, header, Column::TRADE_TIME);
+    auto recvTimes = Algos::column<std::int64_t>(bytes, header, Column::RECV_TIME);
+    auto provenances = Algos::column<std::uint8_t>(bytes, header, Column::PROVENANCE);
+    auto commentIndices = Algos::column<std::uint16_t>(bytes, header, Column::COMMENT);
+    // distinct comments in order of appearance, the empty comment first
+    std::vector<const std::string*> comments;
+    std::map<std::string, std::uint16_t> commentToIndex;
+    const std::string emptyComment;
+    comments.push_back(&emptyComment);
+    commentToIndex.emplace(emptyComment, 0);
+    std::size_t row = 0;
+    for (const OptionChain::RecordMap* recordMap : {&puts, &calls})
+    {
+        for (const auto& pair : *recordMap)
+        {
+            const OptionChain::Record& record = pair.second;
+            strikes[row] = Algos::parseStrikeKey(pair.first);
+            bidPrices[row] = record.m_bidPrice.price();
+            bidSizes[row] = std::get<1>(record.m_bidPrice);
+            askPrices[row] = record.m_askPrice.price();
+            askSizes[row] = std::get<1>(record.m_askPrice);
+            tradePrices[row] = record.m_price.price();
+            tradeSizes[row] = std::get<1>(record.m_price);
+            tradeTimes[row] = Algos::toNanoseconds(record.m_priceTime);
+            recvTimes[row] = Algos::toNanoseconds(record.m_recvTime);
+            provenances[row] = getProvenance(record.m_comment);
+            auto commentIt = commentToIndex.find(record.m_comment);
+            if (commentIt == commentToIndex.end())
+            {
+                if (comments.size() > std::numeric_limits<std::uint16_t>::max())
+                {
+                    throw std::invalid_argument("BinaryChain: too many distinct comments");
+                }
+                commentIt = commentToIndex.emplace(record.m_comment,
+                    static_cast<std::uint16_t>(comments.size())).first;
+                comments.push_back(&record.m_comment);
+            }
+            commentIndices[row] = commentIt->second;
+            ++row;
+        }
+    }
+    header.m_nComments = static_cast<std::uint32_t>(comments.size());
+    header.m_commentsOffset = columnsEnd;
+    for (const std::string* comment : comments)
+    {
+        std::uint32_t length = static_cast<std::uint32_t>(comment->size());
+        const char* lengthBytes = reinterpret_cast<const char*>(&length);
+        bytes.insert(bytes.end(), lengthBytes, lengthBytes + sizeof(length));
+        bytes.insert(bytes.end(), comment->begin(), comment->end());
+    }
+    header.m_fileSize = bytes.size();
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    ostr.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+std::uint8_t BinaryChain::getProvenance(const std::string& comment)
+{
+    static const std::pair<const std::string*, Provenance> tags[] = {
+        {&OptionRecordGapFiller::m_pcpFitComment, PCP_FIT},
+        {&OptionRecordGapFiller::m_spreadFitComment, SPREAD_FIT},
+        {&OptionRecordGapFiller::m_linInterpolComment, LIN_INTERPOL},
+        {&OptionRecordGapFiller::m_logExtrapolateComment, LOG_EXTRAPOLATE},
+        {&OptionChain::m_deltaShiftComment, DELTA_SHIFT}
+    };
+    std::uint8_t provenance = 0;
+    if (comment.empty())
+    {
+        return provenance;
+    }
+    for (const std::string& tag : AppUtils::splitStr(comment, ":"))
+    {
+        std::uint8_t flag = OTHER;
+        for (const auto& knownTag : tags)
+        {
+            if (tag == *knownTag.first)
+            {
+                flag = knownTag.second;
+                break;
+            }
+        }
+        provenance |= flag;
+    }
+    return provenance;
+}
+
+BinaryChain::Reader::Reader(const std::string& path, const ZstdStream::Dictionary* dictionary) :
+    m_bytes(),
+    m_data(nullptr),
+    m_size(0)
+{
+    std::ifstream istr(path, std::ios::binary | std::ios::ate);
+    if (!istr)
+    {
+        throw std::runtime_error("BinaryChain: failed to open " + path);
+    }
+    std::streamsize size = istr.tellg();
+    istr.seekg(0);
+    m_bytes.resize(static_cast<std::size_t>(size));
+    if (!istr.read(m_bytes.data(), size))
+    {
+        throw std::runtime_error("BinaryChain: failed to read " + path);
+    }
+    if (ZstdStream::isCompressed(m_bytes.data(), m_bytes.size()))
+    {
+        std::string decompressed = ZstdStream::decompress(std::string(m_bytes.data(), m_bytes.size()),
+            dictionary);
+        m_bytes.assign(decompressed.begin(), decompressed.end());
+    }
+    m_data = m_bytes.data();
+    m_size = m_bytes.size();
+    validate();
+}
+
+BinaryChain::Reader::Reader(std::vector<char>&& bytes) :
+    m_bytes(std::move(bytes)),
+    m_data(m_bytes.data()),
+    m_size(m_bytes.size())
+{
+    validate();
+}
+
+BinaryChain::Reader::Reader(const char* data, std::size_t size) :
+    m_bytes(),
+    m_data(data),
+    m_size(size)
+{
+    validate();
+}
+
+void BinaryChain::Reader::validate()
+{
+    if (m_size < sizeof(Header) || reinterpret_cast<std::uintptr_t>(m_data) % Algos::m_alignment != 0)
+    {
+        throw std::runtime_error("BinaryChain: truncated or misaligned file");
+    }
+    const Header& header = getHeader();
+    if (std::memcmp(header.m_magic, m_magic, sizeof(m_magic)) != 0)
+    {
+        throw std::runtime_error("BinaryChain: not a binary chain file");
+    }
+    if (header.m_version != m_version || header.m_byteOrder != m_byteOrder)
+    {
+        throw std::runtime_error(fmt::format("BinaryChain: unsupported version {} or byte order {:#x}",
+            header.m_version, header.m_byteOrder));
+    }
+    Header layout{};
+    std::size_t columnsEnd = Algos::layoutColumns(layout, getRowCount());
+    if (header.m_fileSize != m_size || header.m_commentsOffset != columnsEnd
+        || std::memcmp(layout.m_columnOffsets, header.m_columnOffsets, sizeof(layout.m_columnOffsets)) != 0)
+    {
+        throw std::runtime_error("BinaryChain: corrupted column layout");
+    }
+    std::size_t offset = header.m_commentsOffset;
+    m_comments.clear();
+    m_comments.reserve(header.m_nComments);
+    for (std::uint32_t i = 0; i < header.m_nComments; ++i)
+    {
+        std::uint32_t length = 0;
+        if (offset + sizeof(length) > m_size)
+        {
+            throw std::runtime_error("BinaryChain: corrupted comment table");
+        }
+        std::memcpy(&length, m_data + offset, sizeof(length));
+        offset += sizeof(length);
+        if (offset + length > m_size)
+        {
+            throw std::runtime_error("BinaryChain: corrupted comment table");
+        }
+        m_comments.emplace_back(m_data + offset, length);
+        offset += length;
+    }
+    const std::uint16_t* commentIndices = getColumn<std::uint16_t>(Column::COMMENT);
+    for (std::size_t row = 0; row < getRowCount(); ++row)
+    {
+        if (commentIndices[row] >= m_comments.size())
+        {
+            throw std::runtime_error("BinaryChain: comment index out of range");
+        }
+    }
+}
+
+std::string BinaryChain::Reader::getSymbol() const
+{
+    return Algos::readString(getHeader().m_symbol);
+}
+
+std::string BinaryChain::Reader::getValuationDate() const
+{
+    return Algos::readString(getHeader().m_valuationDate);
+}
+
+std::string BinaryChain::Reader::getExpiryDate() const
+{
+    return Algos::readString(getHeader().m_expiryDate);
+}
+
+Timestamp BinaryChain::Reader::getChainTime() const
+{
+    return Algos::fromNanoseconds(getHeader().m_chainTime);
+}
+
+Timestamp BinaryChain::Reader::getExpiryTime() const
+{
+    return Algos::fromNanoseconds(getHeader().m_expiryTime);
+}
+
+std::string BinaryChain::Reader::getStrikeKey(std::size_t row) const
+{
+    return fmt::format("{:08d}", getStrikes()[row]);
+}
+
+OptionChain BinaryChain::Reader::toOptionChain() const
+{
+    OptionChain::PutCallRecordMap recordMaps;
+    const std::uint64_t* bidSizes = getBidSizes();
+    const std::uint64_t* askSizes = getAskSizes();
+    const std::uint64_t* tradeSizes = getTradeSizes();
+    const double* bidPrices = getBidPrices();
+    const double* askPrices = getAskPrices();
+    const double* tradePrices = getTradePrices();
+    const std::int64_t* tradeTimes = getTradeTimes();
+    const std::int64_t* recvTimes = getRecvTimes();
+    std::size_t nPuts = getHeader().m_nPuts;
+    for (std::size_t row = 0; row < getRowCount(); ++row)
+    {
+        OptionChain::RecordMap& recordMap = row < nPuts ? recordMaps.first : recordMaps.second;
+        OptionChain::Record record(
+            OptionChain::PriceWeight::fromPrice(tradePrices[row], tradeSizes[row]),
+            Algos::fromNanoseconds(tradeTimes[row]),
+            OptionChain::PriceWeight::fromPrice(askPrices[row], askSizes[row]),
+            OptionChain::PriceWeight::fromPrice(bidPrices[row], bidSizes[row]),
+            Algos::fromNanoseconds(recvTimes[row]));
+        record.m_comment = getComment(row);
+        // keys are written in map order, so hinted inserts append
+        recordMap.emplace_hint(recordMap.end(), getStrikeKey(row), std::move(record));
+    }
+    return OptionChain::fromRecords(getSymbol(), getValuationDate(), getExpiryDate(),
+        std::move(recordMaps));
+}
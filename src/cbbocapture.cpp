@@ -0,0 +1,210 @@
+#include "bentoclient/cbbocapture.hpp"
+#include "bentoclient/optioninstruments.hpp"
+#include "bentoclient/marketenvironment.hpp"
+#include <boost/log/trivial.hpp>
+#include <fmt/core.h>
+#include <fmt/chrono.h>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace bentoclient;
+
+const char CbboCapture::m_magic[4] = {'B', 'C', 'B', 'O'};
+const std::uint32_t CbboCapture::m_version = 1;
+const std::uint32_t CbboCapture::m_byteOrder = 0x01020304;
+const std::string CbboCapture::m_fileExtension(".cbc");
+
+class CbboCapture::Algos
+{
+public:
+    static_assert(std::is_trivially_copyable_v<databento::CbboMsg>, "CbboCapture writes raw cbbo records");
+    static_assert(std::is_trivially_copyable_v<Header>, "CbboCapture::Header must be trivially copyable");
+    static void copyString(char (&target)[16], const std::string& source, const char* name)
+    {
+        if (source.size() >= sizeof(target))
+        {
+            throw std::invalid_argument(fmt::format("CbboCapture: {} {} exceeds {} characters",
+                name, source, sizeof(target) - 1));
+        }
+        std::memset(target, 0, sizeof(target));
+        std::memcpy(target, source.data(), source.size());
+    }
+    static std::string readString(const char (&source)[16])
+    {
+        return std::string(source, strnlen(source, sizeof(source)));
+    }
+    template <typename T>
+    static void writeValue(std::ostream& ostr, const T& value)
+    {
+        ostr.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    template <typename T>
+    static T readValue(std::istream& istr)
+    {
+        T value;
+        if (!istr.read(reinterpret_cast<char*>(&value), sizeof(value)))
+        {
+            throw std::runtime_error("CbboCapture: truncated file");
+        }
+        return value;
+    }
+    static void writeString(std::ostream& ostr, const std::string& value)
+    {
+        writeValue(ostr, static_cast<std::uint16_t>(value.size()));
+        ostr.write(value.data(), static_cast<std::streamsize>(value.size()));
+    }
+    static std::string readString(std::istream& istr)
+    {
+        std::string value(readValue<std::uint16_t>(istr), '\0');
+        if (!istr.read(value.data(), static_cast<std::streamsize>(value.size())))
+        {
+            throw std::runtime_error("CbboCapture: truncated file");
+        }
+        return value;
+    }
+};
+
+CbboCapture::CbboCapture(const std::string& symbol, const std::string& valuationDate,
+    const std::string& expiryDate, Timestamp requestTime,
+    std::map<std::string, std::string> idToOsi,
+    OptionChain::InstrumentIdToCbboMap cbboMap) :
+    m_symbol(symbol),
+    m_valuationDate(valuationDate),
+    m_expiryDate(expiryDate),
+    m_requestTime(requestTime),
+    m_idToOsi(std::move(idToOsi)),
+    m_cbboMap(std::move(cbboMap))
+{}
+
+void CbboCapture::write(std::ostream& ostr, const std::string& symbol, const std::string& valuationDate,
+    const std::string& expiryDate, Timestamp requestTime,
+    const std::map<std::string, std::string>& idToOsi,
+    const OptionChain::InstrumentIdToCbboMap& cbboMap)
+{
+    // instruments of the chain, and any without OSI ID the cbbo map may have
+    std::map<std::string, const std::string*> instruments;
+    static const std::string noOsi;
+    for (auto& idOsiPair : idToOsi)
+    {
+        instruments[idOsiPair.first] = &idOsiPair.second;
+    }
+    Header header{};
+    for (auto& cbboPair : cbboMap)
+    {
+        instruments.try_emplace(cbboPair.first, &noOsi);
+        header.m_nCbboMsgs += cbboPair.second.size();
+    }
+    std::memcpy(header.m_magic, m_magic, sizeof(m_magic));
+    header.m_version = m_version;
+    header.m_byteOrder = m_byteOrder;
+    header.m_nInstruments = static_cast<std::uint32_t>(instruments.size());
+    header.m_requestTime = static_cast<std::int64_t>(requestTime.time_since_epoch().count());
+    Algos::copyString(header.m_symbol, symbol, "symbol");
+    Algos::copyString(header.m_valuationDate, valuationDate, "valuation date");
+    Algos::copyString(header.m_expiryDate, expiryDate, "expiry date");
+    Algos::writeValue(ostr, header);
+    for (auto& instrument : instruments)
+    {
+        Algos::writeString(ostr, instrument.first);
+        Algos::writeString(ostr, *instrument.second);
+        auto cbboIt = cbboMap.find(instrument.first);
+        std::uint32_t nCbboMsgs = cbboIt == cbboMap.end() ? 0 : static_cast<std::uint32_t>(cbboIt->second.size());
+        Algos::writeValue(ostr, nCbboMsgs);
+        if (nCbboMsgs > 0)
+        {
+            for (auto& cbboMsg : cbboIt->second)
+            {
+                Algos::writeValue(ostr, cbboMsg);
+            }
+        }
+    }
+    if (!ostr)
+    {
+        throw std::runtime_error("CbboCapture: failed to write capture of " + symbol);
+    }
+}
+
+CbboCapture CbboCapture::read(std::istream& istr)
+{
+    Header header = Algos::readValue<Header>(istr);
+    if (std::memcmp(header.m_magic, m_magic, sizeof(m_magic)) != 0)
+    {
+        throw std::runtime_error("CbboCapture: not a cbbo capture file");
+    }
+    if (header.m_version != m_version || header.m_byteOrder != m_byteOrder)
+    {
+        throw std::runtime_error(fmt::format("CbboCapture: unsupported version {} or byte order {:#x}",
+            header.m_version, header.m_byteOrder));
+    }
+    std::map<std::string, std::string> idToOsi;
+    OptionChain::InstrumentIdToCbboMap cbboMap;
+    for (std::uint32_t i = 0; i < header.m_nInstruments; ++i)
+    {
+        std::string instrumentId = Algos::readString(istr);
+        std::string osiIdentifier = Algos::readString(istr);
+        if (!osiIdentifier.empty())
+        {
+            idToOsi.emplace(instrumentId, std::move(osiIdentifier));
+        }
+        std::uint32_t nCbboMsgs = Algos::readValue<std::uint32_t>(istr);
+        if (nCbboMsgs > 0)
+        {
+            auto& cbboMsgs = cbboMap[instrumentId];
+            for (std::uint32_t n = 0; n < nCbboMsgs; ++n)
+            {
+                cbboMsgs.push_back(Algos::readValue<databento::CbboMsg>(istr));
+            }
+        }
+    }
+    return CbboCapture(Algos::readString(header.m_symbol),
+        Algos::readString(header.m_valuationDate),
+        Algos::readString(header.m_expiryDate),
+        Timestamp(Timestamp::duration(static_cast<Timestamp::duration::rep>(header.m_requestTime))),
+        std::move(idToOsi),
+        std::move(cbboMap));
+}
+
+CbboCapture CbboCapture::load(const std::string& path)
+{
+    std::ifstream istr(path, std::ios::binary);
+    if (!istr)
+    {
+        throw std::runtime_error("CbboCapture: failed to open " + path);
+    }
+    try {
+        return read(istr);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(fmt::format("{} in {}", e.what(), path));
+    }
+}
+
+std::string CbboCapture::makeFileName(const std::string& symbol, const std::string& valuationDate,
+    const std::string& expiryDate, Timestamp requestTime)
+{
+    return fmt::format("{}_cbbo_{}_{}_{:%H-%M-%S}{}", symbol, valuationDate, expiryDate,
+        std::chrono::time_point_cast<std::chrono::seconds>(requestTime), m_fileExtension);
+}
+
+OptionChain CbboCapture::buildOptionChain(const MarketEnvironment& marketEnvironment,
+    TimeRange deltaShiftStaleAfter) const
+{
+    std::map<std::string, std::string> osiToId;
+    for (auto& idOsiPair : m_idToOsi)
+    {
+        osiToId.emplace(idOsiPair.second, idOsiPair.first);
+    }
+    OptionInstruments optionInstruments;
+    optionInstruments.insert(m_valuationDate, osiToId);
+    OptionInstruments chainInstruments = optionInstruments.get(m_symbol, m_valuationDate, m_expiryDate);
+    OptionChain::RecordTimeline timeline = OptionChain::buildRecordTimeline(m_cbboMap, m_idToOsi);
+    OptionChain rawChain(OptionChain::build(OptionChain::mapLatestBestInTimelineToRecord(timeline),
+        chainInstruments));
+    if (rawChain.isValid() && deltaShiftStaleAfter > TimeRange::zero())
+    {
+        // the same shift as of RequesterSynchronous, failures keep the unshifted chain
+        rawChain.shiftStaleRecords(timeline, marketEnvironment, deltaShiftStaleAfter);
+    }
+    return rawChain;
+}
@@ -0,0 +1,394 @@
+#include "bentoclient/chainhistory.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/marketenvironmentextended.hpp"
+#include <mutex>
+#include <stdexcept>
+
+using namespace bentoclient;
+
+class ChainHistory::Algos
+{
+public:
+    /// @brief Fields present in an encoded record
+    enum Flags : std::uint8_t
+    {
+        HAS_BID = 1,
+        HAS_ASK = 2,
+        HAS_TRADE = 4,
+        HAS_RECV_TIME = 8,
+        HAS_TRADE_TIME = 16,
+        HAS_COMMENT = 32
+    };
+    /// @brief Largest tick unit, a whole price unit
+    static constexpr std::uint64_t m_maxTickUnit = 1000000000;
+
+    static std::uint64_t zigzag(std::int64_t value)
+    {
+        return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+    static std::int64_t unzigzag(std::uint64_t value)
+    {
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+    static void putVarint(std::vector<std::uint8_t>& bytes, std::uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<std::uint8_t>(value));
+    }
+    static void putSigned(std::vector<std::uint8_t>& bytes, std::int64_t value)
+    {
+        putVarint(bytes, zigzag(value));
+    }
+
+    /// @brief Sequential reader of an encoded snapshot
+    class Cursor
+    {
+    public:
+        explicit Cursor(const std::vector<std::uint8_t>& bytes) :
+            m_pos(bytes.data()), m_end(bytes.data() + bytes.size())
+        {}
+        std::uint64_t getVarint()
+        {
+            std::uint64_t value = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7)
+            {
+                std::uint8_t byte = getByte();
+                value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return value;
+                }
+            }
+            throw std::runtime_error("ChainHistory: malformed varint");
+        }
+        std::int64_t getSigned()
+        {
+            return unzigzag(getVarint());
+        }
+        std::uint8_t getByte()
+        {
+            if (m_pos == m_end)
+            {
+                throw std::runtime_error("ChainHistory: truncated snapshot");
+            }
+            return *m_pos++;
+        }
+    private:
+        const std::uint8_t* m_pos;
+        const std::uint8_t* m_end;
+    };
+
+    static std::int64_t toNanoseconds(Timestamp timestamp)
+    {
+        return static_cast<std::int64_t>(timestamp.time_since_epoch().count());
+    }
+    static Timestamp fromNanoseconds(std::int64_t nanoseconds)
+    {
+        return Timestamp(Timestamp::duration(static_cast<Timestamp::duration::rep>(nanoseconds)));
+    }
+
+    /// @brief Record values prepared for encoding
+    struct Fields
+    {
+        std::uint8_t m_flags;
+        std::int64_t m_bidTicks;
+        std::int64_t m_askTicks;
+        std::int64_t m_tradeTicks;
+    };
+    static Fields makeFields(const OptionChain::Record& record)
+    {
+        // prices of zero weight are irrelevant and not kept
+        Fields fields{0, record.m_bidPrice.fixedPrice(), record.m_askPrice.fixedPrice(),
+            record.m_price.fixedPrice()};
+        if (record.m_bidPrice.weight() > 0)
+        {
+            fields.m_flags |= HAS_BID;
+        }
+        if (record.m_askPrice.weight() > 0)
+        {
+            fields.m_flags |= HAS_ASK;
+        }
+        if (record.m_price.weight() > 0)
+        {
+            fields.m_flags |= HAS_TRADE;
+        }
+        if (record.m_recvTime.time_since_epoch().count() != 0)
+        {
+            fields.m_flags |= HAS_RECV_TIME;
+        }
+        if (record.m_priceTime.time_since_epoch().count() != 0)
+        {
+            fields.m_flags |= HAS_TRADE_TIME;
+        }
+        if (!record.m_comment.empty())
+        {
+            fields.m_flags |= HAS_COMMENT;
+        }
+        return fields;
+    }
+    /// @brief Reduces {tickUnit} to a power of 10 dividing the ticks of {fields}
+    static void reduceTickUnit(const Fields& fields, std::uint64_t& tickUnit)
+    {
+        auto reduce = [&tickUnit](std::int64_t ticks) {
+            while (tickUnit > 1 && ticks % static_cast<std::int64_t>(tickUnit) != 0)
+            {
+                tickUnit /= 10;
+            }
+        };
+        if (fields.m_flags & HAS_BID) reduce(fields.m_bidTicks);
+        if (fields.m_flags & HAS_ASK) reduce(fields.m_askTicks);
+        if (fields.m_flags & HAS_TRADE) reduce(fields.m_tradeTicks);
+    }
+
+    static std::uint32_t getIndex(const std::string& key, std::vector<std::string>& keys,
+        std::unordered_map<std::string, std::uint32_t>& indices)
+    {
+        auto it = indices.find(key);
+        if (it == indices.end())
+        {
+            it = indices.emplace(key, static_cast<std::uint32_t>(keys.size())).first;
+            keys.push_back(key);
+        }
+        return it->second;
+    }
+
+    /// @brief Appends the records of one side to {bytes}
+    static void encode(const OptionChain::RecordMap& recordMap, const std::vector<Fields>& fields,
+        std::size_t& row, std::int64_t chainTime, std::uint64_t tickUnit,
+        Series& series, std::vector<std::uint8_t>& bytes)
+    {
+        std::int64_t previousIndex = -1;
+        std::int64_t unit = static_cast<std::int64_t>(tickUnit);
+        for (auto& pair : recordMap)
+        {
+            const OptionChain::Record& record = pair.second;
+            const Fields& field = fields[row++];
+            std::int64_t index = getIndex(pair.first, series.m_strikeKeys, series.m_strikeIndices);
+            putSigned(bytes, index - previousIndex);
+            previousIndex = index;
+            bytes.push_back(field.m_flags);
+            if (field.m_flags & HAS_BID)
+            {
+                putVarint(bytes, record.m_bidPrice.weight());
+            }
+            if (field.m_flags & HAS_ASK)
+            {
+                putVarint(bytes, record.m_askPrice.weight());
+            }
+            if (field.m_flags & HAS_TRADE)
+            {
+                putVarint(bytes, record.m_price.weight());
+            }
+            // ask and trade relative to bid, which is mostly a few ticks away
+            std::int64_t base = (field.m_flags & HAS_BID) ? field.m_bidTicks / unit : 0;
+            if (field.m_flags & HAS_BID) putSigned(bytes, base);
+            if (field.m_flags & HAS_ASK) putSigned(bytes, field.m_askTicks / unit - base);
+            if (field.m_flags & HAS_TRADE) putSigned(bytes, field.m_tradeTicks / unit - base);
+            if (field.m_flags & HAS_RECV_TIME)
+            {
+                putSigned(bytes, chainTime - toNanoseconds(record.m_recvTime));
+            }
+            if (field.m_flags & HAS_TRADE_TIME)
+            {
+                putSigned(bytes, chainTime - toNanoseconds(record.m_priceTime));
+            }
+            if (field.m_flags & HAS_COMMENT)
+            {
+                putVarint(bytes, getIndex(record.m_comment, series.m_comments, series.m_commentIndices));
+            }
+        }
+    }
+
+    /// @brief Decodes {nRecords} records of one side from {cursor}
+    static OptionChain::RecordMap decode(Cursor& cursor, std::uint32_t nRecords,
+        std::int64_t chainTime, std::uint64_t tickUnit, const Series& series)
+    {
+        OptionChain::RecordMap recordMap;
+        std::int64_t index = -1;
+        std::int64_t unit = static_cast<std::int64_t>(tickUnit);
+        for (std::uint32_t n = 0; n < nRecords; ++n)
+        {
+            index += cursor.getSigned();
+            if (index < 0 || static_cast<std::size_t>(index) >= series.m_strikeKeys.size())
+            {
+                throw std::runtime_error("ChainHistory: invalid strike index");
+            }
+            std::uint8_t flags = cursor.getByte();
+            OptionChain::Record record;
+            if (flags & HAS_BID) record.m_bidPrice.weight() = cursor.getVarint();
+            if (flags & HAS_ASK) record.m_askPrice.weight() = cursor.getVarint();
+            if (flags & HAS_TRADE) record.m_price.weight() = cursor.getVarint();
+            std::int64_t base = (flags & HAS_BID) ? cursor.getSigned() : 0;
+            if (flags & HAS_BID) record.m_bidPrice.fixedPrice() = base * unit;
+            if (flags & HAS_ASK) record.m_askPrice.fixedPrice() = (cursor.getSigned() + base) * unit;
+            if (flags & HAS_TRADE) record.m_price.fixedPrice() = (cursor.getSigned() + base) * unit;
+            if (flags & HAS_RECV_TIME)
+            {
+                record.m_recvTime = fromNanoseconds(chainTime - cursor.getSigned());
+            }
+            if (flags & HAS_TRADE_TIME)
+            {
+                record.m_priceTime = fromNanoseconds(chainTime - cursor.getSigned());
+            }
+            if (flags & HAS_COMMENT)
+            {
+                record.m_comment = series.m_comments.at(cursor.getVarint());
+            }
+            // keys are encoded in map order, so hinted inserts append
+            recordMap.emplace_hint(recordMap.end(), series.m_strikeKeys[index], std::move(record));
+        }
+        return recordMap;
+    }
+};
+
+ChainHistory::ChainHistory() :
+    m_series(),
+    m_nSnapshots(0),
+    m_mutex()
+{}
+
+ChainHistory::~ChainHistory()
+{}
+
+void ChainHistory::append(const OptionChain& optionChain)
+{
+    Timestamp chainTime = optionChain.getChainTime();
+    std::int64_t chainTimeNs = Algos::toNanoseconds(chainTime);
+    // ticks and the common tick unit don't depend on the shared tables
+    std::vector<Algos::Fields> fields;
+    fields.reserve(optionChain.getPuts().size() + optionChain.getCalls().size());
+    std::uint64_t tickUnit = Algos::m_maxTickUnit;
+    for (auto* recordMap : {&optionChain.getPuts(), &optionChain.getCalls()})
+    {
+        for (auto& pair : *recordMap)
+        {
+            fields.push_back(Algos::makeFields(pair.second));
+            Algos::reduceTickUnit(fields.back(), tickUnit);
+        }
+    }
+    Snapshot snapshot{optionChain.getValuationDate(), tickUnit,
+        static_cast<std::uint32_t>(optionChain.getPuts().size()),
+        static_cast<std::uint32_t>(optionChain.getCalls().size()),
+        {}};
+    // roughly the size of raw records with a few ticks of spread
+    snapshot.m_bytes.reserve(fields.size() * 16);
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    Series& series = m_series[optionChain.getUnderlier()][optionChain.getExpiryDate()];
+    std::size_t row = 0;
+    Algos::encode(optionChain.getPuts(), fields, row, chainTimeNs, tickUnit, series, snapshot.m_bytes);
+    Algos::encode(optionChain.getCalls(), fields, row, chainTimeNs, tickUnit, series, snapshot.m_bytes);
+    snapshot.m_bytes.shrink_to_fit();
+    auto result = series.m_snapshots.insert_or_assign(chainTime, std::move(snapshot));
+    if (result.second)
+    {
+        ++m_nSnapshots;
+    }
+}
+
+bool ChainHistory::find(const std::string& symbol, Timestamp dateTime, const std::string& expiryDate,
+    TimeRange timeRange, Timestamp& chainTime) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    const Series* series = findSeries(symbol, expiryDate);
+    if (series == nullptr)
+    {
+        return false;
+    }
+    auto next = MarketEnvironmentExtended::getNextInTimeRange(dateTime, series->m_snapshots, timeRange);
+    if (next.second)
+    {
+        chainTime = next.first;
+    }
+    return next.second;
+}
+
+OptionChain ChainHistory::get(const std::string& symbol, const std::string& expiryDate,
+    Timestamp chainTime) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    const Series* series = findSeries(symbol, expiryDate);
+    if (series == nullptr)
+    {
+        throw std::out_of_range("ChainHistory: no chains of " + symbol + " expiring " + expiryDate);
+    }
+    auto it = series->m_snapshots.find(chainTime);
+    if (it == series->m_snapshots.end())
+    {
+        throw std::out_of_range("ChainHistory: no chain of " + symbol + " expiring " + expiryDate
+            + " at " + serializeTimestamp(chainTime));
+    }
+    const Snapshot& snapshot = it->second;
+    std::int64_t chainTimeNs = Algos::toNanoseconds(chainTime);
+    Algos::Cursor cursor(snapshot.m_bytes);
+    OptionChain::PutCallRecordMap recordMaps;
+    recordMaps.first = Algos::decode(cursor, snapshot.m_nPuts, chainTimeNs, snapshot.m_tickUnit, *series);
+    recordMaps.second = Algos::decode(cursor, snapshot.m_nCalls, chainTimeNs, snapshot.m_tickUnit, *series);
+    return OptionChain::fromRecords(symbol, snapshot.m_valuationDate, expiryDate, std::move(recordMaps));
+}
+
+std::vector<Timestamp> ChainHistory::getChainTimes(const std::string& symbol,
+    const std::string& expiryDate) const
+{
+    std::vector<Timestamp> chainTimes;
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    const Series* series = findSeries(symbol, expiryDate);
+    if (series != nullptr)
+    {
+        chainTimes.reserve(series->m_snapshots.size());
+        for (auto& pair : series->m_snapshots)
+        {
+            chainTimes.push_back(pair.first);
+        }
+    }
+    return chainTimes;
+}
+
+std::size_t ChainHistory::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_nSnapshots;
+}
+
+std::size_t ChainHistory::getMemoryUsage() const
+{
+    // map and hash nodes estimated at their payload plus three pointers
+    constexpr std::size_t nodeOverhead = 3 * sizeof(void*);
+    std::size_t nBytes = 0;
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    for (auto& symbolPair : m_series)
+    {
+        for (auto& expiryPair : symbolPair.second)
+        {
+            const Series& series = expiryPair.second;
+            nBytes += sizeof(Series) + nodeOverhead;
+            for (auto* keys : {&series.m_strikeKeys, &series.m_comments})
+            {
+                // key vector entry and index map node per key
+                nBytes += keys->size() * (2 * sizeof(std::string) + sizeof(std::uint32_t) + nodeOverhead);
+            }
+            for (auto& snapshotPair : series.m_snapshots)
+            {
+                nBytes += sizeof(Timestamp) + sizeof(Snapshot) + nodeOverhead
+                    + snapshotPair.second.m_bytes.capacity();
+            }
+        }
+    }
+    return nBytes;
+}
+
+const ChainHistory::Series* ChainHistory::findSeries(const std::string& symbol,
+    const std::string& expiryDate) const
+{
+    auto symbolIt = m_series.find(symbol);
+    if (symbolIt == m_series.end())
+    {
+        return nullptr;
+    }
+    auto expiryIt = symbolIt->second.find(expiryDate);
+    return expiryIt == symbolIt->second.end() ? nullptr : &expiryIt->second;
+}
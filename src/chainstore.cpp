@@ -0,0 +1,308 @@
+#include "bentoclient/chainstore.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/marketenvironmentextended.hpp"
+#include <boost/log/trivial.hpp>
+#include <fmt/core.h>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace bentoclient;
+
+const std::string ChainStore::m_dataFileName("chains.bcs");
+const std::string ChainStore::m_indexFileName("chains.bci");
+
+class ChainStore::Algos
+{
+public:
+    static_assert(std::is_trivially_copyable_v<IndexEntry>, "ChainStore::IndexEntry must be trivially copyable");
+    static constexpr std::uint64_t m_alignment = 8;
+    static std::uint64_t align(std::uint64_t offset)
+    {
+        return (offset + m_alignment - 1) / m_alignment * m_alignment;
+    }
+    static std::uint64_t getFileSize(const std::string& path)
+    {
+        std::error_code errorCode;
+        std::uintmax_t size = std::filesystem::file_size(path, errorCode);
+        return errorCode ? 0 : static_cast<std::uint64_t>(size);
+    }
+    static void copyString(char (&target)[16], const std::string& source)
+    {
+        if (source.size() >= sizeof(target))
+        {
+            throw std::invalid_argument(fmt::format("ChainStore: key {} exceeds {} characters",
+                source, sizeof(target) - 1));
+        }
+        std::memset(target, 0, sizeof(target));
+        std::memcpy(target, source.data(), source.size());
+    }
+    static std::string readString(const char (&source)[16])
+    {
+        return std::string(source, strnlen(source, sizeof(source)));
+    }
+    /// @brief Exclusive advisory lock on a file, held by all writers of a store while appending
+    class FileLock
+    {
+    public:
+        explicit FileLock(int fd) : m_fd(fd)
+        {
+            while (::flock(m_fd, LOCK_EX) != 0)
+            {
+                if (errno != EINTR)
+                {
+                    throw std::runtime_error(fmt::format("ChainStore: failed to lock index: {}",
+                        std::strerror(errno)));
+                }
+            }
+        }
+        FileLock(const FileLock&) = delete;
+        FileLock& operator = (const FileLock&) = delete;
+        ~FileLock()
+        {
+            ::flock(m_fd, LOCK_UN);
+        }
+    private:
+        int m_fd;
+    };
+    static void openAppend(std::ofstream& ostr, const std::string& path)
+    {
+        if (!ostr.is_open())
+        {
+            ostr.open(path, std::ios::out | std::ios::binary | std::ios::app);
+            if (!ostr)
+            {
+                throw std::runtime_error("ChainStore: failed to open " + path + " for writing");
+            }
+        }
+    }
+};
+
+ChainStore::ChainStore(const std::string& basePath) :
+    m_basePath(basePath),
+    m_dataPath(basePath + "/" + m_dataFileName),
+    m_indexPath(basePath + "/" + m_indexFileName),
+    m_dataStream(),
+    m_indexStream(),
+    m_dataSize(0),
+    m_indexSize(0),
+    m_locations(),
+    m_nChains(0),
+    m_indexLockFd(-1),
+    m_mapping(nullptr),
+    m_mappingSize(0),
+    m_mutex()
+{
+    std::filesystem::create_directories(basePath);
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    loadIndex();
+}
+
+ChainStore::~ChainStore()
+{
+    unmapData();
+    if (m_indexLockFd >= 0)
+    {
+        ::close(m_indexLockFd);
+    }
+}
+
+void ChainStore::append(const OptionChain& optionChain, const BinaryChain::Summary& summary)
+{
+    IndexEntry entry{};
+    Algos::copyString(entry.m_symbol, optionChain.getUnderlier());
+    Algos::copyString(entry.m_expiryDate, optionChain.getExpiryDate());
+    entry.m_chainTime = static_cast<std::int64_t>(optionChain.getChainTime().time_since_epoch().count());
+    // serialize outside of the lock
+    std::ostringstream ostr;
+    BinaryChain::write(ostr, optionChain, summary);
+    const std::string bytes = ostr.str();
+    entry.m_size = bytes.size();
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    if (!m_indexStream.is_open())
+    {
+        Algos::openAppend(m_dataStream, m_dataPath);
+        Algos::openAppend(m_indexStream, m_indexPath);
+        m_indexLockFd = ::open(m_indexPath.c_str(), O_RDONLY);
+        if (m_indexLockFd < 0)
+        {
+            throw std::runtime_error(fmt::format("ChainStore: failed to open {}: {}",
+                m_indexPath, std::strerror(errno)));
+        }
+    }
+    // writers of other stores on the same directory append in turns, each one first
+    // taking up their entries and the current end of the data file
+    Algos::FileLock fileLock(m_indexLockFd);
+    loadIndex();
+    std::uint64_t indexFileSize = Algos::getFileSize(m_indexPath);
+    std::uint64_t tornSize = (indexFileSize - m_indexSize) % sizeof(IndexEntry);
+    if (tornSize > 0)
+    {
+        // a torn entry of an interrupted writer would misalign entries appended after it
+        std::filesystem::resize_file(m_indexPath, indexFileSize - tornSize);
+    }
+    m_dataSize = Algos::getFileSize(m_dataPath);
+    entry.m_offset = Algos::align(m_dataSize);
+    static const char padding[Algos::m_alignment] = {};
+    m_dataStream.write(padding, static_cast<std::streamsize>(entry.m_offset - m_dataSize));
+    m_dataStream.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    // the index entry must not get visible before its data
+    m_dataStream.flush();
+    if (!m_dataStream)
+    {
+        throw std::runtime_error("ChainStore: failed to write " + m_dataPath);
+    }
+    m_dataSize = entry.m_offset + entry.m_size;
+    m_indexStream.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    m_indexStream.flush();
+    if (!m_indexStream)
+    {
+        throw std::runtime_error("ChainStore: failed to write " + m_indexPath);
+    }
+    // the index got loaded up to this entry, unless reading it failed
+    if (m_indexSize == indexFileSize - tornSize)
+    {
+        m_indexSize += sizeof(entry);
+    }
+    insertLocation(optionChain.getUnderlier(), optionChain.getExpiryDate(),
+        optionChain.getChainTime(), Location{entry.m_offset, entry.m_size});
+}
+
+bool ChainStore::find(const std::string& symbol, Timestamp dateTime, const std::string& expiryDate,
+    TimeRange timeRange, Location& location)
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    auto symIt = m_locations.find(symbol);
+    if (symIt == m_locations.end())
+    {
+        return false;
+    }
+    auto expIt = symIt->second.find(expiryDate);
+    if (expIt == symIt->second.end())
+    {
+        return false;
+    }
+    auto val = MarketEnvironmentExtended::getNextInTimeRange(dateTime, expIt->second, timeRange);
+    if (val.second)
+    {
+        location = expIt->second.at(val.first);
+    }
+    return val.second;
+}
+
+OptionChain ChainStore::read(const Location& location)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        if (location.m_offset + location.m_size <= m_mappingSize)
+        {
+            return BinaryChain::Reader(m_mapping + location.m_offset, location.m_size).toOptionChain();
+        }
+    }
+    // chains appended since the data file got mapped
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    mapData(location.m_offset + location.m_size);
+    return BinaryChain::Reader(m_mapping + location.m_offset, location.m_size).toOptionChain();
+}
+
+void ChainStore::refresh()
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    loadIndex();
+}
+
+std::size_t ChainStore::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_nChains;
+}
+
+void ChainStore::loadIndex()
+{
+    std::uint64_t indexFileSize = Algos::getFileSize(m_indexPath);
+    if (indexFileSize < m_indexSize + sizeof(IndexEntry))
+    {
+        return;
+    }
+    std::ifstream istr(m_indexPath, std::ios::binary);
+    istr.seekg(static_cast<std::streamoff>(m_indexSize));
+    std::uint64_t dataFileSize = Algos::getFileSize(m_dataPath);
+    IndexEntry entry;
+    while (m_indexSize + sizeof(entry) <= indexFileSize
+        && istr.read(reinterpret_cast<char*>(&entry), sizeof(entry)))
+    {
+        if (entry.m_offset % Algos::m_alignment != 0 || entry.m_offset + entry.m_size > dataFileSize)
+        {
+            // e.g. data lost in a crash after its entry got written, later entries are still good
+            BOOST_LOG_TRIVIAL(warning) << "ChainStore: index entry at " << m_indexSize
+                << " of " << m_indexPath << " exceeds the data file, skipping it";
+            m_indexSize += sizeof(entry);
+            continue;
+        }
+        Timestamp chainTime{Timestamp::duration(static_cast<Timestamp::duration::rep>(entry.m_chainTime))};
+        insertLocation(Algos::readString(entry.m_symbol), Algos::readString(entry.m_expiryDate),
+            chainTime, Location{entry.m_offset, entry.m_size});
+        m_indexSize += sizeof(entry);
+    }
+}
+
+void ChainStore::insertLocation(const std::string& symbol, const std::string& expiryDate,
+    Timestamp chainTime, const Location& location)
+{
+    // replaced keys count once
+    if (m_locations[symbol][expiryDate].insert_or_assign(chainTime, location).second)
+    {
+        ++m_nChains;
+    }
+}
+
+void ChainStore::mapData(std::uint64_t size)
+{
+    if (size <= m_mappingSize)
+    {
+        return;
+    }
+    unmapData();
+    int fd = ::open(m_dataPath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error(fmt::format("ChainStore: failed to open {}: {}",
+            m_dataPath, std::strerror(errno)));
+    }
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) != 0 || static_cast<std::uint64_t>(fileStat.st_size) < size)
+    {
+        ::close(fd);
+        throw std::runtime_error("ChainStore: data file " + m_dataPath + " is truncated");
+    }
+    std::uint64_t mappingSize = static_cast<std::uint64_t>(fileStat.st_size);
+    void* mapping = ::mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        throw std::runtime_error(fmt::format("ChainStore: failed to map {}: {}",
+            m_dataPath, std::strerror(errno)));
+    }
+    m_mapping = static_cast<const char*>(mapping);
+    m_mappingSize = mappingSize;
+}
+
+void ChainStore::unmapData()
+{
+    if (m_mapping != nullptr)
+    {
+        ::munmap(const_cast<char*>(m_mapping), m_mappingSize);
+        m_mapping = nullptr;
+        m_mappingSize = 0;
+    }
+}
@@ -0,0 +1,399 @@
+#include "bentoclient/consolidatedfile.hpp"
+#include "bentoclient/binarychain.hpp"
+#include "bentoclient/marketenvironmentextended.hpp"
+#include "bentoclient/apputils.hpp"
+#include <boost/log/trivial.hpp>
+#include <fmt/core.h>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace bentoclient;
+
+const std::string ConsolidatedFile::m_csvFileExtension(".csv");
+const std::string ConsolidatedFile::m_binaryFileExtension(".bcd");
+
+class ConsolidatedFile::Algos
+{
+public:
+    /// @brief Binary footer entry
+    struct IndexEntry
+    {
+        char m_expiryDate[16];
+        std::int64_t m_chainTime;
+        std::uint64_t m_offset;
+        std::uint64_t m_size;
+    };
+    /// @brief Binary trailer, last bytes of a binary file
+    struct Trailer
+    {
+        char m_magic[8];
+        std::uint64_t m_indexOffset;
+        std::uint64_t m_nEntries;
+    };
+    static_assert(std::is_trivially_copyable_v<IndexEntry>, "ConsolidatedFile index entries must be trivially copyable");
+    static constexpr char m_binaryMagic[8] = {'B', 'C', 'D', 'I', 'N', 'D', 'E', 'X'};
+    static constexpr const char* m_csvChainMarker = "#chain";
+    static constexpr const char* m_csvIndexMarker = "#index";
+    static constexpr const char* m_csvTrailerMarker = "#bentoindex";
+    /// @brief "#bentoindex," plus 20 digits offset, comma, 10 digits count, linefeed
+    static constexpr std::uint64_t m_csvTrailerSize = 44;
+    static constexpr std::uint64_t m_alignment = 8;
+
+    static std::uint64_t align(std::uint64_t offset)
+    {
+        return (offset + m_alignment - 1) / m_alignment * m_alignment;
+    }
+    static std::int64_t toNanos(Timestamp timestamp)
+    {
+        return static_cast<std::int64_t>(timestamp.time_since_epoch().count());
+    }
+    static Timestamp fromNanos(std::int64_t nanos)
+    {
+        return Timestamp{Timestamp::duration(static_cast<Timestamp::duration::rep>(nanos))};
+    }
+    static std::string readBytes(std::istream& istr, std::uint64_t offset, std::uint64_t size)
+    {
+        std::string bytes(size, '\0');
+        istr.clear();
+        istr.seekg(static_cast<std::streamoff>(offset));
+        if (!istr.read(bytes.data(), static_cast<std::streamsize>(size)))
+        {
+            throw std::runtime_error(fmt::format("ConsolidatedFile: failed to read {} bytes at {}", size, offset));
+        }
+        return bytes;
+    }
+    static std::vector<std::string> splitFields(const std::string& line)
+    {
+        std::list<std::string> fields = AppUtils::splitStr(line, ",");
+        return std::vector<std::string>(fields.begin(), fields.end());
+    }
+
+    static std::string makeFooter(Flavour flavour, const std::vector<Entry>& entries, std::uint64_t indexOffset)
+    {
+        std::string footer;
+        if (flavour == Flavour::CSV)
+        {
+            for (const auto& entry : entries)
+            {
+                footer += fmt::format("{},{},{},{},{}\n", m_csvIndexMarker, entry.m_expiryDate,
+                    toNanos(entry.m_chainTime), entry.m_location.m_offset, entry.m_location.m_size);
+            }
+            footer += fmt::format("{},{:020},{:010}\n", m_csvTrailerMarker, indexOffset, entries.size());
+            return footer;
+        }
+        footer.reserve(entries.size() * sizeof(IndexEntry) + sizeof(Trailer));
+        for (const auto& entry : entries)
+        {
+            IndexEntry indexEntry{};
+            if (entry.m_expiryDate.size() >= sizeof(indexEntry.m_expiryDate))
+            {
+                throw std::invalid_argument("ConsolidatedFile: expiry date too long: " + entry.m_expiryDate);
+            }
+            std::memcpy(indexEntry.m_expiryDate, entry.m_expiryDate.data(), entry.m_expiryDate.size());
+            indexEntry.m_chainTime = toNanos(entry.m_chainTime);
+            indexEntry.m_offset = entry.m_location.m_offset;
+            indexEntry.m_size = entry.m_location.m_size;
+            footer.append(reinterpret_cast<const char*>(&indexEntry), sizeof(indexEntry));
+        }
+        Trailer trailer{};
+        std::memcpy(trailer.m_magic, m_binaryMagic, sizeof(m_binaryMagic));
+        trailer.m_indexOffset = indexOffset;
+        trailer.m_nEntries = entries.size();
+        footer.append(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+        return footer;
+    }
+
+    /// @brief Loads the footer index
+    /// @return False if there is no valid footer
+    static bool loadFooter(std::istream& istr, std::uint64_t fileSize, Flavour flavour,
+        std::vector<Entry>& entries, std::uint64_t& indexOffset)
+    {
+        entries.clear();
+        if (flavour == Flavour::CSV)
+        {
+            if (fileSize < m_csvTrailerSize)
+            {
+                return false;
+            }
+            std::vector<std::string> trailer = splitFields(
+                readBytes(istr, fileSize - m_csvTrailerSize, m_csvTrailerSize - 1));
+            if (trailer.size() != 3 || trailer[0] != m_csvTrailerMarker)
+            {
+                return false;
+            }
+            indexOffset = std::stoull(trailer[1]);
+            std::uint64_t nEntries = std::stoull(trailer[2]);
+            if (indexOffset > fileSize - m_csvTrailerSize)
+            {
+                return false;
+            }
+            std::istringstream lines(readBytes(istr, indexOffset, fileSize - m_csvTrailerSize - indexOffset));
+            std::string line;
+            while (std::getline(lines, line))
+            {
+                std::vector<std::string> fields = splitFields(line);
+                if (fields.size() != 5 || fields[0] != m_csvIndexMarker)
+                {
+                    return false;
+                }
+                entries.push_back(Entry{fields[1], fromNanos(std::stoll(fields[2])),
+                    Location{std::stoull(fields[3]), std::stoull(fields[4])}});
+            }
+            return entries.size() == nEntries && checkLocations(entries, indexOffset);
+        }
+        if (fileSize < sizeof(Trailer))
+        {
+            return false;
+        }
+        Trailer trailer;
+        std::string trailerBytes = readBytes(istr, fileSize - sizeof(Trailer), sizeof(Trailer));
+        std::memcpy(&trailer, trailerBytes.data(), sizeof(trailer));
+        if (std::memcmp(trailer.m_magic, m_binaryMagic, sizeof(m_binaryMagic)) != 0
+            || trailer.m_indexOffset > fileSize - sizeof(Trailer)
+            || (fileSize - sizeof(Trailer) - trailer.m_indexOffset) != trailer.m_nEntries * sizeof(IndexEntry))
+        {
+            return false;
+        }
+        indexOffset = trailer.m_indexOffset;
+        std::string indexBytes = readBytes(istr, indexOffset, trailer.m_nEntries * sizeof(IndexEntry));
+        entries.reserve(trailer.m_nEntries);
+        for (std::uint64_t i = 0; i < trailer.m_nEntries; ++i)
+        {
+            IndexEntry indexEntry;
+            std::memcpy(&indexEntry, indexBytes.data() + i * sizeof(IndexEntry), sizeof(indexEntry));
+            entries.push_back(Entry{
+                std::string(indexEntry.m_expiryDate, strnlen(indexEntry.m_expiryDate, sizeof(indexEntry.m_expiryDate))),
+                fromNanos(indexEntry.m_chainTime), Location{indexEntry.m_offset, indexEntry.m_size}});
+        }
+        return checkLocations(entries, indexOffset);
+    }
+
+    static bool checkLocations(const std::vector<Entry>& entries, std::uint64_t dataSize)
+    {
+        for (const auto& entry : entries)
+        {
+            if (entry.m_location.m_offset + entry.m_location.m_size > dataSize)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// @brief Rebuilds the index from the sections of a file without footer
+    /// @return End of the last complete section
+    static std::uint64_t scan(std::istream& istr, std::uint64_t fileSize, Flavour flavour,
+        std::vector<Entry>& entries)
+    {
+        entries.clear();
+        std::uint64_t dataSize = 0;
+        if (flavour == Flavour::CSV)
+        {
+            std::string line;
+            istr.clear();
+            istr.seekg(0);
+            while (std::getline(istr, line))
+            {
+                std::vector<std::string> fields = splitFields(line);
+                if (fields.size() != 4 || fields[0] != m_csvChainMarker)
+                {
+                    break;
+                }
+                std::uint64_t offset = dataSize + line.size() + 1;
+                std::uint64_t size = std::stoull(fields[3]);
+                if (offset + size > fileSize)
+                {
+                    break;
+                }
+                entries.push_back(Entry{fields[1], fromNanos(std::stoll(fields[2])), Location{offset, size}});
+                dataSize = offset + size;
+                istr.seekg(static_cast<std::streamoff>(dataSize));
+            }
+            return dataSize;
+        }
+        for (std::uint64_t offset = 0; offset + sizeof(BinaryChain::Header) <= fileSize;
+            offset = align(dataSize))
+        {
+            BinaryChain::Header header;
+            std::string headerBytes = readBytes(istr, offset, sizeof(header));
+            std::memcpy(&header, headerBytes.data(), sizeof(header));
+            if (std::memcmp(header.m_magic, BinaryChain::m_magic, sizeof(BinaryChain::m_magic)) != 0
+                || header.m_fileSize < sizeof(header) || offset + header.m_fileSize > fileSize)
+            {
+                break;
+            }
+            entries.push_back(Entry{
+                std::string(header.m_expiryDate, strnlen(header.m_expiryDate, sizeof(header.m_expiryDate))),
+                fromNanos(header.m_chainTime), Location{offset, header.m_fileSize}});
+            dataSize = offset + header.m_fileSize;
+        }
+        return dataSize;
+    }
+
+    /// @brief Loads the index of a file, from its footer or by scanning its sections
+    /// @return True if a footer was found
+    static bool load(std::istream& istr, std::uint64_t fileSize, Flavour flavour, const std::string& path,
+        std::vector<Entry>& entries, std::uint64_t& dataSize)
+    {
+        try {
+            if (loadFooter(istr, fileSize, flavour, entries, dataSize))
+            {
+                return true;
+            }
+        } catch (const std::logic_error&) {
+            // unparsable footer numbers
+        }
+        dataSize = scan(istr, fileSize, flavour, entries);
+        if (fileSize > 0)
+        {
+            BOOST_LOG_TRIVIAL(warning) << "ConsolidatedFile: no index footer in " << path
+                << ", rebuilt index of " << entries.size() << " chains from " << dataSize
+                << " of " << fileSize << " bytes";
+        }
+        return false;
+    }
+};
+
+ConsolidatedFile::Writer::Writer(const std::string& path, Flavour flavour) :
+    m_path(path),
+    m_flavour(flavour),
+    m_ostr(),
+    m_entries(),
+    m_dataSize(0)
+{
+    std::filesystem::path filePath(path);
+    if (filePath.has_parent_path())
+    {
+        std::filesystem::create_directories(filePath.parent_path());
+    }
+    open();
+}
+
+ConsolidatedFile::Writer::~Writer()
+{
+    try {
+        finish();
+    } catch (const std::exception& e) {
+        BOOST_LOG_TRIVIAL(error) << e.what();
+    }
+}
+
+void ConsolidatedFile::Writer::open()
+{
+    std::error_code errorCode;
+    std::uintmax_t fileSize = std::filesystem::file_size(m_path, errorCode);
+    if (!errorCode && fileSize > 0)
+    {
+        std::ifstream istr(m_path, std::ios::binary);
+        if (!Algos::load(istr, fileSize, m_flavour, m_path, m_entries, m_dataSize) && m_entries.empty())
+        {
+            throw std::runtime_error("ConsolidatedFile: " + m_path + " is not a consolidated file of this flavour");
+        }
+        // sections get appended over the footer, which finish writes anew
+        std::filesystem::resize_file(m_path, m_dataSize);
+    } else {
+        m_entries.clear();
+        m_dataSize = 0;
+    }
+    m_ostr.open(m_path, std::ios::out | std::ios::binary | std::ios::app);
+    if (!m_ostr)
+    {
+        throw std::runtime_error("ConsolidatedFile: failed to open " + m_path + " for writing");
+    }
+}
+
+void ConsolidatedFile::Writer::append(const std::string& expiryDate, Timestamp chainTime,
+    const std::string& section)
+{
+    if (!m_ostr.is_open())
+    {
+        open();
+    }
+    std::uint64_t offset = m_dataSize;
+    if (m_flavour == Flavour::CSV)
+    {
+        std::string marker = fmt::format("{},{},{},{}\n", Algos::m_csvChainMarker,
+            expiryDate, Algos::toNanos(chainTime), section.size());
+        m_ostr.write(marker.data(), static_cast<std::streamsize>(marker.size()));
+        offset += marker.size();
+    } else {
+        static const char padding[Algos::m_alignment] = {};
+        offset = Algos::align(m_dataSize);
+        m_ostr.write(padding, static_cast<std::streamsize>(offset - m_dataSize));
+    }
+    m_ostr.write(section.data(), static_cast<std::streamsize>(section.size()));
+    if (!m_ostr)
+    {
+        throw std::runtime_error("ConsolidatedFile: failed to write " + m_path);
+    }
+    m_dataSize = offset + section.size();
+    m_entries.push_back(Entry{expiryDate, chainTime, Location{offset, section.size()}});
+}
+
+void ConsolidatedFile::Writer::finish()
+{
+    if (!m_ostr.is_open())
+    {
+        return;
+    }
+    std::uint64_t indexOffset = m_flavour == Flavour::Binary ? Algos::align(m_dataSize) : m_dataSize;
+    static const char padding[Algos::m_alignment] = {};
+    m_ostr.write(padding, static_cast<std::streamsize>(indexOffset - m_dataSize));
+    std::string footer = Algos::makeFooter(m_flavour, m_entries, indexOffset);
+    m_ostr.write(footer.data(), static_cast<std::streamsize>(footer.size()));
+    m_ostr.close();
+    if (!m_ostr)
+    {
+        throw std::runtime_error("ConsolidatedFile: failed to write index of " + m_path);
+    }
+}
+
+ConsolidatedFile::ConsolidatedFile(const std::string& path) :
+    m_path(path),
+    m_flavour(getFlavour(path)),
+    m_istr(path, std::ios::binary),
+    m_locations(),
+    m_bFooter(false)
+{
+    if (!m_istr)
+    {
+        throw std::runtime_error("ConsolidatedFile: failed to open " + path);
+    }
+    std::vector<Entry> entries;
+    std::uint64_t dataSize = 0;
+    m_bFooter = Algos::load(m_istr, std::filesystem::file_size(path), m_flavour, path, entries, dataSize);
+    for (const auto& entry : entries)
+    {
+        m_locations[entry.m_expiryDate][entry.m_chainTime] = entry.m_location;
+    }
+}
+
+bool ConsolidatedFile::find(const std::string& expiryDate, Timestamp dateTime, TimeRange timeRange,
+    Location& location) const
+{
+    auto expIt = m_locations.find(expiryDate);
+    if (expIt == m_locations.end())
+    {
+        return false;
+    }
+    auto val = MarketEnvironmentExtended::getNextInTimeRange(dateTime, expIt->second, timeRange);
+    if (val.second)
+    {
+        location = expIt->second.at(val.first);
+    }
+    return val.second;
+}
+
+std::string ConsolidatedFile::read(const Location& location)
+{
+    return Algos::readBytes(m_istr, location.m_offset, location.m_size);
+}
+
+ConsolidatedFile::Flavour ConsolidatedFile::getFlavour(const std::string& path)
+{
+    return std::filesystem::path(path).extension() == m_binaryFileExtension ?
+        Flavour::Binary : Flavour::CSV;
+}
@@ -2,6 +2,10 @@
 #include "bentoclient/optionchain.hpp"
 #include "bentoclient/osioption.hpp"
 #include "bentoclient/datagrid.hpp"
+#include <fmt/core.h>
+#include <fmt/chrono.h>
+#include <chrono>
+#include <iterator>
 #include <boost/log/trivial.hpp>
 
 using namespace bentoclient;
@@ -26,101 +30,434 @@ const std::string CSVFromOptionChain::HeaderCols::m_bidSize("BidSize");
 const std::string CSVFromOptionChain::HeaderCols::m_askSize("AskSize");
 const std::string CSVFromOptionChain::HeaderCols::m_precision("Precision");
 const std::string CSVFromOptionChain::HeaderCols::m_comment("Comment");
+const std::string CSVFromOptionChain::HeaderCols::m_impliedVolatility("IV");
+const std::string CSVFromOptionChain::HeaderCols::m_delta("Delta");
+const std::string CSVFromOptionChain::HeaderCols::m_gamma("Gamma");
+const std::string CSVFromOptionChain::HeaderCols::m_vega("Vega");
+const std::string CSVFromOptionChain::HeaderCols::m_theta("Theta");
 
 const std::string CSVFromOptionChain::Types::m_put("Put");
 const std::string CSVFromOptionChain::Types::m_call("Call");
 
 class CSVFromOptionChain::Algos{
 public:
-    typedef const std::function<void(std::string &&, 
-        const OptionChain::Record&, const OptionChain::Record&)>
-            SideBySideFunctor;
-    static void sideBySide(const OptionChain& optionChain, SideBySideFunctor rowFunctor)
+    /// @brief Output fields of CSV columns
+    enum class Field : int
     {
-        auto& puts = optionChain.getPuts();
-        auto& calls = optionChain.getCalls();
-        for (auto putIt = puts.begin(); putIt != puts.end(); ++putIt)
+        SYMBOL,
+        DATE,
+        TIME,
+        RATE,
+        TYPE,
+        STRIKE,
+        BID,
+        MID,
+        ASK,
+        EXP_DATE,
+        BID_SIZE,
+        ASK_SIZE,
+        RECV_TIME,
+        LAST_TRADE,
+        LAST_TRADE_TIME,
+        LAST_TRADE_SIZE,
+        COMMENT,
+        PRECISION,
+        IMPLIED_VOLATILITY,
+        DELTA,
+        GAMMA,
+        VEGA,
+        THETA
+    };
+    /// @brief Record a field is taken from, NONE for chain fields and stacked records
+    enum class Side : int
+    {
+        NONE,
+        CALL,
+        PUT
+    };
+    /// @brief Values shared by all rows of a chain, formatted once
+    struct ChainValues
+    {
+        std::string m_symbol;
+        std::string m_date;
+        std::string m_time;
+        std::string m_rate;
+        std::string m_expDate;
+        std::string m_precision;
+    };
+    /// @brief Sources of one CSV row, indexed by Side
+    struct RowContext
+    {
+        const ChainValues* m_chainValues;
+        const std::string* m_type;
+        const std::string* m_strike;
+        const OptionChain::Record* m_records[3];
+        const OptionAnalytics::Greeks* m_greeks[3];
+    };
+    /// @brief Formats rows into a buffer flushed to the output stream in blocks and by flush()
+    class RowWriter
+    {
+    public:
+        RowWriter(std::ostream& ostr, const std::string& timeZone) :
+        m_ostr(ostr),
+        m_timeZone(timeZone)
+        {}
+        void append(const std::string& value)
+        {
+            m_buffer.append(value.data(), value.data() + value.size());
+        }
+        void append(char c)
+        {
+            m_buffer.push_back(c);
+        }
+        void separator()
+        {
+            append(',');
+        }
+        void lineFeed()
+        {
+            append('\n');
+            if (m_buffer.size() >= m_flushSize)
+            {
+                flush();
+            }
+        }
+        void flush()
+        {
+            m_ostr.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+            m_buffer.clear();
+        }
+        void writePrice(double value)
+        {
+            fmt::format_to(std::back_inserter(m_buffer), "{:.2f}", value);
+        }
+        void writeDouble4(double value)
+        {
+            fmt::format_to(std::back_inserter(m_buffer), "{:.4f}", value);
+        }
+        void writeDouble6(double value)
+        {
+            fmt::format_to(std::back_inserter(m_buffer), "{:.6f}", value);
+        }
+        void writeSize(std::uint64_t value)
+        {
+            fmt::format_to(std::back_inserter(m_buffer), "{}", value);
+        }
+        /// @brief Whole seconds in the exchange time zone like DataGrid::TimestampFormatSeconds
+        void writeTimestamp(const Timestamp& timestamp, bool bDate = true, bool bTime = true)
+        {
+            if (timestamp == Timestamp{})
+            {
+                append(m_null);
+                return;
+            }
+            Timestamp localTimePoint = DateUtils::convertZuluToTimestamp(timestamp, m_timeZone);
+            char chars[20];
+            std::size_t nChars = DateUtils::writeCivilTime(chars, DateUtils::toCivilTime(localTimePoint),
+                bDate, bTime);
+            if (nChars > 0)
+            {
+                m_buffer.append(chars, chars + nChars);
+                return;
+            }
+            auto timePointSeconds = std::chrono::time_point_cast<std::chrono::seconds>(localTimePoint);
+            const std::string& format = !bDate ? DataGrid::m_defaultTimeFormat :
+                !bTime ? DataGrid::m_defaultDateFormat : DataGrid::m_defaultTimestampFormat;
+            fmt::format_to(std::back_inserter(m_buffer), DataGrid::Format::makeFmtString(format),
+                timePointSeconds);
+        }
+        /// @brief Formats into a separate string, for values shared by all rows
+        template <typename Functor>
+        std::string toString(Functor&& functor)
+        {
+            std::size_t begin = m_buffer.size();
+            functor(*this);
+            std::string value(m_buffer.data() + begin, m_buffer.size() - begin);
+            m_buffer.resize(begin);
+            return value;
+        }
+    private:
+        static constexpr std::size_t m_flushSize = 1 << 16;
+        static const std::string m_null;
+        std::ostream& m_ostr;
+        const std::string& m_timeZone;
+        fmt::memory_buffer m_buffer;
+    };
+    /// @brief Column writing field F of the record on side S
+    template <Field F, Side S = Side::NONE>
+    struct Col
+    {
+        static std::string getName()
         {
-            auto callIt = calls.find(putIt->first);
-            if (callIt != calls.end())
+            const std::string& name = getFieldName(F);
+            switch (S)
             {
-                rowFunctor(OsiOption::fromStrikeKeyAsString(putIt->first),
-                    putIt->second, callIt->second);
+            case Side::CALL:
+                return HeaderCols::pcs(name);
+            case Side::PUT:
+                return HeaderCols::pps(name);
+            default:
+                return name;
             }
         }
+        static void write(RowWriter& writer, const RowContext& row)
+        {
+            const ChainValues& chainValues = *row.m_chainValues;
+            if constexpr (F == Field::SYMBOL)
+                writer.append(chainValues.m_symbol);
+            else if constexpr (F == Field::DATE)
+                writer.append(chainValues.m_date);
+            else if constexpr (F == Field::TIME)
+                writer.append(chainValues.m_time);
+            else if constexpr (F == Field::RATE)
+                writer.append(chainValues.m_rate);
+            else if constexpr (F == Field::TYPE)
+                writer.append(*row.m_type);
+            else if constexpr (F == Field::STRIKE)
+                writer.append(*row.m_strike);
+            else if constexpr (F == Field::EXP_DATE)
+                writer.append(chainValues.m_expDate);
+            else if constexpr (F == Field::PRECISION)
+                writer.append(chainValues.m_precision);
+            else if constexpr (F >= Field::IMPLIED_VOLATILITY)
+                writeGreeks(writer, row.m_greeks[static_cast<int>(S)]);
+            else
+                writeRecord(writer, *row.m_records[static_cast<int>(S)]);
+        }
+    private:
+        static void writeRecord(RowWriter& writer, const OptionChain::Record& record)
+        {
+            if constexpr (F == Field::BID)
+                writer.writePrice(record.getBidPrice());
+            else if constexpr (F == Field::MID)
+                writer.writePrice(record.getMidPrice());
+            else if constexpr (F == Field::ASK)
+                writer.writePrice(record.getAskPrice());
+            else if constexpr (F == Field::BID_SIZE)
+                writer.writeSize(std::get<1>(record.m_bidPrice));
+            else if constexpr (F == Field::ASK_SIZE)
+                writer.writeSize(std::get<1>(record.m_askPrice));
+            else if constexpr (F == Field::RECV_TIME)
+                writer.writeTimestamp(record.getRecvTime());
+            else if constexpr (F == Field::LAST_TRADE)
+                writer.writePrice(record.getTradePrice());
+            else if constexpr (F == Field::LAST_TRADE_TIME)
+                writer.writeTimestamp(record.getTradeTime());
+            else if constexpr (F == Field::LAST_TRADE_SIZE)
+                writer.writeSize(std::get<1>(record.m_price));
+            else if constexpr (F == Field::COMMENT)
+                writer.append(record.m_comment);
+            else
+                static_assert(F != F, "Unsupported record field");
+        }
+        static void writeGreeks(RowWriter& writer, const OptionAnalytics::Greeks* greeks)
+        {
+            const OptionAnalytics::Greeks& value = greeks != nullptr ? *greeks : m_noGreeks;
+            if constexpr (F == Field::IMPLIED_VOLATILITY)
+                writer.writeDouble4(value.m_impliedVolatility);
+            else if constexpr (F == Field::DELTA)
+                writer.writeDouble4(value.m_delta);
+            else if constexpr (F == Field::GAMMA)
+                writer.writeDouble6(value.m_gamma);
+            else if constexpr (F == Field::VEGA)
+                writer.writeDouble4(value.m_vega);
+            else
+                writer.writeDouble4(value.m_theta);
+        }
+    };
+    /// @brief Compile time column layout
+    template <typename... Cols>
+    struct Schema
+    {
+        static constexpr std::size_t m_nCols = sizeof...(Cols);
+        static std::list<std::string> getNames()
+        {
+            return std::list<std::string>({Cols::getName()...});
+        }
+        static void writeRow(RowWriter& writer, const RowContext& row)
+        {
+            bool bFirst = true;
+            ((bFirst ? void(bFirst = false) : writer.separator(), Cols::write(writer, row)), ...);
+        }
+    };
+    typedef Schema<
+        Col<Field::SYMBOL>,
+        Col<Field::DATE>,
+        Col<Field::TIME>,
+        Col<Field::RATE>,
+        Col<Field::STRIKE>,
+        Col<Field::BID, Side::CALL>,
+        Col<Field::MID, Side::CALL>,
+        Col<Field::ASK, Side::CALL>,
+        Col<Field::BID, Side::PUT>,
+        Col<Field::MID, Side::PUT>,
+        Col<Field::ASK, Side::PUT>,
+        Col<Field::EXP_DATE>,
+        Col<Field::BID_SIZE, Side::CALL>,
+        Col<Field::ASK_SIZE, Side::CALL>,
+        Col<Field::RECV_TIME, Side::CALL>,
+        Col<Field::LAST_TRADE, Side::CALL>,
+        Col<Field::LAST_TRADE_TIME, Side::CALL>,
+        Col<Field::LAST_TRADE_SIZE, Side::CALL>,
+        Col<Field::COMMENT, Side::CALL>,
+        Col<Field::BID_SIZE, Side::PUT>,
+        Col<Field::ASK_SIZE, Side::PUT>,
+        Col<Field::RECV_TIME, Side::PUT>,
+        Col<Field::LAST_TRADE, Side::PUT>,
+        Col<Field::LAST_TRADE_TIME, Side::PUT>,
+        Col<Field::LAST_TRADE_SIZE, Side::PUT>,
+        Col<Field::COMMENT, Side::PUT>,
+        Col<Field::PRECISION>
+    > SideBySideSchema;
+    typedef Schema<
+        Col<Field::IMPLIED_VOLATILITY, Side::CALL>,
+        Col<Field::DELTA, Side::CALL>,
+        Col<Field::GAMMA, Side::CALL>,
+        Col<Field::VEGA, Side::CALL>,
+        Col<Field::THETA, Side::CALL>,
+        Col<Field::IMPLIED_VOLATILITY, Side::PUT>,
+        Col<Field::DELTA, Side::PUT>,
+        Col<Field::GAMMA, Side::PUT>,
+        Col<Field::VEGA, Side::PUT>,
+        Col<Field::THETA, Side::PUT>
+    > SideBySideGreeksSchema;
+    typedef Schema<
+        Col<Field::SYMBOL>,
+        Col<Field::DATE>,
+        Col<Field::TIME>,
+        Col<Field::RATE>,
+        Col<Field::TYPE>,
+        Col<Field::STRIKE>,
+        Col<Field::BID>,
+        Col<Field::MID>,
+        Col<Field::ASK>,
+        Col<Field::EXP_DATE>,
+        Col<Field::BID_SIZE>,
+        Col<Field::ASK_SIZE>,
+        Col<Field::RECV_TIME>,
+        Col<Field::LAST_TRADE>,
+        Col<Field::LAST_TRADE_TIME>,
+        Col<Field::LAST_TRADE_SIZE>,
+        Col<Field::COMMENT>,
+        Col<Field::PRECISION>
+    > StackedSchema;
+    typedef Schema<
+        Col<Field::IMPLIED_VOLATILITY>,
+        Col<Field::DELTA>,
+        Col<Field::GAMMA>,
+        Col<Field::VEGA>,
+        Col<Field::THETA>
+    > StackedGreeksSchema;
+
+    static const std::string& getFieldName(Field field)
+    {
+        switch (field)
+        {
+        case Field::SYMBOL: return HeaderCols::m_symbol;
+        case Field::DATE: return HeaderCols::m_date;
+        case Field::TIME: return HeaderCols::m_time;
+        case Field::RATE: return HeaderCols::m_rate;
+        case Field::TYPE: return HeaderCols::m_type;
+        case Field::STRIKE: return HeaderCols::m_strike;
+        case Field::BID: return HeaderCols::m_bid;
+        case Field::MID: return HeaderCols::m_mid;
+        case Field::ASK: return HeaderCols::m_ask;
+        case Field::EXP_DATE: return HeaderCols::m_expDate;
+        case Field::BID_SIZE: return HeaderCols::m_bidSize;
+        case Field::ASK_SIZE: return HeaderCols::m_askSize;
+        case Field::RECV_TIME: return HeaderCols::m_recvTime;
+        case Field::LAST_TRADE: return HeaderCols::m_lastTrade;
+        case Field::LAST_TRADE_TIME: return HeaderCols::m_lastTradeTime;
+        case Field::LAST_TRADE_SIZE: return HeaderCols::m_lastTradeSize;
+        case Field::COMMENT: return HeaderCols::m_comment;
+        case Field::PRECISION: return HeaderCols::m_precision;
+        case Field::IMPLIED_VOLATILITY: return HeaderCols::m_impliedVolatility;
+        case Field::DELTA: return HeaderCols::m_delta;
+        case Field::GAMMA: return HeaderCols::m_gamma;
+        case Field::VEGA: return HeaderCols::m_vega;
+        case Field::THETA: return HeaderCols::m_theta;
+        }
+        throw std::invalid_argument("CSVFromOptionChain: unknown field");
     }
-    typedef const std::function<void(std::string&&, const std::string, const OptionChain::Record&)> 
-        StackedFunctor;
-    static void stacked(const std::map<std::string, OptionChain::Record>& recordMap, 
-        const std::string& type, StackedFunctor rowFunctor)
+    /// @brief Writes the header row of a schema, optionally followed by the Greeks schema
+    template <typename BaseSchema, typename GreeksSchema>
+    static void writeHeaderRow(RowWriter& writer, bool bGreeks)
     {
-        for (auto it = recordMap.begin(); it != recordMap.end(); ++it)
+        std::list<std::string> cols = BaseSchema::getNames();
+        if (bGreeks)
         {
-            rowFunctor(OsiOption::fromStrikeKeyAsString(it->first), type, it->second);
+            cols.splice(cols.end(), GreeksSchema::getNames());
         }
+        cols = HeaderCols::capitalizeFirst(cols);
+        for (auto it = cols.begin(); it != cols.end(); ++it)
+        {
+            if (it != cols.begin())
+            {
+                writer.separator();
+            }
+            writer.append(*it);
+        }
+        writer.lineFeed();
     }
+    /// @brief Looks up Greeks for a strike key, nullptr if none
+    static const OptionAnalytics::Greeks* findGreeks(const OptionAnalytics::GreeksMap& greeksMap,
+        const std::string& strikeKey)
+    {
+        auto it = greeksMap.find(strikeKey);
+        return it != greeksMap.end() ? &it->second : nullptr;
+    }
+    /// @brief Formats the values shared by all rows of a chain
+    static ChainValues makeChainValues(const CSVFromOptionChain& toCsv,
+        RowWriter& writer, const OptionChain& optionChain)
+    {
+        double fPcpRate = toCsv.getPcpRate(optionChain);
+        double fPrecision = toCsv.computePrecision(optionChain);
+        Timestamp chainTime = optionChain.getChainTime();
+        Timestamp expiryTime = optionChain.getExpiryTime(toCsv.m_marketEnvironment->getExchangeClose());
+        ChainValues chainValues;
+        chainValues.m_symbol = optionChain.getUnderlier();
+        chainValues.m_date = writer.toString([chainTime](RowWriter& w) {
+            w.writeTimestamp(chainTime, true, false); });
+        chainValues.m_time = writer.toString([chainTime](RowWriter& w) {
+            w.writeTimestamp(chainTime, false, true); });
+        chainValues.m_rate = writer.toString([fPcpRate](RowWriter& w) {
+            w.writePrice(fPcpRate); });
+        chainValues.m_expDate = writer.toString([expiryTime](RowWriter& w) {
+            w.writeTimestamp(expiryTime, true, false); });
+        chainValues.m_precision = writer.toString([fPrecision](RowWriter& w) {
+            w.writeDouble4(fPrecision); });
+        return chainValues;
+    }
+    /// @brief nan values for strikes without Greeks
+    static const OptionAnalytics::Greeks m_noGreeks;
 };
 
-std::list<std::string> CSVFromOptionChain::HeaderCols::getSideBySideCols()
+const std::string CSVFromOptionChain::Algos::RowWriter::m_null("{null}");
+const OptionAnalytics::Greeks CSVFromOptionChain::Algos::m_noGreeks;
+
+std::list<std::string> CSVFromOptionChain::HeaderCols::getSideBySideCols(bool bGreeks)
 {
-    return std::list<std::string>(
+    std::list<std::string> cols = Algos::SideBySideSchema::getNames();
+    if (bGreeks)
     {
-        m_symbol,
-        m_date,
-        m_time,
-        m_rate,
-        m_strike,
-        pcs(m_bid),
-        pcs(m_mid),
-        pcs(m_ask),
-        pps(m_bid),
-        pps(m_mid),
-        pps(m_ask),
-        m_expDate,
-        pcs(m_bidSize),
-        pcs(m_askSize),
-        pcs(m_recvTime),
-        pcs(m_lastTrade),
-        pcs(m_lastTradeTime),
-        pcs(m_lastTradeSize),
-        pcs(m_comment),
-        pps(m_bidSize),
-        pps(m_askSize),
-        pps(m_recvTime),
-        pps(m_lastTrade),
-        pps(m_lastTradeTime),
-        pps(m_lastTradeSize),
-        pps(m_comment),
-        m_precision
+        cols.splice(cols.end(), Algos::SideBySideGreeksSchema::getNames());
     }
-    );
-
+    return cols;
 }
 
-std::list<std::string> CSVFromOptionChain::HeaderCols::getStackedCols()
+std::list<std::string> CSVFromOptionChain::HeaderCols::getStackedCols(bool bGreeks)
 {
-    return std::list<std::string>(
+    std::list<std::string> cols = Algos::StackedSchema::getNames();
+    if (bGreeks)
     {
-        m_symbol,
-        m_date,
-        m_time,
-        m_rate,
-        m_type,
-        m_strike,
-        m_bid,
-        m_mid,
-        m_ask,
-        m_expDate,
-        m_bidSize,
-        m_askSize,
-        m_recvTime,
-        m_lastTrade,
-        m_lastTradeTime,
-        m_lastTradeSize,
-        m_comment,
-        m_precision
+        cols.splice(cols.end(), getGreeksCols());
     }
-    );
+    return cols;
+}
+
+std::list<std::string> CSVFromOptionChain::HeaderCols::getGreeksCols()
+{
+    return Algos::StackedGreeksSchema::getNames();
 }
 
 std::list<std::string> CSVFromOptionChain::HeaderCols::capitalizeFirst(const std::list<std::string>& cols)
@@ -138,121 +475,92 @@ std::list<std::string> CSVFromOptionChain::HeaderCols::capitalizeFirst(const std
     return caps;
 }
 
-CSVFromOptionChain::CSVFromOptionChain(std::shared_ptr<MarketEnvironment> marketEnvironment) :
-    m_marketEnvironment(marketEnvironment)
+CSVFromOptionChain::CSVFromOptionChain(std::shared_ptr<MarketEnvironment> marketEnvironment,
+    bool bGreeks) :
+    m_marketEnvironment(marketEnvironment),
+    m_bGreeks(bGreeks)
 {}
 
 
 void CSVFromOptionChain::sideBySide(std::ostream& ostr, const OptionChain& optionChain) const
 {
-    double fPcpRate = getPcpRate(optionChain);
-    double fPrecision = computePrecision(optionChain);
-    DataGrid grid;
-    Algos::SideBySideFunctor rowFunctor = [&grid](std::string&& strike, 
-        const OptionChain::Record& put, const OptionChain::Record& call)
+    Algos::RowWriter writer(ostr, m_marketEnvironment->getExchangeClose().m_timeZone);
+    Algos::ChainValues chainValues = Algos::makeChainValues(*this, writer, optionChain);
+    OptionAnalytics::PutCallGreeksMap greeks;
+    if (m_bGreeks)
     {
-        grid.addRow(
-            std::move(strike),
-            call.getBidPrice(),
-            call.getMidPrice(),
-            call.getAskPrice(),
-            put.getBidPrice(),
-            put.getMidPrice(),
-            put.getAskPrice(),
-            std::get<1>(call.m_bidPrice),
-            std::get<1>(call.m_askPrice),
-            call.getRecvTime(),
-            call.getTradePrice(),
-            call.getTradeTime(),
-            std::get<1>(call.m_price),
-            call.m_comment,
-            std::get<1>(put.m_bidPrice),
-            std::get<1>(put.m_askPrice),
-            put.getRecvTime(),
-            put.getTradePrice(),
-            put.getTradeTime(),
-            std::get<1>(put.m_price),
-            put.m_comment
-            );
-    };
-    Algos::sideBySide(optionChain, rowFunctor);
-    // set timestamp formatting for trades
-    grid.setFormat(DataGrid::FormatFunctor(
-        [this](){
-            return std::make_unique<DataGrid::TimestampFormatSeconds>(
-                DataGrid::m_defaultTimestampFormat, 
-                this->m_marketEnvironment->getExchangeClose().m_timeZone);
+        greeks = computeGreeks(optionChain);
+    }
+    Algos::writeHeaderRow<Algos::SideBySideSchema, Algos::SideBySideGreeksSchema>(writer, m_bGreeks);
+    Algos::RowContext row{&chainValues, nullptr, nullptr, {}, {}};
+    auto& puts = optionChain.getPuts();
+    auto& calls = optionChain.getCalls();
+    // puts and calls are sorted by strike key, rows are strikes present on both sides
+    auto callIt = calls.begin();
+    for (auto putIt = puts.begin(); putIt != puts.end(); ++putIt)
+    {
+        while (callIt != calls.end() && callIt->first < putIt->first)
+        {
+            ++callIt;
         }
-    ));
-    grid.insertColumn(7, optionChain.getExpiryTime(m_marketEnvironment->getExchangeClose()));
-    grid.setFormat(7, std::make_unique<DataGrid::TimestampFormatSeconds>(
-        DataGrid::m_defaultDateFormat, m_marketEnvironment->getExchangeClose().m_timeZone));
-    grid.insertColumn(0, fPcpRate);
-    grid.insertColumn(0, optionChain.getChainTime());
-    grid.setFormat(0, std::make_unique<DataGrid::TimestampFormatSeconds>(
-        DataGrid::m_defaultTimeFormat, m_marketEnvironment->getExchangeClose().m_timeZone));
-    grid.insertColumn(0, optionChain.getChainTime());
-    grid.setFormat(0, std::make_unique<DataGrid::TimestampFormatSeconds>(
-        DataGrid::m_defaultDateFormat, m_marketEnvironment->getExchangeClose().m_timeZone));
-    grid.insertColumn(0, optionChain.getUnderlier());
-    grid.setFormat(DataGrid::FormatFunctor([]{return std::make_unique<DataGrid::DoubleFormat>();}));
-    std::size_t precPos = grid.addColumn(fPrecision);
-    grid.setFormat(precPos, std::make_unique<DataGrid::DoubleFormat>(".4f"));
-    grid.setColNames(HeaderCols::capitalizeFirst(HeaderCols::getSideBySideCols()));
-    grid.serializeHeaderRow(ostr);
-    grid.serializeStringGrid(ostr);
+        if (callIt == calls.end())
+        {
+            break;
+        }
+        if (callIt->first != putIt->first)
+        {
+            continue;
+        }
+        std::string strike = OsiOption::fromStrikeKeyAsString(putIt->first);
+        row.m_strike = &strike;
+        row.m_records[static_cast<int>(Algos::Side::CALL)] = &callIt->second;
+        row.m_records[static_cast<int>(Algos::Side::PUT)] = &putIt->second;
+        Algos::SideBySideSchema::writeRow(writer, row);
+        if (m_bGreeks)
+        {
+            row.m_greeks[static_cast<int>(Algos::Side::CALL)] = Algos::findGreeks(greeks.second, putIt->first);
+            row.m_greeks[static_cast<int>(Algos::Side::PUT)] = Algos::findGreeks(greeks.first, putIt->first);
+            writer.separator();
+            Algos::SideBySideGreeksSchema::writeRow(writer, row);
+        }
+        writer.lineFeed();
+    }
+    writer.flush();
 }
 
 void CSVFromOptionChain::stacked(std::ostream& ostr, const OptionChain& optionChain) const
 {
-    double fPcpRate = getPcpRate(optionChain);
-    double fPrecision = computePrecision(optionChain);
-    DataGrid grid;
-    Algos::StackedFunctor rowFunctor = [&grid](std::string&& strike, 
-        const std::string& type, const OptionChain::Record& rec)
+    Algos::RowWriter writer(ostr, m_marketEnvironment->getExchangeClose().m_timeZone);
+    Algos::ChainValues chainValues = Algos::makeChainValues(*this, writer, optionChain);
+    OptionAnalytics::PutCallGreeksMap greeks;
+    if (m_bGreeks)
     {
-        grid.addRow(
-            type,
-            std::move(strike),
-            rec.getBidPrice(),
-            rec.getMidPrice(),
-            rec.getAskPrice(),
-            std::get<1>(rec.m_bidPrice),
-            std::get<1>(rec.m_askPrice),
-            rec.getRecvTime(),
-            rec.getTradePrice(),
-            rec.getTradeTime(),
-            std::get<1>(rec.m_price),
-            rec.m_comment
-            );
-    };
-    Algos::stacked(optionChain.getPuts(), Types::m_put, rowFunctor);
-    Algos::stacked(optionChain.getCalls(), Types::m_call, rowFunctor);
-    // set timestamp formatting for trades
-    grid.setFormat(DataGrid::FormatFunctor(
-        [this](){
-            return std::make_unique<DataGrid::TimestampFormatSeconds>(
-                DataGrid::m_defaultTimestampFormat, 
-                this->m_marketEnvironment->getExchangeClose().m_timeZone);
+        greeks = computeGreeks(optionChain);
+    }
+    Algos::writeHeaderRow<Algos::StackedSchema, Algos::StackedGreeksSchema>(writer, m_bGreeks);
+    Algos::RowContext row{&chainValues, nullptr, nullptr, {}, {}};
+    auto writeRows = [this, &writer, &row](const OptionChain::RecordMap& recordMap,
+        const std::string& type, const OptionAnalytics::GreeksMap& greeksMap)
+    {
+        row.m_type = &type;
+        for (auto it = recordMap.begin(); it != recordMap.end(); ++it)
+        {
+            std::string strike = OsiOption::fromStrikeKeyAsString(it->first);
+            row.m_strike = &strike;
+            row.m_records[static_cast<int>(Algos::Side::NONE)] = &it->second;
+            Algos::StackedSchema::writeRow(writer, row);
+            if (m_bGreeks)
+            {
+                row.m_greeks[static_cast<int>(Algos::Side::NONE)] = Algos::findGreeks(greeksMap, it->first);
+                writer.separator();
+                Algos::StackedGreeksSchema::writeRow(writer, row);
+            }
+            writer.lineFeed();
         }
-    ));
-    grid.insertColumn(5, optionChain.getExpiryTime(m_marketEnvironment->getExchangeClose()));
-    grid.setFormat(5, std::make_unique<DataGrid::TimestampFormatSeconds>(
-        DataGrid::m_defaultDateFormat, m_marketEnvironment->getExchangeClose().m_timeZone));
-    grid.insertColumn(0, fPcpRate);
-    grid.insertColumn(0, optionChain.getChainTime());
-    grid.setFormat(0, std::make_unique<DataGrid::TimestampFormatSeconds>(
-        DataGrid::m_defaultTimeFormat, m_marketEnvironment->getExchangeClose().m_timeZone));
-    grid.insertColumn(0, optionChain.getChainTime());
-    grid.setFormat(0, std::make_unique<DataGrid::TimestampFormatSeconds>(
-        DataGrid::m_defaultDateFormat, m_marketEnvironment->getExchangeClose().m_timeZone));
-    grid.insertColumn(0, optionChain.getUnderlier());
-    grid.setFormat(DataGrid::FormatFunctor([]{return std::make_unique<DataGrid::DoubleFormat>();}));
-    std::size_t precPos = grid.addColumn(fPrecision);
-    grid.setFormat(precPos, std::make_unique<DataGrid::DoubleFormat>(".4f"));
-    grid.setColNames(HeaderCols::capitalizeFirst(HeaderCols::getStackedCols()));
-    grid.serializeHeaderRow(ostr);
-    grid.serializeStringGrid(ostr);
+    };
+    writeRows(optionChain.getPuts(), Types::m_put, greeks.first);
+    writeRows(optionChain.getCalls(), Types::m_call, greeks.second);
+    writer.flush();
 }
 
 double CSVFromOptionChain::getPcpRate(const OptionChain& optionChain) const
@@ -284,3 +592,16 @@ double CSVFromOptionChain::computePrecision(const OptionChain& optionChain) cons
     }
     return fPrecision;
 }
+
+OptionAnalytics::PutCallGreeksMap CSVFromOptionChain::computeGreeks(const OptionChain& optionChain) const
+{
+    try {
+        return OptionAnalytics(m_marketEnvironment).compute(optionChain);
+    } catch (const std::exception& e)
+    {
+        BOOST_LOG_TRIVIAL(warning) << "Failed to compute Greeks for symbol " << optionChain.getUnderlier() << " at " 
+            << optionChain.getValuationDate() << " for expiry " << optionChain.getExpiryDate() 
+            << ", due to cause: " << e.what();
+    }
+    return OptionAnalytics::PutCallGreeksMap{};
+}
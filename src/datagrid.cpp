@@ -64,8 +64,31 @@ std::string DataGrid::TimestampFormatSeconds::formatCell(const Cell& cell) const
     if (timePoint == Timestamp{})
         return this->m_null;
     auto localTimePoint = DateUtils::convertZuluToTimestamp(timePoint, m_timeZone);
-    auto timePointSeconds = std::chrono::time_point_cast<std::chrono::seconds>(localTimePoint);
-    return fmt::format(m_fmt, timePointSeconds);
+    char buffer[20];
+    std::size_t nChars = 0;
+    if (m_civilFormat != CivilFormat::NONE)
+    {
+        nChars = DateUtils::writeCivilTime(buffer, DateUtils::toCivilTime(localTimePoint),
+            m_civilFormat != CivilFormat::TIME, m_civilFormat != CivilFormat::DATE);
+    }
+    if (nChars == 0)
+    {
+        auto timePointSeconds = std::chrono::time_point_cast<std::chrono::seconds>(localTimePoint);
+        return fmt::format(m_fmt, timePointSeconds);
+    }
+    return std::string(buffer, nChars);
+}
+
+DataGrid::TimestampFormatSeconds::CivilFormat DataGrid::TimestampFormatSeconds::getCivilFormat(
+    const std::string& fmt)
+{
+    if (fmt == makeFmtString(m_defaultTimestampFormat))
+        return CivilFormat::TIMESTAMP;
+    if (fmt == makeFmtString(m_defaultDateFormat))
+        return CivilFormat::DATE;
+    if (fmt == makeFmtString(m_defaultTimeFormat))
+        return CivilFormat::TIME;
+    return CivilFormat::NONE;
 }
 
 std::ostream& operator<<(std::ostream& os, const DataGrid::DataType& dataType)
@@ -3,6 +3,7 @@
 #include <boost/date_time/local_time_adjustor.hpp>
 #include "boost/date_time/posix_time/posix_time.hpp"
 //#include "boost/date_time/c_local_time_adjustor.hpp"
+#include <cstdint>
 #include <regex>
 #include <fmt/chrono.h>
 
@@ -30,16 +31,68 @@ public:
     static TimeConverter m_usCentralToUtc;
     static TimeConverter m_utcToUsMountain;
     static TimeConverter m_usMountainToUtc;
+    /// @brief Converts a timestamp, truncated to seconds
+    /// @details Outside of DST transition days, the converter's offset is constant over
+    /// the day, so it's computed once per day and thread instead of per conversion
     static Timestamp convertTimestamp(const Timestamp& timestamp, 
         const TimeConverter& converter)
     {
-        std::time_t time_t_value = std::chrono::system_clock::to_time_t(
-            std::chrono::time_point_cast<std::chrono::system_clock::duration>(timestamp));
-        boost::posix_time::ptime nyc(boost::posix_time::from_time_t(time_t_value));
-        boost::posix_time::ptime utc = converter(nyc);
-        auto utcTime = std::chrono::time_point_cast<std::chrono::nanoseconds>(
-            std::chrono::system_clock::from_time_t(boost::posix_time::to_time_t(utc)));
-        return Timestamp(std::chrono::nanoseconds(utcTime.time_since_epoch()));
+        std::int64_t seconds = std::chrono::duration_cast<std::chrono::seconds>(
+            timestamp.time_since_epoch()).count();
+        std::int64_t day = floorDiv(seconds, m_secondsPerDay);
+        thread_local DayOffset dayOffset{nullptr, 0, 0};
+        if (dayOffset.m_converter != &converter || dayOffset.m_day != day)
+        {
+            std::int64_t dayStart = day * m_secondsPerDay;
+            std::int64_t startOffset = computeOffset(dayStart, converter);
+            if (startOffset != computeOffset(dayStart + m_secondsPerDay - 1, converter))
+            {
+                // transition day, offsets differ by time of day
+                return fromSeconds(seconds + computeOffset(seconds, converter));
+            }
+            dayOffset = DayOffset{&converter, day, startOffset};
+        }
+        return fromSeconds(seconds + dayOffset.m_offset);
+    }
+
+    /// @brief Days from 1970-01-01 to calendar date
+    /// @details See http://howardhinnant.github.io/date_algorithms.html, civil_from_days
+    static void civilFromDays(std::int64_t days, CivilTime& civilTime)
+    {
+        days += 719468;
+        std::int64_t era = floorDiv(days, 146097);
+        unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+        unsigned yearOfEra = (dayOfEra - dayOfEra/1460 + dayOfEra/36524 - dayOfEra/146096) / 365;
+        unsigned dayOfYear = dayOfEra - (365*yearOfEra + yearOfEra/4 - yearOfEra/100);
+        unsigned monthIndex = (5*dayOfYear + 2)/153;
+        civilTime.m_day = dayOfYear - (153*monthIndex + 2)/5 + 1;
+        civilTime.m_month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+        civilTime.m_year = static_cast<int>(yearOfEra + era * 400 + (civilTime.m_month <= 2));
+    }
+
+    static std::int64_t floorDiv(std::int64_t value, std::int64_t divisor)
+    {
+        std::int64_t quotient = value / divisor;
+        return (value % divisor < 0) ? quotient - 1 : quotient;
+    }
+
+    static constexpr std::int64_t m_secondsPerDay = 86400;
+private:
+    /// @brief A converter's offset in seconds for a day
+    struct DayOffset
+    {
+        const TimeConverter* m_converter;
+        std::int64_t m_day;
+        std::int64_t m_offset;
+    };
+    static std::int64_t computeOffset(std::int64_t seconds, const TimeConverter& converter)
+    {
+        boost::posix_time::ptime from(boost::posix_time::from_time_t(static_cast<std::time_t>(seconds)));
+        return static_cast<std::int64_t>(boost::posix_time::to_time_t(converter(from))) - seconds;
+    }
+    static Timestamp fromSeconds(std::int64_t seconds)
+    {
+        return Timestamp(std::chrono::duration_cast<Timestamp::duration>(std::chrono::seconds(seconds)));
     }
 };
 
@@ -121,6 +174,57 @@ std::string DateUtils::timestampToStringIntSeconds(const Timestamp& timestamp)
     return fmt::format("{:%Y-%m-%d %H:%M:%S}", timePointSeconds);
 }
 
+DateUtils::CivilTime DateUtils::toCivilTime(const Timestamp& timestamp)
+{
+    std::int64_t seconds = std::chrono::duration_cast<std::chrono::seconds>(
+        timestamp.time_since_epoch()).count();
+    std::int64_t days = Impl::floorDiv(seconds, Impl::m_secondsPerDay);
+    unsigned secondOfDay = static_cast<unsigned>(seconds - days * Impl::m_secondsPerDay);
+    CivilTime civilTime;
+    Impl::civilFromDays(days, civilTime);
+    civilTime.m_hour = secondOfDay / 3600;
+    civilTime.m_minute = secondOfDay / 60 % 60;
+    civilTime.m_second = secondOfDay % 60;
+    return civilTime;
+}
+
+std::size_t DateUtils::writeCivilTime(char* buffer, const CivilTime& civilTime, bool bDate, bool bTime)
+{
+    auto put2 = [](char* pos, unsigned value) {
+        pos[0] = static_cast<char>('0' + value / 10);
+        pos[1] = static_cast<char>('0' + value % 10);
+    };
+    char* pos = buffer;
+    if (bDate)
+    {
+        if (civilTime.m_year < 0 || civilTime.m_year > 9999)
+        {
+            return 0;
+        }
+        unsigned year = static_cast<unsigned>(civilTime.m_year);
+        put2(pos, year / 100);
+        put2(pos + 2, year % 100);
+        pos[4] = '-';
+        put2(pos + 5, civilTime.m_month);
+        pos[7] = '-';
+        put2(pos + 8, civilTime.m_day);
+        pos += 10;
+        if (bTime)
+        {
+            *pos++ = ' ';
+        }
+    }
+    if (bTime)
+    {
+        put2(pos, civilTime.m_hour);
+        pos[2] = ':';
+        put2(pos + 3, civilTime.m_minute);
+        pos[5] = ':';
+        put2(pos + 6, civilTime.m_second);
+        pos += 8;
+    }
+    return static_cast<std::size_t>(pos - buffer);
+}
 
 namespace
 {
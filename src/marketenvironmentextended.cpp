@@ -1,19 +1,173 @@
 #include "bentoclient/marketenvironmentextended.hpp"
 #include <boost/log/trivial.hpp>
 #include <fmt/core.h>
+#include <algorithm>
 #include <filesystem>
 #include <chrono>
+#include <cmath>
 #include <fstream>
+#include <functional>
 
 using namespace bentoclient;
 
+const std::size_t MarketEnvironmentExtended::m_nGridDays = 3 * 366 + 1;
+const std::string MarketEnvironmentExtended::m_cacheExtension(".cache");
+
+class MarketEnvironmentExtended::Algos
+{
+public:
+    // C++ 20 is using years = duration<_GLIBCXX_CHRONO_INT64_T, ratio<31556952>>;
+    // so it must be right :)
+    typedef std::chrono::duration<double, std::ratio<31556952>> Years;
+    static constexpr double m_secondsPerDay = 86400.0;
+    static constexpr double m_secondsPerYear = 31556952.0;
+    // yield curve selection is by closest curve date, with curve dates at midnight
+    static constexpr std::chrono::hours m_slotLength{12};
+    // binary cache header
+    static constexpr std::uint32_t m_cacheMagic = 0x43594342; // "BCYC"
+    static constexpr std::uint32_t m_cacheVersion = 1;
+
+    /// @brief Sets up the monotone interpolation and tenor grid tables for one yield curve
+    /// @param curveTime Curve date
+    /// @param curve Semiannual par rates in percent by maturity
+    static InterpolatedCurve interpolate(Timestamp curveTime, const YieldCurveMap::mapped_type& curve)
+    {
+        InterpolatedCurve interpolated;
+        for (auto& maturityRate : curve)
+        {
+            if (maturityRate.first < curveTime) {
+                continue;
+            }
+            interpolated.m_tenors.push_back(Years(maturityRate.first - curveTime).count());
+            // Convert semiannual par rate (percent) to continuously compounded rate
+            double r_sa = maturityRate.second / 100.0;
+            interpolated.m_rates.push_back(2.0 * std::log(1.0 + r_sa / 2.0));
+        }
+        computeSlopes(interpolated);
+        interpolated.m_gridRates.resize(m_nGridDays);
+        for (std::size_t day = 0; day < m_nGridDays; ++day)
+        {
+            interpolated.m_gridRates[day] = evaluate(interpolated, day * m_secondsPerDay / m_secondsPerYear);
+        }
+        return interpolated;
+    }
+
+    /// @brief Fritsch-Carlson slopes for a shape preserving cubic Hermite interpolation
+    static void computeSlopes(InterpolatedCurve& curve)
+    {
+        const std::vector<double>& x = curve.m_tenors;
+        const std::vector<double>& y = curve.m_rates;
+        std::size_t n = x.size();
+        curve.m_slopes.assign(n, 0.0);
+        if (n < 2) {
+            return;
+        }
+        std::vector<double> secants(n - 1);
+        for (std::size_t k = 0; k + 1 < n; ++k)
+        {
+            secants[k] = (y[k + 1] - y[k]) / (x[k + 1] - x[k]);
+        }
+        curve.m_slopes[0] = secants[0];
+        curve.m_slopes[n - 1] = secants[n - 2];
+        for (std::size_t k = 1; k + 1 < n; ++k)
+        {
+            if (secants[k - 1] * secants[k] <= 0.0) {
+                // local extremum, flat to avoid overshoots
+                continue;
+            }
+            // weighted harmonic mean of adjacent secants
+            double hPrevious = x[k] - x[k - 1];
+            double hNext = x[k + 1] - x[k];
+            double w1 = 2.0 * hNext + hPrevious;
+            double w2 = hNext + 2.0 * hPrevious;
+            curve.m_slopes[k] = (w1 + w2) / (w1 / secants[k - 1] + w2 / secants[k]);
+        }
+    }
+
+    /// @brief Evaluates the interpolation at {years}, flat beyond the first and last knots
+    static double evaluate(const InterpolatedCurve& curve, double years)
+    {
+        const std::vector<double>& x = curve.m_tenors;
+        const std::vector<double>& y = curve.m_rates;
+        if (x.empty()) {
+            throw std::invalid_argument("Yield curve without rates");
+        }
+        if (years <= x.front()) {
+            return y.front();
+        }
+        if (years >= x.back()) {
+            return y.back();
+        }
+        std::size_t k = std::upper_bound(x.begin(), x.end(), years) - x.begin() - 1;
+        double h = x[k + 1] - x[k];
+        double t = (years - x[k]) / h;
+        double t2 = t * t;
+        double t3 = t2 * t;
+        return (2.0 * t3 - 3.0 * t2 + 1.0) * y[k]
+            + (t3 - 2.0 * t2 + t) * h * curve.m_slopes[k]
+            + (-2.0 * t3 + 3.0 * t2) * y[k + 1]
+            + (t3 - t2) * h * curve.m_slopes[k + 1];
+    }
+
+    /// @brief Linear lookup in a tenor grid table, tenors beyond the table use {beyondGrid}
+    template <typename F>
+    static double lookup(const std::vector<double>& grid, double years, F beyondGrid)
+    {
+        double days = years * m_secondsPerYear / m_secondsPerDay;
+        std::size_t day = static_cast<std::size_t>(days);
+        if (day + 1 >= grid.size()) {
+            return beyondGrid();
+        }
+        double fraction = days - day;
+        return grid[day] + (grid[day + 1] - grid[day]) * fraction;
+    }
+
+    template <typename T>
+    static void write(std::ostream& ostr, const T& value)
+    {
+        ostr.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    template <typename T>
+    static T read(std::istream& istr)
+    {
+        T value{};
+        if (!istr.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+            throw std::runtime_error("Unexpected end of yield curve cache");
+        }
+        return value;
+    }
+};
+
 MarketEnvironmentExtended::MarketEnvironmentExtended(double fDefaultRiskFreeRate,
     const DateUtils::ExchangeClose& exchangeClose,
-    const std::string& yieldCurveCsv) :
+    const std::string& yieldCurveCsv,
+    const std::string& cacheDirectory) :
     MarketEnvironment(fDefaultRiskFreeRate, exchangeClose),
-    m_yieldCurveMap(readYieldCurveCsv(yieldCurveCsv))
+    m_yieldCurveMap(readYieldCurve(yieldCurveCsv, cacheDirectory)),
+    m_curves{},
+    m_slotToCurve{},
+    m_firstCurveTime{}
 {
-    
+    if (m_yieldCurveMap.empty()) {
+        return;
+    }
+    std::map<Timestamp, std::uint32_t> curveIndices;
+    m_curves.reserve(m_yieldCurveMap.size());
+    for (auto& timeCurve : m_yieldCurveMap)
+    {
+        curveIndices.emplace(timeCurve.first, static_cast<std::uint32_t>(m_curves.size()));
+        m_curves.push_back(Algos::interpolate(timeCurve.first, timeCurve.second));
+    }
+    // closest curve by half day slot, the boundaries between closest curve dates fall on slot starts
+    m_firstCurveTime = m_yieldCurveMap.begin()->first;
+    std::size_t nSlots = (m_yieldCurveMap.rbegin()->first - m_firstCurveTime) / Algos::m_slotLength + 1;
+    m_slotToCurve.reserve(nSlots);
+    for (std::size_t slot = 0; slot < nSlots; ++slot)
+    {
+        Timestamp slotTime = m_firstCurveTime + Algos::m_slotLength * slot;
+        m_slotToCurve.push_back(curveIndices.at(
+            getNextInTimeRange(slotTime, curveIndices, std::chrono::seconds(1)).first));
+    }
 }
 
 MarketEnvironmentExtended::~MarketEnvironmentExtended()
@@ -24,48 +178,141 @@ double MarketEnvironmentExtended::getRiskFreeRate(Timestamp valuationTime,
     Timestamp expiryTime) const
 {
     /* No synchronization in this method, since all class data is const */
-    if (m_yieldCurveMap.empty())
+    if (m_curves.empty())
         return this->m_fRiskFreeRate;
-    // Simply take the difference between expiryTime and valuationTime as tenor
+    // Simply take the difference between expiryTime and valuationTime as tenor. 
+    // The closest yield curve to valuation time may differ significantly from valuationTime,
+    // depending on whether the yield curve data covers the valuation time range. 
+    // And if yield curves files aren't updated...
+    // So: use the incoming tenor on the curve of the closest curve date
+    double years = getTenorYears(valuationTime, expiryTime);
+    const InterpolatedCurve& curve = getCurve(valuationTime);
+    return Algos::lookup(curve.m_gridRates, years, [&curve, years]() {
+        return Algos::evaluate(curve, years);
+    });
+}
+
+const MarketEnvironmentExtended::InterpolatedCurve& MarketEnvironmentExtended::getCurve(
+    Timestamp valuationTime) const
+{
+    std::size_t slot = 0;
+    if (valuationTime > m_firstCurveTime) {
+        slot = std::min<std::size_t>((valuationTime - m_firstCurveTime) / Algos::m_slotLength,
+            m_slotToCurve.size() - 1);
+    }
+    return m_curves[m_slotToCurve[slot]];
+}
+
+double MarketEnvironmentExtended::getTenorYears(Timestamp valuationTime, Timestamp expiryTime)
+{
     if (expiryTime <= valuationTime) {
         throw std::invalid_argument(fmt::format("Expiry time {} not after valuation time {}",
             serializeTimestamp(expiryTime), serializeTimestamp(valuationTime)));
     }
-    // First, get the closest yield curve to valuation time
-    auto pair = getNextInTimeRange(valuationTime, m_yieldCurveMap, std::chrono::seconds(1));
-    if (pair.first == Timestamp{})
+    return Algos::Years(expiryTime - valuationTime).count();
+}
+
+std::string MarketEnvironmentExtended::getCachePath(const std::string& yieldCurveCsv,
+    const std::string& cacheDirectory)
+{
+    std::filesystem::path csvPath(yieldCurveCsv);
+    std::size_t pathHash = std::hash<std::string>()(std::filesystem::absolute(csvPath).lexically_normal().string());
+    return (std::filesystem::path(cacheDirectory) / fmt::format("{}.{:016x}{}",
+        csvPath.filename().string(), pathHash, m_cacheExtension)).string();
+}
+
+MarketEnvironmentExtended::YieldCurveMap MarketEnvironmentExtended::readYieldCurve(
+    const std::string& filename, const std::string& cacheDirectory)
+{
+    if (cacheDirectory.empty() || filename.empty()) {
+        return readYieldCurveCsv(filename);
+    }
+    std::string cacheFilename = getCachePath(filename, cacheDirectory);
+    std::error_code csvError, cacheError;
+    std::filesystem::file_time_type csvTime = std::filesystem::last_write_time(filename, csvError);
+    std::filesystem::file_time_type cacheTime = std::filesystem::last_write_time(cacheFilename, cacheError);
+    // the cache is good unless the CSV got updated after it
+    if (!cacheError && (csvError || cacheTime >= csvTime))
     {
-        BOOST_LOG_TRIVIAL(error) << "Found no valid entry in yield curve list for valuation time "
-            << serializeTimestamp(valuationTime);
-        return this->m_fRiskFreeRate;
+        try {
+            return readYieldCurveCache(cacheFilename);
+        } catch (const std::exception& e) {
+            BOOST_LOG_TRIVIAL(warning) << "Failed to read yield curve cache " << cacheFilename
+                << ", reading CSV instead: " << e.what();
+        }
+    }
+    YieldCurveMap yieldCurveMap = readYieldCurveCsv(filename);
+    if (!yieldCurveMap.empty()) {
+        try {
+            std::filesystem::create_directories(cacheDirectory);
+            writeYieldCurveCache(cacheFilename, yieldCurveMap);
+        } catch (const std::exception& e) {
+            BOOST_LOG_TRIVIAL(warning) << "Failed to write yield curve cache " << cacheFilename
+                << ": " << e.what();
+        }
+    }
+    return yieldCurveMap;
+}
+
+MarketEnvironmentExtended::YieldCurveMap MarketEnvironmentExtended::readYieldCurveCache(
+    const std::string& filename)
+{
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs) {
+        throw std::runtime_error("Failed to open file");
+    }
+    if (Algos::read<std::uint32_t>(ifs) != Algos::m_cacheMagic 
+        || Algos::read<std::uint32_t>(ifs) != Algos::m_cacheVersion) {
+        throw std::runtime_error("Unknown file format");
     }
-    const YieldCurveMap::mapped_type& timeStampedCurve = m_yieldCurveMap.at(pair.first);
-    // The timestamps in the timeStampedCurve have the tenor as difference between them and pair.first.
-    // Therefore, the expiry time passed into here isn't the ideal lookup, because pair.first
-    // may differ significantly from valuationTime, depending on whether the yield curve data
-    // covers the valuation time range. And if yield curves files aren't updated...
-    // So: use the incoming tenor as a shift from curve base time as a lookup key
-    TimeRange tenor = std::chrono::duration_cast<TimeRange>(expiryTime - valuationTime);
-    Timestamp lookupTime = pair.first + tenor;
-    auto yieldPair = getNextInTimeRange(lookupTime, timeStampedCurve, std::chrono::seconds(1));
-    if (yieldPair.first == Timestamp{})
+    YieldCurveMap yieldCurveMap;
+    std::uint64_t nCurves = Algos::read<std::uint64_t>(ifs);
+    for (std::uint64_t i = 0; i < nCurves; ++i)
     {
-        BOOST_LOG_TRIVIAL(error) << "Found no valid entry in best yield curve for lookup time "
-            << serializeTimestamp(lookupTime) << " shifted from expiry time " 
-            << serializeTimestamp(expiryTime);
-        return this->m_fRiskFreeRate;
+        Timestamp curveTime(Timestamp::duration(Algos::read<Timestamp::rep>(ifs)));
+        YieldCurveMap::mapped_type curve;
+        std::uint64_t nRates = Algos::read<std::uint64_t>(ifs);
+        for (std::uint64_t j = 0; j < nRates; ++j)
+        {
+            Timestamp maturity(Timestamp::duration(Algos::read<Timestamp::rep>(ifs)));
+            curve.emplace_hint(curve.end(), maturity, Algos::read<double>(ifs));
+        }
+        // like the CSV reader, curves without rates don't count
+        if (!curve.empty()) {
+            yieldCurveMap[curveTime] = std::move(curve);
+        }
     }
-    // TODO: if options of longer durations are important, interpolate between points 
-    // in the par yield curve. However, for options up to 35 DTE, the algo will always pick the
-    // first point in the curve anyway.
-    double tsyRate = timeStampedCurve.at(yieldPair.first);
-    // Convert semiannual par rate (percent) to continuously compounded rate
-    // and as to the constant below, C++ 20 is using years = duration<_GLIBCXX_CHRONO_INT64_T, ratio<31556952>>;
-    // so it must be right :)
-    double tenor_years = std::chrono::duration_cast<std::chrono::duration<double, std::ratio<31556952>>>(tenor).count();
-    double r_sa = tsyRate / 100.0;
-    double r_cc = 2.0 * std::log(1.0 + r_sa / 2.0);
-    return r_cc;
+    return yieldCurveMap;
+}
+
+void MarketEnvironmentExtended::writeYieldCurveCache(const std::string& filename,
+    const YieldCurveMap& yieldCurveMap)
+{
+    // write to a temporary file first, so concurrent readers never see partial caches
+    std::string tmpFilename = filename + ".tmp";
+    {
+        std::ofstream ofs(tmpFilename, std::ios::binary | std::ios::trunc);
+        if (!ofs) {
+            throw std::runtime_error("Failed to open file");
+        }
+        Algos::write(ofs, Algos::m_cacheMagic);
+        Algos::write(ofs, Algos::m_cacheVersion);
+        Algos::write(ofs, static_cast<std::uint64_t>(yieldCurveMap.size()));
+        for (auto& timeCurve : yieldCurveMap)
+        {
+            Algos::write(ofs, timeCurve.first.time_since_epoch().count());
+            Algos::write(ofs, static_cast<std::uint64_t>(timeCurve.second.size()));
+            for (auto& maturityRate : timeCurve.second)
+            {
+                Algos::write(ofs, maturityRate.first.time_since_epoch().count());
+                Algos::write(ofs, maturityRate.second);
+            }
+        }
+        if (!ofs.flush()) {
+            throw std::runtime_error("Failed to write file");
+        }
+    }
+    std::filesystem::rename(tmpFilename, filename);
 }
 
 MarketEnvironmentExtended::YieldCurveMap MarketEnvironmentExtended::readYieldCurveCsv(const std::string& filename)
@@ -178,6 +425,11 @@ Date,"1 Mo","1.5 Month","2 Mo","3 Mo","4 Mo","6 Mo","1 Yr","2 Yr","3 Yr","5 Yr",
                     << "', underlying error: " << e.what();
             }
         }
+        if (curve.empty()) {
+            // e.g. a holiday row of N/A rates, closest curves of other dates take over
+            BOOST_LOG_TRIVIAL(warning) << "Skipping yield curve without rates for " << dateStr;
+            continue;
+        }
         yieldCurveMap[dateTs] = curve;
     }
     return yieldCurveMap;
@@ -0,0 +1,211 @@
+#include "bentoclient/optionanalytics.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/osioption.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace bentoclient;
+
+const int OptionAnalytics::m_nNewtonSteps = 8;
+
+class OptionAnalytics::Algos
+{
+public:
+    // bounds for implied volatilities to keep Newton steps in a meaningful range
+    static constexpr double m_minVolatility = 1e-4;
+    static constexpr double m_maxVolatility = 5.0;
+    static constexpr double m_daysPerYear = 365.0;
+    static constexpr double m_minTimeValue = 1e-300;
+
+    /// @brief Standard normal cumulative distribution
+    static double normCdf(double x)
+    {
+        constexpr double invSqrt2 = 0.7071067811865476;
+        return 0.5 * std::erfc(-x * invSqrt2);
+    }
+    /// @brief Standard normal density
+    static double normPdf(double x)
+    {
+        constexpr double invSqrt2Pi = 0.3989422804014327;
+        return invSqrt2Pi * std::exp(-0.5 * x * x);
+    }
+    /// @brief Corrado-Miller rational approximation of the total volatility sigma*sqrt(T)
+    /// @param underlierPrice Underlier price S
+    /// @param discountedStrike Strike discounted to valuation time
+    /// @param callPrice Call price, puts converted by put-call-parity
+    static double approximateTotalVolatility(double underlierPrice, double discountedStrike, double callPrice)
+    {
+        constexpr double pi = 3.141592653589793;
+        constexpr double sqrt2Pi = 2.5066282746310002;
+        double forwardGap = underlierPrice - discountedStrike;
+        double a = callPrice - forwardGap / 2.0;
+        double discriminant = std::max(a * a - forwardGap * forwardGap / pi, 0.0);
+        double totalVolatility = sqrt2Pi / (underlierPrice + discountedStrike) * (a + std::sqrt(discriminant));
+        if (!(totalVolatility > 0.0))
+        {
+            // Brenner-Subrahmanyam as fallback far from the money
+            totalVolatility = sqrt2Pi * callPrice / underlierPrice;
+        }
+        return totalVolatility;
+    }
+};
+
+OptionAnalytics::Greeks::Greeks() :
+    m_impliedVolatility(std::nan("0xbad")),
+    m_delta(std::nan("0xbad")),
+    m_gamma(std::nan("0xbad")),
+    m_vega(std::nan("0xbad")),
+    m_theta(std::nan("0xbad"))
+{
+}
+
+OptionAnalytics::OptionAnalytics(std::shared_ptr<MarketEnvironment> marketEnvironment) :
+    m_marketEnvironment(marketEnvironment)
+{
+}
+
+OptionAnalytics::Parameters OptionAnalytics::getParameters(const OptionChain& optionChain) const
+{
+    const DateUtils::ExchangeClose& exchangeClose = m_marketEnvironment->getExchangeClose();
+    Parameters parameters;
+    parameters.m_riskFreeRate = m_marketEnvironment->getRiskFreeRate(
+        optionChain.getChainTime(), optionChain.getExpiryTime(exchangeClose));
+    parameters.m_years = OptionChain::Util::getYearFraction(optionChain, exchangeClose);
+    parameters.m_underlierPrice = optionChain.getParityRate(parameters.m_riskFreeRate, exchangeClose);
+    return parameters;
+}
+
+OptionAnalytics::PutCallGreeksMap OptionAnalytics::compute(const OptionChain& optionChain) const
+{
+    Parameters parameters = getParameters(optionChain);
+    PutCallGreeksMap putCallGreeks;
+    auto computeSide = [&parameters](const OptionChain::RecordMap& recordMap, bool bCall, GreeksMap& greeksMap)
+    {
+        std::vector<const std::string*> strikeKeys;
+        std::vector<double> strikes;
+        std::vector<double> prices;
+        strikeKeys.reserve(recordMap.size());
+        strikes.reserve(recordMap.size());
+        prices.reserve(recordMap.size());
+        for (auto it = recordMap.begin(); it != recordMap.end(); ++it)
+        {
+            if (it->second.bidAskValid())
+            {
+                strikeKeys.push_back(&it->first);
+                strikes.push_back(OsiOption::fromStrikeKey(it->first));
+                prices.push_back(it->second.getMidPrice());
+            }
+        }
+        std::size_t n = strikes.size();
+        std::vector<double> volatilities(n);
+        std::vector<Greeks> greeks(n);
+        impliedVolatilities(parameters, strikes.data(), prices.data(), bCall, volatilities.data(), n);
+        computeGreeks(parameters, strikes.data(), volatilities.data(), bCall, greeks.data(), n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            greeksMap.emplace_hint(greeksMap.end(), *strikeKeys[i], greeks[i]);
+        }
+    };
+    computeSide(optionChain.getPuts(), false, putCallGreeks.first);
+    computeSide(optionChain.getCalls(), true, putCallGreeks.second);
+    return putCallGreeks;
+}
+
+void OptionAnalytics::impliedVolatilities(const Parameters& parameters, const double* strikes,
+    const double* prices, bool bCall, double* volatilities, std::size_t n)
+{
+    const double nan = std::nan("0xbad");
+    if (!(parameters.m_years > 0.0) || !(parameters.m_underlierPrice > 0.0))
+    {
+        std::fill(volatilities, volatilities + n, nan);
+        return;
+    }
+    const double S = parameters.m_underlierPrice;
+    const double sqrtT = std::sqrt(parameters.m_years);
+    const double discountFactor = std::exp(-parameters.m_riskFreeRate * parameters.m_years);
+    const double phi = bCall ? 1.0 : -1.0;
+    std::vector<double> logMoneyness(n);
+    std::vector<double> discountedStrikes(n);
+    std::vector<double> intrinsicValues(n);
+    // first pass: no-arbitrage bounds and rational approximation as initial guess
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        double discountedStrike = strikes[i] * discountFactor;
+        double intrinsic = std::max(phi * (S - discountedStrike), 0.0);
+        double upperBound = bCall ? S : discountedStrike;
+        discountedStrikes[i] = discountedStrike;
+        intrinsicValues[i] = intrinsic;
+        logMoneyness[i] = std::log(S / discountedStrike);
+        if (!(prices[i] > intrinsic && prices[i] < upperBound))
+        {
+            volatilities[i] = nan;
+            continue;
+        }
+        double callPrice = bCall ? prices[i] : prices[i] + S - discountedStrike;
+        double volatility = Algos::approximateTotalVolatility(S, discountedStrike, callPrice) / sqrtT;
+        volatilities[i] = std::min(std::max(volatility, Algos::m_minVolatility), Algos::m_maxVolatility);
+    }
+    // Newton polish on the log of the time value, which is close to linear in volatility
+    // also far from the money where plain Newton crawls down from the initial guess.
+    // Same number of steps for all strikes, nan lanes stay nan.
+    for (int step = 0; step < m_nNewtonSteps; ++step)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            double volatility = volatilities[i];
+            double totalVolatility = volatility * sqrtT;
+            double d1 = logMoneyness[i] / totalVolatility + totalVolatility / 2.0;
+            double d2 = d1 - totalVolatility;
+            double model = phi * (S * Algos::normCdf(phi * d1) - discountedStrikes[i] * Algos::normCdf(phi * d2));
+            double vega = S * Algos::normPdf(d1) * sqrtT;
+            double modelTimeValue = std::max(model - intrinsicValues[i], Algos::m_minTimeValue);
+            double timeValue = prices[i] - intrinsicValues[i];
+            double next = vega > 1e-12 ?
+                volatility - std::log(modelTimeValue / timeValue) * modelTimeValue / vega : volatility;
+            // damp steps into [volatility/2, 2*volatility] where the linearization misleads
+            next = std::min(std::max(next, volatility / 2.0), volatility * 2.0);
+            volatilities[i] = std::min(std::max(next, Algos::m_minVolatility), Algos::m_maxVolatility);
+            if (std::isnan(volatility))
+            {
+                volatilities[i] = nan;
+            }
+        }
+    }
+}
+
+void OptionAnalytics::computeGreeks(const Parameters& parameters, const double* strikes,
+    const double* volatilities, bool bCall, Greeks* greeks, std::size_t n)
+{
+    const double S = parameters.m_underlierPrice;
+    const double r = parameters.m_riskFreeRate;
+    const double sqrtT = std::sqrt(parameters.m_years);
+    const double discountFactor = std::exp(-r * parameters.m_years);
+    const double phi = bCall ? 1.0 : -1.0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        double discountedStrike = strikes[i] * discountFactor;
+        double totalVolatility = volatilities[i] * sqrtT;
+        double d1 = std::log(S / discountedStrike) / totalVolatility + totalVolatility / 2.0;
+        double d2 = d1 - totalVolatility;
+        double density = Algos::normPdf(d1);
+        greeks[i] = Greeks(
+            volatilities[i],
+            bCall ? Algos::normCdf(d1) : Algos::normCdf(d1) - 1.0,
+            density / (S * totalVolatility),
+            S * density * sqrtT / 100.0,
+            (-S * density * volatilities[i] / (2.0 * sqrtT)
+                - phi * r * discountedStrike * Algos::normCdf(phi * d2)) / Algos::m_daysPerYear);
+    }
+}
+
+double OptionAnalytics::price(const Parameters& parameters, double strike, double volatility, bool bCall)
+{
+    const double phi = bCall ? 1.0 : -1.0;
+    double discountedStrike = strike * std::exp(-parameters.m_riskFreeRate * parameters.m_years);
+    double totalVolatility = volatility * std::sqrt(parameters.m_years);
+    double d1 = std::log(parameters.m_underlierPrice / discountedStrike) / totalVolatility + totalVolatility / 2.0;
+    double d2 = d1 - totalVolatility;
+    return phi * (parameters.m_underlierPrice * Algos::normCdf(phi * d1)
+        - discountedStrike * Algos::normCdf(phi * d2));
+}
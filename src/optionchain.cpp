@@ -1,8 +1,11 @@
 #include "bentoclient/optionchain.hpp"
+#include "bentoclient/marketenvironment.hpp"
 #include "bentoclient/optioninstruments.hpp"
 #include "bentoclient/osioption.hpp"
 #include <boost/log/trivial.hpp>
 #include <fmt/core.h>
+#include <algorithm>
+#include <iterator>
 #include <tuple>
 #include <cmath>
 
@@ -26,14 +29,96 @@ public:
             instrumentList.splice(instrumentList.end(), cbboSource, instrumentRecord);
         }
     }
+    // minimum number of put/call pairs in a timeline slot for an underlier estimate
+    static constexpr std::size_t m_nMinPathPairs = 3;
+    /// @brief Median put-call-parity rate of pairs with valid bid and ask, nan if too few pairs
+    static double medianParityRate(const PutCallRecordMap& putCallRecords, double fDiscountFactor,
+        std::vector<double>& parityRates)
+    {
+        parityRates.clear();
+        const RecordMap& puts = putCallRecords.first;
+        const RecordMap& calls = putCallRecords.second;
+        auto putIt = puts.begin();
+        auto callIt = calls.begin();
+        // both maps are ordered by strike key, so a merge join finds matching strikes
+        while (putIt != puts.end() && callIt != calls.end())
+        {
+            if (putIt->first < callIt->first) {
+                ++putIt;
+            } else if (callIt->first < putIt->first) {
+                ++callIt;
+            } else {
+                if (putIt->second.bidAskValid() && callIt->second.bidAskValid())
+                {
+                    parityRates.push_back(callIt->second.getMidPrice() - putIt->second.getMidPrice()
+                        + OsiOption::fromStrikeKey(callIt->first) * fDiscountFactor);
+                }
+                ++putIt;
+                ++callIt;
+            }
+        }
+        if (parityRates.size() < m_nMinPathPairs)
+        {
+            return std::nan("0xbad");
+        }
+        auto middle = parityRates.begin() + parityRates.size() / 2;
+        std::nth_element(parityRates.begin(), middle, parityRates.end());
+        return *middle;
+    }
+    /// @brief Estimates deltas of stale records with valid bid and ask from the mid price slope along strikes
+    /// @details Slopes only use neighbors that are stale as well, as fresh neighbors priced at
+    /// another underlier level would distort the slope.
+    /// @param staleBefore Records received before are stale
+    /// @param bCall Clamps deltas to [0, 1] for calls and [-1, 0] for puts
+    static std::map<std::string, double> estimateStaleDeltas(const RecordMap& recordMap,
+        Timestamp staleBefore, double fUnderlier, bool bCall)
+    {
+        std::vector<const std::string*> strikeKeys;
+        std::vector<double> strikes;
+        std::vector<double> prices;
+        std::vector<bool> stale;
+        for (auto it = recordMap.begin(); it != recordMap.end(); ++it)
+        {
+            if (it->second.bidAskValid())
+            {
+                strikeKeys.push_back(&it->first);
+                strikes.push_back(OsiOption::fromStrikeKey(it->first));
+                prices.push_back(it->second.getMidPrice());
+                stale.push_back(it->second.m_recvTime < staleBefore);
+            }
+        }
+        std::map<std::string, double> deltas;
+        std::size_t n = strikes.size();
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (!stale[i])
+            {
+                continue;
+            }
+            // central differences inside, one sided at the ends of stale strike series
+            std::size_t lower = i > 0 && stale[i - 1] ? i - 1 : i;
+            std::size_t upper = i + 1 < n && stale[i + 1] ? i + 1 : i;
+            if (lower == upper)
+            {
+                continue;
+            }
+            double slope = (prices[upper] - prices[lower]) / (strikes[upper] - strikes[lower]);
+            double delta = (prices[i] - strikes[i] * slope) / fUnderlier;
+            delta = bCall ? std::min(std::max(delta, 0.0), 1.0) : std::min(std::max(delta, -1.0), 0.0);
+            deltas.emplace_hint(deltas.end(), *strikeKeys[i], delta);
+        }
+        return deltas;
+    }
 };
 
-const std::uint64_t OptionChain::Record::priceScaling = 1000000000;
+const std::uint64_t OptionChain::Record::priceScaling = OptionChain::PriceWeight::m_priceScaling;
+const std::string OptionChain::m_deltaShiftComment("delta-shift");
+const TimeRange OptionChain::m_slotWindow = std::chrono::seconds(2);
 OptionChain::Record::Record() :
-    m_price(std::nan("0xbad"), 0),
+    m_price(),
     m_priceTime{},
-    m_askPrice(std::nan("0xbad"), 0),
-    m_bidPrice(std::nan("0xbad"), 0),
+    m_askPrice(),
+    m_bidPrice(),
     m_recvTime{},
     m_comment{}
 {
@@ -55,10 +140,10 @@ OptionChain::Record::Record(
 }
 
 OptionChain::Record::Record(const databento::CbboMsg& cbboMsg) :
-    m_price(static_cast<double>(cbboMsg.price)/priceScaling, cbboMsg.size),
+    m_price(cbboMsg.price, cbboMsg.size),
     m_priceTime(cbboMsg.hd.ts_event),
-    m_askPrice(static_cast<double>(cbboMsg.levels[0].ask_px)/priceScaling, cbboMsg.levels[0].ask_sz),
-    m_bidPrice(static_cast<double>(cbboMsg.levels[0].bid_px)/priceScaling, cbboMsg.levels[0].bid_sz),
+    m_askPrice(cbboMsg.levels[0].ask_px, cbboMsg.levels[0].ask_sz),
+    m_bidPrice(cbboMsg.levels[0].bid_px, cbboMsg.levels[0].bid_sz),
     m_recvTime(cbboMsg.ts_recv),
     m_comment{}
 {
@@ -77,6 +162,108 @@ bool OptionChain::Record::operator == (const Record& other) const
         && m_comment == other.m_comment;
 }
 
+const OptionChain::RecordMap OptionChain::SharedRecordMap::m_emptyRecordMap{};
+std::atomic<std::uint64_t> OptionChain::SharedRecordMap::m_versionCounter{0};
+
+OptionChain::SharedRecordMap::SharedRecordMap(RecordMap&& recordMap) :
+    m_recordMap(std::make_shared<RecordMap>(std::move(recordMap))),
+    m_version(++m_versionCounter)
+{
+}
+
+OptionChain::SharedRecordMap::SharedRecordMap(const SharedRecordMap& other) :
+    m_recordMap(other.m_recordMap ? std::make_shared<RecordMap>(*other.m_recordMap) : nullptr),
+    m_version(++m_versionCounter)
+{
+}
+
+OptionChain::SharedRecordMap& OptionChain::SharedRecordMap::operator=(const SharedRecordMap& other)
+{
+    if (this != &other)
+    {
+        m_recordMap = other.m_recordMap ? std::make_shared<RecordMap>(*other.m_recordMap) : nullptr;
+        m_version = ++m_versionCounter;
+    }
+    return *this;
+}
+
+OptionChain::RecordMap& OptionChain::SharedRecordMap::mutate()
+{
+    if (!m_recordMap)
+    {
+        m_recordMap = std::make_shared<RecordMap>();
+    }
+    else if (m_recordMap.use_count() > 1)
+    {
+        // detach from the chains sharing the records before writing
+        m_recordMap = std::make_shared<RecordMap>(*m_recordMap);
+    }
+    // the caller is about to write, so memoized metrics of the old contents are stale
+    m_version = ++m_versionCounter;
+    return *m_recordMap;
+}
+
+OptionChain::SharedRecordMap OptionChain::SharedRecordMap::share() const
+{
+    SharedRecordMap shared;
+    shared.m_recordMap = m_recordMap;
+    shared.m_version = m_version;
+    return shared;
+}
+
+OptionChain::MetricsCache::MetricsCache(const MetricsCache&) :
+    MetricsCache()
+{
+}
+
+OptionChain::MetricsCache& OptionChain::MetricsCache::operator=(const MetricsCache& other)
+{
+    if (this != &other)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_putsVersion = m_callsVersion = 0;
+        m_chainTime.reset();
+        m_parityRates.clear();
+        m_parityRateQualityScores.clear();
+    }
+    return *this;
+}
+
+OptionChain::MetricsCache::MetricsCache(MetricsCache&& other) :
+    MetricsCache()
+{
+    *this = std::move(other);
+}
+
+OptionChain::MetricsCache& OptionChain::MetricsCache::operator=(MetricsCache&& other)
+{
+    if (this != &other)
+    {
+        std::scoped_lock lock(m_mutex, other.m_mutex);
+        m_putsVersion = other.m_putsVersion;
+        m_callsVersion = other.m_callsVersion;
+        m_chainTime = std::move(other.m_chainTime);
+        m_parityRates = std::move(other.m_parityRates);
+        m_parityRateQualityScores = std::move(other.m_parityRateQualityScores);
+        other.m_chainTime.reset();
+        other.m_parityRates.clear();
+        other.m_parityRateQualityScores.clear();
+    }
+    return *this;
+}
+
+void OptionChain::MetricsCache::validate(std::uint64_t putsVersion, std::uint64_t callsVersion)
+{
+    if (putsVersion != m_putsVersion || callsVersion != m_callsVersion)
+    {
+        m_putsVersion = putsVersion;
+        m_callsVersion = callsVersion;
+        m_chainTime.reset();
+        m_parityRates.clear();
+        m_parityRateQualityScores.clear();
+    }
+}
+
 
 OptionChain::InstrumentIdToCbboMap
 OptionChain::mapCbboMsgsToInstruments(std::list<databento::CbboMsg>&& cbboMsgs,
@@ -121,7 +308,8 @@ OptionChain::RecordTimeline OptionChain::buildRecordTimeline(const InstrumentIdT
             BOOST_LOG_TRIVIAL(error) << "Missing OSI mapping in buildRecordTimeline for instrument " << instrumentIt->first;
             continue;
         }
-        OsiOption osiOpt(osiIt->second);
+        const OsiSymbol osiSymbol = OsiSymbol::fromIdentifier(osiIt->second);
+        const std::string sStrikeKey = osiSymbol.getStrikeKey();
         for (auto cbboListIt = instrumentIt->second.begin(); cbboListIt != instrumentIt->second.end(); 
             ++cbboListIt)
         {
@@ -130,9 +318,9 @@ OptionChain::RecordTimeline OptionChain::buildRecordTimeline(const InstrumentIdT
             {
                 Timestamp recordSlot = slotTime(optionRecord.m_recvTime);
                 RecordTimeline::mapped_type& putCallRecordMap = timeline[recordSlot];
-                RecordMap& recordMap = osiOpt.isPut() ?
+                RecordMap& recordMap = osiSymbol.isPut() ?
                     putCallRecordMap.first : putCallRecordMap.second;
-                auto recordPair = recordMap.emplace(osiOpt.getStrikeKey(), std::move(optionRecord));
+                auto recordPair = recordMap.emplace(sStrikeKey, std::move(optionRecord));
                 if (recordPair.second == false)
                 {
                     // a previous record for this timeslot exists. Check if it should be replaced.
@@ -192,6 +380,22 @@ OptionChain::PutCallRecordMap OptionChain::mapLatestBestInTimelineToRecord(
     return putCallMap;
 }
 
+OptionChain::UnderlierPath OptionChain::estimateUnderlierPath(const RecordTimeline& timeline,
+    double fDiscountFactor)
+{
+    UnderlierPath underlierPath;
+    std::vector<double> parityRates;
+    for (auto timelineIt = timeline.begin(); timelineIt != timeline.end(); ++timelineIt)
+    {
+        double fUnderlier = Algos::medianParityRate(timelineIt->second, fDiscountFactor, parityRates);
+        if (!std::isnan(fUnderlier))
+        {
+            underlierPath.emplace_hint(underlierPath.end(), timelineIt->first, fUnderlier);
+        }
+    }
+    return underlierPath;
+}
+
 std::vector<std::string>
 OptionChain::findInstrumentsMissingCbboMsgs(const InstrumentIdToCbboMap& cbboMap,
     const std::map<std::string, std::string>& instrumentIdToOsiMap)
@@ -239,72 +443,164 @@ OptionChain OptionChain::build(PutCallRecordMap&& recordMaps,
     const OptionInstruments& optionInstruments)
 {
     OptionChain optionChain;
-    optionChain.m_underlier = optionInstruments.getUnderlier();
-    optionChain.m_valuationDate = optionInstruments.getValuationDate();
-    optionChain.m_expiryDate = optionInstruments.getExpiryDate();
+    const OptionInstruments::ChainIndex& chainIndex = optionInstruments.getChainIndex();
+    optionChain.m_underlier = chainIndex.getUnderlier();
+    optionChain.m_valuationDate = chainIndex.getValuationDate();
+    optionChain.m_expiryDate = chainIndex.getExpiryDate();
     // Initialize the option chain's record maps directly from input
-    optionChain.m_putsStrikeKeyToRecord = std::move(recordMaps.first);
-    optionChain.m_callsStrikeKeyToRecord = std::move(recordMaps.second);
+    optionChain.m_putsStrikeKeyToRecord = SharedRecordMap(std::move(recordMaps.first));
+    optionChain.m_callsStrikeKeyToRecord = SharedRecordMap(std::move(recordMaps.second));
     const OptionInstruments::StrikeKeyPutCallMap& strikeKeyPutCallMap(
-        optionInstruments.getStrikeKeyPutCallMap());
-    std::map<std::string, std::string> putStrikeToInstrument(
-        OptionInstruments::makeStrikeKeyToInstrumentIdMap(strikeKeyPutCallMap.first));
-    std::map<std::string, std::string> callStrikeToInstrument(
-        OptionInstruments::makeStrikeKeyToInstrumentIdMap(strikeKeyPutCallMap.second));
-    std::map<std::string, std::string> idToOsiMap = optionInstruments.getInstrumentIdToOsiMap();
-    auto clearFilledInstruments = [&idToOsiMap](
-        const std::map<std::string, std::string>& strikeToInstrument,
-        const RecordMap& recordMap
+        *chainIndex.getStrikeKeyPutCallMap());
+    // Document the still missing / faulty instrument IDs, that is instruments without a record
+    // for their strike key, and fill them with empty records. In option chain printouts, if 
+    // nothing else can estimate them, they will appear as nan, {null} or similar.
+    auto fillMissingInstruments = [&optionChain](
+        const OptionInstruments::StrikeKeyToOsiInstrumentMap& strikeToOsiInstrument,
+        RecordMap& recordMap
     )
     {
-        for (auto recordIt = recordMap.begin(); recordIt != recordMap.end(); ++recordIt)
+        for (auto strikeIt = strikeToOsiInstrument.begin(); strikeIt != strikeToOsiInstrument.end(); ++strikeIt)
         {
-            auto instrumentIt = strikeToInstrument.find(recordIt->first);
-            if (instrumentIt != strikeToInstrument.end())
+            if (recordMap.try_emplace(strikeIt->first).second)
             {
-               auto idToOsiIt = idToOsiMap.find(instrumentIt->second);
-               if (idToOsiIt != idToOsiMap.end())
-                idToOsiMap.erase(idToOsiIt); 
+                const OptionInstruments::OsiToInstrumentId& osiInstrumentPair = strikeIt->second;
+                optionChain.m_missingInstrumentIdToOsiMap[osiInstrumentPair.second] = osiInstrumentPair.first;
             }
         }
     };
-    clearFilledInstruments(putStrikeToInstrument, optionChain.m_putsStrikeKeyToRecord);
-    clearFilledInstruments(callStrikeToInstrument, optionChain.m_callsStrikeKeyToRecord);
-    // Document the still missing / faulty instrument IDs
-    optionChain.m_missingInstrumentIdToOsiMap = std::move(idToOsiMap);
-    // Fill the missing instruments with empty records. In option chain printouts, if 
-    // nothing else can estimate them, they will appear as nan, {null} or similar.
-    for (auto osiIt = optionChain.m_missingInstrumentIdToOsiMap.begin(); 
-        osiIt != optionChain.m_missingInstrumentIdToOsiMap.end(); ++osiIt)
+    fillMissingInstruments(strikeKeyPutCallMap.first, optionChain.m_putsStrikeKeyToRecord.mutate());
+    fillMissingInstruments(strikeKeyPutCallMap.second, optionChain.m_callsStrikeKeyToRecord.mutate());
+    return optionChain;
+}
+
+OptionChain OptionChain::fromRecords(const std::string& underlier,
+    const std::string& valuationDate, const std::string& expiryDate,
+    PutCallRecordMap&& recordMaps)
+{
+    OptionChain optionChain;
+    optionChain.m_underlier = underlier;
+    optionChain.m_valuationDate = valuationDate;
+    optionChain.m_expiryDate = expiryDate;
+    optionChain.m_putsStrikeKeyToRecord = SharedRecordMap(std::move(recordMaps.first));
+    optionChain.m_callsStrikeKeyToRecord = SharedRecordMap(std::move(recordMaps.second));
+    return optionChain;
+}
+
+OptionChain OptionChain::shareRecords(const OptionChain& optionChain)
+{
+    OptionChain sharedChain;
+    sharedChain.m_underlier = optionChain.m_underlier;
+    sharedChain.m_valuationDate = optionChain.m_valuationDate;
+    sharedChain.m_expiryDate = optionChain.m_expiryDate;
+    sharedChain.m_putsStrikeKeyToRecord = optionChain.m_putsStrikeKeyToRecord.share();
+    sharedChain.m_callsStrikeKeyToRecord = optionChain.m_callsStrikeKeyToRecord.share();
+    sharedChain.m_missingInstrumentIdToOsiMap = optionChain.m_missingInstrumentIdToOsiMap;
+    return sharedChain;
+}
+
+Timestamp OptionChain::getChainTime() const
+{
     {
-        OsiOption osiOpt(osiIt->second);
-        RecordMap& target = osiOpt.isPut() ? 
-            optionChain.m_putsStrikeKeyToRecord : optionChain.m_callsStrikeKeyToRecord;
-        auto pair = target.insert(std::make_pair(osiOpt.getStrikeKey(), Record()));
-        if (!pair.second)
+        std::lock_guard<std::mutex> lock(m_metricsCache.m_mutex);
+        m_metricsCache.validate(m_putsStrikeKeyToRecord.getVersion(), m_callsStrikeKeyToRecord.getVersion());
+        if (m_metricsCache.m_chainTime)
         {
-            BOOST_LOG_TRIVIAL(error) << "Not blanking existing data in OptionChain::build for strike key "
-                << osiOpt.getStrikeKey() << " OSI id " << osiIt->second;
+            return *m_metricsCache.m_chainTime;
         }
     }
-    return optionChain;
+    Timestamp chainTime = computeChainTime();
+    std::lock_guard<std::mutex> lock(m_metricsCache.m_mutex);
+    m_metricsCache.validate(m_putsStrikeKeyToRecord.getVersion(), m_callsStrikeKeyToRecord.getVersion());
+    m_metricsCache.m_chainTime = chainTime;
+    return chainTime;
 }
 
-Timestamp OptionChain::getChainTime() const
+Timestamp OptionChain::computeChainTime() const
 {
-    std::function<bentoclient::Timestamp(const bentoclient::OptionChain::Record&)> getRecvTime =
-    [](const bentoclient::OptionChain::Record& record) {
-        return record.m_recvTime;
-    };
-    std::list<bentoclient::Timestamp> recvTimes =
-        Util::onAllRecords(*this, getRecvTime);
-    
-    if (recvTimes.empty()) {
-        return Timestamp{};
+    Timestamp chainTime{};
+    for (const RecordMap* recordMap : {&getCalls(), &getPuts()})
+    {
+        for (auto it = recordMap->begin(); it != recordMap->end(); ++it)
+        {
+            chainTime = std::max(chainTime, it->second.m_recvTime);
+        }
     }
+    return chainTime;
+}
 
-    auto maxIt = std::max_element(recvTimes.begin(), recvTimes.end());
-    return *maxIt;
+std::size_t OptionChain::shiftStaleRecords(const UnderlierPath& underlierPath, TimeRange staleAfter)
+{
+    if (underlierPath.empty())
+    {
+        return 0;
+    }
+    const Timestamp chainTime = getChainTime();
+    const double fUnderlier = underlierPath.rbegin()->second;
+    std::size_t nShifted = 0;
+    auto shiftSide = [&](SharedRecordMap& sharedRecordMap, bool bCall)
+    {
+        // deltas come from the unshifted prices of stale records on this side
+        std::map<std::string, double> deltas = Algos::estimateStaleDeltas(sharedRecordMap.get(),
+            chainTime - staleAfter, fUnderlier, bCall);
+        std::list<std::pair<std::string, double>> shifts;
+        for (auto& deltaPair : deltas)
+        {
+            const Record& record = sharedRecordMap.get().at(deltaPair.first);
+            // underlier estimate of the latest slot at or before the record's receive time
+            auto pathIt = underlierPath.upper_bound(record.m_recvTime);
+            if (pathIt == underlierPath.begin())
+            {
+                continue;
+            }
+            double fShift = deltaPair.second * (fUnderlier - std::prev(pathIt)->second);
+            if (fShift != 0.0)
+            {
+                shifts.emplace_back(deltaPair.first, fShift);
+            }
+        }
+        if (shifts.empty())
+        {
+            return;
+        }
+        RecordMap& recordMap = sharedRecordMap.mutate();
+        for (auto& shift : shifts)
+        {
+            Record& record = recordMap.at(shift.first);
+            // keep the spread, prices don't go negative
+            record.m_bidPrice.setPrice(std::max(record.m_bidPrice.price() + shift.second, 0.0));
+            record.m_askPrice.setPrice(std::max(record.m_askPrice.price() + shift.second,
+                record.m_bidPrice.price()));
+            record.m_recvTime = chainTime;
+            record.m_comment = record.m_comment.empty() ? m_deltaShiftComment
+                : record.m_comment + ":" + m_deltaShiftComment;
+        }
+        nShifted += shifts.size();
+    };
+    shiftSide(m_putsStrikeKeyToRecord, false);
+    shiftSide(m_callsStrikeKeyToRecord, true);
+    return nShifted;
+}
+
+std::size_t OptionChain::shiftStaleRecords(const RecordTimeline& timeline,
+    const MarketEnvironment& marketEnvironment, TimeRange staleAfter)
+{
+    try {
+        const DateUtils::ExchangeClose& exchangeClose = marketEnvironment.getExchangeClose();
+        double fRiskFreeRate = marketEnvironment.getRiskFreeRate(getChainTime(), getExpiryTime(exchangeClose));
+        double fDiscountFactor = Util::getDiscountFactor(*this, fRiskFreeRate, exchangeClose);
+        UnderlierPath underlierPath = estimateUnderlierPath(timeline, fDiscountFactor);
+        std::size_t nShifted = shiftStaleRecords(underlierPath, staleAfter);
+        BOOST_LOG_TRIVIAL(info) << "Delta shifted " << nShifted << " stale records for symbol "
+            << m_underlier << " and expiry date " << m_expiryDate
+            << " along underlier path of " << underlierPath.size() << " time slots";
+        return nShifted;
+    } catch (const std::exception& e)
+    {
+        BOOST_LOG_TRIVIAL(warning) << "Unable to delta shift stale records for symbol "
+            << m_underlier << " and expiry date " << m_expiryDate << ": " << e.what();
+        return 0;
+    }
 }
 
 Timestamp OptionChain::getExpiryTime(const DateUtils::ExchangeClose& exchangeClose) const
@@ -316,46 +612,76 @@ Timestamp OptionChain::getExpiryTime(const DateUtils::ExchangeClose& exchangeClo
         exchangeClose.m_hour, exchangeClose.m_minute, 0, exchangeClose.m_timeZone);
 }
 
+double OptionChain::getParityMetric(bool bQualityScore, double fRiskFreeRate, 
+    const DateUtils::ExchangeClose& exchangeClose) const
+{
+    MetricsCache::ParityKey parityKey(fRiskFreeRate, exchangeClose.m_hour, exchangeClose.m_minute,
+        exchangeClose.m_timeZone);
+    auto cacheMap = bQualityScore ? &MetricsCache::m_parityRateQualityScores : &MetricsCache::m_parityRates;
+    {
+        std::lock_guard<std::mutex> lock(m_metricsCache.m_mutex);
+        m_metricsCache.validate(m_putsStrikeKeyToRecord.getVersion(), m_callsStrikeKeyToRecord.getVersion());
+        auto it = (m_metricsCache.*cacheMap).find(parityKey);
+        if (it != (m_metricsCache.*cacheMap).end())
+        {
+            return it->second;
+        }
+    }
+    // compute without holding the lock, as the computation itself memoizes the chain time.
+    // Failures throw and aren't memoized.
+    double fMetric = bQualityScore ? computeParityRateQualityScore(fRiskFreeRate, exchangeClose)
+        : computeParityRate(fRiskFreeRate, exchangeClose);
+    std::lock_guard<std::mutex> lock(m_metricsCache.m_mutex);
+    m_metricsCache.validate(m_putsStrikeKeyToRecord.getVersion(), m_callsStrikeKeyToRecord.getVersion());
+    (m_metricsCache.*cacheMap)[parityKey] = fMetric;
+    return fMetric;
+}
+
 /// @brief Get the put-call parity rate consistent with put/call records
 double OptionChain::getParityRate(double fRiskFreeRate, 
     const DateUtils::ExchangeClose& exchangeClose) const
+{
+    return getParityMetric(false, fRiskFreeRate, exchangeClose);
+}
+
+double OptionChain::getParityRateQualityScore(double fRiskFreeRate, 
+    const DateUtils::ExchangeClose& exchangeClose) const
+{
+    return getParityMetric(true, fRiskFreeRate, exchangeClose);
+}
+
+double OptionChain::computeParityRate(double fRiskFreeRate, 
+    const DateUtils::ExchangeClose& exchangeClose) const
 {
     double discountFactor = Util::getDiscountFactor(*this, fRiskFreeRate, exchangeClose);
-    Util::PutCallParityRate putCallParityRate(discountFactor);
-    std::function<double(const RecordMap::value_type&, const RecordMap::value_type&)> parityRate = putCallParityRate;
-    auto parityCalculator = [this,&parityRate](bool bRelaxedValid) {
-        auto parityRates = Util::onAllPutCallRecords(*this, parityRate, true, bRelaxedValid);
+    auto parityCalculator = [this, discountFactor](bool bRelaxedValid) {
+        Util::ParitySeries series = Util::makeParitySeries(*this, bRelaxedValid);
+        std::size_t n = series.size();
+        if (n == 0) {
+            throw std::invalid_argument("No valid parity rates found.");
+        }
+        std::vector<double> parityRates(n);
+        Util::computeParityRates(series.m_strikes.data(), series.m_putPrices.data(),
+            series.m_callPrices.data(), discountFactor, parityRates.data(), n);
         // compute average of parity rates
         double sum = 0.0;
-        for (auto& pair : parityRates) {
-            sum += pair.second;
+        for (std::size_t i = 0; i < n; ++i) {
+            sum += parityRates[i];
         }
-        double avgParityRate = sum / parityRates.size();
+        double avgParityRate = sum / n;
         // the overall average is likely not the best consistent parity rate. Better take
         // four values around that average and compute the average of those.
         std::string parityKey = OsiOption::toStrikeKey(avgParityRate);
-        auto upperBound = parityRates.upper_bound(parityKey);
-        auto lowerBound = upperBound;
-        for (int i = 0; i < 2; ++i) {
-            if (lowerBound != parityRates.begin()) {
-                --lowerBound;
-            }
-        }
-        for (int i = 0; i < 2; ++i) {
-            if (upperBound != parityRates.end()) {
-                ++upperBound;
-            }
-        }
+        std::size_t upperBound = std::upper_bound(series.m_strikeKeys.begin(), series.m_strikeKeys.end(),
+            &parityKey, [](const std::string* lhs, const std::string* rhs) { return *lhs < *rhs; })
+            - series.m_strikeKeys.begin();
+        std::size_t lowerBound = upperBound >= 2 ? upperBound - 2 : 0;
+        upperBound = std::min(upperBound + 2, n);
         double avg4ParityRate = 0.0;
-        int count = 0;
-        for (auto it = lowerBound; it != upperBound; ++it) {
-            avg4ParityRate += it->second;
-            ++count;
-        }
-        if (count == 0) {
-            throw std::invalid_argument("No valid parity rates found.");
+        for (std::size_t i = lowerBound; i < upperBound; ++i) {
+            avg4ParityRate += parityRates[i];
         }
-        avg4ParityRate /= count;
+        avg4ParityRate /= (upperBound - lowerBound);
         return avg4ParityRate;
     };
     try {
@@ -379,22 +705,19 @@ double OptionChain::getParityRate(double fRiskFreeRate,
         }
     }
 }
-double OptionChain::getParityRateQualityScore(double fRiskFreeRate, 
+double OptionChain::computeParityRateQualityScore(double fRiskFreeRate, 
     const DateUtils::ExchangeClose& exchangeClose) const
 {
     double discountFactor = Util::getDiscountFactor(*this, fRiskFreeRate, exchangeClose);
-    Util::PutCallParityRate putCallParityRate(discountFactor);
-    std::function<double(const RecordMap::value_type&, const RecordMap::value_type&)> parityRate = putCallParityRate;
-    auto parityRates = Util::onAllPutCallRecords(*this, parityRate, true);
-    std::list<std::pair<double, double>> parityRatesByStrike;
-    for (auto& pair : parityRates) {
-        double strike = OsiOption::fromStrikeKey(pair.first);
-        double parityRate = pair.second;
-        parityRatesByStrike.emplace_back(strike, parityRate);
-    }
-    std::pair<double, double> line = Util::fitLeastSquaresLine(parityRatesByStrike);
+    Util::ParitySeries series = Util::makeParitySeries(*this);
+    std::size_t n = series.size();
+    std::vector<double> parityRates(n);
+    Util::computeParityRates(series.m_strikes.data(), series.m_putPrices.data(),
+        series.m_callPrices.data(), discountFactor, parityRates.data(), n);
+    std::pair<double, double> line = Util::fitLeastSquaresLine(
+        series.m_strikes.data(), parityRates.data(), n);
     double variance = Util::computeVarianceAlongFittedLine(
-        parityRatesByStrike, line);
+        series.m_strikes.data(), parityRates.data(), n, line);
     return variance;
 }
 double OptionChain::Util::PutCallParityRate::operator()(const std::pair<const std::string, OptionChain::Record>& put,
@@ -408,7 +731,7 @@ double OptionChain::Util::PutCallParityRate::operator()(const std::pair<const st
     return S;
 }
 
-double OptionChain::Util::getDiscountFactor(const OptionChain& optionChain, double fContinuousRate,
+double OptionChain::Util::getYearFraction(const OptionChain& optionChain,
     const DateUtils::ExchangeClose& exchangeClose)
 {
     Timestamp chainTime = optionChain.getChainTime();
@@ -425,12 +748,124 @@ double OptionChain::Util::getDiscountFactor(const OptionChain& optionChain, doub
     constexpr double secondsInYear = 365.25 * 24 * 60 * 60;
 
     // Calculate the year fraction
-    double yearFraction = static_cast<double>(seconds) / secondsInYear;
+    return static_cast<double>(seconds) / secondsInYear;
+}
+
+double OptionChain::Util::getDiscountFactor(const OptionChain& optionChain, double fContinuousRate,
+    const DateUtils::ExchangeClose& exchangeClose)
+{
+    double yearFraction = getYearFraction(optionChain, exchangeClose);
     double discountFactor = std::exp(-fContinuousRate * yearFraction);
     return discountFactor;
 }
 
 
+OptionChain::Util::ParitySeries OptionChain::Util::makeParitySeries(const OptionChain& optionChain,
+    bool bRelaxedBidAskValid)
+{
+    const RecordMap& puts = optionChain.getPuts();
+    const RecordMap& calls = optionChain.getCalls();
+    ParitySeries series;
+    std::size_t nCapacity = std::min(puts.size(), calls.size());
+    series.m_strikeKeys.reserve(nCapacity);
+    series.m_strikes.reserve(nCapacity);
+    series.m_putPrices.reserve(nCapacity);
+    series.m_callPrices.reserve(nCapacity);
+    // both maps are ordered by strike key, so a merge join matches them in linear time
+    auto putIt = puts.begin();
+    for (auto callIt = calls.begin(); callIt != calls.end() && putIt != puts.end(); ++callIt) {
+        while (putIt != puts.end() && putIt->first < callIt->first) {
+            ++putIt;
+        }
+        if (putIt == puts.end() || putIt->first != callIt->first) {
+            continue;
+        }
+        if ((bRelaxedBidAskValid && putIt->second.bidAskValid() && callIt->second.bidAskValid())
+            || (putIt->second.isValid() && callIt->second.isValid())) {
+            series.m_strikeKeys.push_back(&callIt->first);
+            series.m_strikes.push_back(OsiOption::fromStrikeKey(callIt->first));
+            series.m_putPrices.push_back(putIt->second.getMidPrice());
+            series.m_callPrices.push_back(callIt->second.getMidPrice());
+        }
+    }
+    return series;
+}
+
+void OptionChain::Util::computeParityRates(const double* strikes, const double* putPrices,
+    const double* callPrices, double discountFactor, double* parityRates, std::size_t n)
+{
+    // Put/Call Parity: P + S = C + K * e^(-rT), branch free for vectorization
+    for (std::size_t i = 0; i < n; ++i) {
+        parityRates[i] = callPrices[i] - putPrices[i] + strikes[i] * discountFactor;
+    }
+}
+
+namespace {
+    // independent partial sums let compilers vectorize reductions without reassociating
+    constexpr std::size_t nKernelLanes = 4;
+}
+
+std::pair<double, double> OptionChain::Util::fitLeastSquaresLine(
+    const double* x, const double* y, std::size_t n)
+{
+    if (n < 2) {
+        throw std::invalid_argument("Not enough data points to fit a line.");
+    }
+    double sumX[nKernelLanes] = {}, sumY[nKernelLanes] = {};
+    double sumXY[nKernelLanes] = {}, sumX2[nKernelLanes] = {};
+    std::size_t i = 0;
+    for (; i + nKernelLanes <= n; i += nKernelLanes) {
+        for (std::size_t l = 0; l < nKernelLanes; ++l) {
+            sumX[l] += x[i + l];
+            sumY[l] += y[i + l];
+            sumXY[l] += x[i + l] * y[i + l];
+            sumX2[l] += x[i + l] * x[i + l];
+        }
+    }
+    for (std::size_t l = 0; i < n; ++i, ++l) {
+        sumX[l] += x[i];
+        sumY[l] += y[i];
+        sumXY[l] += x[i] * y[i];
+        sumX2[l] += x[i] * x[i];
+    }
+    double fSumX = (sumX[0] + sumX[1]) + (sumX[2] + sumX[3]);
+    double fSumY = (sumY[0] + sumY[1]) + (sumY[2] + sumY[3]);
+    double fSumXY = (sumXY[0] + sumXY[1]) + (sumXY[2] + sumXY[3]);
+    double fSumX2 = (sumX2[0] + sumX2[1]) + (sumX2[2] + sumX2[3]);
+    double N = static_cast<double>(n);
+    double denominator = N * fSumX2 - fSumX * fSumX;
+    if (std::abs(denominator) < 1e-10) {
+        throw std::runtime_error("Denominator is too small, cannot fit a line.");
+    }
+    double slope = (N * fSumXY - fSumX * fSumY) / denominator;
+    double intercept = (fSumY - slope * fSumX) / N;
+    return {slope, intercept};
+}
+
+double OptionChain::Util::computeVarianceAlongFittedLine(const double* x, const double* y, std::size_t n,
+    const std::pair<double, double>& fittedLine)
+{
+    if (n == 0) {
+        throw std::invalid_argument("No data points to compute variance.");
+    }
+    double slope = fittedLine.first;
+    double intercept = fittedLine.second;
+    double sumSquaredDifferences[nKernelLanes] = {};
+    std::size_t i = 0;
+    for (; i + nKernelLanes <= n; i += nKernelLanes) {
+        for (std::size_t l = 0; l < nKernelLanes; ++l) {
+            double difference = y[i + l] - (slope * x[i + l] + intercept);
+            sumSquaredDifferences[l] += difference * difference;
+        }
+    }
+    for (std::size_t l = 0; i < n; ++i, ++l) {
+        double difference = y[i] - (slope * x[i] + intercept);
+        sumSquaredDifferences[l] += difference * difference;
+    }
+    return ((sumSquaredDifferences[0] + sumSquaredDifferences[1])
+        + (sumSquaredDifferences[2] + sumSquaredDifferences[3])) / n;
+}
+
 std::pair<double, double> OptionChain::Util::fitLeastSquaresLine(
     const std::list<std::pair<double, double>>& dataSeries) 
 {
@@ -5,10 +5,52 @@
 
 using namespace bentoclient;
 
-OptionInstruments::OptionInstruments(UnderlierToPutCallMap&& underlierToPutCallMap) :
-    m_underlierToPutCallMap(std::move(underlierToPutCallMap)),
-    m_unmapped(nullptr) {
-    // Constructor implementation
+const std::map<std::string, std::string> OptionInstruments::m_emptyMap;
+
+OptionInstruments::ChainIndex::ChainIndex(const std::string& underlier, 
+    const std::string& valuationDate, const std::string& expiryDate,
+    StrikeKeyPutCallMapPtr strikeKeyPutCallMapPtr) :
+    m_underlier(underlier),
+    m_valuationDate(valuationDate),
+    m_expiryDate(expiryDate),
+    m_strikeKeyPutCallMapPtr(std::move(strikeKeyPutCallMapPtr))
+{
+    if (!m_strikeKeyPutCallMapPtr) {
+        throw std::invalid_argument("ChainIndex requires a strike key put call map.");
+    }
+    const StrikeKeyPutCallMap& strikeKeyPutCallMap = *m_strikeKeyPutCallMapPtr;
+    std::size_t nInstruments = strikeKeyPutCallMap.first.size() + strikeKeyPutCallMap.second.size();
+    m_byInstrumentId.reserve(nInstruments);
+    m_byOsiIdentifier.reserve(nInstruments);
+    // hashed lookups are views into the strike key maps: no strings copied
+    auto indexer = [this](const StrikeKeyToOsiInstrumentMap& keyMap, bool bPut) {
+        EntryMap& byStrikeKey = bPut ? m_putsByStrikeKey : m_callsByStrikeKey;
+        byStrikeKey.reserve(keyMap.size());
+        for (const auto& pair : keyMap) {
+            const OsiToInstrumentId& osiInstrumentPair = pair.second;
+            Entry entry{&pair.first, &osiInstrumentPair, bPut};
+            byStrikeKey.emplace(pair.first, entry);
+            m_byInstrumentId[osiInstrumentPair.second] = entry;
+            m_byOsiIdentifier[osiInstrumentPair.first] = entry;
+            m_instrumentIdToOsi[osiInstrumentPair.second] = osiInstrumentPair.first;
+            m_osiToInstrumentId[osiInstrumentPair.first] = osiInstrumentPair.second;
+        }
+    };
+    indexer(strikeKeyPutCallMap.first, true);
+    indexer(strikeKeyPutCallMap.second, false);
+}
+
+OptionInstruments::OptionInstruments(ChainIndexPtr chainIndexPtr) :
+    m_unmapped(nullptr),
+    m_defaultChainIndex(std::move(chainIndexPtr)) {
+    // Single chain instance sharing the chain index
+    if (m_defaultChainIndex) {
+        const ChainIndex& chainIndex = *m_defaultChainIndex;
+        m_underlierToPutCallMap[chainIndex.getUnderlier()][chainIndex.getValuationDate()]
+            [chainIndex.getExpiryDate()] = chainIndex.getStrikeKeyPutCallMap();
+        m_chainIndex.emplace(makeChainKey(chainIndex.getUnderlier(), chainIndex.getValuationDate(),
+            chainIndex.getExpiryDate()), m_defaultChainIndex);
+    }
 }
 
 OptionInstruments::OptionInstruments() :
@@ -16,47 +58,66 @@ OptionInstruments::OptionInstruments() :
     // Constructor implementation
 }
 
-OptionInstruments::StrikeKeyPutCallMapPtr OptionInstruments::getStrikeKeyPutCallMap(const std::string& underlier,
-    const std::string& date, const std::string& expiryDate) const { 
-    // Check if the option instruments contain the specified underlier, date, and expiry date
-    StrikeKeyPutCallMapPtr strikeKeyPutCallMapPtr;
-    auto it = m_underlierToPutCallMap.find(underlier);
-    if (it != m_underlierToPutCallMap.end()) {
-        auto it2 = it->second.find(date);
-        if (it2 != it->second.end()) {
-            auto it3 = it2->second.find(expiryDate);
-            if (it3 != it2->second.end()) {
-                strikeKeyPutCallMapPtr = it3->second;
-            }
-        }
+std::string OptionInstruments::makeChainKey(const std::string& underlier, const std::string& date,
+    const std::string& expiryDate)
+{
+    std::string key;
+    key.reserve(underlier.size() + date.size() + expiryDate.size() + 2);
+    key.append(underlier).append(1, '|').append(date).append(1, '|').append(expiryDate);
+    return key;
+}
+
+OptionInstruments::ChainIndexPtr OptionInstruments::getChainIndex(const std::string& underlier,
+    const std::string& date, const std::string& expiryDate) const
+{
+    auto it = m_chainIndex.find(makeChainKey(underlier, date, expiryDate));
+    if (it != m_chainIndex.end()) {
+        return it->second;
     }
-    return strikeKeyPutCallMapPtr;
+    return ChainIndexPtr{};
 }
 
-const OptionInstruments::StrikeKeyPutCallMap& OptionInstruments::getStrikeKeyPutCallMap() const 
+const OptionInstruments::ChainIndex& OptionInstruments::getChainIndex() const
 {
-    // Get the first strike key put call map from the underlier to put call map
+    if (m_defaultChainIndex) {
+        return *m_defaultChainIndex;
+    }
+    // Get the first chain from the underlier to put call map
     if (m_underlierToPutCallMap.begin() != m_underlierToPutCallMap.end()) {
         auto& dateLevel = m_underlierToPutCallMap.begin()->second;
         if (dateLevel.begin() != dateLevel.end()) {
             auto& expiryLevel = dateLevel.begin()->second;
             if (expiryLevel.begin() != expiryLevel.end()) {
-                return *expiryLevel.begin()->second;
+                ChainIndexPtr chainIndexPtr = getChainIndex(m_underlierToPutCallMap.begin()->first,
+                    dateLevel.begin()->first, expiryLevel.begin()->first);
+                if (chainIndexPtr) {
+                    return *chainIndexPtr;
+                }
             }
         }
     }
     throw std::invalid_argument("No default strike key put call map available.");
 }
 
+OptionInstruments::StrikeKeyPutCallMapPtr OptionInstruments::getStrikeKeyPutCallMap(const std::string& underlier,
+    const std::string& date, const std::string& expiryDate) const { 
+    // Check if the option instruments contain the specified underlier, date, and expiry date
+    ChainIndexPtr chainIndexPtr = getChainIndex(underlier, date, expiryDate);
+    if (chainIndexPtr) {
+        return chainIndexPtr->getStrikeKeyPutCallMap();
+    }
+    return StrikeKeyPutCallMapPtr{};
+}
+
+const OptionInstruments::StrikeKeyPutCallMap& OptionInstruments::getStrikeKeyPutCallMap() const 
+{
+    return *getChainIndex().getStrikeKeyPutCallMap();
+}
+
 OptionInstruments OptionInstruments::get(const std::string& underlier, const std::string& date,
     const std::string& expiryDate) const {
     // Get the option instruments for the specified underlier, date, and expiry date only
-    UnderlierToPutCallMap underlierToPutCallMap;
-    StrikeKeyPutCallMapPtr strikeKeyPutCallMapPtr(getStrikeKeyPutCallMap(underlier, date, expiryDate));
-    if (strikeKeyPutCallMapPtr) {
-        underlierToPutCallMap[underlier][date][expiryDate] = strikeKeyPutCallMapPtr;
-    }
-    return OptionInstruments(std::move(underlierToPutCallMap));
+    return OptionInstruments(getChainIndex(underlier, date, expiryDate));
 }
 
 std::list<std::string> OptionInstruments::getExpiryDatesForDTE(const std::string& underlier,
@@ -142,6 +203,11 @@ void OptionInstruments::insert(const databento::SymbologyResolution& resolution)
     // 5 digits dollar strike, 3 digits decimal strike. Basically, divide the number 
     // past C/P by 1000 to get the strike price. If underlier has less than 6 characters, 
     // it's padded with spaces.
+    // Chains touched by this insert. Indexed chains are copied on write, so
+    // that chain indexes and single chain instances sharing them stay immutable.
+    TouchedChainMap touchedChains;
+    std::string sValuationDate;
+    decltype(databento::MappingInterval::start_date) lastValuationDate{};
     for (const auto& mapping : resolution.mappings) {
         const std::string& osiIdentifier = mapping.first;
         const std::vector<databento::MappingInterval>& intervals = mapping.second;
@@ -151,46 +217,84 @@ void OptionInstruments::insert(const databento::SymbologyResolution& resolution)
             }
             continue; // Skip empty intervals
         }
-        try {
-            OsiOption osiOption(osiIdentifier);
-            auto mi = intervals.begin();
-            // insert the good mappings
-            auto& valuationDateToExpiryPutCallMap =
-                m_underlierToPutCallMap[osiOption.getUnderlier()];
-            // get the valuation date in yyyy-mm-dd format
-            auto& valuationDate = mi->start_date;
+        OsiSymbol osiSymbol;
+        if (!OsiSymbol::parse(osiIdentifier, osiSymbol)) {
+            if (m_unmapped) {
+                m_unmapped->m_invalidOsiIdentifiers.push_back(osiIdentifier);
+            }
+            continue; // Skip invalid OSI identifiers
+        }
+        auto mi = intervals.begin();
+        // get the valuation date in yyyy-mm-dd format, practically the same for all mappings
+        auto& valuationDate = mi->start_date;
+        if (sValuationDate.empty() || !(valuationDate == lastValuationDate)) {
             std::ostringstream valuationDateStream;
             valuationDateStream << valuationDate;
-            // get the options data for underlier and valuation date
-            auto& expiryToPutCallMap = 
-                valuationDateToExpiryPutCallMap[valuationDateStream.str()];
-            auto& strikeKeyPutCallMapPtr = 
-                expiryToPutCallMap[osiOption.getExpiryDate()];
-            if (!strikeKeyPutCallMapPtr) {
-                strikeKeyPutCallMapPtr = std::make_shared<StrikeKeyPutCallMap>();
-            }
-            auto& strikeKeyPutCallMap = *strikeKeyPutCallMapPtr;
-            auto& strikeKeyToOsiInstrumentMap = osiOption.isPut() ?
-                strikeKeyPutCallMap.first : strikeKeyPutCallMap.second;
-            // insert the OSI ID to instrument ID mapping
-            auto& instrumentId = mi->symbol;
-            strikeKeyToOsiInstrumentMap[osiOption.getStrikeKey()] =
-                std::make_pair(osiIdentifier, instrumentId);
-            // check for unexpected additional mappings
-            for (auto umi = ++mi; umi != intervals.end(); ++umi) {
-                if (m_unmapped) {
-                    m_unmapped->m_mappings.push_back(std::make_pair(osiIdentifier,*umi));
-                }
+            sValuationDate = valuationDateStream.str();
+            lastValuationDate = valuationDate;
+        }
+        // insert the good mappings
+        insertMapping(osiSymbol, osiIdentifier, sValuationDate, mi->symbol, touchedChains);
+        // check for unexpected additional mappings
+        for (auto umi = ++mi; umi != intervals.end(); ++umi) {
+            if (m_unmapped) {
+                m_unmapped->m_mappings.push_back(std::make_pair(osiIdentifier,*umi));
             }
-        } catch (const std::invalid_argument& e) {
+        }
+
+    }
+    indexChains(touchedChains);
+}
+
+void OptionInstruments::insert(const std::string& valuationDate,
+    const std::map<std::string, std::string>& osiToInstrumentId) {
+    TouchedChainMap touchedChains;
+    for (const auto& osiPair : osiToInstrumentId) {
+        OsiSymbol osiSymbol;
+        if (!OsiSymbol::parse(osiPair.first, osiSymbol)) {
             if (m_unmapped) {
-                m_unmapped->m_invalidOsiIdentifiers.push_back(osiIdentifier);
+                m_unmapped->m_invalidOsiIdentifiers.push_back(osiPair.first);
             }
             continue; // Skip invalid OSI identifiers
         }
+        insertMapping(osiSymbol, osiPair.first, valuationDate, osiPair.second, touchedChains);
+    }
+    indexChains(touchedChains);
+}
 
+void OptionInstruments::insertMapping(const OsiSymbol& osiSymbol, const std::string& osiIdentifier,
+    const std::string& valuationDate, const std::string& instrumentId,
+    TouchedChainMap& touchedChains) {
+    auto underlierIt = m_underlierToPutCallMap.try_emplace(
+        std::string(osiSymbol.getUnderlier())).first;
+    auto& valuationDateToExpiryPutCallMap = underlierIt->second;
+    // get the options data for underlier and valuation date
+    auto dateIt = valuationDateToExpiryPutCallMap.try_emplace(valuationDate).first;
+    auto& expiryToPutCallMap = dateIt->second;
+    auto expiryIt = expiryToPutCallMap.try_emplace(osiSymbol.getExpiryDate()).first;
+    auto& strikeKeyPutCallMapPtr = expiryIt->second;
+    if (touchedChains.find(&strikeKeyPutCallMapPtr) == touchedChains.end()) {
+        strikeKeyPutCallMapPtr = strikeKeyPutCallMapPtr ?
+            std::make_shared<StrikeKeyPutCallMap>(*strikeKeyPutCallMapPtr) :
+            std::make_shared<StrikeKeyPutCallMap>();
+        touchedChains.emplace(&strikeKeyPutCallMapPtr,
+            TouchedChain{&underlierIt->first, &dateIt->first, &expiryIt->first});
     }
+    auto& strikeKeyPutCallMap = *strikeKeyPutCallMapPtr;
+    auto& strikeKeyToOsiInstrumentMap = osiSymbol.isPut() ?
+        strikeKeyPutCallMap.first : strikeKeyPutCallMap.second;
+    // insert the OSI ID to instrument ID mapping
+    strikeKeyToOsiInstrumentMap[osiSymbol.getStrikeKey()] =
+        std::make_pair(osiIdentifier, instrumentId);
+}
 
+void OptionInstruments::indexChains(const TouchedChainMap& touchedChains) {
+    for (const auto& touchedPair : touchedChains) {
+        const TouchedChain& touched = touchedPair.second;
+        m_chainIndex[makeChainKey(*touched.m_underlier, *touched.m_valuationDate, *touched.m_expiryDate)] =
+            std::make_shared<const ChainIndex>(*touched.m_underlier, *touched.m_valuationDate,
+                *touched.m_expiryDate, *touchedPair.first);
+    }
 }
 
 std::map<std::string, std::string> OptionInstruments::makeOsiToInstrumentIdMap(const StrikeKeyPutCallMap& strikeKeyPutCallMap)
@@ -231,34 +335,34 @@ std::map<std::string, std::string> OptionInstruments::makeStrikeKeyToInstrumentI
 }
 
 
-std::map<std::string, std::string> OptionInstruments::getOsiToInstrumentIdMap(const std::string& underlier,
+const std::map<std::string, std::string>& OptionInstruments::getOsiToInstrumentIdMap(const std::string& underlier,
     const std::string& date, const std::string& expiryDate) const 
 {
-    StrikeKeyPutCallMapPtr strikeKeyPutCallMapPtr(getStrikeKeyPutCallMap(underlier, date, expiryDate));
-    if (strikeKeyPutCallMapPtr) {
-        return makeOsiToInstrumentIdMap(*strikeKeyPutCallMapPtr);
+    ChainIndexPtr chainIndexPtr = getChainIndex(underlier, date, expiryDate);
+    if (chainIndexPtr) {
+        return chainIndexPtr->getOsiToInstrumentIdMap();
     }
-    return std::map<std::string, std::string>();
+    return m_emptyMap;
 }
 
-std::map<std::string, std::string> OptionInstruments::getOsiToInstrumentIdMap() const
+const std::map<std::string, std::string>& OptionInstruments::getOsiToInstrumentIdMap() const
 {
-    return makeOsiToInstrumentIdMap(getStrikeKeyPutCallMap());
+    return getChainIndex().getOsiToInstrumentIdMap();
 }
 
-std::map<std::string, std::string> OptionInstruments::getInstrumentIdToOsiMap(const std::string& underlier,
+const std::map<std::string, std::string>& OptionInstruments::getInstrumentIdToOsiMap(const std::string& underlier,
     const std::string& date, const std::string& expiryDate) const
 {
-    StrikeKeyPutCallMapPtr strikeKeyPutCallMapPtr(getStrikeKeyPutCallMap(underlier, date, expiryDate));
-    if (strikeKeyPutCallMapPtr) {
-        return makeInstrumentIdToOsiMap(*strikeKeyPutCallMapPtr);
+    ChainIndexPtr chainIndexPtr = getChainIndex(underlier, date, expiryDate);
+    if (chainIndexPtr) {
+        return chainIndexPtr->getInstrumentIdToOsiMap();
     }
-    return std::map<std::string, std::string>();
+    return m_emptyMap;
 }
 
-std::map<std::string, std::string> OptionInstruments::getInstrumentIdToOsiMap() const
+const std::map<std::string, std::string>& OptionInstruments::getInstrumentIdToOsiMap() const
 {
-    return makeInstrumentIdToOsiMap(getStrikeKeyPutCallMap());
+    return getChainIndex().getInstrumentIdToOsiMap();
 }
 const std::string& OptionInstruments::getUnderlier() const
 {
@@ -338,7 +442,7 @@ std::list<std::string> OptionInstruments::getStrikes(const std::string& underlie
             strikeKeyPutCallMapPtr->first : 
             strikeKeyPutCallMapPtr->second;
         for (const auto& pair : strikeKeyToOsiInstrumentMap) {
-            strikes.push_back(OsiOption(pair.second.first).getStrike());
+            strikes.push_back(OsiOption::fromStrikeKeyAsString(pair.first));
         }
     }
     return strikes;
@@ -3,7 +3,9 @@
 #include "bentoclient/optionrecordgapfiller.hpp"
 #include <boost/log/trivial.hpp>
 #include <fmt/core.h>
-#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 using namespace bentoclient;
 
@@ -16,279 +18,295 @@ class OptionRecordGapFiller::Algos
 {
     // sets a lower limit for double values to take logs from to ensure validity 
     static constexpr double m_logLowerLimit = 1e-9;
+    // number of valid records for log-linear fits at the start and end of the strike series
+    static constexpr std::size_t m_nEndFitPoints = 24;
+    // no index marker
+    static constexpr std::size_t m_npos = static_cast<std::size_t>(-1);
 public:
-    /// @brief The result of a put-call-parity computation on matching strike options
-    struct PCPResult
-    {
-        PCPResult():
-        m_pcpConsistentRate(std::nan("0xbad")),
-        m_putPrice(std::nan("0xbad")),
-        m_callPrice(std::nan("0xbad")),
-        m_isValid(false)
-        {}
-        PCPResult(double pcpConsistentRate,
-            double putPrice, double callPrice): 
-        m_pcpConsistentRate(pcpConsistentRate),
-        m_putPrice(putPrice),
-        m_callPrice(callPrice),
-        m_isValid(true)
-        {}
-        /// @brief The put-call-parity price from a put call same strike options pair
-        double m_pcpConsistentRate;
-        /// @brief Price of the put option
-        double m_putPrice;
-        /// @brief Price of the call option
-        double m_callPrice;
-        /// @brief Indicates that a computation on a Record pair matched on strike could be performed
-        bool m_isValid;
-    };
     using Record = OptionChain::Record;
     using RecordMap = OptionChain::RecordMap;
-    /// @brief maps strike key to put-call-parity computation
-    typedef std::map<std::string, PCPResult> PCPMap;
+    using SharedRecordMap = OptionChain::SharedRecordMap;
     /// @brief Slope and intercept of a least squares fit line
     typedef std::pair<double, double> LSFitValue;
-    // type for points to perform a LS fit on 
-    typedef std::list<std::pair<double, double>> FitPoints;
     /// @brief Indicates whether a fit is extrapolating (start or end) or interpolating (gap)
     enum class FitType
     {
         Start, Gap, End
     };
-    /// @brief A least squares fit in the scope of next unfitted valid records
-    struct LSFit
+    /// @brief Running sums of a least squares line fit
+    /// @details Accumulates in point order with the arithmetic of
+    /// OptionChain::Util::fitLeastSquaresLine on lists, so fits come out identical.
+    struct LineSums
     {
-        LSFit() = delete;
-        LSFit(const LSFitValue& fitValue, 
-            FitType type, 
-            const std::string& lowerKey,
-            const std::string& upperKey):
-        m_fit(fitValue),
-        m_type(type),
-        m_lowerKey(lowerKey),
-        m_upperKey(upperKey)
-        {}
-        LSFit(const FitPoints& fitPoints, 
-            FitType type, 
-            const std::string& lowerKey,
-            const std::string& upperKey):
-        m_fit(OptionChain::Util::fitLeastSquaresLine(fitPoints)),
-        m_type(type),
-        m_lowerKey(lowerKey),
-        m_upperKey(upperKey)
-        {}
-        /// @brief slope and intercept of fit line
-        LSFitValue m_fit;
+        void add(double x, double y)
+        {
+            m_sumX += x;
+            m_sumY += y;
+            m_sumXY += x * y;
+            m_sumX2 += x * x;
+            ++m_n;
+        }
+        LSFitValue fit() const
+        {
+            if (m_n < 2) {
+                throw std::invalid_argument("Not enough data points to fit a line.");
+            }
+            double denominator = m_n * m_sumX2 - m_sumX * m_sumX;
+            if (std::abs(denominator) < 1e-10) {
+                throw std::runtime_error("Denominator is too small, cannot fit a line.");
+            }
+            double slope = (m_n * m_sumXY - m_sumX * m_sumY) / denominator;
+            double intercept = (m_sumY - slope * m_sumX) / m_n;
+            return {slope, intercept};
+        }
+        double m_sumX{};
+        double m_sumY{};
+        double m_sumXY{};
+        double m_sumX2{};
+        int m_n{};
+    };
+    /// @brief Strike matched put and call records as contiguous arrays, index aligned
+    struct AlignedChain
+    {
+        std::size_t size() const
+        {
+            return m_strikes.size();
+        }
+        /// @brief Both put and call have valid bid and ask, so there is a parity rate
+        bool isValid(std::size_t i) const
+        {
+            return m_putValid[i] && m_callValid[i];
+        }
+        std::vector<double> m_strikes;
+        std::vector<double> m_putPrices;
+        std::vector<double> m_callPrices;
+        std::vector<double> m_parityRates;
+        std::vector<std::uint8_t> m_putValid;
+        std::vector<std::uint8_t> m_callValid;
+    };
+    /// @brief A least squares fit for a contiguous range of records without parity rate
+    struct GapFit
+    {
+        /// @brief First index of the gap
+        std::size_t m_begin;
+        /// @brief One past the last index of the gap
+        std::size_t m_end;
         /// @brief indicates start, gap, and end fits 
         FitType m_type;
-        /// @brief record key having valid values on lower end of fit range
-        std::string m_lowerKey;
-        /// @brief record key having valid values on upper end of fit range
-        std::string m_upperKey;
+        /// @brief slope and intercept of fit line
+        LSFitValue m_fit;
+        /// @brief index having valid values on lower end of fit range, unused for start fits
+        std::size_t m_lower;
+        /// @brief index having valid values on upper end of fit range, unused for end fits
+        std::size_t m_upper;
     };
-    /// @brief maps strike keys to least squares fits
-    typedef std::map<std::string, LSFit> LSFitMap;
+    typedef std::vector<GapFit> GapFits;
 
-    /// @brief Iterates strike key matched records of an option chain to compute put-call-parities
-    /// @param optionChain Option chain holding put/call records
-    /// @param discountFactor Discount factor for the strike as a zero coupon bond
-    /// @return map of strike key to put-call-parity computation
-    static PCPMap matchPutCall(const OptionChain& optionChain, double discountFactor)
-    {
-        OptionChain::Util::PutCallParityRate parityRateCalculator(discountFactor);
-        auto pcpFunctor = std::function<PCPResult(const RecordMap::value_type&, const RecordMap::value_type&)>(
-            [&parityRateCalculator](const RecordMap::value_type& put, const RecordMap::value_type& call)
-            {
-                if (put.second.bidAskValid() && call.second.bidAskValid())
-                {
-                    double pcpRate = parityRateCalculator(put, call);
-                    return PCPResult{ pcpRate, put.second.getMidPrice(), call.second.getMidPrice() };
-                } else {
-                    return PCPResult{ };
-                }
-            }
-        );
-        PCPMap result = OptionChain::Util::onAllPutCallRecords(
-            optionChain, pcpFunctor, false);
-        return result;
-    }
-
-    /// @brief Clears records from map M1 that have no matching key in map M2
-    /// @tparam M1 Map1 type
-    /// @tparam M2 Map2 type
+    /// @brief Clears records from a shared record map that have no matching key in {keysIn}
+    /// @details A merge join on the ordered maps. Detaches the record map from sharing chains
+    /// only if any record is erased
     /// @param clearFrom Map to clear records from
     /// @param keysIn Map that holds the keys that should remain in clearFrom
     /// @return A list of keys erased from clearFrom map
-    template <typename M1, typename M2>
-    static std::list<std::string> removeElementsNotInKeys(M1& clearFrom, const M2& keysIn)
+    static std::list<std::string> removeElementsNotInKeys(SharedRecordMap& clearFrom, const RecordMap& keysIn)
     {
         std::list<std::string>  erasedKeys;
-        for (auto m1It = clearFrom.begin(); m1It != clearFrom.end();)
+        const RecordMap& records = clearFrom.get();
+        auto keyIt = keysIn.begin();
+        for (auto it = records.begin(); it != records.end(); ++it)
         {
-            if (keysIn.find(m1It->first) == keysIn.end())
+            while (keyIt != keysIn.end() && keyIt->first < it->first)
             {
-                auto toErase = m1It++;
-                erasedKeys.emplace_back(std::move(toErase->first));
-                clearFrom.erase(toErase);
-            } else {
-                ++m1It;
+                ++keyIt;
+            }
+            if (keyIt == keysIn.end() || keyIt->first != it->first)
+            {
+                erasedKeys.push_back(it->first);
+            }
+        }
+        if (!erasedKeys.empty())
+        {
+            RecordMap& recordMap = clearFrom.mutate();
+            for (auto& key : erasedKeys)
+            {
+                recordMap.erase(key);
             }
         }
         return erasedKeys;
     }
-    /// @brief Produces a map of strike keys to least squares fits for gaps
-    /// @param pcpMap Map of strike key to put-call-parity computation
-    /// @return Map of least squares fits
-    static LSFitMap fitPCPRateForGaps(const PCPMap& pcpMap)
+
+    /// @brief Aligns put and call records having the same strike keys into arrays
+    /// @param discountFactor Discount factor for the strike as a zero coupon bond
+    static AlignedChain alignPutCall(const RecordMap& puts, const RecordMap& calls, double discountFactor)
     {
-        LSFitMap lsFits;
-        // a sequence of contiguous strike keys without valid pcp values
-        std::set<std::string> currentGap;
-        // puts a fit for the corrent gap into the output map
-        auto putFit = [&lsFits,&currentGap](const FitPoints& points, FitType type, 
-            const std::string& lowerKey, const std::string& upperKey)
+        if (puts.size() != calls.size())
         {
-            LSFit fit(points, type, lowerKey, upperKey);
-            for (auto& key : currentGap)
-            {
-                lsFits.insert({key, fit});
+            throw std::logic_error("alignPutCall: put and call strike keys differ");
+        }
+        AlignedChain aligned;
+        std::size_t n = calls.size();
+        aligned.m_strikes.reserve(n);
+        aligned.m_putPrices.reserve(n);
+        aligned.m_callPrices.reserve(n);
+        aligned.m_parityRates.reserve(n);
+        aligned.m_putValid.reserve(n);
+        aligned.m_callValid.reserve(n);
+        auto putIt = puts.begin();
+        for (auto callIt = calls.begin(); callIt != calls.end(); ++callIt, ++putIt)
+        {
+            double strike = OsiOption::fromStrikeKey(callIt->first);
+            double putPrice = putIt->second.getMidPrice();
+            double callPrice = callIt->second.getMidPrice();
+            aligned.m_strikes.push_back(strike);
+            aligned.m_putPrices.push_back(putPrice);
+            aligned.m_callPrices.push_back(callPrice);
+            // Put/Call Parity: P + S = C + K * e^(-rT)
+            aligned.m_parityRates.push_back(callPrice - putPrice + strike * discountFactor);
+            aligned.m_putValid.push_back(putIt->second.bidAskValid());
+            aligned.m_callValid.push_back(callIt->second.bidAskValid());
+        }
+        return aligned;
+    }
+
+    /// @brief Produces least squares fits for gaps of records without parity rate in one forward pass
+    /// @details Gaps in between valid records get a line fit on parity rates of the two valid
+    /// records on either side. Gaps at the start fit logs of OTM put prices, gaps at the end
+    /// logs of OTM call prices.
+    /// @param aligned Aligned put and call records
+    /// @return Fits by gap
+    static GapFits fitGaps(const AlignedChain& aligned)
+    {
+        GapFits gapFits;
+        const std::size_t n = aligned.size();
+        auto nextValid = [&aligned, n](std::size_t i) {
+            while (i < n && !aligned.isValid(i)) {
+                ++i;
             }
+            return i;
         };
-        // puts a fit for a gap in between valid upper and lower values
-        auto gapFitter = [&pcpMap, &lsFits, &putFit]( 
-            PCPMap::const_iterator previous, PCPMap::const_iterator next)
+        // fit for a gap in between valid lower and upper values
+        auto gapFitter = [&aligned, &nextValid, n](std::size_t beforeLower, std::size_t lower, std::size_t upper)
         {
-            auto pprevious = previous;
-            FitPoints points;
-            while (pprevious != pcpMap.begin()) {
-                --pprevious;
-                if (pprevious->second.m_isValid) {
-                    points.push_back({OsiOption::fromStrikeKey(pprevious->first),
-                        pprevious->second.m_pcpConsistentRate});
-                    break;
-                }
+            LineSums sums;
+            if (beforeLower != m_npos) {
+                sums.add(aligned.m_strikes[beforeLower], aligned.m_parityRates[beforeLower]);
             }
-            points.push_back({OsiOption::fromStrikeKey(previous->first),
-                previous->second.m_pcpConsistentRate});
-            points.push_back({OsiOption::fromStrikeKey(next->first),
-                next->second.m_pcpConsistentRate});
-            std::string upperKey = next->first;
-            while (++next != pcpMap.end()) {
-                if (next->second.m_isValid) {
-                    points.push_back({OsiOption::fromStrikeKey(next->first),
-                        next->second.m_pcpConsistentRate});
-                    break;
-                }
+            sums.add(aligned.m_strikes[lower], aligned.m_parityRates[lower]);
+            sums.add(aligned.m_strikes[upper], aligned.m_parityRates[upper]);
+            std::size_t afterUpper = nextValid(upper + 1);
+            if (afterUpper < n) {
+                sums.add(aligned.m_strikes[afterUpper], aligned.m_parityRates[afterUpper]);
             }
-            putFit(points, FitType::Gap, previous->first, upperKey);
+            return sums.fit();
         };
-        // puts a fit at the lower end of strike keys, if no previous valid pcp value exists
-        // fit is performed on logarithms of OTM put prices
-        auto startFitter = [&pcpMap, &lsFits, &putFit](
-            PCPMap::const_iterator next)
+        // at start of series, values of far OTM puts may be estimated
+        // the fit is then done on logs of valid OTM put prices.
+        // Loglinear interpols avoid overflows by setting lower limit of 1e-9
+        auto startFitter = [&aligned, n](std::size_t upper, LineSums& sums)
         {
-            // at start of series, values of far OTM puts may be estimated
-            // the fit is then done on logs of valid OTM put prices.
-            // Loglinear interpols avoid overflows by setting lower limit of 
-            // 1e-9
-            constexpr size_t min_start_points = 24;
-            FitPoints points;
-            std::string upperKey = next->first;
-            do {
-                if (next->second.m_isValid) {
-                    points.push_back({OsiOption::fromStrikeKey(next->first), 
-                        std::log(std::max(m_logLowerLimit, next->second.m_putPrice))});
+            for (std::size_t i = upper; i < n && static_cast<std::size_t>(sums.m_n) < m_nEndFitPoints; ++i) {
+                if (aligned.isValid(i)) {
+                    sums.add(aligned.m_strikes[i], std::log(std::max(m_logLowerLimit, aligned.m_putPrices[i])));
                 }
-            } while (points.size() < min_start_points && ++next != pcpMap.end());
-            if (points.size() >= min_start_points/6) {
-                putFit(points, FitType::Start, std::string{}, upperKey);
             }
         };
-        // puts a fit at the upper and of strike keys, if no next valid pcp value exists
-        // fit is performed on logarithm of OTM call prices
-        auto endFitter = [&pcpMap, &lsFits, &putFit](
-            PCPMap::const_iterator last)
+        // at end of series, values of far OTM calls may be estimated
+        // fits are done on logs of valid OTM calls, in strike order. The first record of the
+        // series is not part of the fit, unless it is the last valid one.
+        auto endFitter = [&aligned](std::size_t lower, LineSums& sums)
         {
-            // at end of series, values of far OTM calls may be estimated
-            // fits are done on logs of valid OTM calls
-            // Loglinear interpols avoid overflows by setting lower limit of 
-            // 1e-9
-            constexpr size_t min_end_points = 24;
-            FitPoints points;
-            std::string lowerKey = last->first;
-            do  {
-                if (last->second.m_isValid) {
-                    points.push_front({OsiOption::fromStrikeKey(last->first),
-                        std::log(std::max(m_logLowerLimit, last->second.m_callPrice))});
+            std::size_t indices[m_nEndFitPoints];
+            std::size_t nPoints = 0;
+            std::size_t i = lower;
+            do {
+                if (aligned.isValid(i)) {
+                    indices[nPoints++] = i;
                 }
-                if (last != pcpMap.begin()) --last;
-            } while(points.size() < min_end_points && last != pcpMap.begin());
-            if (points.size() >= min_end_points/6) {
-                putFit(points, FitType::End, lowerKey, std::string{});
+                if (i != 0) --i;
+            } while (nPoints < m_nEndFitPoints && i != 0);
+            while (nPoints > 0) {
+                --nPoints;
+                sums.add(aligned.m_strikes[indices[nPoints]],
+                    std::log(std::max(m_logLowerLimit, aligned.m_callPrices[indices[nPoints]])));
             }
         };
-        // Finally, invoke the appropriate type of fitter for existing gaps
-        auto previousValid = pcpMap.end();
-        for (auto it = pcpMap.begin(); it != pcpMap.end(); ++it)
+        std::size_t beforePreviousValid = m_npos;
+        std::size_t previousValid = m_npos;
+        std::size_t gapBegin = m_npos;
+        for (std::size_t i = 0; i < n; ++i)
         {
-            if (it->second.m_isValid == false){
+            if (!aligned.isValid(i)) {
                 // Gap without a valid PCP rate
-                currentGap.insert(it->first);
-            } else {
-                if (!currentGap.empty())
-                {
-                    if (previousValid != pcpMap.end())
-                    {
-                        gapFitter(previousValid, it);
-                    } else {
-                        startFitter(it);
+                if (gapBegin == m_npos) {
+                    gapBegin = i;
+                }
+                continue;
+            }
+            if (gapBegin != m_npos) {
+                if (previousValid != m_npos) {
+                    gapFits.push_back({gapBegin, i, FitType::Gap,
+                        gapFitter(beforePreviousValid, previousValid, i), previousValid, i});
+                } else {
+                    LineSums sums;
+                    startFitter(i, sums);
+                    if (static_cast<std::size_t>(sums.m_n) >= m_nEndFitPoints / 6) {
+                        gapFits.push_back({gapBegin, i, FitType::Start, sums.fit(), m_npos, i});
                     }
-                    currentGap.clear();
                 }
-                previousValid = it;
+                gapBegin = m_npos;
             }
+            beforePreviousValid = previousValid;
+            previousValid = i;
         }
-        if (!currentGap.empty())
-        {
-            endFitter(previousValid);
+        if (gapBegin != m_npos && previousValid != m_npos) {
+            LineSums sums;
+            endFitter(previousValid, sums);
+            if (static_cast<std::size_t>(sums.m_n) >= m_nEndFitPoints / 6) {
+                gapFits.push_back({gapBegin, n, FitType::End, sums.fit(), previousValid, m_npos});
+            }
         }
-        return lsFits;
+        return gapFits;
     }
-    static Timestamp getRecvTime(const RecordMap& recordMap, const std::string& key)
+
+    /// @brief Records of one side by index, detaching the side from sharing chains
+    /// only on the first write, so a side without fills stays shared
+    class IndexedSide
     {
-        auto it = recordMap.find(key);
-        if (it != recordMap.end())
+    public:
+        explicit IndexedSide(SharedRecordMap& sharedRecordMap) :
+            m_sharedRecordMap(sharedRecordMap),
+            m_records(),
+            m_mutableRecords()
         {
-            return it->second.m_recvTime;
+            const RecordMap& recordMap = sharedRecordMap.get();
+            m_records.reserve(recordMap.size());
+            for (auto& keyRecord : recordMap)
+            {
+                m_records.push_back(&keyRecord.second);
+            }
         }
-        throw std::invalid_argument("getTimestamp: no record for key " + key);
-    }
-    /// @brief Computes spread for a record matched by key
-    /// @param recordMap maps strike keys to records
-    /// @param key key to compute spread for
-    /// @return bid-ask spread
-    static double computeSpread(const RecordMap& recordMap, const std::string& key)
-    {
-        auto it = recordMap.find(key);
-        if (it != recordMap.end())
+        const Record& get(std::size_t i) const
         {
-            if (it->second.bidAskValid())
+            return m_mutableRecords.empty() ? *m_records[i] : *m_mutableRecords[i];
+        }
+        Record& mutate(std::size_t i)
+        {
+            if (m_mutableRecords.empty())
             {
-                return it->second.getSpread();
+                RecordMap& recordMap = m_sharedRecordMap.mutate();
+                m_mutableRecords.reserve(recordMap.size());
+                for (auto& keyRecord : recordMap)
+                {
+                    m_mutableRecords.push_back(&keyRecord.second);
+                }
             }
-            throw std::invalid_argument("computeSpread: no valid spread value for key " + key);
+            return *m_mutableRecords[i];
         }
-        throw std::invalid_argument("computeSpread: no record for key " + key);
-    }
-    /// @brief Average bid-ask spread for two records matched by key
-    /// @param recordMap maps strike keys to records
-    /// @param key1 first key for spread
-    /// @param key2 second key for spread
-    /// @return average bid-ask spread
-    static double computeSpread(const RecordMap& recordMap, const std::string& key1, const std::string& key2)
-    {
-        return (computeSpread(recordMap, key1) + computeSpread(recordMap, key2)) / 2.0;
-    }
+    private:
+        SharedRecordMap& m_sharedRecordMap;
+        std::vector<const Record*> m_records;
+        std::vector<Record*> m_mutableRecords;
+    };
 
     /// @brief Estimates the ATM price of the put or call series, if minimum quality requirements met
     /// @param recordMap Record map to compute the ATM price from
@@ -319,117 +337,114 @@ public:
         throw std::invalid_argument(fmt::format("Failed to estimate ATM price for PCP rate {}", pcpRate));
     }
 
-    static double interpolate(const RecordMap& recordMap, 
-        double targetStrike, const std::string& lowerKey, const std::string& upperKey)
+    /// @brief Linear interpolation of mid prices at valid lower and upper records
+    static double interpolate(const Record& lower, const Record& upper,
+        double targetStrike, double lowerStrike, double upperStrike)
     {
-        auto lowerIt = recordMap.find(lowerKey);
-        auto upperIt = recordMap.find(upperKey);
-        if (lowerIt != recordMap.end() && upperIt != recordMap.end())
-        {
-            if (lowerIt->second.bidAskValid() && upperIt->second.bidAskValid())
-            {
-                double lowerMidPrice = lowerIt->second.getMidPrice();
-                double upperMidPrice = upperIt->second.getMidPrice();
-                double lowerStrike = OsiOption::fromStrikeKey(lowerKey);
-                double upperStrike = OsiOption::fromStrikeKey(upperKey);
-                double interpolated = lowerMidPrice 
-                    + (upperMidPrice - lowerMidPrice)*(targetStrike - lowerStrike)/(upperStrike - lowerStrike);
-                return interpolated;
-            }
-
-        }
-        throw std::invalid_argument(fmt::format("Unable to perform linear interpolation on strike and keys {},{},{}",
-            targetStrike, lowerKey, upperKey));
+        double lowerMidPrice = lower.getMidPrice();
+        double upperMidPrice = upper.getMidPrice();
+        return lowerMidPrice 
+            + (upperMidPrice - lowerMidPrice)*(targetStrike - lowerStrike)/(upperStrike - lowerStrike);
     }
 
-    static void fillFitValue(double discountFactor, const LSFitMap& fitMap, RecordMap& putMap, RecordMap& callMap, 
-        double atmPrice)
+    /// @brief Fills the records of gaps from their fits
+    /// @param puts Put records by index, aligned with calls
+    /// @param calls Call records by index
+    static void fillFitValue(double discountFactor, const AlignedChain& aligned, const GapFits& gapFits,
+        IndexedSide& puts, IndexedSide& calls, double atmPrice)
     {
-        for (auto it = fitMap.begin(); it != fitMap.end(); ++it) 
+        for (const GapFit& gapFit : gapFits)
         {
-            auto putIt = putMap.find(it->first);
-            auto callIt = callMap.find(it->first);
-            if (putIt != putMap.end() && callIt != callMap.end())
+            if (gapFit.m_type == FitType::Gap)
             {
-                double strike = OsiOption::fromStrikeKey(it->first);
-                if (it->second.m_type == FitType::Gap)
+                // If there is a gap in between good data, can fill it
+                // by put-call-parity, if at least the put or call side
+                // is filled. On the ends of the chain, put-call-parity
+                // does not necessarily give realisitc estimates.
+                const double lowerStrike = aligned.m_strikes[gapFit.m_lower];
+                const double upperStrike = aligned.m_strikes[gapFit.m_upper];
+                const double putSpread = (puts.get(gapFit.m_lower).getSpread()
+                    + puts.get(gapFit.m_upper).getSpread()) / 2.0;
+                const double callSpread = (calls.get(gapFit.m_lower).getSpread()
+                    + calls.get(gapFit.m_upper).getSpread()) / 2.0;
+                // do not use put-call-parity fits when they result in low values, compared
+                // to ATM prices.
+                const double atmPriceThreshold = atmPrice/4;
+                for (std::size_t i = gapFit.m_begin; i < gapFit.m_end; ++i)
                 {
-                    // If there is a gap in between good data, can fill it
-                    // by put-call-parity, if at least the put or call side
-                    // is filled. On the ends of the chain, put-call-parity
-                    // does not necessarily give realisitc estimates.
+                    double strike = aligned.m_strikes[i];
                     // compute put/call parity rate from fit
-                    double pcpRate = it->second.m_fit.first * strike + it->second.m_fit.second;
+                    double pcpRate = gapFit.m_fit.first * strike + gapFit.m_fit.second;
                     double computedPrice{};
                     double spread{};
                     Timestamp recvTime{};
-                    std::list<RecordMap::iterator> targetElement;
-                    std::list<std::reference_wrapper<RecordMap>> targetMap;
+                    IndexedSide* targetSide = nullptr;
+                    const Record* lower = nullptr;
+                    const Record* upper = nullptr;
                     // Put/Call Parity: C+B=P+S
-                    if (!putIt->second.bidAskValid() && callIt->second.bidAskValid())
+                    if (!aligned.m_putValid[i] && aligned.m_callValid[i])
                     {
                         // P = C+B-S
-                        computedPrice = callIt->second.getMidPrice() 
+                        computedPrice = aligned.m_callPrices[i] 
                             + strike * discountFactor 
                             - pcpRate;
-                        targetElement.push_back(putIt);
-                        targetMap.push_back(putMap);
-                        spread = computeSpread(putMap, it->second.m_lowerKey, it->second.m_upperKey);
-                        recvTime = getRecvTime(putMap, it->second.m_upperKey);
-                    } else if (!callIt->second.bidAskValid() && putIt->second.bidAskValid())
+                        targetSide = &puts;
+                        lower = &puts.get(gapFit.m_lower);
+                        upper = &puts.get(gapFit.m_upper);
+                        spread = putSpread;
+                        recvTime = upper->m_recvTime;
+                    } else if (!aligned.m_callValid[i] && aligned.m_putValid[i])
                     {
                         // C=P+S-B
-                        computedPrice = putIt->second.getMidPrice()
+                        computedPrice = aligned.m_putPrices[i]
                             + pcpRate
                             - strike * discountFactor;
-                        targetElement.push_back(callIt);
-                        targetMap.push_back(callMap);
-                        spread = computeSpread(callMap, it->second.m_lowerKey, it->second.m_upperKey);
-                        recvTime = getRecvTime(callMap, it->second.m_lowerKey);
+                        targetSide = &calls;
+                        lower = &calls.get(gapFit.m_lower);
+                        upper = &calls.get(gapFit.m_upper);
+                        spread = callSpread;
+                        recvTime = lower->m_recvTime;
+                    } else {
+                        continue;
                     }
-                    if (!targetElement.empty())
-                    {
-                        // do not use put-call-parity fits when they result in low values, compared
-                        // to ATM prices. So for comparison, first get the ATM price
-                        std::string comment = m_pcpFitComment;
-                        double atmPriceThreshold = atmPrice/4;
-                        if (computedPrice < atmPriceThreshold) {
-                            double linInterpolPrice = interpolate(targetMap.front(), 
-                                strike, it->second.m_lowerKey, it->second.m_upperKey);
-                            BOOST_LOG_TRIVIAL(info) << "Overwrite PCP computed price from " << computedPrice << " to "
-                                << linInterpolPrice << " because it's less than threshold " << atmPriceThreshold;
-                            computedPrice = linInterpolPrice;
-                            comment = m_linInterpolComment;
-                        }
-                        // have a computed price for a put / call side to fill.
-                        // but need bid/ask spread.
-                        targetElement.front()->second.m_askPrice = OptionChain::PriceWeight(
-                            computedPrice + spread / 2.0, 1);
-                        targetElement.front()->second.m_bidPrice = OptionChain::PriceWeight(
-                            std::max(0.0, computedPrice - spread / 2.0), 1);
-                        addComment(targetElement.front()->second.m_comment, comment);
-                        targetElement.front()->second.m_recvTime = recvTime;
+                    std::string comment = m_pcpFitComment;
+                    if (computedPrice < atmPriceThreshold) {
+                        double linInterpolPrice = interpolate(*lower, *upper,
+                            strike, lowerStrike, upperStrike);
+                        BOOST_LOG_TRIVIAL(info) << "Overwrite PCP computed price from " << computedPrice << " to "
+                            << linInterpolPrice << " because it's less than threshold " << atmPriceThreshold;
+                        computedPrice = linInterpolPrice;
+                        comment = m_linInterpolComment;
                     }
-                } else if (it->second.m_type == FitType::Start
-                        || it->second.m_type == FitType::End) {
-                    // may be able to extrapolate far OTM puts on lower end of strike series
-                    // or far OTM calls on upper end of strike series
-                    const RecordMap& map = it->second.m_type == FitType::Start ? 
-                        putMap : callMap;
-                    std::string key = it->second.m_type == FitType::Start ? 
-                        it->second.m_upperKey : it->second.m_lowerKey;
-                    RecordMap::iterator targetIt = it->second.m_type == FitType::Start ?
-                        putIt : callIt;
-                    double spread = computeSpread(map, key);
-                    Timestamp recvTime = getRecvTime(map, key);
-                    double logPrice = strike * it->second.m_fit.first + it->second.m_fit.second;
+                    // have a computed price for a put / call side to fill.
+                    // but need bid/ask spread.
+                    Record& target = targetSide->mutate(i);
+                    target.m_askPrice = OptionChain::PriceWeight::fromPrice(
+                        computedPrice + spread / 2.0, 1);
+                    target.m_bidPrice = OptionChain::PriceWeight::fromPrice(
+                        std::max(0.0, computedPrice - spread / 2.0), 1);
+                    addComment(target.m_comment, comment);
+                    target.m_recvTime = recvTime;
+                }
+            } else {
+                // may be able to extrapolate far OTM puts on lower end of strike series
+                // or far OTM calls on upper end of strike series
+                const bool bStart = gapFit.m_type == FitType::Start;
+                IndexedSide& targets = bStart ? puts : calls;
+                const Record& source = targets.get(bStart ? gapFit.m_upper : gapFit.m_lower);
+                double spread = source.getSpread();
+                Timestamp recvTime = source.m_recvTime;
+                for (std::size_t i = gapFit.m_begin; i < gapFit.m_end; ++i)
+                {
+                    double logPrice = aligned.m_strikes[i] * gapFit.m_fit.first + gapFit.m_fit.second;
                     double price = std::exp(logPrice);
-                    targetIt->second.m_askPrice = OptionChain::PriceWeight(
+                    Record& target = targets.mutate(i);
+                    target.m_askPrice = OptionChain::PriceWeight::fromPrice(
                         price + spread / 2.0, 1);
-                    targetIt->second.m_bidPrice = OptionChain::PriceWeight(
+                    target.m_bidPrice = OptionChain::PriceWeight::fromPrice(
                         std::max(0.0, price - spread / 2.0), 1);
-                    addComment(targetIt->second.m_comment, m_logExtrapolateComment);
-                    targetIt->second.m_recvTime = recvTime;
+                    addComment(target.m_comment, m_logExtrapolateComment);
+                    target.m_recvTime = recvTime;
                 }
             }
         }
@@ -445,47 +460,46 @@ public:
             target = source;
         }
     }
-    static std::pair<double, bool> getSpread(const Record& record)
-    {
-        if (record.bidAskValid())
-            return std::make_pair(record.getSpread(), true);
-        else
-            return std::make_pair(std::nan("0xbad"), false);
-    }
-    static void spreadFit(RecordMap& recordMap)
+    static void spreadFit(SharedRecordMap& sharedRecordMap)
     {
-        FitPoints spreadPoints;
-        std::set<std::string> fitKeys;
-        for (auto recordIt = recordMap.begin(); recordIt != recordMap.end(); ++recordIt)
+        const RecordMap& constRecordMap = sharedRecordMap.get();
+        LineSums spreadSums;
+        // positions of records with just a bid or an ask
+        std::vector<std::size_t> fitPositions;
+        std::size_t position = 0;
+        for (auto recordIt = constRecordMap.begin(); recordIt != constRecordMap.end(); ++recordIt, ++position)
         {
-            auto pair = getSpread(recordIt->second);
-            if (pair.second) {
-                spreadPoints.push_back(std::make_pair(
-                    OsiOption::fromStrikeKey(recordIt->first), pair.first)
-                );
+            if (recordIt->second.bidAskValid()) {
+                spreadSums.add(OsiOption::fromStrikeKey(recordIt->first), recordIt->second.getSpread());
             } else if (recordIt->second.anyBidAskValid()) {
-                fitKeys.insert(recordIt->first);
+                fitPositions.push_back(position);
             }
         }
-        if (fitKeys.empty()) {
+        if (fitPositions.empty()) {
             return;
         }
         try
         {
-            LSFitValue fit(OptionChain::Util::fitLeastSquaresLine(spreadPoints));
-            for (auto& fitKey : fitKeys)
+            LSFitValue fit(spreadSums.fit());
+            // detach from sharing chains only once records actually get completed
+            RecordMap& recordMap = sharedRecordMap.mutate();
+            auto recordIt = recordMap.begin();
+            position = 0;
+            for (std::size_t fitPosition : fitPositions)
             {
-                double fitX = OsiOption::fromStrikeKey(fitKey);
+                std::advance(recordIt, fitPosition - position);
+                position = fitPosition;
+                double fitX = OsiOption::fromStrikeKey(recordIt->first);
                 double fittedSpread = std::max(fitX * fit.first + fit.second, 0.01);
-                Record& record = recordMap[fitKey];
+                Record& record = recordIt->second;
                 if (std::get<1>(record.m_askPrice) > 0)
                 {
-                    std::get<0>(record.m_bidPrice) = std::max(
-                        std::get<0>(record.m_askPrice) - fittedSpread, 0.0
-                    );
+                    record.m_bidPrice.setPrice(std::max(
+                        record.m_askPrice.price() - fittedSpread, 0.0
+                    ));
                     std::get<1>(record.m_bidPrice) = 1;
                 } else {
-                    std::get<0>(record.m_askPrice) = std::get<0>(record.m_bidPrice) + fittedSpread;
+                    record.m_askPrice.setPrice(record.m_bidPrice.price() + fittedSpread);
                     std::get<1>(record.m_askPrice) = 1;
                 }
                 addComment(record.m_comment, m_spreadFitComment);
@@ -498,30 +512,42 @@ public:
 
 OptionChain OptionRecordGapFiller::fillGaps(const OptionChain& optionChain)
 {
-    OptionChain filledChain(optionChain);
+    // the filled chain shares unchanged records with the source chain
+    return fillGaps(OptionChain::shareRecords(optionChain));
+}
+
+OptionChain OptionRecordGapFiller::fillGaps(OptionChain&& optionChain)
+{
+    OptionChain filledChain(std::move(optionChain));
     // First off, try to complete any incomplete records, typically having an ask, no bid.
     Algos::spreadFit(filledChain.m_callsStrikeKeyToRecord);
     Algos::spreadFit(filledChain.m_putsStrikeKeyToRecord);
     double fRiskFreeRate = m_marketEnvironment->getRiskFreeRate(
-        optionChain.getChainTime(),
-        optionChain.getExpiryTime(m_marketEnvironment->getExchangeClose())
+        filledChain.getChainTime(),
+        filledChain.getExpiryTime(m_marketEnvironment->getExchangeClose())
     );
     double discountFactor = OptionChain::Util::getDiscountFactor(filledChain, fRiskFreeRate,
         m_marketEnvironment->getExchangeClose());
-    Algos::PCPMap pcpMap = Algos::matchPutCall(filledChain, discountFactor);
-    m_orphanedCalls = Algos::removeElementsNotInKeys(filledChain.m_callsStrikeKeyToRecord, pcpMap);
-    m_orphanedPuts = Algos::removeElementsNotInKeys(filledChain.m_putsStrikeKeyToRecord, pcpMap);
+    // keep only strikes having both a put and a call, so both sides align by index
+    m_orphanedCalls = Algos::removeElementsNotInKeys(filledChain.m_callsStrikeKeyToRecord, filledChain.getPuts());
+    m_orphanedPuts = Algos::removeElementsNotInKeys(filledChain.m_putsStrikeKeyToRecord, filledChain.getCalls());
     try {
         double parityRate = filledChain.getParityRate(fRiskFreeRate, m_marketEnvironment->getExchangeClose());
-        double putAtmPrice = Algos::estimateAtmPrice(filledChain.m_putsStrikeKeyToRecord, parityRate);
-        double callAtmPrice = Algos::estimateAtmPrice(filledChain.m_callsStrikeKeyToRecord, parityRate);
-        Algos::LSFitMap fitMap = Algos::fitPCPRateForGaps(pcpMap);
-        Algos::fillFitValue(discountFactor, fitMap, 
-            filledChain.m_putsStrikeKeyToRecord, filledChain.m_callsStrikeKeyToRecord, 
-            (putAtmPrice + callAtmPrice)/2);
+        double putAtmPrice = Algos::estimateAtmPrice(filledChain.getPuts(), parityRate);
+        double callAtmPrice = Algos::estimateAtmPrice(filledChain.getCalls(), parityRate);
+        Algos::AlignedChain aligned = Algos::alignPutCall(filledChain.getPuts(), filledChain.getCalls(),
+            discountFactor);
+        Algos::GapFits gapFits = Algos::fitGaps(aligned);
+        if (!gapFits.empty())
+        {
+            // sides detach from sharing chains only once a fit gets written to them
+            Algos::IndexedSide puts(filledChain.m_putsStrikeKeyToRecord);
+            Algos::IndexedSide calls(filledChain.m_callsStrikeKeyToRecord);
+            Algos::fillFitValue(discountFactor, aligned, gapFits, puts, calls,
+                (putAtmPrice + callAtmPrice)/2);
+        }
     } catch (const std::exception& e) {
         BOOST_LOG_TRIVIAL(warning) << "Failed to perform advanced fill operations: " << e.what();
     }
     return filledChain;
 }
-
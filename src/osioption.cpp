@@ -1,5 +1,6 @@
 #include <bentoclient/osioption.hpp>
-#include <regex>
+#include <algorithm>
+#include <stdexcept>
 using namespace bentoclient;
 
 std::ostream& operator<<(std::ostream& os, const bentoclient::OsiOption& osiOption)
@@ -13,27 +14,40 @@ std::ostream& operator<<(std::ostream& os, const bentoclient::OsiOption& osiOpti
 const std::string OsiOption::m_call("C");
 const std::string OsiOption::m_put("P");
 
+OsiSymbol OsiSymbol::fromIdentifier(std::string_view sOsiIdentifier)
+{
+    OsiSymbol symbol;
+    if (!parse(sOsiIdentifier, symbol)) {
+        throw std::invalid_argument("Invalid OSI identifier format: " + std::string(sOsiIdentifier));
+    }
+    return symbol;
+}
+
+std::string OsiSymbol::getExpiryDate() const
+{
+    std::string sExpiryDate("20yy-mm-dd");
+    sExpiryDate[2] = static_cast<char>('0' + m_year / 10);
+    sExpiryDate[3] = static_cast<char>('0' + m_year % 10);
+    sExpiryDate[5] = static_cast<char>('0' + m_month / 10);
+    sExpiryDate[6] = static_cast<char>('0' + m_month % 10);
+    sExpiryDate[8] = static_cast<char>('0' + m_day / 10);
+    sExpiryDate[9] = static_cast<char>('0' + m_day % 10);
+    return sExpiryDate;
+}
+
 OsiOption::OsiOption(const std::string& sOsiIdentifier) : 
     m_osiIdentifier(sOsiIdentifier) {
     // The OSI format is 6 characters underlier, 2 digits year, two digits month, two digits day, C/P,
     // 5 digits dollar strike, 3 digits decimal strike. Basically, divide the number 
     // past C/P by 1000 to get the strike price. If underlier has less than 6 characters, 
-    // it's padded with spaces.
-    // C++ 11 has thread safe statics initialization.
-    static const std::regex osiRegex(R"(([A-Z]+)\s*(\d{2})(\d{2})(\d{2})(C|P)(\d{5})(\d{3}))");
-    std::smatch match;
-    if (std::regex_match(sOsiIdentifier, match, osiRegex)) {
-        // The OSI identifier is valid
-        m_underlier = match[1].str();
-        m_expiryDate = "20" + match[2].str() + "-" + match[3].str() + "-" + match[4].str();
-        m_type = match[5].str();
-        m_strikeDollars = match[6].str();
-        m_strikeDecimal = match[7].str();
-        m_strike = getStrike(m_strikeDollars, m_strikeDecimal);
-    } else {
-        // The OSI identifier is invalid
-        throw std::invalid_argument("Invalid OSI identifier format: " + sOsiIdentifier);
-    }
+    // it's padded with spaces. Throws std::invalid_argument on invalid identifiers.
+    OsiSymbol symbol = OsiSymbol::fromIdentifier(sOsiIdentifier);
+    m_underlier = symbol.getUnderlier();
+    m_expiryDate = symbol.getExpiryDate();
+    m_type = symbol.isPut() ? m_put : m_call;
+    m_strikeDollars.assign(symbol.m_strikeKey, 5);
+    m_strikeDecimal.assign(symbol.m_strikeKey + 5, 3);
+    m_strike = getStrike(m_strikeDollars, m_strikeDecimal);
 }
 
 std::string OsiOption::getStrike(const std::string& strikeDollars, const std::string& strikeDecimal)
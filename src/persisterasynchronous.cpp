@@ -0,0 +1,204 @@
+#include "bentoclient/persisterasynchronous.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/marketenvironment.hpp"
+#include <boost/log/trivial.hpp>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace bentoclient;
+
+PersisterAsynchronous::PersisterAsynchronous(std::unique_ptr<Persister>&& persister,
+    const Options& options,
+    std::function<bool()> terminateSignal) :
+    m_persister(std::move(persister)),
+    m_options(options),
+    m_terminateSignal(std::move(terminateSignal)),
+    m_queue{},
+    m_nBusy(0),
+    m_nFailed(0),
+    m_failedChains{},
+    m_bStopping(false),
+    m_bTerminateLogged(false),
+    m_mutex{},
+    m_notEmpty{},
+    m_notFull{},
+    m_idle{},
+    m_writers{}
+{
+    std::size_t nWriters = std::max<std::size_t>(m_options.m_nWriters, 1);
+    m_writers.reserve(nWriters);
+    for (std::size_t i = 0; i < nWriters; ++i)
+    {
+        m_writers.emplace_back([this](){ runWriter(); });
+    }
+}
+
+PersisterAsynchronous::~PersisterAsynchronous()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStopping = true;
+    }
+    // writers leave once the queue is empty
+    m_notEmpty.notify_all();
+    for (auto& writer : m_writers)
+    {
+        writer.join();
+    }
+    if (m_nFailed > 0)
+    {
+        BOOST_LOG_TRIVIAL(error) << m_nFailed << " persist calls failed, failed chains are listed"
+            << " with the missing chains";
+    }
+    std::uint64_t nWriteFailures = m_options.m_writeFailures ? m_options.m_writeFailures() : 0;
+    if (nWriteFailures > 0)
+    {
+        BOOST_LOG_TRIVIAL(error) << nWriteFailures << " files failed to get written after persisting";
+    }
+}
+
+void PersisterAsynchronous::persist(OptionChain&& optionChain,
+    std::shared_ptr<MarketEnvironment> marketEnvironment)
+{
+    auto chainPtr = std::make_shared<OptionChain>(std::move(optionChain));
+    push([this, chainPtr, marketEnvironment]() {
+        std::pair<std::string, std::string> key(chainPtr->getUnderlier(), chainPtr->getValuationDate());
+        std::pair<Timestamp, std::string> missing(chainPtr->getChainTime(), chainPtr->getExpiryDate());
+        try {
+            m_persister->persist(std::move(*chainPtr), marketEnvironment);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_failedChains[key].push_back(std::move(missing));
+            throw;
+        }
+    });
+}
+
+void PersisterAsynchronous::persistMissing(const std::string& symbol, const std::string& sDate,
+    std::list<std::pair<Timestamp, std::string>>&& missingList)
+{
+    auto missingPtr = std::make_shared<std::list<std::pair<Timestamp, std::string>>>(std::move(missingList));
+    push([this, symbol, sDate, missingPtr]() {
+        m_persister->persistMissing(symbol, sDate, std::move(*missingPtr));
+    });
+}
+
+void PersisterAsynchronous::drain()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this](){ return m_queue.empty() && m_nBusy == 0; });
+    lock.unlock();
+    m_persister->drain();
+}
+
+std::uint64_t PersisterAsynchronous::getFailedCount() const
+{
+    std::uint64_t nWriteFailures = m_options.m_writeFailures ? m_options.m_writeFailures() : 0;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nFailed + m_persister->getFailedCount() + nWriteFailures;
+}
+
+void PersisterAsynchronous::push(Job&& job)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notFull.wait(lock, [this](){
+        return m_queue.size() < std::max<std::size_t>(m_options.m_nMaxQueued, 1);
+    });
+    m_queue.push_back(std::move(job));
+    lock.unlock();
+    m_notEmpty.notify_one();
+}
+
+void PersisterAsynchronous::runWriter()
+{
+    std::vector<Job> batch;
+    std::size_t nMaxBatch = std::max<std::size_t>(m_options.m_nMaxBatch, 1);
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notEmpty.wait(lock, [this](){ return !m_queue.empty() || m_bStopping; });
+            if (m_queue.empty())
+            {
+                return;
+            }
+            if (!m_bTerminateLogged && m_terminateSignal())
+            {
+                m_bTerminateLogged = true;
+                BOOST_LOG_TRIVIAL(warning) << "Draining " << m_queue.size()
+                    << " queued persist calls after terminate signal";
+            }
+            while (!m_queue.empty() && batch.size() < nMaxBatch)
+            {
+                batch.push_back(std::move(m_queue.front()));
+                m_queue.pop_front();
+            }
+            ++m_nBusy;
+        }
+        m_notFull.notify_all();
+        std::uint64_t nFailed = 0;
+        for (auto& job : batch)
+        {
+            try {
+                job();
+            } catch (const std::exception& e) {
+                ++nFailed;
+                BOOST_LOG_TRIVIAL(error) << "Asynchronous persist failed: " << e.what();
+            }
+        }
+        batch.clear();
+        persistFailed();
+        if (m_options.m_afterBatch)
+        {
+            try {
+                m_options.m_afterBatch();
+            } catch (const std::exception& e) {
+                BOOST_LOG_TRIVIAL(error) << "Asynchronous persist batch completion failed: " << e.what();
+            }
+        }
+        if (m_options.m_durability == Durability::SYNC_BATCH)
+        {
+            sync();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_nFailed += nFailed;
+            --m_nBusy;
+        }
+        m_idle.notify_all();
+    }
+}
+
+void PersisterAsynchronous::persistFailed()
+{
+    FailedChainsMap failedChains;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        failedChains.swap(m_failedChains);
+    }
+    for (auto& failed : failedChains)
+    {
+        try {
+            m_persister->persistMissing(failed.first.first, failed.first.second, std::move(failed.second));
+        } catch (const std::exception& e) {
+            BOOST_LOG_TRIVIAL(error) << "Failed to report chains failing to persist for symbol "
+                << failed.first.first << " and date " << failed.first.second << ": " << e.what();
+        }
+    }
+}
+
+void PersisterAsynchronous::sync() const
+{
+    int fd = ::open(m_options.m_syncPath.empty() ? "." : m_options.m_syncPath.c_str(), O_RDONLY);
+    if (fd < 0 || ::syncfs(fd) != 0)
+    {
+        BOOST_LOG_TRIVIAL(error) << "Failed to sync file system of " << m_options.m_syncPath
+            << ": " << std::strerror(errno);
+    }
+    if (fd >= 0)
+    {
+        ::close(fd);
+    }
+}
@@ -0,0 +1,87 @@
+#include "bentoclient/persisterbinary.hpp"
+#include "bentoclient/binarychain.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/marketenvironment.hpp"
+#include "bentoclient/apputils.hpp"
+#include <fmt/core.h>
+#include <fmt/chrono.h>
+#include <fstream>
+#include <filesystem>
+
+using namespace bentoclient;
+
+PersisterBinary::PersisterBinary(const std::string& basePath, bool splitFoldersByDate) :
+    m_basePath(basePath),
+    m_splitFoldersByDate(splitFoldersByDate),
+    m_outputter(makeFileOutputter(std::ios::out | std::ios::binary)),
+    m_missingOutputter(makeFileOutputter(std::ios::out | std::ios::app))
+{}
+
+void PersisterBinary::persist(OptionChain&& optionChain,
+    std::shared_ptr<MarketEnvironment> marketEnvironment)
+{
+    BinaryChain::Summary summary = BinaryChain::makeSummary(optionChain, *marketEnvironment);
+    std::string outputPath = filenamePart(
+        optionChain.getValuationDate(), optionChain.getUnderlier());
+    outputPath += fmt::format("_chain_{}_{}_n{}{}",
+        optionChain.getValuationDate(),
+        optionChain.getExpiryDate(),
+        optionChain.getPuts().size(),
+        BinaryChain::m_fileExtension);
+    Outputter::result_type ostreamPtr = m_outputter(outputPath);
+    BinaryChain::write(*ostreamPtr, optionChain, summary);
+}
+
+void PersisterBinary::persistMissing(const std::string& symbol, const std::string& sDate,
+    std::list<std::pair<Timestamp, std::string>>&& missingList)
+{
+    if (missingList.empty())
+        return;
+    std::string basePath = filenamePart(sDate, symbol);
+    std::string fileNameEnd = fmt::format("_missing_{0:}_{1:%H-%M-%S}.txt", sDate,
+        missingList.front().first);
+    std::string pathName = basePath + fileNameEnd;
+    Outputter::result_type ostreamPtr = m_missingOutputter(pathName);
+    for (auto& pair: missingList)
+    {
+        *ostreamPtr << fmt::format("{0:%Y-%m-%d %H:%M:%S}", pair.first)
+            << " EXP " << pair.second << "\n";
+    }
+}
+
+void PersisterBinary::setOutputter(Outputter&& outputter)
+{
+    m_outputter = std::move(outputter);
+}
+
+void PersisterBinary::setMissingOutputter(Outputter&& outputter)
+{
+    m_missingOutputter = std::move(outputter);
+}
+
+std::string PersisterBinary::filenamePart(
+    const std::string& sDate, const std::string& symbol) const
+{
+    std::string outputPath(m_basePath);
+    if (m_splitFoldersByDate)
+    {
+        outputPath += "/" + sDate;
+    }
+    outputPath += "/" + AppUtils::toLower(symbol);
+    return outputPath;
+}
+
+PersisterBinary::Outputter PersisterBinary::makeFileOutputter(std::ios::openmode mode)
+{
+    Outputter outputter([mode](const std::string& pathname) -> std::unique_ptr<std::ostream>
+    {
+        // standard file system outputter creating directories if nonexist
+        std::filesystem::path path(pathname);
+        if (path.has_parent_path())
+        {
+            std::filesystem::create_directories(path.parent_path());
+        }
+        return std::make_unique<std::ofstream>(pathname, mode);
+    });
+    return outputter;
+}
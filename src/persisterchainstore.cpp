@@ -0,0 +1,46 @@
+#include "bentoclient/persisterchainstore.hpp"
+#include "bentoclient/chainstore.hpp"
+#include "bentoclient/binarychain.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/marketenvironment.hpp"
+#include "bentoclient/apputils.hpp"
+#include <fmt/core.h>
+#include <fmt/chrono.h>
+#include <fstream>
+
+using namespace bentoclient;
+
+PersisterChainStore::PersisterChainStore(std::shared_ptr<ChainStore> chainStore) :
+    m_chainStore(std::move(chainStore)),
+    m_missingOutputter([](const std::string& pathname) -> std::unique_ptr<std::ostream>
+    {
+        // the store directory exists once the store is open, appending keeps earlier notices
+        return std::make_unique<std::ofstream>(pathname, std::ios::out | std::ios::app);
+    })
+{}
+
+void PersisterChainStore::persist(OptionChain&& optionChain,
+    std::shared_ptr<MarketEnvironment> marketEnvironment)
+{
+    m_chainStore->append(optionChain, BinaryChain::makeSummary(optionChain, *marketEnvironment));
+}
+
+void PersisterChainStore::persistMissing(const std::string& symbol, const std::string& sDate,
+    std::list<std::pair<Timestamp, std::string>>&& missingList)
+{
+    if (missingList.empty())
+        return;
+    std::string pathName = fmt::format("{}/{}_missing_{}_{:%H-%M-%S}.txt",
+        m_chainStore->getBasePath(), AppUtils::toLower(symbol), sDate, missingList.front().first);
+    Outputter::result_type ostreamPtr = m_missingOutputter(pathName);
+    for (auto& pair: missingList)
+    {
+        *ostreamPtr << fmt::format("{0:%Y-%m-%d %H:%M:%S}", pair.first)
+            << " EXP " << pair.second << "\n";
+    }
+}
+
+void PersisterChainStore::setMissingOutputter(Outputter&& outputter)
+{
+    m_missingOutputter = std::move(outputter);
+}
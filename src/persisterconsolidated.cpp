@@ -0,0 +1,139 @@
+#include "bentoclient/persisterconsolidated.hpp"
+#include "bentoclient/binarychain.hpp"
+#include "bentoclient/csvfromoptionchain.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/marketenvironment.hpp"
+#include "bentoclient/apputils.hpp"
+#include <boost/log/trivial.hpp>
+#include <fmt/core.h>
+#include <fmt/chrono.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace bentoclient;
+
+PersisterConsolidated::PersisterConsolidated(const std::string& basePath, bool splitFoldersByDate,
+    ConsolidatedFile::Flavour flavour, PersisterCSV::CSVFormat csvFormat, bool bGreeks,
+    std::size_t nMaxOpenFiles) :
+    m_basePath(basePath),
+    m_splitFoldersByDate(splitFoldersByDate),
+    m_flavour(flavour),
+    m_csvFormat(csvFormat),
+    m_bGreeks(bGreeks),
+    m_nMaxOpenFiles(std::max<std::size_t>(nMaxOpenFiles, 1)),
+    m_openFiles(),
+    m_nUses(0),
+    m_mutex()
+{}
+
+PersisterConsolidated::~PersisterConsolidated()
+{
+    try {
+        flush();
+    } catch (const std::exception& e) {
+        BOOST_LOG_TRIVIAL(error) << e.what();
+    }
+}
+
+void PersisterConsolidated::persist(OptionChain&& optionChain,
+    std::shared_ptr<MarketEnvironment> marketEnvironment)
+{
+    // serialize outside of the lock
+    std::ostringstream section;
+    if (m_flavour == ConsolidatedFile::Flavour::Binary)
+    {
+        BinaryChain::write(section, optionChain, BinaryChain::makeSummary(optionChain, *marketEnvironment));
+    } else {
+        CSVFromOptionChain toCsv(marketEnvironment, m_bGreeks);
+        switch(m_csvFormat)
+        {
+        case PersisterCSV::CSVFormat::SideBySide:
+            toCsv.sideBySide(section, optionChain);
+            break;
+        case PersisterCSV::CSVFormat::Stacked:
+            toCsv.stacked(section, optionChain);
+            break;
+        default:
+            throw std::invalid_argument(fmt::format("Unsupported CSV format {}",
+                static_cast<int>(m_csvFormat)));
+        }
+    }
+    std::string path = getPath(optionChain.getUnderlier(), optionChain.getValuationDate());
+    std::lock_guard<std::mutex> lock(m_mutex);
+    getWriter(path).append(optionChain.getExpiryDate(), optionChain.getChainTime(), section.str());
+}
+
+void PersisterConsolidated::persistMissing(const std::string& symbol, const std::string& sDate,
+    std::list<std::pair<Timestamp, std::string>>&& missingList)
+{
+    if (missingList.empty())
+        return;
+    std::string pathName = filenamePart(sDate, symbol) + fmt::format("_missing_{}.txt", sDate);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::filesystem::path path(pathName);
+    if (path.has_parent_path())
+    {
+        std::filesystem::create_directories(path.parent_path());
+    }
+    std::ofstream ostr(pathName, std::ios::out | std::ios::app);
+    for (auto& pair: missingList)
+    {
+        ostr << fmt::format("{0:%Y-%m-%d %H:%M:%S}", pair.first)
+            << " EXP " << pair.second << "\n";
+    }
+}
+
+void PersisterConsolidated::flush()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // writers left after a failing one finish on destruction
+    std::map<std::string, OpenFile> openFiles;
+    openFiles.swap(m_openFiles);
+    for (auto& openFile : openFiles)
+    {
+        openFile.second.m_writer->finish();
+    }
+}
+
+std::string PersisterConsolidated::getPath(const std::string& symbol, const std::string& sDate) const
+{
+    return filenamePart(sDate, symbol) + fmt::format("_chains_{}{}", sDate,
+        m_flavour == ConsolidatedFile::Flavour::Binary ?
+            ConsolidatedFile::m_binaryFileExtension : ConsolidatedFile::m_csvFileExtension);
+}
+
+std::string PersisterConsolidated::filenamePart(
+    const std::string& sDate, const std::string& symbol) const
+{
+    std::string outputPath(m_basePath);
+    if (m_splitFoldersByDate)
+    {
+        outputPath += "/" + sDate;
+    }
+    outputPath += "/" + AppUtils::toLower(symbol);
+    return outputPath;
+}
+
+ConsolidatedFile::Writer& PersisterConsolidated::getWriter(const std::string& path)
+{
+    auto it = m_openFiles.find(path);
+    if (it == m_openFiles.end())
+    {
+        if (m_openFiles.size() >= m_nMaxOpenFiles)
+        {
+            auto lru = std::min_element(m_openFiles.begin(), m_openFiles.end(),
+                [](const auto& lhs, const auto& rhs) {
+                    return lhs.second.m_lastUse < rhs.second.m_lastUse;
+                });
+            std::unique_ptr<ConsolidatedFile::Writer> writer = std::move(lru->second.m_writer);
+            m_openFiles.erase(lru);
+            writer->finish();
+        }
+        it = m_openFiles.emplace(path,
+            OpenFile{std::make_unique<ConsolidatedFile::Writer>(path, m_flavour), 0}).first;
+    }
+    it->second.m_lastUse = ++m_nUses;
+    return *it->second.m_writer;
+}
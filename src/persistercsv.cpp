@@ -11,12 +11,13 @@
 using namespace bentoclient;
 
 PersisterCSV::PersisterCSV(const std::string& basePath, 
-    bool splitFoldersByDate, CSVFormat csvFormat) :
+    bool splitFoldersByDate, CSVFormat csvFormat, bool bGreeks) :
     m_basePath(basePath),
     m_splitFoldersByDate(splitFoldersByDate),
     m_csvFormat(csvFormat),
+    m_bGreeks(bGreeks),
     m_outputter(makeFileOutputter()),
-    m_missingOutputter(makeFileOutputter())
+    m_missingOutputter(makeFileOutputter(std::ios::out | std::ios::app))
 {}
 
 void PersisterCSV::persist(OptionChain&& optionChain, 
@@ -25,7 +26,7 @@ void PersisterCSV::persist(OptionChain&& optionChain,
     Timestamp chainTime = optionChain.getChainTime();
     Timestamp expiryTime = optionChain.getExpiryTime(marketEnvironment->getExchangeClose());
     double fRiskFreeRate = marketEnvironment->getRiskFreeRate(chainTime, expiryTime);
-    CSVFromOptionChain toCsv(marketEnvironment);
+    CSVFromOptionChain toCsv(marketEnvironment, m_bGreeks);
     std::string outputPath = filenamePart(
         optionChain.getValuationDate(), optionChain.getUnderlier());
     std::string fileNameEnd = fmt::format("_chain_{}_{}_n{}.csv", 
@@ -87,9 +88,9 @@ std::string PersisterCSV::filenamePart(
     return outputPath;
 }
 
-PersisterCSV::Outputter PersisterCSV::makeFileOutputter()
+PersisterCSV::Outputter PersisterCSV::makeFileOutputter(std::ios::openmode mode)
 {
-    Outputter outputter([](const std::string& pathname) -> std::unique_ptr<std::ostream>
+    Outputter outputter([mode](const std::string& pathname) -> std::unique_ptr<std::ostream>
     {
         // standard file system outputter creating directories if nonexist
         std::filesystem::path path(pathname);
@@ -97,7 +98,7 @@ PersisterCSV::Outputter PersisterCSV::makeFileOutputter()
         {
             std::filesystem::create_directories(path.parent_path());
         }
-        return std::make_unique<std::ofstream>(pathname);
+        return std::make_unique<std::ofstream>(pathname, mode);
     });
     return outputter;
 }
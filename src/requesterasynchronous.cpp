@@ -5,6 +5,13 @@
 #include "bentoclient/marketenvironment.hpp"
 #include "bentoclient/optionchain.hpp"
 #include "bentoclient/persistercsv.hpp"
+#include "bentoclient/persisterbinary.hpp"
+#include "bentoclient/persisterchainstore.hpp"
+#include "bentoclient/persisterconsolidated.hpp"
+#include "bentoclient/persisterasynchronous.hpp"
+#include "bentoclient/batchfilewriter.hpp"
+#include "bentoclient/chainstore.hpp"
+#include "bentoclient/zstdstream.hpp"
 #include <boost/log/trivial.hpp>
 
 using namespace bentoclient;
@@ -20,7 +27,8 @@ RequesterAsynchronous::RequesterAsynchronous(
     std::uint64_t nThreads,
     std::function<bool()> terminateSignal,
     double fDefaultRiskFreeRate,
-    const std::string& sInterestRatesCsv
+    const std::string& sInterestRatesCsv,
+    const std::string& sInterestRatesCache
     ) :
     RequesterSynchronous(
         std::move(getter),
@@ -31,7 +39,8 @@ RequesterAsynchronous::RequesterAsynchronous(
         cbbo1mRange,
         nInstrumentsSplit,
         fDefaultRiskFreeRate,
-        sInterestRatesCsv
+        sInterestRatesCsv,
+        sInterestRatesCache
         ),
         m_threadPool(nThreads)
 {
@@ -66,27 +75,11 @@ ThreadPool::ResultMap RequesterAsynchronous::query()
 }
 
 
-std::unique_ptr<RequesterAsynchronous> RequesterAsynchronous::makeRequesterCSV(
-    const std::string& sApiKey,
-    const std::string& sDataset,
-    const std::string& sBasePath,
-    std::uint64_t nThreadsRequester,
-    std::uint64_t nThreadsSymbology,
-    std::uint64_t nThreadsTimeseries,
-    std::function<bool()> terminateSignal,
-    std::uint64_t nSplitInstrumentIds,
-    std::uint64_t nRetries,
-    TimeRange chainLookupTimeRange,
-    TimeRange cbbo1sTimeRange,
-    TimeRange cbbo1mTimeRange,
-    double fDefaultRiskFreeRate,
-    const std::string& sInterestRatesCsv,
-    bool bStacked,
-    bool bDateDirs)
+std::unique_ptr<RequesterAsynchronous> RequesterAsynchronous::makeRequesterCSV(const Options& options)
 {
     std::unique_ptr<databento::Historical> clientPtr(std::make_unique<databento::Historical>(
         std::move(databento::HistoricalBuilder{}
-        .SetKey(sApiKey)
+        .SetKey(options.m_sApiKey)
         .Build())));
     
     std::unique_ptr<Getter> _getterPtr = std::make_unique<GetterSynchronous>(
@@ -94,33 +87,93 @@ std::unique_ptr<RequesterAsynchronous> RequesterAsynchronous::makeRequesterCSV(
 
     std::unique_ptr<Getter> getterPtr = std::make_unique<GetterAsynchronous>(
         std::move(_getterPtr),
-        nThreadsSymbology,
-        nThreadsTimeseries,
-        nSplitInstrumentIds,
-        nRetries);
+        options.m_nThreadsSymbology,
+        options.m_nThreadsTimeseries,
+        options.m_nSplitInstrumentIds,
+        options.m_nRetries);
 
+    // Chains are looked up right after the requesting thread built them, so an LRU
+    // bound per requester thread keeps memory flat in long running processes.
+    constexpr std::uint64_t nRetainedChainsPerThread = 1024;
     std::unique_ptr<Retriever> retrieverPtr = std::make_unique<RetrieverInMemory>(
-        chainLookupTimeRange
+        options.m_chainLookupTimeRange,
+        RetrieverInMemory::RetentionPolicy(
+            std::max<std::uint64_t>(options.m_nThreadsRequester, 1) * nRetainedChainsPerThread)
     );
 
-    std::unique_ptr<Persister> persisterPtr = std::make_unique<PersisterCSV>(
-        sBasePath,
-        bDateDirs,
-        bStacked? PersisterCSV::CSVFormat::Stacked : PersisterCSV::CSVFormat::SideBySide
-    );
+    constexpr std::uint64_t nMaxPersistBatch = 32;
+    PersisterAsynchronous::Options persisterOptions(
+        std::max<std::uint64_t>(options.m_nThreadsRequester, 1) * 4,
+        2,
+        nMaxPersistBatch,
+        options.m_bSyncWrites ? PersisterAsynchronous::Durability::SYNC_BATCH : PersisterAsynchronous::Durability::NONE,
+        options.m_sBasePath);
+    std::unique_ptr<Persister> persisterPtr;
+    if (options.m_bChainStore)
+    {
+        persisterPtr = std::make_unique<PersisterChainStore>(std::make_shared<ChainStore>(options.m_sBasePath));
+    } else if (options.m_bConsolidated) {
+        // one file per symbol and date, kept open across batches
+        persisterPtr = std::make_unique<PersisterConsolidated>(
+            options.m_sBasePath,
+            options.m_bDateDirs,
+            options.m_bBinary ? ConsolidatedFile::Flavour::Binary : ConsolidatedFile::Flavour::CSV,
+            options.m_bStacked? PersisterCSV::CSVFormat::Stacked : PersisterCSV::CSVFormat::SideBySide,
+            options.m_bGreeks);
+    } else {
+        // one file per chain, written in batches of a persister batch. Missing chain notices
+        // keep the default outputters appending to files, as notices of chains failing to get
+        // written may go to the same file as the requester's.
+        std::shared_ptr<BatchFileWriter> fileWriter = BatchFileWriter::create(nMaxPersistBatch, options.m_bIoUring);
+        persisterOptions.m_afterBatch = [fileWriter](){ fileWriter->flush(); };
+        persisterOptions.m_writeFailures = [fileWriter](){ return fileWriter->getFailedCount(); };
+        PersisterCSV::Outputter chainOutputter = fileWriter->makeOutputter();
+        if (options.m_nCompressionLevel != 0)
+        {
+            std::shared_ptr<const ZstdStream::Dictionary> dictionary;
+            if (!options.m_sCompressionDictionary.empty())
+            {
+                dictionary = ZstdStream::Dictionary::load(options.m_sCompressionDictionary, options.m_nCompressionLevel);
+            }
+            chainOutputter = ZstdStream::wrapOutputter(std::move(chainOutputter), options.m_nCompressionLevel, dictionary);
+        }
+        if (options.m_bBinary)
+        {
+            auto persisterBinary = std::make_unique<PersisterBinary>(options.m_sBasePath, options.m_bDateDirs);
+            persisterBinary->setOutputter(std::move(chainOutputter));
+            persisterPtr = std::move(persisterBinary);
+        } else {
+            auto persisterCSV = std::make_unique<PersisterCSV>(
+                options.m_sBasePath,
+                options.m_bDateDirs,
+                options.m_bStacked? PersisterCSV::CSVFormat::Stacked : PersisterCSV::CSVFormat::SideBySide,
+                options.m_bGreeks
+            );
+            persisterCSV->setOutputter(std::move(chainOutputter));
+            persisterPtr = std::move(persisterCSV);
+        }
+    }
+    // fetching threads hand chains over to writer threads instead of waiting on disk
+    persisterPtr = std::make_unique<PersisterAsynchronous>(
+        std::move(persisterPtr),
+        persisterOptions,
+        options.m_terminateSignal);
 
     std::unique_ptr<RequesterAsynchronous> requesterPtr = std::make_unique<RequesterAsynchronous>(
         std::move(getterPtr),
         std::move(retrieverPtr),
         std::move(persisterPtr),
-        sDataset,
-        cbbo1sTimeRange,
-        cbbo1mTimeRange,
-        nSplitInstrumentIds,
-        nThreadsRequester,
-        terminateSignal,
-        fDefaultRiskFreeRate,
-        sInterestRatesCsv
+        options.m_sDataset,
+        options.m_cbbo1sTimeRange,
+        options.m_cbbo1mTimeRange,
+        options.m_nSplitInstrumentIds,
+        options.m_nThreadsRequester,
+        options.m_terminateSignal,
+        options.m_fDefaultRiskFreeRate,
+        options.m_sInterestRatesCsv,
+        options.m_sInterestRatesCache
     );
+    requesterPtr->setDeltaShift(options.m_deltaShiftStaleAfter);
+    requesterPtr->setCbboCapture(options.m_sCbboCapturePath);
     return requesterPtr;
 }
@@ -10,15 +10,23 @@
 #include "bentoclient/clienttypes.hpp"
 #include "bentoclient/logging.hpp"
 #include "bentoclient/retry.hpp"
+#include "bentoclient/osioption.hpp"
+#include "bentoclient/variadicthreadpool.hpp"
+#include "bentoclient/cbbocapture.hpp"
 #include <boost/log/trivial.hpp>
 #include <fmt/core.h>
 #include <fmt/chrono.h>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <future>
 #include <mutex>
+#include <thread>
 
 #define STREAM_DEBUG 0
 
 #if STREAM_DEBUG
-#include <fstream>
 #include "bentoclient/bentoserializer.hpp"
 #endif
 using namespace bentoclient;
@@ -61,13 +69,11 @@ public:
         return fmt::format("{}_{}", symbol, date);
     }
 
-    static OptionChain::PutCallRecordMap getPutCallRecordMap(
+    static OptionChain::RecordTimeline getRecordTimeline(
         const RequesterSynchronous& requester,
         Timestamp dateTime,
-        const std::map<std::string, std::string>& idToOsi
-#if STREAM_DEBUG
-        , const std::string& _symbol, const std::string& _date, const std::string& _expiryDate
-#endif        
+        const std::map<std::string, std::string>& idToOsi,
+        const std::string& symbol, const std::string& date, const std::string& expiryDate
         )
     {
         // Due to issues with spotty data, get data from two cbbo schemata and join maps
@@ -176,7 +182,8 @@ public:
         // and allows estimating the delta of options along the strike axis. This in turn allows
         // fitting past results into the snapshot at {dateTime}.
         // However, using a delta estimate to shift out of date cbbo records to their probable
-        // value at {dateTime} is not necessarily an improvement, depending on user needs.
+        // value at {dateTime} is not necessarily an improvement, depending on user needs, and
+        // therefore only happens when enabled by setDeltaShift.
         BOOST_LOG_TRIVIAL(info) << "Missing instruments number " << missingInstrumentIds.size() 
             << " after cbbo1s run. Example: " 
             << (missingInstrumentIds.empty() ? "None" : idToOsi.at(missingInstrumentIds[0]));
@@ -216,25 +223,156 @@ public:
             traceLogger(missingInstrumentIds, "databento::Schema::Cbbo1M");
         }
 
+        // Instruments that only have 1m data are mostly far from the money, and rarely come as
+        // put/call pairs. For delta shifting, a few pairs around the money give the underlier path
+        // over the 1m lookback at low request volume.
+        if (requester.m_deltaShiftStaleAfter > TimeRange::zero() && !cbboMaps.empty())
+        {
+            cbboMaps.push_back(getUnderlierPathCbbos(requester, dateTime, idToOsi, cbboMaps.front(), nMaxRecords));
+        }
+
         OptionChain::InstrumentIdToCbboMap cbboMap = joinCbboMaps(std::move(cbboMaps));
 #if STREAM_DEBUG
 {
-    std::ofstream ofs(_symbol + "_cbboMap_" + _date + "_exp_" + _expiryDate + ".txt");
+    std::ofstream ofs(symbol + "_cbboMap_" + date + "_exp_" + expiryDate + ".txt");
     boost::archive::text_oarchive oa(ofs);
     oa << cbboMap;
 }
 #endif
+        if (!requester.m_sCbboCapturePath.empty())
+        {
+            captureCbboMap(requester.m_sCbboCapturePath, symbol, date, expiryDate, dateTime, idToOsi, cbboMap);
+        }
         // At this points, CBBO map is as good as it gets. In order to find the most relevant data,
         // first reshuffle to a timeline of 2 second buckets
-        OptionChain::RecordTimeline timeline = OptionChain::buildRecordTimeline(cbboMap,
-            idToOsi, std::chrono::seconds(2));
-        // Based on this timeline, one *could* now attempt a put-call-parity analysis, and then
-        // request a larger timeframe of ATM instruments to compute a pcp-rate history for shifting
-        // of out-of-date elements. For now, just produce the RecordMaps for the raw option chain
-        // from the last-best values in the timeline. Otherwise, put another call of the getterRetryLoop here...
+        OptionChain::RecordTimeline timeline = OptionChain::buildRecordTimeline(cbboMap, idToOsi);
+        // Based on this timeline, a put-call-parity analysis estimates the underlier path for
+        // shifting of out-of-date elements, see shiftStaleRecords.
+        return timeline;
+    }
+
+    /// @brief Writes the joined cbbo map to {capturePath}/{date}/ for offline reprocessing
+    /// @details Failures only get logged, as captures must not cost the chain itself
+    static void captureCbboMap(const std::string& capturePath,
+        const std::string& symbol, const std::string& date, const std::string& expiryDate,
+        Timestamp dateTime,
+        const std::map<std::string, std::string>& idToOsi,
+        const OptionChain::InstrumentIdToCbboMap& cbboMap)
+    {
+        std::filesystem::path path = std::filesystem::path(capturePath) / date;
+        std::error_code errorCode;
+        std::filesystem::create_directories(path, errorCode);
+        path /= CbboCapture::makeFileName(symbol, date, expiryDate, dateTime);
+        try {
+            std::ofstream ostr(path, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!ostr)
+            {
+                throw std::runtime_error("failed to open " + path.string());
+            }
+            CbboCapture::write(ostr, symbol, date, expiryDate, dateTime, idToOsi, cbboMap);
+        } catch (const std::exception& e) {
+            BOOST_LOG_TRIVIAL(error) << "Failed to capture cbbo data for symbol " << symbol
+                << " and expiry date " << expiryDate << ": " << e.what();
+        }
+    }
 
-        OptionChain::PutCallRecordMap putCallRecords = OptionChain::mapLatestBestInTimelineToRecord(timeline);
-        return putCallRecords;
+    /// @brief Gets cbbo 1m data over the 1m lookback for put/call pairs nearest to the money
+    /// @param cbboMap Recent cbbo data to locate the money
+    static OptionChain::InstrumentIdToCbboMap getUnderlierPathCbbos(
+        const RequesterSynchronous& requester,
+        Timestamp dateTime,
+        const std::map<std::string, std::string>& idToOsi,
+        const OptionChain::InstrumentIdToCbboMap& cbboMap,
+        std::uint64_t nMaxRecords)
+    {
+        // number of strikes nearest to the money with put and call instruments requested
+        constexpr std::size_t nPathStrikes = 3;
+        // strike key to put and call instrument IDs, and latest put and call mid prices
+        typedef std::pair<std::string, double> InstrumentMid;
+        std::map<std::string, std::pair<InstrumentMid, InstrumentMid>> strikeToPair;
+        for (auto& idOsiPair : idToOsi)
+        {
+            const OsiSymbol osiSymbol = OsiSymbol::fromIdentifier(idOsiPair.second);
+            auto& pair = strikeToPair[osiSymbol.getStrikeKey()];
+            InstrumentMid& instrumentMid = osiSymbol.isPut() ? pair.first : pair.second;
+            instrumentMid.first = idOsiPair.first;
+            instrumentMid.second = std::nan("0xbad");
+            auto cbboIt = cbboMap.find(idOsiPair.first);
+            if (cbboIt == cbboMap.end())
+            {
+                continue;
+            }
+            Timestamp latest{};
+            for (auto& cbboMsg : cbboIt->second)
+            {
+                OptionChain::Record record(cbboMsg);
+                if (record.bidAskValid() && record.m_recvTime >= latest)
+                {
+                    latest = record.m_recvTime;
+                    instrumentMid.second = record.getMidPrice();
+                }
+            }
+        }
+        // rough put-call-parity rate, discounting doesn't matter to find strikes near the money
+        std::vector<double> parityRates;
+        for (auto& strikePair : strikeToPair)
+        {
+            double fParityRate = strikePair.second.second.second - strikePair.second.first.second
+                + OsiOption::fromStrikeKey(strikePair.first);
+            if (!std::isnan(fParityRate))
+            {
+                parityRates.push_back(fParityRate);
+            }
+        }
+        if (parityRates.empty())
+        {
+            return OptionChain::InstrumentIdToCbboMap{};
+        }
+        auto middle = parityRates.begin() + parityRates.size() / 2;
+        std::nth_element(parityRates.begin(), middle, parityRates.end());
+        double fUnderlier = *middle;
+        std::vector<std::pair<double, std::string>> distanceToStrike;
+        for (auto& strikePair : strikeToPair)
+        {
+            if (!strikePair.second.first.first.empty() && !strikePair.second.second.first.empty())
+            {
+                distanceToStrike.emplace_back(
+                    std::abs(OsiOption::fromStrikeKey(strikePair.first) - fUnderlier), strikePair.first);
+            }
+        }
+        std::size_t nStrikes = std::min(nPathStrikes, distanceToStrike.size());
+        std::partial_sort(distanceToStrike.begin(), distanceToStrike.begin() + nStrikes, distanceToStrike.end());
+        std::vector<std::string> instrumentIds;
+        for (std::size_t i = 0; i < nStrikes; ++i)
+        {
+            auto& pair = strikeToPair.at(distanceToStrike[i].second);
+            instrumentIds.push_back(pair.first.first);
+            instrumentIds.push_back(pair.second.first);
+        }
+        if (instrumentIds.empty())
+        {
+            return OptionChain::InstrumentIdToCbboMap{};
+        }
+        // slice the lookback so responses stay below nMaxRecords
+        TimeRange timeRange = requester.m_cbbo1mRange;
+        std::uint64_t nExpected = instrumentIds.size() * (timeRange / std::chrono::minutes(1));
+        std::uint64_t nSplit = nExpected / nMaxRecords + 1;
+        TimeRange subRange = timeRange / nSplit;
+        std::list<databento::CbboMsg> cbboMsgs;
+        try {
+            for (std::uint64_t i = 0; i < nSplit; ++i)
+            {
+                cbboMsgs.splice(cbboMsgs.end(), requester.m_getter->getCbboTimeseriesRange(
+                    instrumentIds, requester.m_sDataset, databento::Schema::Cbbo1M,
+                    dateTime - subRange * i, subRange));
+            }
+        } catch (const std::exception& e)
+        {
+            BOOST_LOG_TRIVIAL(warning) << "Failed to get cbbo 1m data for underlier path: " << e.what();
+        }
+        BOOST_LOG_TRIVIAL(info) << "Got " << cbboMsgs.size() << " cbbo 1m records of " << instrumentIds.size()
+            << " instruments for underlier path near " << fUnderlier;
+        return OptionChain::mapCbboMsgsToInstruments(std::move(cbboMsgs), idToOsi);
     }
 
     static OptionChain::InstrumentIdToCbboMap joinCbboMaps(std::list<OptionChain::InstrumentIdToCbboMap>&& cbboMaps)
@@ -265,15 +403,22 @@ RequesterSynchronous::RequesterSynchronous(std::unique_ptr<Getter>&& getter,
     TimeRange cbbo1mRange,
     std::uint64_t nInstrumentsSplit,
     double fDefaultRiskFreeRate,
-    const std::string& sInterestRatesCsv
+    const std::string& sInterestRatesCsv,
+    const std::string& sInterestRatesCache
     ) :
     Requester(std::move(getter), std::move(retriever), std::move(persister)),
     m_internal(std::make_unique<Internal>()),
     m_marketEnvironment(std::make_shared<MarketEnvironmentExtended>(
         fDefaultRiskFreeRate,
         DateUtils::m_nasdaqClose,
-        sInterestRatesCsv)),
+        sInterestRatesCsv,
+        sInterestRatesCache)),
+    m_computePool(std::make_unique<VariadicThreadPool>(
+        std::max<std::uint64_t>(std::thread::hardware_concurrency(), 1),
+        VariadicThreadPool::Scheduling::WorkStealing)),
     m_terminateSignal([](){return false;}),
+    m_deltaShiftStaleAfter(TimeRange::zero()),
+    m_sCbboCapturePath(),
     m_cbbo1sRange(cbbo1sRange),
     m_cbbo1mRange(cbbo1mRange),
     m_sDataset(sDataset),
@@ -323,16 +468,13 @@ void RequesterSynchronous::getOptionChains(const std::string& symbol,
         }
 
         OptionInstruments specificDateInstruments = optionInstruments.get(symbol, date, expiryDate);
-        std::map<std::string, std::string> idToOsi = specificDateInstruments.getInstrumentIdToOsiMap();
+        const std::map<std::string, std::string>& idToOsi = specificDateInstruments.getInstrumentIdToOsiMap();
         std::vector<std::string> instrumentIds = AppUtils::keyVector(idToOsi);
         BOOST_LOG_TRIVIAL(info) << "Getting CBBOs for symbol " << symbol << " and expiry date " 
             << expiryDate;
-        OptionChain::PutCallRecordMap putCallRecordMap = Internal::getPutCallRecordMap(
-            *this, dateTime, idToOsi
-#if STREAM_DEBUG
-            , symbol, date, expiryDate
-#endif        
-        );
+        OptionChain::RecordTimeline timeline = Internal::getRecordTimeline(
+            *this, dateTime, idToOsi, symbol, date, expiryDate);
+        OptionChain::PutCallRecordMap putCallRecordMap = OptionChain::mapLatestBestInTimelineToRecord(timeline);
 
         BOOST_LOG_TRIVIAL(info) << "Starting to build option chain from CBBO and instrument data for symbol " << symbol
             << " and expiry date " << expiryDate;
@@ -342,6 +484,10 @@ void RequesterSynchronous::getOptionChains(const std::string& symbol,
             {
                 BOOST_LOG_TRIVIAL(info) << "Built raw chain for symbol " << symbol << " and expiry date " 
                     << expiryDate;
+                if (m_deltaShiftStaleAfter > TimeRange::zero())
+                {
+                    rawChain.shiftStaleRecords(timeline, *m_marketEnvironment, m_deltaShiftStaleAfter);
+                }
                 chainTimes.push_back({rawChain.getChainTime(), expiryDate});
                 m_retriever->submitOptionChain(std::move(rawChain));
             } else {
@@ -356,18 +502,33 @@ void RequesterSynchronous::getOptionChains(const std::string& symbol,
             missingChains.push_back({dateTime, expiryDate});
         }
     }
-    for (auto chainPair : chainTimes)
+    // Gap filling and CSV formatting are pure CPU work, fan out all expiry dates to the
+    // compute pool and join before reporting missing chains.
+    std::list<std::future<bool>> persisted;
+    for (auto& chainPair : chainTimes)
     {
-        try {
-            OptionChain enhancedChain = m_retriever->getOptionChain(symbol, chainPair.first, chainPair.second);
-            BOOST_LOG_TRIVIAL(info) << "Persisting enhanced chain for symbol " << symbol << " at " 
-                << serializeTimestamp(dateTime) << " and expiry date " << enhancedChain.getExpiryDate();
-            m_persister->persist(std::move(enhancedChain),
-                m_retriever->getMarketEnvironment(symbol));
-        } catch (const std::exception& e)
+        persisted.push_back(m_computePool->post([this, &symbol, dateTime](
+            const std::pair<Timestamp, std::string>& chainPair) -> bool {
+            try {
+                OptionChain enhancedChain = m_retriever->getOptionChain(symbol, chainPair.first, chainPair.second);
+                BOOST_LOG_TRIVIAL(info) << "Persisting enhanced chain for symbol " << symbol << " at " 
+                    << serializeTimestamp(dateTime) << " and expiry date " << enhancedChain.getExpiryDate();
+                m_persister->persist(std::move(enhancedChain),
+                    m_retriever->getMarketEnvironment(symbol));
+                return true;
+            } catch (const std::exception& e)
+            {
+                BOOST_LOG_TRIVIAL(error) << "Failed to retrieve enhanced chain and persist it for symbol " << symbol << " at "
+                    << serializeTimestamp(dateTime) << " for expiry date " << chainPair.second << ": " << e.what();
+            }
+            return false;
+        }, chainPair));
+    }
+    auto persistedIt = persisted.begin();
+    for (auto& chainPair : chainTimes)
+    {
+        if (!(persistedIt++)->get())
         {
-            BOOST_LOG_TRIVIAL(error) << "Failed to retrieve enhanced chain and persist it for symbol " << symbol << " at "
-                << serializeTimestamp(dateTime) << " for expiry date " << chainPair.second << ": " << e.what();
             missingChains.push_back(chainPair);
         }
     }
@@ -381,3 +542,19 @@ void RequesterSynchronous::setTerminateSignal(std::function<bool()> terminateSig
 {
     m_terminateSignal = terminateSignal;
 }
+
+void RequesterSynchronous::setDeltaShift(TimeRange staleAfter)
+{
+    m_deltaShiftStaleAfter = staleAfter;
+}
+
+void RequesterSynchronous::setCbboCapture(const std::string& capturePath)
+{
+    m_sCbboCapturePath = capturePath;
+}
+
+std::uint64_t RequesterSynchronous::finishPersisting()
+{
+    m_persister->drain();
+    return m_persister->getFailedCount();
+}
@@ -1,7 +1,6 @@
 #include "bentoclient/retriever.hpp"
 #include "bentoclient/optionchain.hpp"
 #include "bentoclient/optionrecordgapfiller.hpp"
-#include "bentoclient/marketenvironmentextended.hpp"
 
 using namespace bentoclient;
 
@@ -15,18 +14,8 @@ OptionChain Retriever::getOptionChain(
     Timestamp dateTime,
     const std::string& expiryDate)
 {
-    const OptionChain& rawOptionChain = getRawOptionChain(symbol, dateTime, expiryDate);
-    std::shared_ptr<MarketEnvironment> marketEnvironment = getMarketEnvironment(symbol);
-    double fRiskFreeRate = marketEnvironment->getRiskFreeRate(
-        rawOptionChain.getChainTime(),
-        rawOptionChain.getExpiryTime(marketEnvironment->getExchangeClose()));
-    OptionRecordGapFiller gapFiller(marketEnvironment);
-    return gapFiller.fillGaps(rawOptionChain);
-}
-
-
-std::pair<Timestamp, bool> Retriever::getNextInTimeRange(Timestamp at,
-    const TimeToChainMap& timeToChainMap) const
-{
-    return MarketEnvironmentExtended::getNextInTimeRange(at, timeToChainMap, m_timeRange);
+    OptionChainPtr rawOptionChain = getRawOptionChain(symbol, dateTime, expiryDate);
+    OptionRecordGapFiller gapFiller(getMarketEnvironment(symbol));
+    // the filled chain shares any records left untouched by the gap filler with the raw chain
+    return gapFiller.fillGaps(*rawOptionChain);
 }
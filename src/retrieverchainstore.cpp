@@ -0,0 +1,94 @@
+#include "bentoclient/retrieverchainstore.hpp"
+#include "bentoclient/chainstore.hpp"
+#include "bentoclient/binarychain.hpp"
+#include "bentoclient/marketenvironment.hpp"
+#include "bentoclient/optionchain.hpp"
+#include <fmt/core.h>
+#include <fmt/chrono.h>
+#include <cmath>
+
+using namespace bentoclient;
+
+RetrieverChainStore::RetrieverChainStore(TimeRange timeRange, std::shared_ptr<ChainStore> chainStore) :
+    Retriever(timeRange),
+    m_chainStore(std::move(chainStore)),
+    m_timeRange(timeRange),
+    m_marketEnvironmentData{},
+    m_mutex{}
+{
+}
+
+void RetrieverChainStore::submitOptionChain(OptionChain&& optionChain)
+{
+    std::shared_ptr<MarketEnvironment> marketEnvironment;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto symIt = m_marketEnvironmentData.find(optionChain.getUnderlier());
+        if (symIt != m_marketEnvironmentData.end())
+        {
+            marketEnvironment = symIt->second;
+        }
+    }
+    BinaryChain::Summary summary = marketEnvironment ?
+        BinaryChain::makeSummary(optionChain, *marketEnvironment) :
+        BinaryChain::Summary{Timestamp{}, std::nan("0xbad"), std::nan("0xbad"), std::nan("0xbad")};
+    m_chainStore->append(optionChain, summary);
+}
+
+void RetrieverChainStore::submitMarketEnvironment(const std::string& symbol,
+    std::shared_ptr<MarketEnvironment> marketEnvironment)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_marketEnvironmentData[symbol] = marketEnvironment;
+}
+
+bool RetrieverChainStore::hasOptionChain(
+    const std::string& symbol,
+    Timestamp dateTime,
+    const std::string& expiryDate)
+{
+    ChainStore::Location location{};
+    return findLocation(symbol, dateTime, expiryDate, location);
+}
+
+Retriever::OptionChainPtr RetrieverChainStore::getRawOptionChain(
+    const std::string& symbol,
+    Timestamp dateTime,
+    const std::string& expiryDate)
+{
+    ChainStore::Location location{};
+    if (findLocation(symbol, dateTime, expiryDate, location))
+    {
+        return std::make_shared<const OptionChain>(m_chainStore->read(location));
+    }
+    throw std::invalid_argument(fmt::format("No option chain in acceptable time range"
+        " for {:%Y-%m-%d %H:%M:%S} of {} EXP {}",  dateTime, symbol, expiryDate));
+}
+
+bool RetrieverChainStore::findLocation(
+    const std::string& symbol,
+    Timestamp dateTime,
+    const std::string& expiryDate,
+    ChainStore::Location& location)
+{
+    if (m_chainStore->find(symbol, dateTime, expiryDate, m_timeRange, location))
+    {
+        return true;
+    }
+    // another writer may have appended the chain since the index got loaded
+    m_chainStore->refresh();
+    return m_chainStore->find(symbol, dateTime, expiryDate, m_timeRange, location);
+}
+
+std::shared_ptr<MarketEnvironment> RetrieverChainStore::getMarketEnvironment(
+    const std::string& symbol) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto symIt = m_marketEnvironmentData.find(symbol);
+    if (symIt != m_marketEnvironmentData.end())
+    {
+        return symIt->second;
+    }
+    throw std::invalid_argument(fmt::format("No market environment data for symbol {}",
+        symbol));
+}
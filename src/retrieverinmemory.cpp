@@ -1,26 +1,232 @@
 #include "bentoclient/retrieverinmemory.hpp"
 #include "bentoclient/marketenvironment.hpp"
 #include "bentoclient/optionchain.hpp"
+#include <boost/log/trivial.hpp>
 #include <fmt/core.h>
 #include <fmt/chrono.h>
+#include <functional>
+#include <list>
 
 using namespace bentoclient;
 
-RetrieverInMemory::RetrieverInMemory(TimeRange timeRange) :
+/// @brief Chains for a subset of symbols, guarded by their own lock
+class RetrieverInMemory::Shard
+{
+public:
+    /// @brief Locates a chain in the shard's maps
+    struct ChainKey
+    {
+        std::string m_symbol;
+        std::string m_expiryDate;
+        Timestamp m_chainTime;
+        /// @brief Use tick, comparable across shards
+        std::uint64_t m_lastUsed;
+    };
+    /// @brief Chain keys, most recently used first
+    typedef std::list<ChainKey> LruList;
+    /// @brief Chain handle with its position in the LRU list
+    struct Entry
+    {
+        OptionChainPtr m_chain;
+        LruList::iterator m_lruIt;
+    };
+    typedef std::map<Timestamp, Entry> TimeToEntryMap;
+    typedef std::map<std::string, TimeToEntryMap> ExpiryToEntriesMap;
+    typedef std::map<std::string, ExpiryToEntriesMap> SymbolToExpiryMap;
+public:
+    Shard() :
+        m_mutex{},
+        m_chainData{},
+        m_lru{},
+        m_latestChainTime{}
+    {}
+    Shard(const Shard&) = delete;
+    Shard& operator = (const Shard&) = delete;
+    Shard(Shard&&) = delete;
+    Shard& operator = (Shard&&) = delete;
+    ~Shard() = default;
+
+    /// @brief Finds the chains for a symbol and expiry date, or nullptr
+    const TimeToEntryMap* find(const std::string& symbol, const std::string& expiryDate) const
+    {
+        auto symIt = m_chainData.find(symbol);
+        if (symIt != m_chainData.end())
+        {
+            auto expIt = symIt->second.find(expiryDate);
+            if (expIt != symIt->second.end())
+            {
+                return &expIt->second;
+            }
+        }
+        return nullptr;
+    }
+
+    /// @brief Inserts a chain unless one exists for the same time, and marks it most recently used
+    /// @return If the chain got inserted
+    bool insert(OptionChainPtr&& optionChain, std::uint64_t useTick)
+    {
+        Timestamp chainTime = optionChain->getChainTime();
+        TimeToEntryMap& timeToEntryMap = m_chainData[optionChain->getUnderlier()]
+            [optionChain->getExpiryDate()];
+        auto inserted = timeToEntryMap.try_emplace(chainTime);
+        if (inserted.second)
+        {
+            inserted.first->second.m_chain = std::move(optionChain);
+            m_lru.push_front(ChainKey{inserted.first->second.m_chain->getUnderlier(),
+                inserted.first->second.m_chain->getExpiryDate(), chainTime, useTick});
+            inserted.first->second.m_lruIt = m_lru.begin();
+        }
+        else
+        {
+            touch(inserted.first->second, useTick);
+        }
+        m_latestChainTime = std::max(m_latestChainTime, chainTime);
+        return inserted.second;
+    }
+
+    /// @brief Marks an entry as most recently used
+    void touch(const Entry& entry, std::uint64_t useTick)
+    {
+        entry.m_lruIt->m_lastUsed = useTick;
+        m_lru.splice(m_lru.begin(), m_lru, entry.m_lruIt);
+    }
+
+    /// @brief Evicts chains last used before {horizon}, least recently used first
+    /// @param nMaxEvictions Upper limit of evicted chains
+    /// @return Number of evicted chains
+    std::size_t evictUsedBefore(std::uint64_t horizon, std::size_t nMaxEvictions)
+    {
+        std::size_t nEvicted = 0;
+        while (nEvicted < nMaxEvictions && !m_lru.empty() && m_lru.back().m_lastUsed < horizon)
+        {
+            ChainKey leastRecentKey(m_lru.back());
+            erase(leastRecentKey);
+            ++nEvicted;
+        }
+        return nEvicted;
+    }
+
+    /// @brief Evicts chains outside the retention window
+    /// @return Number of evicted chains
+    std::size_t evictExpired(TimeRange retentionWindow)
+    {
+        std::size_t nEvicted = 0;
+        if (retentionWindow != TimeRange::zero() 
+            && m_latestChainTime.time_since_epoch() > retentionWindow)
+        {
+            Timestamp horizon = m_latestChainTime - retentionWindow;
+            for (auto symIt = m_chainData.begin(); symIt != m_chainData.end();)
+            {
+                for (auto expIt = symIt->second.begin(); expIt != symIt->second.end();)
+                {
+                    TimeToEntryMap& timeToEntryMap = expIt->second;
+                    auto horizonIt = timeToEntryMap.lower_bound(horizon);
+                    for (auto it = timeToEntryMap.begin(); it != horizonIt; ++it)
+                    {
+                        m_lru.erase(it->second.m_lruIt);
+                        ++nEvicted;
+                    }
+                    timeToEntryMap.erase(timeToEntryMap.begin(), horizonIt);
+                    expIt = timeToEntryMap.empty() ? symIt->second.erase(expIt) : std::next(expIt);
+                }
+                symIt = symIt->second.empty() ? m_chainData.erase(symIt) : std::next(symIt);
+            }
+        }
+        return nEvicted;
+    }
+
+    std::mutex m_mutex;
+    SymbolToExpiryMap m_chainData;
+    LruList m_lru;
+    Timestamp m_latestChainTime;
+private:
+    /// @brief Erases a chain and its LRU entry, dropping emptied maps
+    void erase(const ChainKey& chainKey)
+    {
+        auto symIt = m_chainData.find(chainKey.m_symbol);
+        auto expIt = symIt->second.find(chainKey.m_expiryDate);
+        auto chainIt = expIt->second.find(chainKey.m_chainTime);
+        BOOST_LOG_TRIVIAL(debug) << "Evicting option chain for " << chainKey.m_symbol << " at "
+            << serializeTimestamp(chainKey.m_chainTime) << " for expiry date " << chainKey.m_expiryDate;
+        m_lru.erase(chainIt->second.m_lruIt);
+        expIt->second.erase(chainIt);
+        if (expIt->second.empty())
+        {
+            symIt->second.erase(expIt);
+            if (symIt->second.empty())
+            {
+                m_chainData.erase(symIt);
+            }
+        }
+    }
+};
+
+RetrieverInMemory::RetrieverInMemory(TimeRange timeRange,
+    const RetentionPolicy& retentionPolicy) :
     Retriever(timeRange),
-    m_chainData{},
+    m_retentionPolicy(retentionPolicy),
+    m_shards{},
+    m_nChains(0),
+    m_useTick(0),
     m_marketEnvironmentData{},
     m_mutex{}
 {
+    std::size_t nShards = std::max<std::size_t>(m_retentionPolicy.m_nShards, 1);
+    m_shards.reserve(nShards);
+    for (std::size_t i = 0; i < nShards; ++i)
+    {
+        m_shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+RetrieverInMemory::~RetrieverInMemory() = default;
+
+RetrieverInMemory::Shard& RetrieverInMemory::getShard(const std::string& symbol) const
+{
+    return *m_shards[std::hash<std::string>{}(symbol) % m_shards.size()];
 }
 
 void RetrieverInMemory::submitOptionChain(OptionChain&& optionChain)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    TimeToChainMap& timeToChainMap = m_chainData[optionChain.getUnderlier()]
-        [optionChain.getExpiryDate()];
-    Timestamp chainTime = optionChain.getChainTime();
-    timeToChainMap.emplace(chainTime, std::move(optionChain));
+    // build the handle outside of the lock
+    OptionChainPtr chainPtr = std::make_shared<const OptionChain>(std::move(optionChain));
+    Shard& shard = getShard(chainPtr->getUnderlier());
+    {
+        std::lock_guard<std::mutex> lock(shard.m_mutex);
+        if (shard.insert(std::move(chainPtr), ++m_useTick))
+        {
+            ++m_nChains;
+        }
+        m_nChains -= shard.evictExpired(m_retentionPolicy.m_retentionWindow);
+    }
+    evictLeastRecentlyUsed();
+}
+
+void RetrieverInMemory::evictLeastRecentlyUsed()
+{
+    const std::size_t nMaxChains = m_retentionPolicy.m_nMaxChains;
+    if (nMaxChains == 0 || m_nChains <= nMaxChains)
+    {
+        return;
+    }
+    // Evicting down to below the bound leaves room for the next submits without another pass.
+    // At most nKeptChains chains got used during the last nKeptChains ticks, so evicting the
+    // chains used before leaves at most nKeptChains, without searching the globally least
+    // recently used chain for each of them.
+    const std::size_t nKeptChains = nMaxChains - nMaxChains / 8;
+    std::uint64_t useTick = m_useTick;
+    std::uint64_t horizon = useTick >= nKeptChains ? useTick - nKeptChains + 1 : 0;
+    // one shard lock at a time, so evicting threads never wait on each other in a cycle
+    for (auto& shard : m_shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->m_mutex);
+        std::size_t nChains = m_nChains;
+        if (nChains <= nKeptChains)
+        {
+            return;
+        }
+        m_nChains -= shard->evictUsedBefore(horizon, nChains - nKeptChains);
+    }
 }
 
 void RetrieverInMemory::submitMarketEnvironment(const std::string& symbol, 
@@ -35,42 +241,37 @@ bool RetrieverInMemory::hasOptionChain(
     Timestamp dateTime,
     const std::string& expiryDate)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    auto symIt = m_chainData.find(symbol);
-    if (symIt != m_chainData.end())
+    Shard& shard = getShard(symbol);
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    const Shard::TimeToEntryMap* timeToEntryMap = shard.find(symbol, expiryDate);
+    if (timeToEntryMap != nullptr)
     {
-        auto expIt = symIt->second.find(expiryDate);
-        if (expIt != symIt->second.end())
-        {
-            return getNextInTimeRange(dateTime, expIt->second).second;
-        }
+        return getNextInTimeRange(dateTime, *timeToEntryMap).second;
     }
     return false; 
 }
 
-const OptionChain& RetrieverInMemory::getRawOptionChain(
+Retriever::OptionChainPtr RetrieverInMemory::getRawOptionChain(
     const std::string& symbol,
     Timestamp dateTime,
     const std::string& expiryDate)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    auto symIt = m_chainData.find(symbol);
-    if (symIt != m_chainData.end())
+    Shard& shard = getShard(symbol);
+    std::lock_guard<std::mutex> lock(shard.m_mutex);
+    const Shard::TimeToEntryMap* timeToEntryMap = shard.find(symbol, expiryDate);
+    if (timeToEntryMap != nullptr)
     {
-        auto expIt = symIt->second.find(expiryDate);
-        if (expIt != symIt->second.end())
+        auto val = getNextInTimeRange(dateTime, *timeToEntryMap);
+        if (val.second)
         {
-            auto val = getNextInTimeRange(dateTime, expIt->second);
-            if (val.second)
+            auto chainIt = timeToEntryMap->find(val.first);
+            if (chainIt != timeToEntryMap->end())
             {
-                auto chainIt = expIt->second.find(val.first);
-                if (chainIt != expIt->second.end())
-                {
-                    return chainIt->second;
-                }
-                throw std::runtime_error(fmt::format("Corrupted data retrieving chain"
-                    " for {:%Y-%m-%d %H:%M:%S} of {} EXP {}",  dateTime, symbol, expiryDate));
+                shard.touch(chainIt->second, ++m_useTick);
+                return chainIt->second.m_chain;
             }
+            throw std::runtime_error(fmt::format("Corrupted data retrieving chain"
+                " for {:%Y-%m-%d %H:%M:%S} of {} EXP {}",  dateTime, symbol, expiryDate));
         }
     }
 
@@ -90,3 +291,14 @@ std::shared_ptr<MarketEnvironment> RetrieverInMemory::getMarketEnvironment(
     throw std::invalid_argument(fmt::format("No market environment data for symbol {}",
         symbol));
 }
+
+std::size_t RetrieverInMemory::size() const
+{
+    std::size_t nChains = 0;
+    for (auto& shard : m_shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->m_mutex);
+        nChains += shard->m_lru.size();
+    }
+    return nChains;
+}
@@ -1,21 +1,48 @@
 #include "bentoclient/threadpool.hpp"
 #include "bentoclient/variadicthreadpool.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <map>
-#include <set>
+#include <mutex>
 #include <fmt/core.h>
 
 using namespace bentoclient;
 
+/// @details Posting and completing jobs is lock-free: job IDs come from an atomic counter,
+/// pending jobs are an atomic count, and each job carries its own completion slot, which
+/// the worker pushes onto a lock-free stack of finished jobs. query() takes over the whole
+/// stack with a single exchange. Workers only touch the condition variable when a query
+/// waits for results. Job lookups by ID are the slow path and serialize on m_mutex.
 class ThreadPool::Impl
 {
+    /// @brief Per-job completion slot, linked into the finished stack once the job ran
+    struct Completion
+    {
+        Completion(JobId id) : m_id(id), m_result(false), m_next(nullptr) {}
+        JobId m_id;
+        Result m_result;
+        Completion* m_next;
+    };
 public:
-    Impl(std::uint64_t nThreads) : 
-    m_pool(nThreads), 
-    m_jobId(0), 
-    m_resultMap{},
-    m_pendingJobs{} 
+    Impl(std::uint64_t nThreads) :
+    m_pool(nThreads),
+    m_jobId(0),
+    m_nPending(0),
+    m_finished(nullptr),
+    m_nWaiters(0),
+    m_nDrained(0),
+    m_drainedResults{},
+    m_consumedBits{},
+    m_consumedBase(1)
     {}
 
+    ~Impl()
+    {
+        m_pool.join();
+        deleteCompletions(m_finished.exchange(nullptr));
+    }
+
     void join()
     {
         m_pool.join();
@@ -23,9 +50,11 @@ public:
 
     JobId post(std::function<void()> job)
     {
-        JobId jobId = getNextJobId();
-        std::function<void()> wrapper = [this, job, jobId](){
-            Result result(false);
+        JobId jobId = m_jobId.fetch_add(1) + 1;
+        Completion* completion = new Completion(jobId);
+        m_nPending.fetch_add(1);
+        m_pool.postNoFuture([this, job = std::move(job), completion](){
+            Result& result = completion->m_result;
             try {
                 job();
             } catch (const std::exception& ex) {
@@ -35,26 +64,24 @@ public:
                 result.m_failed = true;
                 result.m_message = m_genericMessage;
             }
-            this->storeResult(jobId, std::move(result));
-            this->m_condition.notify_all();
-        };
-        pushPending(jobId);
-        m_pool.postNoFuture(wrapper);
+            this->complete(completion);
+        });
         return jobId;
     }
 
     Result query(JobId id)
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        auto it = m_resultMap.find(id);
-        if (it != m_resultMap.end()) {
-        
+        drainFinished();
+        auto it = m_drainedResults.find(id);
+        if (it != m_drainedResults.end()) {
             Result res(std::move(it->second));
-            m_resultMap.erase(it);
+            m_drainedResults.erase(it);
+            m_nDrained.fetch_sub(1);
+            markConsumed(id);
             return res;
         }
-        auto pjIt = m_pendingJobs.find(id);
-        if (pjIt == m_pendingJobs.end()){
+        if (id == 0 || id > m_jobId.load() || isConsumed(id)) {
             throw std::invalid_argument(fmt::format("Invalid JobId {}", id));
         }
         return Result();
@@ -62,54 +89,154 @@ public:
 
     ResultMap query()
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-
-        m_condition.wait(lock, [this](){
-            return !this->m_resultMap.empty() 
-                // Upon notification, lock must be released if other threads
-                // retrieved results and there are no pending jobs.
-                || this->m_pendingJobs.empty();
-        });
-        ResultMap ret;
-        for (auto it = m_resultMap.begin(); it != m_resultMap.end();)
+        while (true)
         {
-            ret.emplace(it->first, std::move(it->second));
-            m_resultMap.erase(it++);
+            Completion* completions = m_finished.exchange(nullptr);
+            // jobs push their completion before leaving the pending count, so after
+            // the count dropped to zero a second exchange catches the last of them
+            bool bIdle = m_nPending.load() == 0;
+            if (completions == nullptr && bIdle) {
+                completions = m_finished.exchange(nullptr);
+            }
+            ResultMap ret;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_drainedResults.empty()) {
+                    m_nDrained.fetch_sub(m_drainedResults.size());
+                    ret.swap(m_drainedResults);
+                }
+                while (completions != nullptr) {
+                    Completion* next = completions->m_next;
+                    ret.emplace(completions->m_id, std::move(completions->m_result));
+                    delete completions;
+                    completions = next;
+                }
+                for (auto& pair : ret) {
+                    markConsumed(pair.first);
+                }
+            }
+            if (!ret.empty() || bIdle) {
+                return ret;
+            }
+            waitForResults();
         }
-        return ret;
     }
 
-    JobId getNextJobId()
+    /// @brief Size of the delivery window above the base
+    std::uint64_t getTrackedIdCount()
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        return ++m_jobId;
+        return m_consumedBits.size() * 64;
     }
 
-    void storeResult(JobId id, Result&& result)
+private:
+    /// @brief Publishes a finished job, called from pool threads
+    void complete(Completion* completion)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        auto pjIt = m_pendingJobs.find(id);
-        if (pjIt != m_pendingJobs.end()) {
-            m_pendingJobs.erase(pjIt);
-        } else {
-            result.m_message =fmt::format("Error corrupted ThreadPool missing pending JobId {}", id);
-            result.m_failed = true;
+        Completion* head = m_finished.load();
+        do {
+            completion->m_next = head;
+        } while (!m_finished.compare_exchange_weak(head, completion));
+        m_nPending.fetch_sub(1);
+        notifyWaiters();
+    }
+
+    /// @brief Wakes up blocked queries, if any
+    void notifyWaiters()
+    {
+        // sequentially consistent with the waiter count increment in waitForResults,
+        // either the waiter sees the new state or this thread sees the waiter
+        if (m_nWaiters.load() > 0) {
+            std::lock_guard<std::mutex> lock(m_waitMutex);
+            m_condition.notify_all();
         }
-        m_resultMap.emplace(id, std::move(result));
     }
-private:
-    void pushPending(JobId id)
+
+    /// @brief Blocks until finished jobs are available or no job is pending
+    void waitForResults()
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_pendingJobs.insert(id);
+        m_nWaiters.fetch_add(1);
+        {
+            std::unique_lock<std::mutex> lock(m_waitMutex);
+            m_condition.wait(lock, [this](){
+                return m_finished.load() != nullptr
+                    || m_nDrained.load() > 0
+                    || m_nPending.load() == 0;
+            });
+        }
+        m_nWaiters.fetch_sub(1);
+    }
+
+    /// @brief Moves the finished stack into m_drainedResults, requires m_mutex
+    void drainFinished()
+    {
+        Completion* completions = m_finished.exchange(nullptr);
+        if (completions == nullptr) {
+            return;
+        }
+        std::size_t nDrained = 0;
+        while (completions != nullptr) {
+            Completion* next = completions->m_next;
+            m_drainedResults.emplace(completions->m_id, std::move(completions->m_result));
+            delete completions;
+            completions = next;
+            ++nDrained;
+        }
+        m_nDrained.fetch_add(nDrained);
+        // results of other jobs left here must not be missed by blocked queries
+        notifyWaiters();
+    }
+
+    /// @brief Records a job ID as delivered, requires m_mutex
+    void markConsumed(JobId id)
+    {
+        std::uint64_t index = id - m_consumedBase;
+        std::size_t word = static_cast<std::size_t>(index / 64);
+        if (word >= m_consumedBits.size()) {
+            m_consumedBits.resize(word + 1, 0);
+        }
+        m_consumedBits[word] |= std::uint64_t(1) << (index % 64);
+        // IDs below the base are all delivered, only the window above needs bits
+        while (!m_consumedBits.empty() && m_consumedBits.front() == ~std::uint64_t(0)) {
+            m_consumedBits.pop_front();
+            m_consumedBase += 64;
+        }
+    }
+
+    /// @brief Checks if a job ID was delivered, requires m_mutex
+    bool isConsumed(JobId id) const
+    {
+        if (id < m_consumedBase) {
+            return true;
+        }
+        std::uint64_t index = id - m_consumedBase;
+        std::size_t word = static_cast<std::size_t>(index / 64);
+        return word < m_consumedBits.size()
+            && (m_consumedBits[word] & (std::uint64_t(1) << (index % 64))) != 0;
+    }
+
+    static void deleteCompletions(Completion* completions)
+    {
+        while (completions != nullptr) {
+            Completion* next = completions->m_next;
+            delete completions;
+            completions = next;
+        }
     }
 
 private:
     VariadicThreadPool m_pool;
-    JobId m_jobId;
-    ResultMap m_resultMap;
-    std::set<JobId> m_pendingJobs;
+    std::atomic<JobId> m_jobId;
+    std::atomic<std::uint64_t> m_nPending;
+    std::atomic<Completion*> m_finished;
+    std::atomic<std::uint64_t> m_nWaiters;
+    std::atomic<std::uint64_t> m_nDrained;
+    // slow path state of job lookups by ID
+    ResultMap m_drainedResults;
+    std::deque<std::uint64_t> m_consumedBits;
+    JobId m_consumedBase;
     std::mutex m_mutex;
+    std::mutex m_waitMutex;
     std::condition_variable m_condition;
 };
 
@@ -139,6 +266,11 @@ ThreadPool::ResultMap ThreadPool::query()
     return m_impl->query();
 }
 
+std::uint64_t ThreadPool::getTrackedIdCount() const
+{
+    return m_impl->getTrackedIdCount();
+}
+
 void ThreadPool::join()
 {
     m_impl->join();
@@ -0,0 +1,188 @@
+#include "bentoclient/workstealingexecutor.hpp"
+#include <boost/log/trivial.hpp>
+#include <algorithm>
+#include <deque>
+#include <random>
+
+using namespace bentoclient;
+
+namespace {
+    /// @brief Executor and queue index of the current worker thread, if any
+    thread_local const WorkStealingExecutor* t_executor = nullptr;
+    thread_local std::size_t t_queueIndex = 0;
+}
+
+/// @brief Task deque of one worker, on its own cache line
+class alignas(64) WorkStealingExecutor::WorkerQueue
+{
+public:
+    void pushBack(Task&& task)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+
+    /// @brief Newest task, for the owning worker
+    bool popBack(Task& task)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_tasks.empty()) {
+            return false;
+        }
+        task = std::move(m_tasks.back());
+        m_tasks.pop_back();
+        return true;
+    }
+
+    /// @brief Oldest task, for thieves
+    bool popFront(Task& task)
+    {
+        // a busy victim is skipped rather than waited for
+        std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+        if (!lock.owns_lock() || m_tasks.empty()) {
+            return false;
+        }
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::deque<Task> m_tasks;
+};
+
+WorkStealingExecutor::WorkStealingExecutor(std::uint64_t nThreads) :
+    m_queues{},
+    m_threads{},
+    m_nQueued(0),
+    m_nOutstanding(0),
+    m_nIdle(0),
+    m_nextQueue(0),
+    m_joining(false)
+{
+    nThreads = std::max<std::uint64_t>(nThreads, 1);
+    for (std::uint64_t i = 0; i < nThreads; ++i)
+    {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (std::size_t i = 0; i < m_queues.size(); ++i)
+    {
+        m_threads.emplace_back([this, i](){ run(i); });
+    }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor()
+{
+    join();
+}
+
+void WorkStealingExecutor::post(Task task)
+{
+    m_nOutstanding.fetch_add(1);
+    // counted ahead of the push, a worker taking the task right away must not wrap the count below zero
+    m_nQueued.fetch_add(1);
+    std::size_t index = t_executor == this
+        ? t_queueIndex
+        : static_cast<std::size_t>(m_nextQueue.fetch_add(1) % m_queues.size());
+    m_queues[index]->pushBack(std::move(task));
+    notifyIdle();
+}
+
+void WorkStealingExecutor::join()
+{
+    std::lock_guard<std::mutex> joinLock(m_joinMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        m_joining.store(true);
+        m_idleCondition.notify_all();
+    }
+    for (auto& thread : m_threads)
+    {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+std::uint64_t WorkStealingExecutor::getThreadCount() const
+{
+    return m_queues.size();
+}
+
+void WorkStealingExecutor::run(std::size_t index)
+{
+    t_executor = this;
+    t_queueIndex = index;
+    Task task;
+    while (true)
+    {
+        if (tryAcquire(index, task)) {
+            m_nQueued.fetch_sub(1);
+            try {
+                task();
+            } catch (const std::exception& e) {
+                BOOST_LOG_TRIVIAL(error) << "WorkStealingExecutor: Task failed: " << e.what();
+            } catch (...) {
+                BOOST_LOG_TRIVIAL(error) << "WorkStealingExecutor: Task failed with unknown exception";
+            }
+            task = nullptr;
+            if (m_nOutstanding.fetch_sub(1) == 1 && m_joining.load()) {
+                std::lock_guard<std::mutex> lock(m_idleMutex);
+                m_idleCondition.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_idleMutex);
+        // sequentially consistent with the queued count increment in post, either the
+        // poster sees this worker idle or this worker sees the queued task
+        m_nIdle.fetch_add(1);
+        m_idleCondition.wait(lock, [this](){
+            return m_nQueued.load() > 0 || isDone();
+        });
+        m_nIdle.fetch_sub(1);
+        if (m_nQueued.load() == 0 && isDone()) {
+            break;
+        }
+    }
+    t_executor = nullptr;
+}
+
+bool WorkStealingExecutor::tryAcquire(std::size_t index, Task& task)
+{
+    if (m_queues[index]->popBack(task)) {
+        return true;
+    }
+    thread_local std::minstd_rand random(static_cast<std::minstd_rand::result_type>(index + 1));
+    std::size_t nQueues = m_queues.size();
+    // sweep until nothing is queued anywhere, thieves may skip locked victims
+    while (nQueues > 1 && m_nQueued.load() > 0)
+    {
+        std::size_t start = random() % nQueues;
+        for (std::size_t i = 0; i < nQueues; ++i)
+        {
+            std::size_t victim = (start + i) % nQueues;
+            if (victim != index && m_queues[victim]->popFront(task)) {
+                return true;
+            }
+        }
+        if (m_queues[index]->popBack(task)) {
+            return true;
+        }
+        std::this_thread::yield();
+    }
+    return false;
+}
+
+void WorkStealingExecutor::notifyIdle()
+{
+    if (m_nIdle.load() > 0) {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        m_idleCondition.notify_one();
+    }
+}
+
+bool WorkStealingExecutor::isDone() const
+{
+    return m_joining.load() && m_nOutstanding.load() == 0;
+}
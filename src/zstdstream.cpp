@@ -0,0 +1,219 @@
+#include "bentoclient/zstdstream.hpp"
+#include <boost/log/trivial.hpp>
+#include <fmt/core.h>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <zstd.h>
+#include <zdict.h>
+
+using namespace bentoclient;
+
+const std::string ZstdStream::m_fileExtension(".zst");
+
+class ZstdStream::Algos
+{
+public:
+    static std::size_t check(std::size_t code, const char* operation)
+    {
+        if (ZSTD_isError(code))
+        {
+            throw std::runtime_error(fmt::format("ZstdStream: {} failed: {}",
+                operation, ZSTD_getErrorName(code)));
+        }
+        return code;
+    }
+};
+
+/// @brief Stream buffer compressing input in chunks into the sink
+class ZstdStream::CompressBuffer : public std::streambuf
+{
+public:
+    CompressBuffer(std::unique_ptr<std::ostream>&& sink, int level,
+        std::shared_ptr<const Dictionary> dictionary) :
+        m_sink(std::move(sink)),
+        m_dictionary(std::move(dictionary)),
+        m_cctx(ZSTD_createCCtx()),
+        m_input(1 << 17),
+        m_output(ZSTD_CStreamOutSize())
+    {
+        if (m_cctx == nullptr)
+        {
+            throw std::runtime_error("ZstdStream: failed to create compression context");
+        }
+        if (m_dictionary)
+        {
+            Algos::check(ZSTD_CCtx_refCDict(m_cctx,
+                static_cast<const ZSTD_CDict*>(m_dictionary->m_cdict)), "referencing dictionary");
+        } else {
+            Algos::check(ZSTD_CCtx_setParameter(m_cctx, ZSTD_c_compressionLevel, level),
+                "setting compression level");
+        }
+        setp(m_input.data(), m_input.data() + m_input.size());
+    }
+    ~CompressBuffer() override
+    {
+        ZSTD_freeCCtx(m_cctx);
+    }
+    /// @brief Compresses pending input and ends the frame
+    void finish()
+    {
+        compress(ZSTD_e_end);
+        m_sink->flush();
+    }
+protected:
+    int_type overflow(int_type ch) override
+    {
+        compress(ZSTD_e_continue);
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+private:
+    void compress(ZSTD_EndDirective mode)
+    {
+        ZSTD_inBuffer input{pbase(), static_cast<std::size_t>(pptr() - pbase()), 0};
+        std::size_t remaining = 0;
+        do {
+            ZSTD_outBuffer output{m_output.data(), m_output.size(), 0};
+            remaining = Algos::check(ZSTD_compressStream2(m_cctx, &output, &input, mode), "compressing");
+            m_sink->write(m_output.data(), static_cast<std::streamsize>(output.pos));
+        } while (mode == ZSTD_e_end ? remaining != 0 : input.pos != input.size);
+        if (!*m_sink)
+        {
+            throw std::runtime_error("ZstdStream: failed to write compressed output");
+        }
+        setp(m_input.data(), m_input.data() + m_input.size());
+    }
+private:
+    std::unique_ptr<std::ostream> m_sink;
+    std::shared_ptr<const Dictionary> m_dictionary;
+    ZSTD_CCtx* m_cctx;
+    std::vector<char> m_input;
+    std::vector<char> m_output;
+};
+
+ZstdStream::Dictionary::Dictionary(const std::string& bytes, int level) :
+    m_bytes(bytes),
+    m_cdict(ZSTD_createCDict(m_bytes.data(), m_bytes.size(), level)),
+    m_ddict(ZSTD_createDDict(m_bytes.data(), m_bytes.size()))
+{
+    if (m_cdict == nullptr || m_ddict == nullptr)
+    {
+        ZSTD_freeCDict(static_cast<ZSTD_CDict*>(m_cdict));
+        ZSTD_freeDDict(static_cast<ZSTD_DDict*>(m_ddict));
+        throw std::invalid_argument("ZstdStream: invalid dictionary");
+    }
+}
+
+ZstdStream::Dictionary::~Dictionary()
+{
+    ZSTD_freeCDict(static_cast<ZSTD_CDict*>(m_cdict));
+    ZSTD_freeDDict(static_cast<ZSTD_DDict*>(m_ddict));
+}
+
+std::shared_ptr<const ZstdStream::Dictionary> ZstdStream::Dictionary::load(const std::string& path, int level)
+{
+    std::ifstream istr(path, std::ios::binary);
+    if (!istr)
+    {
+        throw std::runtime_error("ZstdStream: failed to open dictionary " + path);
+    }
+    std::ostringstream bytes;
+    bytes << istr.rdbuf();
+    return std::make_shared<const Dictionary>(bytes.str(), level);
+}
+
+ZstdStream::ZstdStream(std::unique_ptr<std::ostream>&& sink, int level,
+    std::shared_ptr<const Dictionary> dictionary) :
+    std::ostream(nullptr),
+    m_buffer(std::make_unique<CompressBuffer>(std::move(sink), level, std::move(dictionary)))
+{
+    rdbuf(m_buffer.get());
+}
+
+ZstdStream::~ZstdStream()
+{
+    try {
+        m_buffer->finish();
+    } catch (const std::exception& e) {
+        BOOST_LOG_TRIVIAL(error) << e.what();
+    }
+}
+
+ZstdStream::Outputter ZstdStream::wrapOutputter(Outputter outputter, int level,
+    std::shared_ptr<const Dictionary> dictionary)
+{
+    return [outputter, level, dictionary](const std::string& pathname) -> std::unique_ptr<std::ostream>
+    {
+        return std::make_unique<ZstdStream>(outputter(pathname + m_fileExtension), level, dictionary);
+    };
+}
+
+std::string ZstdStream::trainDictionary(const std::vector<std::string>& samples, std::size_t capacity)
+{
+    std::string concatenated;
+    std::vector<std::size_t> sampleSizes;
+    sampleSizes.reserve(samples.size());
+    for (const auto& sample : samples)
+    {
+        concatenated += sample;
+        sampleSizes.push_back(sample.size());
+    }
+    std::string dictionary(capacity, '\0');
+    std::size_t size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(),
+        concatenated.data(), sampleSizes.data(), static_cast<unsigned>(sampleSizes.size()));
+    if (ZDICT_isError(size))
+    {
+        throw std::invalid_argument(fmt::format("ZstdStream: dictionary training failed: {}",
+            ZDICT_getErrorName(size)));
+    }
+    dictionary.resize(size);
+    return dictionary;
+}
+
+std::string ZstdStream::decompress(const std::string& compressed, const Dictionary* dictionary)
+{
+    std::unique_ptr<ZSTD_DCtx, std::size_t(*)(ZSTD_DCtx*)> dctx(ZSTD_createDCtx(), &ZSTD_freeDCtx);
+    if (!dctx)
+    {
+        throw std::runtime_error("ZstdStream: failed to create decompression context");
+    }
+    if (dictionary != nullptr)
+    {
+        Algos::check(ZSTD_DCtx_refDDict(dctx.get(), static_cast<const ZSTD_DDict*>(dictionary->m_ddict)),
+            "referencing dictionary");
+    }
+    std::string decompressed;
+    std::vector<char> output(ZSTD_DStreamOutSize());
+    ZSTD_inBuffer input{compressed.data(), compressed.size(), 0};
+    std::size_t remaining = 0;
+    bool bOutputFull = false;
+    while (input.pos < input.size || bOutputFull)
+    {
+        ZSTD_outBuffer outBuffer{output.data(), output.size(), 0};
+        remaining = Algos::check(ZSTD_decompressStream(dctx.get(), &outBuffer, &input), "decompressing");
+        decompressed.append(output.data(), outBuffer.pos);
+        bOutputFull = outBuffer.pos == outBuffer.size;
+    }
+    if (remaining != 0)
+    {
+        throw std::runtime_error("ZstdStream: truncated frame");
+    }
+    return decompressed;
+}
+
+bool ZstdStream::isCompressed(const char* bytes, std::size_t size)
+{
+    std::uint32_t magic = 0;
+    if (size < sizeof(magic))
+    {
+        return false;
+    }
+    std::memcpy(&magic, bytes, sizeof(magic));
+    return magic == ZSTD_MAGICNUMBER;
+}
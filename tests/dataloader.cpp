@@ -124,3 +124,35 @@ bentoclient::OptionChain DataLoader::buildOptionChainFromCbboMap(
     return OptionChain::build(std::move(putCallRecords), testInstruments);
 }
 
+bentoclient::OptionChain bentotests::shiftChainTime(const bentoclient::OptionChain& source,
+    bentoclient::Timestamp targetChainTime)
+{
+    OptionChain shiftedChain(source);
+    std::function<int(const OptionChain::Record&)> shifter =
+        [targetChainTime](const OptionChain::Record& record)
+    {
+        auto& nonconstRecord = const_cast<OptionChain::Record&>(record);
+        nonconstRecord.m_recvTime = targetChainTime;
+        return 0;
+    };
+    OptionChain::Util::onAllRecords(shiftedChain, shifter);
+    return shiftedChain;
+}
+
+bentoclient::OptionChain bentotests::shiftChainTime(const bentoclient::OptionChain& source,
+    bentoclient::TimeRange shift)
+{
+    OptionChain shiftedChain(source);
+    std::function<int(const OptionChain::Record&)> shifter =
+        [shift](const OptionChain::Record& record)
+    {
+        auto& nonconstRecord = const_cast<OptionChain::Record&>(record);
+        if (nonconstRecord.m_recvTime != Timestamp{})
+            nonconstRecord.m_recvTime += shift;
+        if (nonconstRecord.m_priceTime != Timestamp{})
+            nonconstRecord.m_priceTime += shift;
+        return 0;
+    };
+    OptionChain::Util::onAllRecords(shiftedChain, shifter);
+    return shiftedChain;
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <databento/symbology.hpp>
 #include <databento/record.hpp>
+#include "bentoclient/clienttypes.hpp"
 #include <list>
 #include <map>
 
@@ -60,4 +61,12 @@ namespace bentotests
     private:
         std::string m_path;
     };
+
+    /// @brief Copy of {source} with all records received at {targetChainTime}
+    bentoclient::OptionChain shiftChainTime(const bentoclient::OptionChain& source,
+        bentoclient::Timestamp targetChainTime);
+
+    /// @brief Copy of {source} with receive and price times of all records moved by {shift}
+    bentoclient::OptionChain shiftChainTime(const bentoclient::OptionChain& source,
+        bentoclient::TimeRange shift);
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bentoclient/batchfilewriter.hpp"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace bc = bentoclient;
+
+namespace {
+    std::string readFile(const std::filesystem::path& path)
+    {
+        std::ifstream istr(path, std::ios::binary);
+        std::ostringstream content;
+        content << istr.rdbuf();
+        return content.str();
+    }
+}
+
+TEST_CASE( "Batch file writer writes files in batches", "[batchfilewriter]" ) {
+    std::filesystem::path basePath = std::filesystem::temp_directory_path() / "bentoclient_testbatchfilewriter";
+    for (bool bIoUring : {true, false})
+    {
+        std::filesystem::remove_all(basePath);
+        {
+            auto writer = bc::BatchFileWriter::create(4, bIoUring);
+            if (!bIoUring)
+            {
+                REQUIRE(!writer->isIoUring());
+            }
+            bc::BatchFileWriter::Outputter outputter = writer->makeOutputter();
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 3; ++t)
+            {
+                threads.emplace_back([&outputter, &basePath, t]() {
+                    for (int i = 0; i < 10; ++i)
+                    {
+                        auto ostr = outputter((basePath / std::to_string(i % 2) /
+                            ("file_" + std::to_string(t) + "_" + std::to_string(i) + ".csv")).string());
+                        *ostr << "thread," << t << "\n" << std::string(1000 * i, 'x');
+                    }
+                });
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            // an empty file and a file waiting for the next batch
+            outputter((basePath / "empty.csv").string());
+            *outputter((basePath / "last.csv").string()) << "last";
+            writer->flush();
+            REQUIRE(readFile(basePath / "last.csv") == "last");
+            REQUIRE(writer->getFailedCount() == 0);
+            // unwritable paths get counted
+            *outputter((basePath / "last.csv" / "sub.csv").string()) << "never";
+            writer->flush();
+            REQUIRE(writer->getFailedCount() == 1);
+        }
+        REQUIRE(std::filesystem::file_size(basePath / "empty.csv") == 0);
+        for (int t = 0; t < 3; ++t)
+        {
+            for (int i = 0; i < 10; ++i)
+            {
+                REQUIRE(readFile(basePath / std::to_string(i % 2) /
+                    ("file_" + std::to_string(t) + "_" + std::to_string(i) + ".csv")) ==
+                    "thread," + std::to_string(t) + "\n" + std::string(1000 * i, 'x'));
+            }
+        }
+    }
+    std::filesystem::remove_all(basePath);
+}
@@ -0,0 +1,63 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bentoclient/cbbocapture.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/optioninstruments.hpp"
+#include "bentoclient/marketenvironment.hpp"
+#include "dataloader.hpp"
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+namespace bc = bentoclient;
+
+TEST_CASE( "CBBO capture round trip and chain rebuild", "[cbbocapture]" ) {
+    bentotests::DataLoader dataLoader;
+    std::string cbboMapFile("QQQ_cbboMap_2025-04-28_exp_2025-04-29.txt");
+    bc::OptionChain::InstrumentIdToCbboMap cbboMap = dataLoader.getMappedCbboMessages(cbboMapFile);
+    bc::OptionInstruments instruments = dataLoader.getOptionInstruments(
+        "QQQ_symbologyResolution_2025-04-28.txt", "QQQ", "2025-04-28", "2025-04-29");
+    const std::map<std::string, std::string>& idToOsi = instruments.getInstrumentIdToOsiMap();
+    bc::Timestamp requestTime = bc::DateUtils::makeTimestamp(2025, 04, 28, 10, 30, 00);
+
+    std::stringstream capture;
+    bc::CbboCapture::write(capture, "QQQ", "2025-04-28", "2025-04-29", requestTime, idToOsi, cbboMap);
+    // raw records are much smaller than text archives
+    REQUIRE(capture.str().size() < std::filesystem::file_size(dataLoader.pathName(cbboMapFile)));
+
+    bc::CbboCapture readCapture = bc::CbboCapture::read(capture);
+    REQUIRE(readCapture.getSymbol() == "QQQ");
+    REQUIRE(readCapture.getValuationDate() == "2025-04-28");
+    REQUIRE(readCapture.getExpiryDate() == "2025-04-29");
+    REQUIRE(readCapture.getRequestTime() == requestTime);
+    REQUIRE(readCapture.getInstrumentIdToOsiMap() == idToOsi);
+    REQUIRE(readCapture.getCbboMap().size() == cbboMap.size());
+    for (auto& cbboPair : cbboMap)
+    {
+        auto& readCbbos = readCapture.getCbboMap().at(cbboPair.first);
+        REQUIRE(readCbbos.size() == cbboPair.second.size());
+        auto readIt = readCbbos.begin();
+        for (auto& cbbo : cbboPair.second)
+        {
+            REQUIRE(std::memcmp(&cbbo, &*readIt++, sizeof(cbbo)) == 0);
+        }
+    }
+    REQUIRE(bc::CbboCapture::makeFileName("QQQ", "2025-04-28", "2025-04-29", requestTime) ==
+        "QQQ_cbbo_2025-04-28_2025-04-29_14-30-00.cbc");
+
+    // the rebuilt chain is the one of the requester
+    bc::MarketEnvironment marketEnvironment(0.04, bc::DateUtils::m_nasdaqClose);
+    bc::OptionChain rebuiltChain = readCapture.buildOptionChain(marketEnvironment);
+    bc::OptionChain expectedChain = dataLoader.buildOptionChainFromCbboMap(
+        "QQQ_symbologyResolution_2025-04-28.txt", "QQQ", "2025-04-28", "2025-04-29", cbboMapFile);
+    REQUIRE(rebuiltChain.isValid());
+    REQUIRE(rebuiltChain.getChainTime() == expectedChain.getChainTime());
+    REQUIRE(rebuiltChain.getPuts() == expectedChain.getPuts());
+    REQUIRE(rebuiltChain.getCalls() == expectedChain.getCalls());
+
+    // torn and foreign files get rejected
+    std::string truncated = capture.str().substr(0, capture.str().size() / 2);
+    std::istringstream truncatedCapture(truncated);
+    REQUIRE_THROWS_AS(bc::CbboCapture::read(truncatedCapture), std::runtime_error);
+    std::istringstream foreignCapture(std::string(sizeof(bc::CbboCapture::Header), 'x'));
+    REQUIRE_THROWS_AS(bc::CbboCapture::read(foreignCapture), std::runtime_error);
+}
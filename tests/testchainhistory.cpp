@@ -0,0 +1,68 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bentoclient/chainhistory.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/optionrecordgapfiller.hpp"
+#include "bentoclient/marketenvironment.hpp"
+#include "dataloader.hpp"
+
+namespace bc = bentoclient;
+
+using bentotests::shiftChainTime;
+
+TEST_CASE( "Compressed chain history", "[chainhistory]" ) {
+    auto marketEnvironment(std::make_shared<bc::MarketEnvironment>(0.04, bc::DateUtils::m_nasdaqClose));
+    bc::OptionChain rawChain =
+        bentotests::DataLoader().buildOptionChain(
+            "SPY_symbology_2025-04-02.txt",
+            "SPY", "2025-04-02", "2025-04-04",
+            "SPY_cbbos_2025-04-02_17-30.txt");
+    REQUIRE(rawChain.isValid());
+    bc::OptionChain filledChain = bc::OptionRecordGapFiller(marketEnvironment).fillGaps(rawChain);
+
+    bc::ChainHistory history;
+    std::vector<bc::OptionChain> chains;
+    for (int i = 0; i < 10; ++i)
+    {
+        const bc::OptionChain& source = i % 2 == 0 ? rawChain : filledChain;
+        chains.push_back(shiftChainTime(source, std::chrono::minutes(i)));
+        history.append(chains.back());
+    }
+    REQUIRE(history.size() == 10);
+    // same key replaces
+    history.append(chains.back());
+    REQUIRE(history.size() == 10);
+
+    std::vector<bc::Timestamp> chainTimes = history.getChainTimes("SPY", "2025-04-04");
+    REQUIRE(chainTimes.size() == 10);
+    REQUIRE(history.getChainTimes("SPY", "2025-04-11").empty());
+    for (std::size_t i = 0; i < chains.size(); ++i)
+    {
+        REQUIRE(chainTimes[i] == chains[i].getChainTime());
+        // single snapshots decode to the chains appended, gap filled prices included
+        bc::OptionChain decoded = history.get("SPY", "2025-04-04", chainTimes[i]);
+        REQUIRE(decoded.getUnderlier() == "SPY");
+        REQUIRE(decoded.getValuationDate() == "2025-04-02");
+        REQUIRE(decoded.getExpiryDate() == "2025-04-04");
+        REQUIRE(decoded.getPuts() == chains[i].getPuts());
+        REQUIRE(decoded.getCalls() == chains[i].getCalls());
+    }
+
+    bc::Timestamp chainTime;
+    REQUIRE(history.find("SPY", chains[3].getChainTime() + std::chrono::seconds(20), "2025-04-04",
+        std::chrono::minutes(1), chainTime));
+    REQUIRE(chainTime == chains[3].getChainTime());
+    REQUIRE(!history.find("SPY", chains[9].getChainTime() + std::chrono::minutes(5), "2025-04-04",
+        std::chrono::minutes(1), chainTime));
+    REQUIRE(!history.find("QQQ", chains[3].getChainTime(), "2025-04-04",
+        std::chrono::minutes(1), chainTime));
+    REQUIRE_THROWS_AS(history.get("SPY", "2025-04-04", chains[3].getChainTime() + std::chrono::seconds(1)),
+        std::out_of_range);
+
+    // far below the size of the record maps, at about 100 bytes per record without map nodes
+    std::size_t nRecords = 0;
+    for (auto& chain : chains)
+    {
+        nRecords += chain.getPuts().size() + chain.getCalls().size();
+    }
+    REQUIRE(history.getMemoryUsage() < nRecords * sizeof(bc::OptionChain::Record) / 3);
+}
@@ -0,0 +1,120 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bentoclient/chainstore.hpp"
+#include "bentoclient/persisterchainstore.hpp"
+#include "bentoclient/retrieverchainstore.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/marketenvironment.hpp"
+#include "dataloader.hpp"
+#include <filesystem>
+#include <fstream>
+
+namespace bc = bentoclient;
+
+using bentotests::shiftChainTime;
+
+TEST_CASE( "Chain store persister and retriever", "[chainstore]" ) {
+    std::filesystem::path storePath = std::filesystem::temp_directory_path() / "bentoclient_testchainstore";
+    std::filesystem::remove_all(storePath);
+    auto timeRange = std::chrono::minutes(10);
+    auto marketEnvironment(std::make_shared<bc::MarketEnvironment>(0.04, bc::DateUtils::m_nasdaqClose));
+    bc::OptionChain optionChain =
+        bentotests::DataLoader().buildOptionChain(
+            "SPY_symbology_2025-04-02.txt",
+            "SPY", "2025-04-02", "2025-04-04",
+            "SPY_cbbos_2025-04-02_17-30.txt");
+    bc::Timestamp testTime = bc::DateUtils::makeTimestamp(2025, 04, 02, 10, 30, 00);
+    bc::OptionChain chain1 = shiftChainTime(optionChain, testTime);
+    bc::OptionChain chain2 = shiftChainTime(optionChain, testTime + std::chrono::minutes(30));
+    {
+        auto chainStore = std::make_shared<bc::ChainStore>(storePath.string());
+        bc::PersisterChainStore persister(chainStore);
+        bc::RetrieverChainStore retriever(timeRange, chainStore);
+        retriever.submitMarketEnvironment("SPY", marketEnvironment);
+        REQUIRE(!retriever.hasOptionChain("SPY", testTime, "2025-04-04"));
+        persister.persist(bc::OptionChain(chain1), marketEnvironment);
+        retriever.submitOptionChain(bc::OptionChain(chain2));
+        REQUIRE(chainStore->size() == 2);
+
+        REQUIRE(retriever.hasOptionChain("SPY", testTime + std::chrono::minutes(5), "2025-04-04"));
+        REQUIRE(!retriever.hasOptionChain("SPY", testTime + std::chrono::minutes(50), "2025-04-04"));
+        REQUIRE(!retriever.hasOptionChain("SPY", testTime, "2025-04-11"));
+        REQUIRE(!retriever.hasOptionChain("QQQ", testTime, "2025-04-04"));
+        auto retrieved1 = retriever.getRawOptionChain("SPY", testTime + std::chrono::minutes(5), "2025-04-04");
+        REQUIRE(retrieved1->getChainTime() == testTime);
+        REQUIRE(retrieved1->getPuts() == chain1.getPuts());
+        REQUIRE(retrieved1->getCalls() == chain1.getCalls());
+        auto retrieved2 = retriever.getRawOptionChain("SPY", testTime + std::chrono::minutes(25), "2025-04-04");
+        REQUIRE(retrieved2->getChainTime() == chain2.getChainTime());
+        REQUIRE_THROWS_AS(retriever.getRawOptionChain("SPY", testTime + std::chrono::minutes(50), "2025-04-04"),
+            std::invalid_argument);
+        // completed chains get filled from the stored raw chain
+        bc::OptionChain filled = retriever.getOptionChain("SPY", testTime, "2025-04-04");
+        REQUIRE(filled.getPuts().size() == 193);
+    }
+    // a reopened store finds chains through its index
+    auto reopenedStore = std::make_shared<bc::ChainStore>(storePath.string());
+    REQUIRE(reopenedStore->size() == 2);
+    bc::RetrieverChainStore reopenedRetriever(timeRange, reopenedStore);
+    auto retrieved = reopenedRetriever.getRawOptionChain("SPY", testTime, "2025-04-04");
+    REQUIRE(retrieved->getPuts() == chain1.getPuts());
+    // chains appended by another writer get visible on lookup
+    {
+        bc::ChainStore writerStore(storePath.string());
+        bc::OptionChain chain3 = shiftChainTime(optionChain, testTime + std::chrono::hours(1));
+        writerStore.append(chain3, bc::BinaryChain::makeSummary(chain3, *marketEnvironment));
+    }
+    REQUIRE(reopenedRetriever.hasOptionChain("SPY", testTime + std::chrono::hours(1), "2025-04-04"));
+    REQUIRE(reopenedRetriever.getRawOptionChain("SPY", testTime + std::chrono::hours(1), "2025-04-04")
+        ->getChainTime() == testTime + std::chrono::hours(1));
+    REQUIRE(reopenedStore->size() == 3);
+    // writers opened at the same time keep each others entries and data offsets
+    {
+        bc::ChainStore writerA(storePath.string());
+        bc::ChainStore writerB(storePath.string());
+        bc::OptionChain chain4 = shiftChainTime(optionChain, testTime + std::chrono::hours(2));
+        bc::OptionChain chain5 = shiftChainTime(optionChain, testTime + std::chrono::hours(3));
+        writerA.append(chain4, bc::BinaryChain::makeSummary(chain4, *marketEnvironment));
+        writerB.append(chain5, bc::BinaryChain::makeSummary(chain5, *marketEnvironment));
+        writerA.append(chain5, bc::BinaryChain::makeSummary(chain5, *marketEnvironment));
+        // replaced keys count once
+        REQUIRE(writerA.size() == 5);
+        REQUIRE(writerB.size() == 5);
+    }
+    bc::ChainStore mergedStore(storePath.string());
+    REQUIRE(mergedStore.size() == 5);
+    for (auto hours : {0, 1, 2, 3})
+    {
+        bc::Timestamp chainTime = testTime + std::chrono::hours(hours);
+        bc::ChainStore::Location location;
+        REQUIRE(mergedStore.find("SPY", chainTime, "2025-04-04", std::chrono::minutes(1), location));
+        bc::OptionChain stored = mergedStore.read(location);
+        REQUIRE(stored.getChainTime() == chainTime);
+        REQUIRE(stored.getPuts() == shiftChainTime(optionChain, chainTime).getPuts());
+    }
+    // an entry whose data got lost doesn't hide the entries appended after it
+    {
+        std::fstream indexFile(storePath / bc::ChainStore::m_indexFileName,
+            std::ios::in | std::ios::out | std::ios::binary);
+        bc::ChainStore::IndexEntry entry;
+        indexFile.seekg(static_cast<std::streamoff>(sizeof(entry)));
+        indexFile.read(reinterpret_cast<char*>(&entry), sizeof(entry));
+        entry.m_offset = std::filesystem::file_size(storePath / bc::ChainStore::m_dataFileName) + 8;
+        indexFile.seekp(static_cast<std::streamoff>(sizeof(entry)));
+        indexFile.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    }
+    {
+        bc::ChainStore writerStore(storePath.string());
+        bc::OptionChain chain6 = shiftChainTime(optionChain, testTime + std::chrono::hours(4));
+        writerStore.append(chain6, bc::BinaryChain::makeSummary(chain6, *marketEnvironment));
+    }
+    bc::ChainStore repairedStore(storePath.string());
+    bc::ChainStore::Location location;
+    REQUIRE(!repairedStore.find("SPY", testTime + std::chrono::minutes(30), "2025-04-04",
+        std::chrono::minutes(1), location));
+    REQUIRE(repairedStore.find("SPY", testTime + std::chrono::hours(4), "2025-04-04",
+        std::chrono::minutes(1), location));
+    REQUIRE(repairedStore.read(location).getChainTime() == testTime + std::chrono::hours(4));
+    REQUIRE(repairedStore.find("SPY", testTime + std::chrono::hours(3), "2025-04-04",
+        std::chrono::minutes(1), location));
+    std::filesystem::remove_all(storePath);
+}
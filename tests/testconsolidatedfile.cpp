@@ -0,0 +1,136 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bentoclient/consolidatedfile.hpp"
+#include "bentoclient/persisterconsolidated.hpp"
+#include "bentoclient/binarychain.hpp"
+#include "bentoclient/csvfromoptionchain.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/marketenvironment.hpp"
+#include "dataloader.hpp"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace bc = bentoclient;
+
+using bentotests::shiftChainTime;
+
+namespace {
+    /// @brief Checks a section against the chain it was written from
+    void checkSection(bc::ConsolidatedFile::Flavour flavour, const std::string& section,
+        const bc::OptionChain& optionChain, std::shared_ptr<bc::MarketEnvironment> marketEnvironment)
+    {
+        if (flavour == bc::ConsolidatedFile::Flavour::CSV)
+        {
+            std::ostringstream expectedCsv;
+            bc::CSVFromOptionChain(marketEnvironment).sideBySide(expectedCsv, optionChain);
+            REQUIRE(section == expectedCsv.str());
+        } else {
+            bc::BinaryChain::Reader reader(std::vector<char>(section.begin(), section.end()));
+            REQUIRE(reader.getChainTime() == optionChain.getChainTime());
+            REQUIRE(reader.toOptionChain().getPuts() == optionChain.getPuts());
+        }
+    }
+}
+
+TEST_CASE( "Consolidated files with index footer", "[consolidatedfile]" ) {
+    std::filesystem::path basePath = std::filesystem::temp_directory_path() / "bentoclient_testconsolidatedfile";
+    auto marketEnvironment(std::make_shared<bc::MarketEnvironment>(0.04, bc::DateUtils::m_nasdaqClose));
+    bc::OptionChain optionChain =
+        bentotests::DataLoader().buildOptionChain(
+            "SPY_symbology_2025-04-02.txt",
+            "SPY", "2025-04-02", "2025-04-04",
+            "SPY_cbbos_2025-04-02_17-30.txt");
+    bc::Timestamp testTime = bc::DateUtils::makeTimestamp(2025, 04, 02, 10, 30, 00);
+    std::vector<bc::OptionChain> chains;
+    for (int i = 0; i < 3; ++i)
+    {
+        chains.push_back(shiftChainTime(optionChain, testTime + std::chrono::minutes(30 * i)));
+    }
+    for (auto flavour : {bc::ConsolidatedFile::Flavour::CSV, bc::ConsolidatedFile::Flavour::Binary})
+    {
+        std::filesystem::remove_all(basePath);
+        std::string path;
+        {
+            bc::PersisterConsolidated persister(basePath.string(), true, flavour,
+                bc::PersisterCSV::CSVFormat::SideBySide);
+            persister.persist(bc::OptionChain(chains[0]), marketEnvironment);
+            persister.persist(bc::OptionChain(chains[1]), marketEnvironment);
+            persister.persistMissing("SPY", "2025-04-02", {{testTime, "2025-04-07"}});
+            persister.persistMissing("SPY", "2025-04-02", {{testTime, "2025-04-08"}});
+            path = persister.getPath("SPY", "2025-04-02");
+        }
+        REQUIRE(path == (basePath / "2025-04-02" / "spy_chains_2025-04-02").string() +
+            (flavour == bc::ConsolidatedFile::Flavour::CSV ? ".csv" : ".bcd"));
+        {
+            std::ifstream missing(basePath / "2025-04-02" / "spy_missing_2025-04-02.txt");
+            std::string line1, line2;
+            REQUIRE(std::getline(missing, line1));
+            REQUIRE(std::getline(missing, line2));
+            REQUIRE(line1.substr(line1.size() - 14) == "EXP 2025-04-07");
+            REQUIRE(line2.substr(line2.size() - 14) == "EXP 2025-04-08");
+        }
+        {
+            bc::ConsolidatedFile file(path);
+            REQUIRE(file.getFlavour() == flavour);
+            REQUIRE(file.hasFooter());
+            REQUIRE(file.getLocations().at("2025-04-04").size() == 2);
+            bc::ConsolidatedFile::Location location;
+            REQUIRE(!file.find("2025-04-11", testTime, std::chrono::minutes(10), location));
+            REQUIRE(!file.find("2025-04-04", testTime + std::chrono::minutes(15), std::chrono::minutes(10), location));
+            REQUIRE(file.find("2025-04-04", testTime + std::chrono::minutes(25), std::chrono::minutes(10), location));
+            checkSection(flavour, file.read(location), chains[1], marketEnvironment);
+        }
+        // a later run appends to the same file
+        {
+            bc::PersisterConsolidated persister(basePath.string(), true, flavour,
+                bc::PersisterCSV::CSVFormat::SideBySide);
+            persister.persist(bc::OptionChain(chains[2]), marketEnvironment);
+        }
+        bc::ConsolidatedFile::Location last;
+        {
+            bc::ConsolidatedFile file(path);
+            REQUIRE(file.hasFooter());
+            REQUIRE(file.getLocations().at("2025-04-04").size() == 3);
+            bc::ConsolidatedFile::Location location;
+            REQUIRE(file.find("2025-04-04", testTime, std::chrono::minutes(10), location));
+            checkSection(flavour, file.read(location), chains[0], marketEnvironment);
+            last = file.getLocations().at("2025-04-04").rbegin()->second;
+            checkSection(flavour, file.read(last), chains[2], marketEnvironment);
+        }
+        // without footer, e.g. after a crash, the index gets rebuilt from the sections
+        std::filesystem::resize_file(path, last.m_offset + last.m_size + 1);
+        {
+            bc::ConsolidatedFile file(path);
+            REQUIRE(!file.hasFooter());
+            REQUIRE(file.getLocations().at("2025-04-04").size() == 3);
+            checkSection(flavour, file.read(file.getLocations().at("2025-04-04").rbegin()->second),
+                chains[2], marketEnvironment);
+        }
+        // a torn last section gets dropped on appending
+        std::filesystem::resize_file(path, last.m_offset + last.m_size - 1);
+        {
+            bc::ConsolidatedFile::Writer writer(path, flavour);
+            REQUIRE(writer.size() == 2);
+            std::ostringstream section;
+            if (flavour == bc::ConsolidatedFile::Flavour::CSV)
+            {
+                bc::CSVFromOptionChain(marketEnvironment).sideBySide(section, chains[2]);
+            } else {
+                bc::BinaryChain::write(section, chains[2], bc::BinaryChain::makeSummary(chains[2], *marketEnvironment));
+            }
+            writer.append("2025-04-04", chains[2].getChainTime(), section.str());
+        }
+        {
+            bc::ConsolidatedFile file(path);
+            REQUIRE(file.hasFooter());
+            REQUIRE(file.getLocations().at("2025-04-04").size() == 3);
+            checkSection(flavour, file.read(file.getLocations().at("2025-04-04").rbegin()->second),
+                chains[2], marketEnvironment);
+        }
+    }
+    // flavours don't mix
+    REQUIRE_THROWS_AS(bc::ConsolidatedFile::Writer(
+        (basePath / "2025-04-02" / "spy_chains_2025-04-02.bcd").string(), bc::ConsolidatedFile::Flavour::CSV),
+        std::runtime_error);
+    std::filesystem::remove_all(basePath);
+}
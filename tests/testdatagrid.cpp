@@ -181,3 +181,38 @@ TEST_CASE( "Data grid operations", "[datagrid]" ) {
 }
 
 
+
+TEST_CASE( "Timestamp format in local time zones", "[datagrid]" ) {
+    namespace bc = bentoclient;
+    auto formatNyc = [](const std::string& fmt, const bc::Timestamp& timestamp)
+    {
+        bc::DataGrid::TimestampFormatSeconds format(fmt, bc::DateUtils::Timezone::m_NYC);
+        return format.formatCell(bc::DataGrid::GenericCell<bc::Timestamp>(timestamp));
+    };
+    // winter and summer time, fractional seconds truncated
+    bc::Timestamp winter = bc::DateUtils::makeTimestampZulu(2025, 1, 2, 3, 4, 5) 
+        + std::chrono::milliseconds(999);
+    REQUIRE(formatNyc(bc::DataGrid::m_defaultTimestampFormat, winter) == "2025-01-01 22:04:05");
+    REQUIRE(formatNyc(bc::DataGrid::m_defaultDateFormat, winter) == "2025-01-01");
+    REQUIRE(formatNyc(bc::DataGrid::m_defaultTimeFormat, winter) == "22:04:05");
+    bc::Timestamp summer = bc::DateUtils::makeTimestampZulu(2025, 7, 1, 13, 30, 9);
+    REQUIRE(formatNyc(bc::DataGrid::m_defaultTimestampFormat, summer) == "2025-07-01 09:30:09");
+    // within the day of a DST transition, offsets change at 2am local time
+    bc::Timestamp beforeDst = bc::DateUtils::makeTimestampZulu(2024, 3, 10, 6, 59, 59);
+    REQUIRE(formatNyc(bc::DataGrid::m_defaultTimestampFormat, beforeDst) == "2024-03-10 01:59:59");
+    REQUIRE(formatNyc(bc::DataGrid::m_defaultTimestampFormat, beforeDst + std::chrono::seconds(1)) 
+        == "2024-03-10 03:00:00");
+    REQUIRE(bc::DateUtils::makeTimestamp("2024-03-10", "03:00:00") == beforeDst + std::chrono::seconds(1));
+    REQUIRE(bc::DateUtils::makeTimestamp("2024-11-03", "12:00:00") 
+        == bc::DateUtils::makeTimestampZulu(2024, 11, 3, 17, 0, 0));
+    // other formats than defaults
+    REQUIRE(formatNyc("%d.%m.%Y", summer) == "01.07.2025");
+    bc::DateUtils::CivilTime civilTime = bc::DateUtils::toCivilTime(
+        bc::DateUtils::makeTimestampZulu(2000, 2, 29, 23, 59, 58));
+    REQUIRE(civilTime.m_year == 2000);
+    REQUIRE(civilTime.m_month == 2);
+    REQUIRE(civilTime.m_day == 29);
+    REQUIRE(civilTime.m_hour == 23);
+    REQUIRE(civilTime.m_minute == 59);
+    REQUIRE(civilTime.m_second == 58);
+}
@@ -1,6 +1,8 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
 #include "bentoclient/marketenvironmentextended.hpp"
+#include <filesystem>
+#include <fstream>
 
 namespace bc = bentoclient;
 
@@ -10,7 +12,8 @@ TEST_CASE( "Marketenvironment extended yield curve loading", "[yieldcurve]" ) {
     bc::Timestamp valuationTime = bc::DateUtils::makeTimestampZulu("2024-02-03");
     bc::Timestamp expiryTime = bc::DateUtils::makeTimestampZulu("2024-10-03");
     double fRate = me.getRiskFreeRate(valuationTime, expiryTime);
-    REQUIRE(fRate == Catch::Approx(0.051530415772052848).epsilon(1e-9));
+    // 8 months tenor interpolated in between 6 months and 1 year rates
+    REQUIRE(fRate == Catch::Approx(0.049996240309139094).epsilon(1e-9));
     expiryTime = bc::DateUtils::makeTimestampZulu("2024-02-04");
     fRate = me.getRiskFreeRate(valuationTime, expiryTime);
     REQUIRE(fRate == Catch::Approx(0.054160008807484304).epsilon(1e-9));
@@ -26,7 +29,7 @@ TEST_CASE( "Marketenvironment extended yield curve loading", "[yieldcurve]" ) {
     expiryTime = bc::DateUtils::makeTimestampZulu("2025-06-04");
     // takes last yield curve in me
     fRate = me.getRiskFreeRate(valuationTime, expiryTime);
-    REQUIRE(fRate == Catch::Approx(0.042740051472385091).epsilon(1e-9));
+    REQUIRE(fRate == Catch::Approx(0.04275105139926752).epsilon(1e-9));
     // takes first yield curve in me
     valuationTime = bc::DateUtils::makeTimestampZulu("2023-02-03");
     expiryTime = bc::DateUtils::makeTimestampZulu("2023-02-04");
@@ -40,11 +43,68 @@ TEST_CASE( "Marketenvironment extended yield curve loading", "[yieldcurve]" ) {
     expiryTime = bc::DateUtils::makeTimestampZulu("2025-03-18");
     fRate = me2.getRiskFreeRate(valuationTime, expiryTime);
     // in this case, since 1.5 Month is filled only from 2025-02-18, get
-    // a result based on 1 Month rate.
-    REQUIRE(fRate == Catch::Approx(0.043229419944815856).epsilon(1e-9));
+    // a result interpolated in between 1 Month and 2 Month rates.
+    REQUIRE(fRate == Catch::Approx(0.043279603047401159).epsilon(1e-9));
     valuationTime = bc::DateUtils::makeTimestampZulu("2025-02-18");
     expiryTime = bc::DateUtils::makeTimestampZulu("2025-04-02");
     fRate = me2.getRiskFreeRate(valuationTime, expiryTime);
-    // Now, result on 1.5 Month rate.
-    REQUIRE(fRate == Catch::Approx(0.043620828527698212).epsilon(1e-9));
-}
\ No newline at end of file
+    // Now, result interpolated in between 1 Month and 1.5 Month rates.
+    REQUIRE(fRate == Catch::Approx(0.043604514592382571).epsilon(1e-9));
+}
+
+TEST_CASE( "Marketenvironment extended yield curve cache", "[yieldcurve]" ) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "bentoclient_yieldcurve_cache";
+    std::filesystem::create_directories(dir);
+    std::string csv = (dir / "TSY.2025-06-06.csv").string();
+    std::filesystem::copy_file("./tests/data/TSY.2025-06-06.csv", csv,
+        std::filesystem::copy_options::overwrite_existing);
+    std::string cacheDir = (dir / "cache").string();
+    std::string cachePath = bc::MarketEnvironmentExtended::getCachePath(csv, cacheDir);
+    REQUIRE(std::filesystem::path(cachePath).parent_path() == std::filesystem::path(cacheDir));
+    REQUIRE(cachePath != bc::MarketEnvironmentExtended::getCachePath(
+        "./tests/data/TSY.2025-06-06.csv", cacheDir));
+    // caching is opt-in
+    bc::MarketEnvironmentExtended uncached(0.04, bc::DateUtils::m_nasdaqClose, csv);
+    REQUIRE(!std::filesystem::exists(cacheDir));
+    bc::MarketEnvironmentExtended fromCsv(0.04, bc::DateUtils::m_nasdaqClose, csv, cacheDir);
+    REQUIRE(std::filesystem::exists(cachePath));
+    REQUIRE(!std::filesystem::exists(csv + bc::MarketEnvironmentExtended::m_cacheExtension));
+    // with the CSV gone, the cache has all yield curves
+    std::filesystem::remove(csv);
+    bc::MarketEnvironmentExtended fromCache(0.04, bc::DateUtils::m_nasdaqClose, csv, cacheDir);
+    REQUIRE(fromCache.getYieldCurveMap().size() == 108);
+    REQUIRE(fromCache.getYieldCurveMap() == fromCsv.getYieldCurveMap());
+    bc::Timestamp valuationTime = bc::DateUtils::makeTimestampZulu("2025-02-18");
+    for (const char* expiry : {"2025-02-19", "2025-04-02", "2026-01-16", "2035-04-02"})
+    {
+        bc::Timestamp expiryTime = bc::DateUtils::makeTimestampZulu(expiry);
+        REQUIRE(fromCache.getRiskFreeRate(valuationTime, expiryTime) 
+            == fromCsv.getRiskFreeRate(valuationTime, expiryTime));
+    }
+    REQUIRE(uncached.getYieldCurveMap() == fromCsv.getYieldCurveMap());
+    std::filesystem::remove_all(dir);
+}
+TEST_CASE( "Marketenvironment extended yield curve without rates", "[yieldcurve]" ) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "bentoclient_yieldcurve_empty";
+    std::filesystem::create_directories(dir);
+    std::string csv = (dir / "TSY.empty.csv").string();
+    bc::Timestamp valuationTime = bc::DateUtils::makeTimestampZulu("2025-06-05");
+    bc::Timestamp expiryTime = bc::DateUtils::makeTimestampZulu("2025-07-05");
+    {
+        std::ofstream ofs(csv);
+        ofs << "Date,\"1 Mo\",\"2 Mo\",\"3 Mo\"\n"
+            << "06/06/2025,N/A,N/A,N/A\n";
+    }
+    // a curve of only blank rates falls back to the default rate
+    bc::MarketEnvironmentExtended blank(0.04, bc::DateUtils::m_nasdaqClose, csv, (dir / "cache").string());
+    REQUIRE(blank.getYieldCurveMap().empty());
+    REQUIRE(blank.getRiskFreeRate(valuationTime, expiryTime) == 0.04);
+    {
+        std::ofstream ofs(csv, std::ios::app);
+        ofs << "06/05/2025,4.28,4.35,4.43\n";
+    }
+    bc::MarketEnvironmentExtended partial(0.04, bc::DateUtils::m_nasdaqClose, csv);
+    REQUIRE(partial.getYieldCurveMap().size() == 1);
+    REQUIRE(partial.getRiskFreeRate(valuationTime, expiryTime) != 0.04);
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,147 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "bentoclient/optionanalytics.hpp"
+#include "bentoclient/csvfromoptionchain.hpp"
+#include "bentoclient/optionrecordgapfiller.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/osioption.hpp"
+#include "bentoclient/apputils.hpp"
+#include "dataloader.hpp"
+#include <cmath>
+#include <vector>
+
+namespace bc = bentoclient;
+
+static bc::OptionChain fillAnalyticsChain(std::shared_ptr<bc::MarketEnvironment> marketEnvironment)
+{
+    bc::OptionChain optionChain =
+        bentotests::DataLoader().buildOptionChain(
+            "SPY_symbology_2025-04-02.txt",
+            "SPY", "2025-04-02", "2025-04-04",
+            "SPY_cbbos_2025-04-02_17-30.txt");
+    REQUIRE( optionChain.getPuts().size() == 193 );
+    bc::OptionRecordGapFiller gapFiller(marketEnvironment);
+    return gapFiller.fillGaps(optionChain);
+}
+
+TEST_CASE( "Implied volatility round trip", "[optionanalytics]" ) {
+    bc::OptionAnalytics::Parameters parameters{560.0, 0.04, 30.0 / 365.25};
+    std::vector<double> strikes;
+    std::vector<double> volatilities;
+    for (double fStrike = 450.0; fStrike <= 670.0; fStrike += 5.0)
+    {
+        strikes.push_back(fStrike);
+        // a skew from 35% on low strikes to 15% on high strikes
+        volatilities.push_back(0.35 - 0.2 * (fStrike - 450.0) / 220.0);
+    }
+    std::size_t n = strikes.size();
+    for (bool bCall : {true, false})
+    {
+        std::vector<double> prices(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            prices[i] = bc::OptionAnalytics::price(parameters, strikes[i], volatilities[i], bCall);
+        }
+        std::vector<double> implied(n);
+        bc::OptionAnalytics::impliedVolatilities(parameters, strikes.data(), prices.data(),
+            bCall, implied.data(), n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (prices[i] > 1e-3)
+            {
+                // far out of the money vega is tiny, so the round trip is also checked in price space
+                double fRepriced = bc::OptionAnalytics::price(parameters, strikes[i], implied[i], bCall);
+                REQUIRE( std::abs(fRepriced - prices[i]) < 1e-6 );
+                REQUIRE( std::abs(implied[i] - volatilities[i]) < 1e-6 );
+            }
+        }
+    }
+    // prices below intrinsic value imply no volatility
+    double fStrike = 500.0;
+    double fPrice = 1.0;
+    double fImplied = 0.0;
+    bc::OptionAnalytics::impliedVolatilities(parameters, &fStrike, &fPrice, true, &fImplied, 1);
+    REQUIRE( std::isnan(fImplied) );
+}
+
+TEST_CASE( "Greeks on option chain", "[optionanalytics]" ) {
+    auto marketEnvironment(std::make_shared<bc::MarketEnvironment>(0.04, bc::DateUtils::m_nasdaqClose));
+    bc::OptionChain filled = fillAnalyticsChain(marketEnvironment);
+    bc::OptionAnalytics analytics(marketEnvironment);
+    bc::OptionAnalytics::PutCallGreeksMap greeks = analytics.compute(filled);
+    REQUIRE( !greeks.first.empty() );
+    REQUIRE( !greeks.second.empty() );
+    std::size_t nImplied = 0;
+    for (auto& pair : greeks.second)
+    {
+        const bc::OptionAnalytics::Greeks& callGreeks = pair.second;
+        if (std::isnan(callGreeks.m_impliedVolatility))
+        {
+            continue;
+        }
+        ++nImplied;
+        REQUIRE( callGreeks.m_impliedVolatility > 0.0 );
+        REQUIRE( callGreeks.m_delta > 0.0 );
+        REQUIRE( callGreeks.m_delta < 1.0 );
+        REQUIRE( callGreeks.m_gamma >= 0.0 );
+        REQUIRE( callGreeks.m_vega >= 0.0 );
+        auto putIt = greeks.first.find(pair.first);
+        if (putIt != greeks.first.end() && !std::isnan(putIt->second.m_impliedVolatility))
+        {
+            REQUIRE( putIt->second.m_delta < 0.0 );
+            REQUIRE( putIt->second.m_delta > -1.0 );
+        }
+    }
+    REQUIRE( nImplied > 50 );
+    // at the money volatility of SPY in April 2025 was far above 5% and below 200%
+    bc::OptionAnalytics::Parameters parameters = analytics.getParameters(filled);
+    auto atmIt = greeks.second.lower_bound(bc::OsiOption::toStrikeKey(std::round(parameters.m_underlierPrice)));
+    REQUIRE( atmIt != greeks.second.end() );
+    REQUIRE( atmIt->second.m_impliedVolatility > 0.05 );
+    REQUIRE( atmIt->second.m_impliedVolatility < 2.0 );
+}
+
+TEST_CASE( "CSV with Greeks", "[optionanalytics]" ) {
+    auto marketEnvironment(std::make_shared<bc::MarketEnvironment>(0.04, bc::DateUtils::m_nasdaqClose));
+    bc::OptionChain filled = fillAnalyticsChain(marketEnvironment);
+    bc::CSVFromOptionChain toCSV(marketEnvironment, true);
+    std::ostringstream sideBySide;
+    toCSV.sideBySide(sideBySide, filled);
+    std::vector<std::string> lines = bc::AppUtils::splitByLinefeed(sideBySide.str());
+    std::string expectedHeadersEnd = "Precision,C_IV,C_Delta,C_Gamma,C_Vega,C_Theta,"
+        "P_IV,P_Delta,P_Gamma,P_Vega,P_Theta";
+    REQUIRE( lines.at(0).size() > expectedHeadersEnd.size() );
+    REQUIRE( lines.at(0).substr(lines.at(0).size() - expectedHeadersEnd.size()) == expectedHeadersEnd );
+    REQUIRE( lines.size() >= 194 );
+
+    std::ostringstream stacked;
+    toCSV.stacked(stacked, filled);
+    lines = bc::AppUtils::splitByLinefeed(stacked.str());
+    expectedHeadersEnd = "Precision,IV,Delta,Gamma,Vega,Theta";
+    REQUIRE( lines.at(0).substr(lines.at(0).size() - expectedHeadersEnd.size()) == expectedHeadersEnd );
+    REQUIRE( lines.size() >= 387 );
+}
+
+TEST_CASE( "Implied volatility benchmark", "[.][benchmark][optionanalytics]" ) {
+    bc::OptionAnalytics::Parameters parameters{5000.0, 0.04, 45.0 / 365.25};
+    const std::size_t n = 8192;
+    std::vector<double> strikes(n);
+    std::vector<double> prices(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        strikes[i] = 3000.0 + 4000.0 * static_cast<double>(i) / n;
+        prices[i] = bc::OptionAnalytics::price(parameters, strikes[i], 0.2, true);
+    }
+    std::vector<double> volatilities(n);
+    std::vector<bc::OptionAnalytics::Greeks> greeks(n);
+    BENCHMARK("implied volatilities") {
+        bc::OptionAnalytics::impliedVolatilities(parameters, strikes.data(), prices.data(),
+            true, volatilities.data(), n);
+        return volatilities[n / 2];
+    };
+    BENCHMARK("greeks") {
+        bc::OptionAnalytics::computeGreeks(parameters, strikes.data(), volatilities.data(),
+            true, greeks.data(), n);
+        return greeks[n / 2].m_delta;
+    };
+}
@@ -1,7 +1,10 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include "bentoclient/optionchain.hpp"
+#include "bentoclient/optionanalytics.hpp"
 #include "bentoclient/optioninstruments.hpp"
+#include "bentoclient/osioption.hpp"
 #include "bentoclient/apputils.hpp"
 #include "bentoclient/dateutils.hpp"
 #include "dataloader.hpp"
@@ -9,6 +12,51 @@
 
 namespace bc = bentoclient;
 
+namespace {
+    typedef std::list<std::pair<double, double>> FitPoints;
+    // the node based parity computation the array kernels replace
+    FitPoints parityRatesByStrike(const bc::OptionChain& optionChain, double discountFactor)
+    {
+        std::function<double(const bc::OptionChain::RecordMap::value_type&, 
+            const bc::OptionChain::RecordMap::value_type&)> parityRate =
+            bc::OptionChain::Util::PutCallParityRate(discountFactor);
+        auto parityRates = bc::OptionChain::Util::onAllPutCallRecords(optionChain, parityRate);
+        FitPoints points;
+        for (auto& pair : parityRates) {
+            points.emplace_back(bc::OsiOption::fromStrikeKey(pair.first), pair.second);
+        }
+        return points;
+    }
+    double nodeBasedQualityScore(const bc::OptionChain& optionChain, double discountFactor)
+    {
+        FitPoints points = parityRatesByStrike(optionChain, discountFactor);
+        return bc::OptionChain::Util::computeVarianceAlongFittedLine(points,
+            bc::OptionChain::Util::fitLeastSquaresLine(points));
+    }
+    double arrayBasedQualityScore(const bc::OptionChain& optionChain, double discountFactor)
+    {
+        bc::OptionChain::Util::ParitySeries series = bc::OptionChain::Util::makeParitySeries(optionChain);
+        std::vector<double> parityRates(series.size());
+        bc::OptionChain::Util::computeParityRates(series.m_strikes.data(), series.m_putPrices.data(),
+            series.m_callPrices.data(), discountFactor, parityRates.data(), series.size());
+        auto line = bc::OptionChain::Util::fitLeastSquaresLine(
+            series.m_strikes.data(), parityRates.data(), series.size());
+        return bc::OptionChain::Util::computeVarianceAlongFittedLine(
+            series.m_strikes.data(), parityRates.data(), series.size(), line);
+    }
+    std::list<bc::OptionChain> loadKernelFixtures()
+    {
+        std::list<bc::OptionChain> chains;
+        chains.push_back(bentotests::DataLoader().buildOptionChain(
+            "SPY_symbology_2025-04-02.txt", "SPY", "2025-04-02", "2025-04-04",
+            "SPY_cbbos_2025-04-02_17-30.txt"));
+        chains.push_back(bentotests::DataLoader().buildOptionChainFromCbboMap(
+            "QQQ_symbologyResolution_2025-04-28.txt", "QQQ", "2025-04-28", "2025-04-30",
+            "QQQ_cbboMap_2025-04-28_exp_2025-04-30.txt"));
+        return chains;
+    }
+}
+
 TEST_CASE( "Build Option Chain", "[buildoptionchain]" ) {
     // Check operator == for Records
     bc::OptionChain::Record rA{}, rB{};
@@ -118,6 +166,16 @@ TEST_CASE( "Build Option Chain", "[buildoptionchain]" ) {
     double parityVariance = optionChain.getParityRateQualityScore(
         fContinuousRate, bc::DateUtils::m_nasdaqClose);
     REQUIRE( parityVariance == Catch::Approx(0.0019996671612625434) ); 
+    // memoized metrics are keyed by rate and survive moves, copies recompute them
+    REQUIRE( optionChain.getParityRate(fContinuousRate, bc::DateUtils::m_nasdaqClose) == avg4Parity );
+    REQUIRE( optionChain.getParityRate(0.0, bc::DateUtils::m_nasdaqClose) != avg4Parity );
+    bc::OptionChain movedChain(std::move(optionChain));
+    REQUIRE( movedChain.getChainTime() == chainTime );
+    REQUIRE( movedChain.getParityRateQualityScore(
+        fContinuousRate, bc::DateUtils::m_nasdaqClose) == parityVariance );
+    bc::OptionChain copiedChain(movedChain);
+    REQUIRE( copiedChain.getChainTime() == chainTime );
+    REQUIRE( copiedChain.getParityRate(fContinuousRate, bc::DateUtils::m_nasdaqClose) == avg4Parity );
 }
 
 
@@ -204,3 +262,181 @@ TEST_CASE( "Build QQQ Option Chain exp 2025-05-01 from cbboMap", "[qqq0501mapbui
     REQUIRE( optionChain.getMissingInstrumentIdToOsiMap().size() == 0 );
     
 }
+
+TEST_CASE( "Parity kernels match node based computations", "[paritykernels]" ) {
+    double fContinuousRate = 0.05;
+    for (auto& optionChain : loadKernelFixtures()) {
+        double discountFactor = bc::OptionChain::Util::getDiscountFactor(
+            optionChain, fContinuousRate, bc::DateUtils::m_nasdaqClose);
+        FitPoints points = parityRatesByStrike(optionChain, discountFactor);
+        bc::OptionChain::Util::ParitySeries series = bc::OptionChain::Util::makeParitySeries(optionChain);
+        REQUIRE( series.size() == points.size() );
+        std::vector<double> parityRates(series.size());
+        bc::OptionChain::Util::computeParityRates(series.m_strikes.data(), series.m_putPrices.data(),
+            series.m_callPrices.data(), discountFactor, parityRates.data(), series.size());
+        std::size_t i = 0;
+        for (auto& point : points) {
+            REQUIRE( series.m_strikes[i] == point.first );
+            REQUIRE( parityRates[i] == point.second );
+            ++i;
+        }
+        auto nodeLine = bc::OptionChain::Util::fitLeastSquaresLine(points);
+        auto arrayLine = bc::OptionChain::Util::fitLeastSquaresLine(
+            series.m_strikes.data(), parityRates.data(), series.size());
+        REQUIRE( arrayLine.first == Catch::Approx(nodeLine.first).epsilon(1e-9) );
+        REQUIRE( arrayLine.second == Catch::Approx(nodeLine.second).epsilon(1e-9) );
+        REQUIRE( arrayBasedQualityScore(optionChain, discountFactor) 
+            == Catch::Approx(nodeBasedQualityScore(optionChain, discountFactor)).epsilon(1e-6) );
+    }
+    // kernels handle lengths that aren't a multiple of the lane count
+    std::vector<double> x{1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0};
+    std::vector<double> y{3.0, 5.0, 7.0, 9.0, 11.0, 13.0, 15.0};
+    auto line = bc::OptionChain::Util::fitLeastSquaresLine(x.data(), y.data(), x.size());
+    REQUIRE( line.first == Catch::Approx(2.0) );
+    REQUIRE( line.second == Catch::Approx(1.0) );
+    REQUIRE( bc::OptionChain::Util::computeVarianceAlongFittedLine(
+        x.data(), y.data(), x.size(), line) == Catch::Approx(0.0).margin(1e-12) );
+    REQUIRE_THROWS_AS( bc::OptionChain::Util::fitLeastSquaresLine(x.data(), y.data(), 1),
+        std::invalid_argument );
+}
+
+TEST_CASE( "Parity kernels benchmark", "[.][benchmark][paritykernels]" ) {
+    double fContinuousRate = 0.05;
+    for (auto& optionChain : loadKernelFixtures()) {
+        double discountFactor = bc::OptionChain::Util::getDiscountFactor(
+            optionChain, fContinuousRate, bc::DateUtils::m_nasdaqClose);
+        std::string sName = optionChain.getUnderlier() + " " + optionChain.getExpiryDate();
+        BENCHMARK( "node based quality score " + sName ) {
+            return nodeBasedQualityScore(optionChain, discountFactor);
+        };
+        BENCHMARK( "array kernel quality score " + sName ) {
+            return arrayBasedQualityScore(optionChain, discountFactor);
+        };
+    }
+}
+
+TEST_CASE( "Delta shift of stale records along parity underlier path", "[deltashift]" ) {
+    bentotests::DataLoader dataLoader;
+    bc::OptionInstruments instruments = dataLoader.getOptionInstruments(
+        "QQQ_symbologyResolution_2025-04-28.txt", "QQQ", "2025-04-28", "2025-04-30");
+    std::map<std::string, std::string> idToOsi = instruments.getInstrumentIdToOsiMap();
+    bc::OptionChain::RecordTimeline timeline = bc::OptionChain::buildRecordTimeline(
+        dataLoader.getMappedCbboMessages("QQQ_cbboMap_2025-04-28_exp_2025-04-30.txt"),
+        idToOsi, std::chrono::seconds(2));
+    bc::OptionChain rawChain = bc::OptionChain::build(
+        bc::OptionChain::mapLatestBestInTimelineToRecord(timeline), instruments);
+    double discountFactor = bc::OptionChain::Util::getDiscountFactor(rawChain, 0.04);
+    bc::OptionChain::UnderlierPath underlierPath =
+        bc::OptionChain::estimateUnderlierPath(timeline, discountFactor);
+    REQUIRE( !underlierPath.empty() );
+    // the path ends close to the parity rate of the chain built from latest records
+    double parityRate = rawChain.getParityRate(0.04);
+    REQUIRE( underlierPath.rbegin()->second == Catch::Approx(parityRate).epsilon(0.01) );
+    for (auto& pathPair : underlierPath) {
+        REQUIRE( pathPair.second == Catch::Approx(parityRate).epsilon(0.05) );
+    }
+
+    bc::OptionChain shiftedChain(rawChain);
+    std::size_t nShifted = shiftedChain.shiftStaleRecords(underlierPath, std::chrono::seconds(10));
+    bc::Timestamp chainTime = rawChain.getChainTime();
+    std::size_t nComments = 0;
+    for (auto side : {&bc::OptionChain::getPuts, &bc::OptionChain::getCalls}) {
+        const bc::OptionChain::RecordMap& before = (rawChain.*side)();
+        const bc::OptionChain::RecordMap& after = (shiftedChain.*side)();
+        REQUIRE( before.size() == after.size() );
+        for (auto& pair : after) {
+            const bc::OptionChain::Record& original = before.at(pair.first);
+            if (pair.second.m_comment != bc::OptionChain::m_deltaShiftComment) {
+                REQUIRE( pair.second == original );
+                continue;
+            }
+            ++nComments;
+            REQUIRE( original.m_recvTime + std::chrono::seconds(10) < chainTime );
+            REQUIRE( pair.second.m_recvTime == chainTime );
+            REQUIRE( pair.second.getBidPrice() >= 0.0 );
+            REQUIRE( pair.second.getAskPrice() >= pair.second.getBidPrice() );
+        }
+    }
+    REQUIRE( nComments == nShifted );
+    // shifting leaves the source chain untouched and keeps the chain time
+    REQUIRE( shiftedChain.getChainTime() == chainTime );
+    // an empty path shifts nothing
+    bc::OptionChain unshiftedChain(rawChain);
+    REQUIRE( unshiftedChain.shiftStaleRecords(bc::OptionChain::UnderlierPath{}, std::chrono::seconds(10)) == 0 );
+}
+
+TEST_CASE( "Delta shift recovers model prices after underlier move", "[deltashift]" ) {
+    bentotests::DataLoader dataLoader;
+    bc::OptionInstruments instruments = dataLoader.getOptionInstruments(
+        "QQQ_symbologyResolution_2025-04-28.txt", "QQQ", "2025-04-28", "2025-04-30");
+    bc::OptionChain referenceChain = dataLoader.buildOptionChainFromCbboMap(
+        "QQQ_symbologyResolution_2025-04-28.txt", "QQQ", "2025-04-28", "2025-04-30",
+        "QQQ_cbboMap_2025-04-28_exp_2025-04-30.txt");
+    // synthetic Black-Scholes quotes on QQQ strikes: a full chain at {staleTime},
+    // and fresh quotes near the money at {chainTime} after the underlier moved by 2.
+    double riskFreeRate = 0.04;
+    double discountFactor = bc::OptionChain::Util::getDiscountFactor(referenceChain, riskFreeRate);
+    bc::Timestamp chainTime = referenceChain.getChainTime();
+    bc::Timestamp staleTime = chainTime - std::chrono::minutes(10);
+    bc::OptionAnalytics::Parameters staleParameters{470.0, riskFreeRate, -std::log(discountFactor) / riskFreeRate};
+    bc::OptionAnalytics::Parameters freshParameters(staleParameters);
+    freshParameters.m_underlierPrice = 472.0;
+    auto makeRecord = [](double price, bc::Timestamp recvTime) {
+        return bc::OptionChain::Record(bc::OptionChain::PriceWeight(), bc::Timestamp{},
+            bc::OptionChain::PriceWeight::fromPrice(price + 0.01, 10),
+            bc::OptionChain::PriceWeight::fromPrice(price - 0.01, 10),
+            std::move(recvTime));
+    };
+    bc::OptionChain::RecordTimeline timeline;
+    const bc::OptionInstruments::StrikeKeyPutCallMap& strikeKeyPutCallMap =
+        *instruments.getChainIndex().getStrikeKeyPutCallMap();
+    for (bool bCall : {false, true}) {
+        auto& strikeToInstrument = bCall ? strikeKeyPutCallMap.second : strikeKeyPutCallMap.first;
+        for (auto& strikePair : strikeToInstrument) {
+            double strike = bc::OsiOption::fromStrikeKey(strikePair.first);
+            if (strike < 440.0 || strike > 500.0) {
+                continue;
+            }
+            auto& staleSide = bCall ? timeline[staleTime].second : timeline[staleTime].first;
+            staleSide.emplace(strikePair.first,
+                makeRecord(bc::OptionAnalytics::price(staleParameters, strike, 0.25, bCall), staleTime));
+            if (strike >= 465.0 && strike <= 478.0) {
+                auto& freshSide = bCall ? timeline[chainTime].second : timeline[chainTime].first;
+                freshSide.emplace(strikePair.first,
+                    makeRecord(bc::OptionAnalytics::price(freshParameters, strike, 0.25, bCall), chainTime));
+            }
+        }
+    }
+    bc::OptionChain::UnderlierPath underlierPath =
+        bc::OptionChain::estimateUnderlierPath(timeline, discountFactor);
+    REQUIRE( underlierPath.size() == 2 );
+    REQUIRE( underlierPath.begin()->second == Catch::Approx(470.0).margin(1e-6) );
+    REQUIRE( underlierPath.rbegin()->second == Catch::Approx(472.0).margin(1e-6) );
+
+    bc::OptionChain shiftedChain = bc::OptionChain::build(
+        bc::OptionChain::mapLatestBestInTimelineToRecord(timeline), instruments);
+    REQUIRE( shiftedChain.getChainTime() == chainTime );
+    std::size_t nShifted = shiftedChain.shiftStaleRecords(underlierPath, std::chrono::seconds(10));
+    REQUIRE( nShifted > 20 );
+    for (bool bCall : {false, true}) {
+        const bc::OptionChain::RecordMap& records = bCall ? shiftedChain.getCalls() : shiftedChain.getPuts();
+        for (auto& pair : records) {
+            if (pair.second.m_comment != bc::OptionChain::m_deltaShiftComment) {
+                continue;
+            }
+            double strike = bc::OsiOption::fromStrikeKey(pair.first);
+            double stalePrice = bc::OptionAnalytics::price(staleParameters, strike, 0.25, bCall);
+            double freshPrice = bc::OptionAnalytics::price(freshParameters, strike, 0.25, bCall);
+            if (stalePrice < 0.05) {
+                // synthetic quotes of the far wings are below the spread
+                continue;
+            }
+            // shifted quotes move closer to the model price after the underlier move
+            REQUIRE( std::abs(pair.second.getMidPrice() - freshPrice)
+                <= std::abs(stalePrice - freshPrice) + 1e-9 );
+            REQUIRE( std::abs(pair.second.getMidPrice() - freshPrice) < 0.25 );
+            REQUIRE( pair.second.getAskPrice() - pair.second.getBidPrice() == Catch::Approx(0.02).margin(1e-9) );
+            REQUIRE( pair.second.m_recvTime == chainTime );
+        }
+    }
+}
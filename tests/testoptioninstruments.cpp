@@ -81,6 +81,27 @@ TEST_CASE( "SymbologyResolution Insert", "[syminsert]" ) {
     std::map<std::string, std::string> osiToInstrumentId2 =
         optionInstrumentsSub.getOsiToInstrumentIdMap();
     REQUIRE( osiToInstrumentId == osiToInstrumentId2 );
+    // hashed lookups of the shared chain index
+    const bentoclient::OptionInstruments::ChainIndex& chainIndex = optionInstrumentsSub.getChainIndex();
+    REQUIRE( &chainIndex == instruments.getChainIndex("SPY", "2024-06-10", "2024-06-17").get() );
+    REQUIRE( chainIndex.size() == 230 );
+    const auto* entry = chainIndex.findInstrumentId("1375732232");
+    REQUIRE( entry != nullptr );
+    REQUIRE( entry->getOsiIdentifier() == "SPY   240617P00531000" );
+    REQUIRE( entry->getStrikeKey() == "00531000" );
+    REQUIRE( entry->m_put == true );
+    REQUIRE( chainIndex.findOsiIdentifier("SPY   240617P00531000")->getInstrumentId() == "1375732232" );
+    REQUIRE( chainIndex.findStrikeKey("00531000", true)->getInstrumentId() == "1375732232" );
+    REQUIRE( chainIndex.findStrikeKey("00531000", false)->getOsiIdentifier() == "SPY   240617C00531000" );
+    REQUIRE( chainIndex.findInstrumentId("0") == nullptr );
+    REQUIRE( instruments.getChainIndex("SPY", "2024-06-10", "2024-06-16") == nullptr );
+    REQUIRE( optionInstrumentsSub.getInstrumentIdToOsiMap().at("1375732232") == "SPY   240617P00531000" );
+    // inserting again leaves indexed chains and single chain instances untouched
+    instruments.insert(resolution);
+    REQUIRE( instruments.getChainIndex("SPY", "2024-06-10", "2024-06-17").get() != &chainIndex );
+    REQUIRE( chainIndex.findInstrumentId("1375732232") == entry );
+    REQUIRE( instruments.getInstrumentIdToOsiMap("SPY", "2024-06-10", "2024-06-17") ==
+        optionInstrumentsSub.getInstrumentIdToOsiMap() );
 }
 
 TEST_CASE( "Get next expiry dates for symbol", "[chainexpiry]" ) {
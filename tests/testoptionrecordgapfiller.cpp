@@ -4,6 +4,7 @@
 #include "bentoclient/optionchain.hpp"
 #include "bentoclient/optioninstruments.hpp"
 #include "dataloader.hpp"
+#include <random>
 
 namespace bc = bentoclient;
 #define REQUIRE_MESSAGE(cond, msg) do { INFO(msg); REQUIRE(cond);} while((void)0,0)
@@ -55,8 +56,8 @@ namespace{
             m_comment(comment)
         {}
         RecordCmp(const bc::OptionChain::Record& record) :
-            m_ask(std::get<0>(record.m_askPrice)),
-            m_bid(std::get<0>(record.m_bidPrice)),
+            m_ask(record.m_askPrice.price()),
+            m_bid(record.m_bidPrice.price()),
             m_comment(record.m_comment)
         {}
 
@@ -149,7 +150,7 @@ TEST_CASE( "Record Gap Filler SPY 2025-04-02", "[gapfillerspy0402]" ) {
     REQUIRE(nrec.m_askPrice == orec.m_askPrice);
     REQUIRE(nrec.m_comment == bc::OptionRecordGapFiller::m_spreadFitComment);
     // check the approximation is 0.1% close to the original
-    REQUIRE(std::get<0>(nrec.m_bidPrice) == Catch::Approx(std::get<0>(orec.m_bidPrice)).epsilon(1e-3));
+    REQUIRE(nrec.m_bidPrice.price() == Catch::Approx(orec.m_bidPrice.price()).epsilon(1e-3));
     // verify that the otm put wasn't valid before and is valid now
     REQUIRE(!ootmput.bidAskValid());
     REQUIRE(filled.getPuts().at(otmPutKey).bidAskValid());
@@ -170,9 +171,89 @@ TEST_CASE( "Record Gap Filler SPY 2025-04-02", "[gapfillerspy0402]" ) {
     REQUIRE(orec2.m_bidPrice != nrec2.m_bidPrice);
     REQUIRE(orec2.m_askPrice == nrec2.m_askPrice);
     // and that the extimates are 1 cents precision
-    REQUIRE(std::get<0>(orec2.m_bidPrice) == Catch::Approx(std::get<0>(nrec2.m_bidPrice)).epsilon(0).margin(0.01));
-
+    REQUIRE(orec2.m_bidPrice.price() == Catch::Approx(nrec2.m_bidPrice.price()).epsilon(0).margin(0.01));
+    // filling in place gives the same result as filling a shared copy
+    bc::OptionChain filledInPlace = gapFiller.fillGaps(bc::OptionChain(gapChain2));
+    REQUIRE(filledInPlace.getPuts() == filled2.getPuts());
+    REQUIRE(filledInPlace.getCalls() == filled2.getCalls());
+    // shared chains reference the same records, deep copies don't
+    bc::OptionChain sharedChain = bc::OptionChain::shareRecords(optionChain);
+    REQUIRE(&sharedChain.getPuts() == &optionChain.getPuts());
+    REQUIRE(&sharedChain.getCalls() == &optionChain.getCalls());
+    bc::OptionChain copiedChain(optionChain);
+    REQUIRE(&copiedChain.getPuts() != &optionChain.getPuts());
+    REQUIRE(copiedChain.getPuts() == optionChain.getPuts());
+    // a gap fit written to the put side only leaves the call side shared
+    bc::OptionChain refillChain(filled);
+    emptyRecordAt(refillChain.getPuts(), testKey);
+    bc::OptionChain refilled = gapFiller.fillGaps(refillChain);
+    REQUIRE(refilled.getPuts().at(testKey).bidAskValid());
+    REQUIRE(!refillChain.getPuts().at(testKey).bidAskValid());
+    REQUIRE(&refilled.getPuts() != &refillChain.getPuts());
+    REQUIRE(&refilled.getCalls() == &refillChain.getCalls());
+}
 
+TEST_CASE( "Record Gap Filler SPY 2025-04-02 perturbed", "[gapfillerspyperturbed]" ) {
+    bc::OptionChain optionChain =
+        bentotests::DataLoader().buildOptionChain(
+            "SPY_symbology_2025-04-02.txt",
+            "SPY", "2025-04-02", "2025-04-04",
+            "SPY_cbbos_2025-04-02_17-30.txt");
+    auto marketEnvironment(std::make_shared<bc::MarketEnvironment>(0.04, bc::DateUtils::m_nasdaqClose));
+    for (unsigned seed = 1; seed <= 40; ++seed)
+    {
+        // blank records, drop bids or asks, and erase strikes of either side at random
+        std::mt19937 generator(seed);
+        bc::OptionChain perturbed(optionChain);
+        for (const bc::OptionChain::RecordMap* side : {&perturbed.getPuts(), &perturbed.getCalls()})
+        {
+            auto& recordMap = const_cast<bc::OptionChain::RecordMap&>(*side);
+            for (auto it = recordMap.begin(); it != recordMap.end();)
+            {
+                switch (generator() % 8)
+                {
+                case 0: it->second = bc::OptionChain::Record(); break;
+                case 1: std::get<1>(it->second.m_bidPrice) = 0; break;
+                case 2: std::get<1>(it->second.m_askPrice) = 0; break;
+                case 3: it = recordMap.erase(it); continue;
+                default: break;
+                }
+                ++it;
+            }
+        }
+        std::list<std::string> orphanedPuts, orphanedCalls;
+        for (auto& keyRecord : perturbed.getPuts())
+        {
+            if (perturbed.getCalls().count(keyRecord.first) == 0)
+                orphanedPuts.push_back(keyRecord.first);
+        }
+        for (auto& keyRecord : perturbed.getCalls())
+        {
+            if (perturbed.getPuts().count(keyRecord.first) == 0)
+                orphanedCalls.push_back(keyRecord.first);
+        }
+        bc::OptionRecordGapFiller gapFiller(marketEnvironment);
+        bc::OptionChain filled = gapFiller.fillGaps(perturbed);
+        INFO("seed " << seed);
+        REQUIRE(gapFiller.getOrphanedPuts() == orphanedPuts);
+        REQUIRE(gapFiller.getOrphanedCalls() == orphanedCalls);
+        REQUIRE(filled.getPuts().size() == filled.getCalls().size());
+        // strikes with valid puts and calls are the fit points and stay as they were
+        for (auto& keyRecord : filled.getPuts())
+        {
+            const bc::OptionChain::Record& put = perturbed.getPuts().at(keyRecord.first);
+            const bc::OptionChain::Record& call = perturbed.getCalls().at(keyRecord.first);
+            if (put.bidAskValid() && call.bidAskValid())
+            {
+                REQUIRE(keyRecord.second == put);
+                REQUIRE(filled.getCalls().at(keyRecord.first) == call);
+            }
+        }
+        // filling in place gives the same records as filling a shared copy
+        bc::OptionChain filledInPlace = gapFiller.fillGaps(bc::OptionChain(perturbed));
+        REQUIRE(filledInPlace.getPuts() == filled.getPuts());
+        REQUIRE(filledInPlace.getCalls() == filled.getCalls());
+    }
 }
 
 TEST_CASE( "Record Gap Filler BNO 2025-04-28", "[gapfillerbno0428]" ) {
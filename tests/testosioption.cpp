@@ -1,6 +1,8 @@
 #include <catch2/catch_all.hpp>
 #include <catch2/catch_test_macros.hpp>
 #include <bentoclient/osioption.hpp>
+#include <string_view>
+#include <type_traits>
 
 TEST_CASE( "OSI Option", "[osiopt]" ) {
     // Test the OsiOption class
@@ -51,3 +53,55 @@ TEST_CASE( "OSI Option", "[osiopt]" ) {
     REQUIRE( sStrikeKey == "00000000");
 
 }
+
+namespace {
+    constexpr bentoclient::OsiSymbol parseOsi(std::string_view sOsiIdentifier) {
+        bentoclient::OsiSymbol symbol;
+        bentoclient::OsiSymbol::parse(sOsiIdentifier, symbol);
+        return symbol;
+    }
+    constexpr bool isOsi(std::string_view sOsiIdentifier) {
+        bentoclient::OsiSymbol symbol;
+        return bentoclient::OsiSymbol::parse(sOsiIdentifier, symbol);
+    }
+    // the parser core runs at compile time
+    static_assert(std::is_trivially_copyable_v<bentoclient::OsiSymbol>);
+    static_assert(parseOsi("SPY   240610P01120004").getUnderlier() == "SPY");
+    static_assert(parseOsi("SPY   240610P01120004").getStrikeKeyView() == "01120004");
+    static_assert(parseOsi("SPY   240610P01120004").m_strikeThousandths == 1120004);
+    static_assert(parseOsi("SPY   240610P01120004").isPut());
+    static_assert(parseOsi("BRKB  240610C00123000").isCall());
+    static_assert(parseOsi("SPXW  241231C05000000").m_month == 12);
+    static_assert(!isOsi("SPY 240610X00123000"));
+    static_assert(!isOsi("240610C00123000"));
+    static_assert(!isOsi("spy 240610C00123000"));
+    static_assert(!isOsi("SPY 240610C0012300"));
+    static_assert(!isOsi("SPY 24061AC00123000"));
+}
+
+TEST_CASE( "OSI Symbol", "[osisymbol]" ) {
+    bentoclient::OsiSymbol symbol = bentoclient::OsiSymbol::fromIdentifier("SPY   240610C00123400");
+    REQUIRE( symbol.getUnderlier() == "SPY");
+    REQUIRE( symbol.getExpiryDate() == "2024-06-10");
+    REQUIRE( symbol.getStrikeKey() == "00123400");
+    REQUIRE( symbol.getStrikeValue() == Catch::Approx(123.4));
+    REQUIRE( symbol.isCall());
+    // both parsers agree
+    const std::string osiIdentifiers[] = {"SPY 240610P00120040", "QQQ   250428C00450500",
+        "SPXW  251219P06000000", "BNO\t250516C00025000"};
+    for (const std::string& sOsiIdentifier : osiIdentifiers) {
+        bentoclient::OsiOption osi(sOsiIdentifier);
+        bentoclient::OsiSymbol osiSymbol = bentoclient::OsiSymbol::fromIdentifier(sOsiIdentifier);
+        REQUIRE( std::string(osiSymbol.getUnderlier()) == osi.getUnderlier());
+        REQUIRE( osiSymbol.getExpiryDate() == osi.getExpiryDate());
+        REQUIRE( osiSymbol.getStrikeKey() == osi.getStrikeKey());
+        REQUIRE( osiSymbol.isPut() == osi.isPut());
+    }
+    std::string sInvalid = "SPY 240610X00123000";
+    try {
+        bentoclient::OsiSymbol::fromIdentifier(sInvalid);
+        REQUIRE( false ); // Should not reach here
+    } catch (const std::invalid_argument& e) {
+        REQUIRE( std::string(e.what()) == "Invalid OSI identifier format: " + sInvalid );
+    }
+}
@@ -0,0 +1,81 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bentoclient/persisterasynchronous.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/marketenvironment.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace bc = bentoclient;
+
+namespace {
+    bc::OptionChain makeChain(const std::string& expiryDate)
+    {
+        return bc::OptionChain::fromRecords("SPY", "2025-04-02", expiryDate, bc::OptionChain::PutCallRecordMap());
+    }
+
+    /// @brief Persister counting calls from writer threads, slowed down like a slow disk
+    class CountingPersister : public bc::Persister
+    {
+    public:
+        CountingPersister(std::atomic<int>& nPersisted, std::atomic<int>& nMissing,
+            std::atomic<int>& nOnCaller, std::thread::id callerId) :
+        m_nPersisted(nPersisted),
+        m_nMissing(nMissing),
+        m_nOnCaller(nOnCaller),
+        m_callerId(callerId)
+        {}
+        void persist(bc::OptionChain&& optionChain,
+            std::shared_ptr<bc::MarketEnvironment>) override
+        {
+            if (std::this_thread::get_id() == m_callerId)
+            {
+                ++m_nOnCaller;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            if (optionChain.getExpiryDate() == "fail")
+            {
+                throw std::runtime_error("disk full");
+            }
+            ++m_nPersisted;
+        }
+        void persistMissing(const std::string&, const std::string&,
+            std::list<std::pair<bc::Timestamp, std::string>>&& missingList) override
+        {
+            m_nMissing += static_cast<int>(missingList.size());
+        }
+    private:
+        std::atomic<int>& m_nPersisted;
+        std::atomic<int>& m_nMissing;
+        std::atomic<int>& m_nOnCaller;
+        std::thread::id m_callerId;
+    };
+}
+
+TEST_CASE( "Asynchronous persister writes behind", "[persisterasynchronous]" ) {
+    std::atomic<int> nPersisted(0), nMissing(0), nOnCaller(0);
+    auto marketEnvironment(std::make_shared<bc::MarketEnvironment>(0.04, bc::DateUtils::m_nasdaqClose));
+    {
+        bc::PersisterAsynchronous persister(
+            std::make_unique<CountingPersister>(nPersisted, nMissing, nOnCaller, std::this_thread::get_id()),
+            bc::PersisterAsynchronous::Options(4, 2, 3));
+        for (int i = 0; i < 20; ++i)
+        {
+            persister.persist(makeChain(i == 7 ? "fail" : "2025-04-04"),
+                marketEnvironment);
+        }
+        persister.persistMissing("SPY", "2025-04-02", {{bc::Timestamp{}, "2025-04-04"}, {bc::Timestamp{}, "2025-04-11"}});
+        persister.drain();
+        REQUIRE(nPersisted == 19);
+        // the failed chain gets reported as missing
+        REQUIRE(nMissing == 3);
+        REQUIRE(persister.getFailedCount() == 1);
+        // queued calls get written on destruction
+        for (int i = 0; i < 10; ++i)
+        {
+            persister.persist(makeChain("2025-04-04"), marketEnvironment);
+        }
+    }
+    REQUIRE(nPersisted == 29);
+    REQUIRE(nOnCaller == 0);
+}
@@ -0,0 +1,79 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bentoclient/persisterbinary.hpp"
+#include "bentoclient/binarychain.hpp"
+#include "bentoclient/csvfromoptionchain.hpp"
+#include "bentoclient/optionrecordgapfiller.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/marketenvironment.hpp"
+#include "dataloader.hpp"
+#include "persistercsvinterceptor.hpp"
+#include <cmath>
+#include <sstream>
+
+namespace bc = bentoclient;
+
+static bc::OptionChain fillChain(std::shared_ptr<bc::MarketEnvironment> marketEnvironment)
+{
+    bc::OptionChain optionChain =
+        bentotests::DataLoader().buildOptionChain(
+            "SPY_symbology_2025-04-02.txt",
+            "SPY", "2025-04-02", "2025-04-04",
+            "SPY_cbbos_2025-04-02_17-30.txt");
+    REQUIRE( optionChain.getPuts().size() == 193 );
+    bc::OptionRecordGapFiller gapFiller(marketEnvironment);
+    return gapFiller.fillGaps(optionChain);
+}
+
+TEST_CASE( "PersisterBinary round trip", "[persisterbinary]" ) {
+    std::list<std::string> capturedBinary, capturedPath;
+    auto marketEnvironment(std::make_shared<bc::MarketEnvironment>(0.04, bc::DateUtils::m_nasdaqClose));
+    bc::OptionChain filledChain(fillChain(marketEnvironment));
+    bc::OptionChain filledChainCopy(filledChain);
+    std::string basePath("basePath");
+    bc::PersisterBinary persisterBinary(basePath, true);
+    persisterBinary.setOutputter(bentotests::createStringCaptureOutputter(capturedPath, capturedBinary));
+    persisterBinary.persist(std::move(filledChain), marketEnvironment);
+    REQUIRE(capturedPath.size() == 1);
+    REQUIRE(capturedPath.front() == basePath + "/2025-04-02/spy_chain_2025-04-02_2025-04-04_n193.bcc");
+    REQUIRE(capturedBinary.size() == 1);
+
+    const std::string& bytes = capturedBinary.front();
+    bc::BinaryChain::Reader reader(std::vector<char>(bytes.begin(), bytes.end()));
+    REQUIRE(reader.getSymbol() == "SPY");
+    REQUIRE(reader.getValuationDate() == "2025-04-02");
+    REQUIRE(reader.getExpiryDate() == "2025-04-04");
+    REQUIRE(reader.getChainTime() == filledChainCopy.getChainTime());
+    REQUIRE(reader.getHeader().m_nPuts == 193);
+    REQUIRE(reader.getHeader().m_nCalls == 193);
+    REQUIRE(reader.getRowCount() == 386);
+    // same rate and precision as in the CSV columns
+    REQUIRE(std::abs(reader.getHeader().m_parityRate - 566.05) < 0.005);
+    REQUIRE(std::abs(reader.getHeader().m_precision - 0.0465) < 0.00005);
+    REQUIRE(reader.getStrikeKey(0) == "00375000");
+    REQUIRE(reader.getStrikes()[0] == 375000);
+    REQUIRE(reader.getComment(0) == "spread-fit");
+    REQUIRE(reader.getProvenances()[0] == bc::BinaryChain::SPREAD_FIT);
+    REQUIRE(bc::BinaryChain::getProvenance("lin-interpol:delta-shift") ==
+        (bc::BinaryChain::LIN_INTERPOL | bc::BinaryChain::DELTA_SHIFT));
+    REQUIRE(bc::BinaryChain::getProvenance("manual") == bc::BinaryChain::OTHER);
+
+    bc::OptionChain readChain = reader.toOptionChain();
+    REQUIRE(readChain.getUnderlier() == "SPY");
+    REQUIRE(readChain.getExpiryDate() == "2025-04-04");
+    REQUIRE(readChain.getPuts() == filledChainCopy.getPuts());
+    REQUIRE(readChain.getCalls() == filledChainCopy.getCalls());
+    // the rebuilt chain writes the same CSV
+    bc::CSVFromOptionChain toCSV(marketEnvironment);
+    std::ostringstream expectedCsv, actualCsv;
+    toCSV.sideBySide(expectedCsv, filledChainCopy);
+    toCSV.sideBySide(actualCsv, readChain);
+    REQUIRE(actualCsv.str() == expectedCsv.str());
+    REQUIRE(reader.getHeader().m_fileSize == bytes.size());
+
+    // corrupted files get rejected
+    std::vector<char> truncated(bytes.begin(), bytes.end() - 1);
+    REQUIRE_THROWS_AS(bc::BinaryChain::Reader(std::move(truncated)), std::runtime_error);
+    std::vector<char> badMagic(bytes.begin(), bytes.end());
+    badMagic[0] = 'X';
+    REQUIRE_THROWS_AS(bc::BinaryChain::Reader(std::move(badMagic)), std::runtime_error);
+}
@@ -7,6 +7,8 @@
 #include "bentoclient/marketenvironment.hpp"
 #include "dataloader.hpp"
 #include "persistercsvinterceptor.hpp"
+#include <filesystem>
+#include <fstream>
 
 namespace bc = bentoclient;
 
@@ -65,4 +67,32 @@ TEST_CASE( "PersisterCSV output interceptor test", "[persistercsv]" ) {
         "75,12,2025-04-02 13:30:09,nan,{null},0,,0.0465";
     REQUIRE(lines.at(193) == expectedLastLine);
 
-}
\ No newline at end of file
+}
+
+TEST_CASE( "PersisterCSV appends missing chain notices", "[persistercsv]" ) {
+    std::filesystem::path basePath = std::filesystem::temp_directory_path() / "bentoclient_testpersistercsv";
+    std::filesystem::remove_all(basePath);
+    bc::PersisterCSV persisterCsv(basePath.string(), true);
+    bc::Timestamp chainTime = bc::DateUtils::makeTimestamp(2025, 04, 02, 10, 30, 00);
+    // e.g. the requester's notice and a later one of chains failing to get written, named alike
+    persisterCsv.persistMissing("SPY", "2025-04-02", {{chainTime, "2025-04-04"}});
+    persisterCsv.persistMissing("SPY", "2025-04-02", {{chainTime, "2025-04-11"}});
+    std::vector<std::filesystem::path> missingFiles;
+    for (auto& entry : std::filesystem::directory_iterator(basePath / "2025-04-02"))
+    {
+        missingFiles.push_back(entry.path());
+    }
+    REQUIRE(missingFiles.size() == 1);
+    REQUIRE(missingFiles.front().filename().string().find("spy_missing_2025-04-02_") == 0);
+    std::ifstream missing(missingFiles.front());
+    std::string line;
+    std::vector<std::string> lines;
+    while (std::getline(missing, line))
+    {
+        lines.push_back(line);
+    }
+    REQUIRE(lines.size() == 2);
+    REQUIRE(lines.at(0).find("EXP 2025-04-04") != std::string::npos);
+    REQUIRE(lines.at(1).find("EXP 2025-04-11") != std::string::npos);
+    std::filesystem::remove_all(basePath);
+}
@@ -6,23 +6,8 @@
 #include "dataloader.hpp"
 #include <cmath>
 
-namespace {
-    bentoclient::OptionChain shiftChainTime(
-        const bentoclient::OptionChain& source,
-        bentoclient::Timestamp targetChainTime)
-    {
-        bentoclient::OptionChain shiftedChain(source);
-        std::function<int(const bentoclient::OptionChain::Record&)> shifter =
-            [targetChainTime](const bentoclient::OptionChain::Record& record)
-        {
-            auto& nonconstRecord = const_cast<bentoclient::OptionChain::Record&>(record);
-            nonconstRecord.m_recvTime = targetChainTime;
-            return 0;
-        };
-        bentoclient::OptionChain::Util::onAllRecords(shiftedChain, shifter);
-        return shiftedChain;
-    }
-}
+using bentotests::shiftChainTime;
+
 TEST_CASE( "Retriever in memory test", "[retriever]" ) {
     
     auto timeRange = std::chrono::minutes(10);
@@ -37,7 +22,7 @@ TEST_CASE( "Retriever in memory test", "[retriever]" ) {
        
     try
     {
-        const auto& chain = retriever.getRawOptionChain(sSymbol, testTime, sExpiryDate);
+        auto chain = retriever.getRawOptionChain(sSymbol, testTime, sExpiryDate);
         REQUIRE(false);
     }
     catch(const std::invalid_argument& e)
@@ -57,8 +42,8 @@ TEST_CASE( "Retriever in memory test", "[retriever]" ) {
     REQUIRE( optionChain.getCalls().size() == 193 );
     auto shifted1 = shiftChainTime(optionChain, testTime + std::chrono::nanoseconds(789));
     retriever.submitOptionChain(std::move(shifted1));
-    auto& retrieved1 = retriever.getRawOptionChain(sSymbol, testTime, sExpiryDate);
-    bentoclient::Timestamp chainTime = retrieved1.getChainTime();
+    auto retrieved1 = retriever.getRawOptionChain(sSymbol, testTime, sExpiryDate);
+    bentoclient::Timestamp chainTime = retrieved1->getChainTime();
     // verify that the test time is no longer exactly same as chain time
     // which proves the time lenient lookup works.
     REQUIRE(chainTime != testTime);
@@ -68,7 +53,7 @@ TEST_CASE( "Retriever in memory test", "[retriever]" ) {
     auto testTime2 = testTime - (timeRange + std::chrono::seconds(1));
     try
     {
-        auto& retrieved2 = retriever.getRawOptionChain(sSymbol, testTime2, sExpiryDate);
+        auto retrieved2 = retriever.getRawOptionChain(sSymbol, testTime2, sExpiryDate);
         REQUIRE(false);
     }
     catch(const std::invalid_argument& e)
@@ -119,4 +104,79 @@ TEST_CASE( "Retriever in memory test", "[retriever]" ) {
     // out of range above last timestamp, return that and false
     auto pair9 = retriever.getNextInTimeRange(tv.back() + timeRange + std::chrono::seconds(1), ttm);
     REQUIRE(pair9 == std::make_pair(tv.back(), false));
-}
\ No newline at end of file
+}
+
+TEST_CASE( "Retriever in memory retention test", "[retriever]" ) {
+    auto timeRange = std::chrono::minutes(10);
+    std::string sSymbol("SPY");
+    std::string sDate("2025-04-02");
+    std::string sExpiryDate("2025-04-04");
+    bentoclient::Timestamp testTime = bentoclient::DateUtils::makeTimestamp(2025, 04, 02, 10, 30, 00);
+    bentoclient::OptionChain optionChain =
+        bentotests::DataLoader().buildOptionChain(
+            "SPY_symbology_2025-04-02.txt",
+            sSymbol, sDate, sExpiryDate,
+            "SPY_cbbos_2025-04-02_17-30.txt");
+    std::vector<bentoclient::Timestamp> chainTimes;
+    for (int i = 0; i < 4; ++i)
+    {
+        chainTimes.push_back(testTime + std::chrono::hours(i));
+    }
+
+    // LRU bound: a single shard holding two chains evicts the least recently used
+    bentoclient::RetrieverInMemory lruRetriever(timeRange,
+        bentoclient::RetrieverInMemory::RetentionPolicy(2, bentoclient::TimeRange::zero(), 1));
+    lruRetriever.submitOptionChain(shiftChainTime(optionChain, chainTimes[0]));
+    lruRetriever.submitOptionChain(shiftChainTime(optionChain, chainTimes[1]));
+    auto handle = lruRetriever.getRawOptionChain(sSymbol, chainTimes[0], sExpiryDate);
+    lruRetriever.submitOptionChain(shiftChainTime(optionChain, chainTimes[2]));
+    REQUIRE(lruRetriever.size() == 2);
+    // chain 0 was used more recently than chain 1
+    REQUIRE(lruRetriever.hasOptionChain(sSymbol, chainTimes[0], sExpiryDate));
+    REQUIRE(!lruRetriever.hasOptionChain(sSymbol, chainTimes[1], sExpiryDate));
+    REQUIRE(lruRetriever.hasOptionChain(sSymbol, chainTimes[2], sExpiryDate));
+    lruRetriever.submitOptionChain(shiftChainTime(optionChain, chainTimes[3]));
+    REQUIRE(!lruRetriever.hasOptionChain(sSymbol, chainTimes[0], sExpiryDate));
+    // handles stay valid after eviction
+    REQUIRE(handle->getChainTime() == chainTimes[0]);
+    REQUIRE(handle->getPuts().size() == 193);
+
+    // Time window: chains older than the latest by more than the window get evicted
+    bentoclient::RetrieverInMemory windowRetriever(timeRange,
+        bentoclient::RetrieverInMemory::RetentionPolicy(0, std::chrono::minutes(90)));
+    for (auto& chainTime : chainTimes)
+    {
+        windowRetriever.submitOptionChain(shiftChainTime(optionChain, chainTime));
+    }
+    REQUIRE(windowRetriever.size() == 2);
+    REQUIRE(!windowRetriever.hasOptionChain(sSymbol, chainTimes[1], sExpiryDate));
+    REQUIRE(windowRetriever.hasOptionChain(sSymbol, chainTimes[2], sExpiryDate));
+    REQUIRE(windowRetriever.hasOptionChain(sSymbol, chainTimes[3], sExpiryDate));
+
+    // the bound holds across shards, so a single hot symbol keeps all of it
+    bentoclient::RetrieverInMemory hotRetriever(timeRange,
+        bentoclient::RetrieverInMemory::RetentionPolicy(3, bentoclient::TimeRange::zero(), 16));
+    for (auto& chainTime : chainTimes)
+    {
+        hotRetriever.submitOptionChain(shiftChainTime(optionChain, chainTime));
+    }
+    REQUIRE(hotRetriever.size() == 3);
+    REQUIRE(!hotRetriever.hasOptionChain(sSymbol, chainTimes[0], sExpiryDate));
+    REQUIRE(hotRetriever.hasOptionChain(sSymbol, chainTimes[1], sExpiryDate));
+    REQUIRE(hotRetriever.hasOptionChain(sSymbol, chainTimes[3], sExpiryDate));
+
+    // exceeding the bound evicts down to 7/8 of it, leaving room for the next submits
+    bentoclient::RetrieverInMemory batchRetriever(std::chrono::seconds(10),
+        bentoclient::RetrieverInMemory::RetentionPolicy(16, bentoclient::TimeRange::zero(), 4));
+    for (int i = 0; i < 17; ++i)
+    {
+        batchRetriever.submitOptionChain(shiftChainTime(optionChain, testTime + std::chrono::minutes(i)));
+    }
+    REQUIRE(batchRetriever.size() == 14);
+    REQUIRE(!batchRetriever.hasOptionChain(sSymbol, testTime + std::chrono::minutes(2), sExpiryDate));
+    REQUIRE(batchRetriever.hasOptionChain(sSymbol, testTime + std::chrono::minutes(3), sExpiryDate));
+    batchRetriever.submitOptionChain(shiftChainTime(optionChain, testTime + std::chrono::minutes(17)));
+    batchRetriever.submitOptionChain(shiftChainTime(optionChain, testTime + std::chrono::minutes(18)));
+    REQUIRE(batchRetriever.size() == 16);
+    REQUIRE(batchRetriever.hasOptionChain(sSymbol, testTime + std::chrono::minutes(3), sExpiryDate));
+}
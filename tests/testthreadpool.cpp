@@ -3,6 +3,10 @@
 #include <list>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include <set>
 
 TEST_CASE( "Threadpool join and query", "[threadjoin]" ) {
     {
@@ -191,3 +195,82 @@ TEST_CASE( "Threadpool queries threadpool", "[threadthread]" ) {
     }
     REQUIRE(endResults.size() == nQueryThreads*2);
 }
+
+TEST_CASE( "Threadpool many small jobs from many posters", "[threadsmall]" ) {
+    std::uint64_t nPosters = 4;
+    std::uint64_t nJobsPerPoster = 5000;
+    bentoclient::ThreadPool worker(8);
+    std::vector<std::vector<bentoclient::ThreadPool::JobId>> postedIds(nPosters);
+    std::atomic<std::uint64_t> nRun(0);
+    {
+        std::vector<std::thread> posters;
+        for (std::uint64_t i = 0; i < nPosters; ++i)
+        {
+            posters.emplace_back([&worker, &postedIds, &nRun, i, nJobsPerPoster](){
+                for (std::uint64_t j = 0; j < nJobsPerPoster; ++j)
+                {
+                    postedIds[i].push_back(worker.post([&nRun, j](){
+                        nRun.fetch_add(1);
+                        if (j % 1000 == 0)
+                            throw std::runtime_error("small job failed");
+                    }));
+                }
+            });
+        }
+        for (auto& poster : posters)
+            poster.join();
+    }
+    std::set<bentoclient::ThreadPool::JobId> uniqueIds;
+    for (auto& ids : postedIds)
+        uniqueIds.insert(ids.begin(), ids.end());
+    REQUIRE(uniqueIds.size() == nPosters * nJobsPerPoster);
+
+    // single job lookups and bulk queries share the results without losing any
+    bentoclient::ThreadPool::ResultMap results;
+    for (std::uint64_t j = 0; j < nJobsPerPoster; j += 100)
+    {
+        bentoclient::ThreadPool::JobId id = postedIds[0][j];
+        bentoclient::ThreadPool::Result r = worker.query(id);
+        if (!r.m_running)
+            results.emplace(id, std::move(r));
+    }
+    bentoclient::ThreadPool::ResultMap r = worker.query();
+    while (!r.empty())
+    {
+        for (auto it = r.begin(); it != r.end(); ++it)
+            REQUIRE(results.emplace(it->first, std::move(it->second)).second);
+        r = worker.query();
+    }
+    REQUIRE(nRun.load() == nPosters * nJobsPerPoster);
+    REQUIRE(results.size() == nPosters * nJobsPerPoster);
+    std::uint64_t nFailed = 0;
+    for (auto& result : results)
+    {
+        REQUIRE(result.second.m_running == false);
+        if (result.second.m_failed)
+        {
+            REQUIRE(result.second.m_message == "small job failed");
+            ++nFailed;
+        }
+    }
+    REQUIRE(nFailed == nPosters * nJobsPerPoster / 1000);
+    REQUIRE_THROWS_AS(worker.query(postedIds[0][0]), std::invalid_argument);
+    REQUIRE_THROWS_AS(worker.query(nPosters * nJobsPerPoster + 1), std::invalid_argument);
+}
+
+TEST_CASE( "Threadpool delivery window advances", "[threadwindow]" ) {
+    bentoclient::ThreadPool pool(4);
+    std::uint64_t nJobs = 1000;
+    std::vector<bentoclient::ThreadPool::JobId> ids;
+    for (std::uint64_t i = 0; i < nJobs; ++i)
+        ids.push_back(pool.post([](){}));
+    pool.join();
+    // single lookups and bulk queries both let the window move on
+    for (std::uint64_t i = 0; i < nJobs / 2; ++i)
+        REQUIRE(pool.query(ids[i]).m_running == false);
+    REQUIRE(pool.getTrackedIdCount() <= 2 * 64);
+    REQUIRE(pool.query().size() == nJobs - nJobs / 2);
+    REQUIRE(pool.getTrackedIdCount() <= 64);
+    for (auto id : ids)
+        REQUIRE_THROWS_AS(pool.query(id), std::invalid_argument);
+}
@@ -1,4 +1,5 @@
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include "bentoclient/threadpool.hpp"
 #include "bentoclient/variadicthreadpool.hpp"
 #include "bentoclient/retry.hpp"
@@ -7,6 +8,10 @@
 #include <chrono>
 #include <sstream>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cmath>
+#include <vector>
 #include <fmt/core.h>
 
 TEST_CASE( "Variadic Threadpool immediately accessing future", "[varthreadimmediate]" ) {
@@ -330,3 +335,120 @@ TEST_CASE( "ThreadPool with delayed retries of sporadic failures", "[threaddelay
     REQUIRE(foundNoLike == false);
     REQUIRE(errors.size() > 0);
 }
+
+namespace {
+    /// @brief A few microseconds of arithmetic, standing in for gap filling a batch
+    double smallWork(std::uint64_t seed)
+    {
+        double x = static_cast<double>(seed % 97) + 1.0;
+        for (int i = 0; i < 200; ++i)
+            x = std::sqrt(x + i);
+        return x;
+    }
+
+    /// @brief Posts {nOuter} jobs, each posting {nInner} leaf jobs to the same pool, and
+    /// blocks until all leaves ran, like per-expiry jobs fanning out per-batch work
+    double nestedFanOut(bentoclient::VariadicThreadPool& pool, std::uint64_t nOuter, std::uint64_t nInner)
+    {
+        std::atomic<std::uint64_t> remaining(nOuter * nInner);
+        std::atomic<std::uint64_t> sum(0);
+        std::mutex mutex;
+        std::condition_variable condition;
+        auto leaf = [&remaining, &sum, &mutex, &condition](std::uint64_t seed){
+            sum.fetch_add(static_cast<std::uint64_t>(smallWork(seed)));
+            if (remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(mutex);
+                condition.notify_all();
+            }
+        };
+        for (std::uint64_t i = 0; i < nOuter; ++i)
+        {
+            pool.postNoFuture([&pool, &leaf, nInner](std::uint64_t outer){
+                for (std::uint64_t j = 0; j < nInner; ++j)
+                    pool.postNoFuture(leaf, outer * nInner + j);
+            }, i);
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&remaining](){ return remaining.load() == 0; });
+        return static_cast<double>(sum.load());
+    }
+}
+
+TEST_CASE( "Variadic Threadpool work stealing scheduling", "[varthreadstealing]" ) {
+    std::uint64_t nThreads = 4;
+    using Scheduling = bentoclient::VariadicThreadPool::Scheduling;
+    for (Scheduling scheduling : {Scheduling::SharedQueue, Scheduling::WorkStealing})
+    {
+        // futures deliver results and exceptions alike
+        {
+        bentoclient::VariadicThreadPool pool(nThreads, scheduling);
+        std::function<int(int)> square = [](int i){
+            if (i == 7)
+                throw std::runtime_error("Bad square");
+            return i * i;
+        };
+        std::vector<std::future<int>> futures;
+        for (int i = 0; i < 100; ++i)
+            futures.push_back(pool.post(square, i));
+        for (int i = 0; i < 100; ++i)
+        {
+            if (i == 7)
+                REQUIRE_THROWS_AS(futures[i].get(), std::runtime_error);
+            else
+                REQUIRE(futures[i].get() == i * i);
+        }
+        }
+
+        // join waits for jobs posted by running jobs
+        std::atomic<std::uint64_t> nLeaves(0);
+        std::uint64_t nOuter = 50;
+        std::uint64_t nInner = 40;
+        {
+        bentoclient::VariadicThreadPool pool(nThreads, scheduling);
+        for (std::uint64_t i = 0; i < nOuter; ++i)
+        {
+            pool.postNoFuture([&pool, &nLeaves, nInner](){
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                for (std::uint64_t j = 0; j < nInner; ++j)
+                    pool.postNoFuture([&nLeaves](){ nLeaves.fetch_add(1); });
+            });
+        }
+        pool.join();
+        REQUIRE(nLeaves.load() == nOuter * nInner);
+        }
+
+        bentoclient::VariadicThreadPool pool(nThreads, scheduling);
+        REQUIRE(nestedFanOut(pool, nOuter, nInner) > 0.0);
+    }
+}
+
+TEST_CASE( "Variadic Threadpool scheduling benchmark", "[.][benchmark][varthreadstealing]" ) {
+    std::uint64_t nThreads = std::max<std::uint64_t>(std::thread::hardware_concurrency(), 2);
+    bentoclient::VariadicThreadPool sharedPool(nThreads);
+    bentoclient::VariadicThreadPool stealingPool(nThreads,
+        bentoclient::VariadicThreadPool::Scheduling::WorkStealing);
+    // about 20 expiries of a day fanning out 50 batches each
+    BENCHMARK("shared queue nested fan-out") {
+        return nestedFanOut(sharedPool, 20, 50);
+    };
+    BENCHMARK("work stealing nested fan-out") {
+        return nestedFanOut(stealingPool, 20, 50);
+    };
+    std::function<double(std::uint64_t)> work = smallWork;
+    auto flat = [&work](bentoclient::VariadicThreadPool& pool){
+        std::vector<std::future<double>> futures;
+        futures.reserve(1000);
+        for (std::uint64_t i = 0; i < 1000; ++i)
+            futures.push_back(pool.post(work, i));
+        double sum = 0.0;
+        for (auto& future : futures)
+            sum += future.get();
+        return sum;
+    };
+    BENCHMARK("shared queue flat futures") {
+        return flat(sharedPool);
+    };
+    BENCHMARK("work stealing flat futures") {
+        return flat(stealingPool);
+    };
+}
@@ -0,0 +1,112 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bentoclient/zstdstream.hpp"
+#include "bentoclient/persistercsv.hpp"
+#include "bentoclient/persisterbinary.hpp"
+#include "bentoclient/binarychain.hpp"
+#include "bentoclient/optionrecordgapfiller.hpp"
+#include "bentoclient/optionchain.hpp"
+#include "bentoclient/marketenvironment.hpp"
+#include "dataloader.hpp"
+#include "persistercsvinterceptor.hpp"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace bc = bentoclient;
+
+static bc::OptionChain fillChain(std::shared_ptr<bc::MarketEnvironment> marketEnvironment)
+{
+    bc::OptionChain optionChain =
+        bentotests::DataLoader().buildOptionChain(
+            "SPY_symbology_2025-04-02.txt",
+            "SPY", "2025-04-02", "2025-04-04",
+            "SPY_cbbos_2025-04-02_17-30.txt");
+    bc::OptionRecordGapFiller gapFiller(marketEnvironment);
+    return gapFiller.fillGaps(optionChain);
+}
+
+TEST_CASE( "ZstdStream compresses persisted chains", "[zstdstream]" ) {
+    auto marketEnvironment(std::make_shared<bc::MarketEnvironment>(0.04, bc::DateUtils::m_nasdaqClose));
+    bc::OptionChain filledChain(fillChain(marketEnvironment));
+    std::string basePath("basePath");
+
+    std::list<std::string> plainCsv, plainPath, compressedCsv, compressedPath;
+    bc::PersisterCSV persisterCSV(basePath, true, bc::PersisterCSV::CSVFormat::SideBySide);
+    persisterCSV.setOutputter(bentotests::createStringCaptureOutputter(plainPath, plainCsv));
+    persisterCSV.persist(bc::OptionChain(filledChain), marketEnvironment);
+    persisterCSV.setOutputter(bc::ZstdStream::wrapOutputter(
+        bentotests::createStringCaptureOutputter(compressedPath, compressedCsv), 3));
+    persisterCSV.persist(bc::OptionChain(filledChain), marketEnvironment);
+    REQUIRE(compressedPath.front() == plainPath.front() + ".zst");
+    const std::string& compressed = compressedCsv.front();
+    REQUIRE(bc::ZstdStream::isCompressed(compressed.data(), compressed.size()));
+    REQUIRE(!bc::ZstdStream::isCompressed(plainCsv.front().data(), plainCsv.front().size()));
+    REQUIRE(bc::ZstdStream::decompress(compressed) == plainCsv.front());
+    REQUIRE(compressed.size() * 5 < plainCsv.front().size());
+
+    // binary chain files get read back compressed
+    std::filesystem::path binaryPath = std::filesystem::temp_directory_path() / "bentoclient_testzstdstream";
+    std::filesystem::remove_all(binaryPath);
+    bc::PersisterBinary persisterBinary(binaryPath.string(), false);
+    persisterBinary.setOutputter(bc::ZstdStream::wrapOutputter(
+        bc::PersisterBinary::makeFileOutputter(std::ios::out | std::ios::binary), 19));
+    persisterBinary.persist(bc::OptionChain(filledChain), marketEnvironment);
+    std::filesystem::path binaryFile = binaryPath / "spy_chain_2025-04-02_2025-04-04_n193.bcc.zst";
+    REQUIRE(std::filesystem::exists(binaryFile));
+    bc::BinaryChain::Reader reader(binaryFile.string());
+    REQUIRE(reader.getRowCount() == 386);
+    REQUIRE(reader.toOptionChain().getCalls() == filledChain.getCalls());
+    std::filesystem::remove_all(binaryPath);
+}
+
+TEST_CASE( "ZstdStream dictionary round trip", "[zstdstream]" ) {
+    auto marketEnvironment(std::make_shared<bc::MarketEnvironment>(0.04, bc::DateUtils::m_nasdaqClose));
+    bc::OptionChain filledChain(fillChain(marketEnvironment));
+    std::list<std::string> capturedCsv, capturedPath;
+    bc::PersisterCSV persisterCSV("basePath", true, bc::PersisterCSV::CSVFormat::Stacked, true);
+    persisterCSV.setOutputter(bentotests::createStringCaptureOutputter(capturedPath, capturedCsv));
+    persisterCSV.persist(bc::OptionChain(filledChain), marketEnvironment);
+
+    // chunks of one chain stand in for many small chain files
+    std::vector<std::string> samples;
+    std::istringstream lines(capturedCsv.front());
+    std::string line, sample;
+    for (int i = 1; std::getline(lines, line); ++i)
+    {
+        sample += line + "\n";
+        if (i % 8 == 0)
+        {
+            samples.push_back(std::move(sample));
+            sample.clear();
+        }
+    }
+    REQUIRE(samples.size() > 40);
+    std::string dictionaryBytes = bc::ZstdStream::trainDictionary(samples, 4096);
+    REQUIRE(!dictionaryBytes.empty());
+    REQUIRE(dictionaryBytes.size() <= 4096);
+    auto dictionary = std::make_shared<const bc::ZstdStream::Dictionary>(dictionaryBytes, 3);
+
+    std::list<std::string> compressed, compressedPath;
+    bc::ZstdStream::Outputter outputter = bc::ZstdStream::wrapOutputter(
+        bentotests::createStringCaptureOutputter(compressedPath, compressed), 3, dictionary);
+    *outputter("sample.csv") << samples[1];
+    REQUIRE(compressedPath.front() == "sample.csv.zst");
+    REQUIRE(bc::ZstdStream::decompress(compressed.front(), dictionary.get()) == samples[1]);
+    REQUIRE_THROWS_AS(bc::ZstdStream::decompress(compressed.front()), std::runtime_error);
+    REQUIRE_THROWS_AS(bc::ZstdStream::Dictionary::load("missing.dict", 3), std::runtime_error);
+
+    // dictionary compressed binary chain files get read back with the dictionary
+    std::filesystem::path binaryPath = std::filesystem::temp_directory_path() / "bentoclient_testzstddict";
+    std::filesystem::remove_all(binaryPath);
+    bc::PersisterBinary persisterBinary(binaryPath.string(), false);
+    persisterBinary.setOutputter(bc::ZstdStream::wrapOutputter(
+        bc::PersisterBinary::makeFileOutputter(std::ios::out | std::ios::binary), 3, dictionary));
+    persisterBinary.persist(bc::OptionChain(filledChain), marketEnvironment);
+    std::filesystem::path binaryFile = binaryPath / "spy_chain_2025-04-02_2025-04-04_n193.bcc.zst";
+    REQUIRE(std::filesystem::exists(binaryFile));
+    REQUIRE_THROWS_AS(bc::BinaryChain::Reader(binaryFile.string()), std::runtime_error);
+    bc::BinaryChain::Reader reader(binaryFile.string(), dictionary.get());
+    REQUIRE(reader.getRowCount() == 386);
+    REQUIRE(reader.toOptionChain().getPuts() == filledChain.getPuts());
+    std::filesystem::remove_all(binaryPath);
+}